@@ -0,0 +1,132 @@
+#include "Benchmark.hpp"
+
+#include <luacpp/Version.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <iomanip>
+
+namespace {
+
+std::string escape(const std::string& str) {
+	std::string result;
+	result.reserve(str.size());
+	for (char c : str) {
+		switch (c) {
+			case '"': result += "\\\""; break;
+			case '\\': result += "\\\\"; break;
+			default: result += c; break;
+		}
+	}
+	return result;
+}
+
+const char* compilerName() {
+#if defined(__clang__)
+	return "clang " __clang_version__;
+#elif defined(__GNUC__)
+	return "gcc " __VERSION__;
+#elif defined(_MSC_VER)
+	return "msvc";
+#else
+	return "unknown";
+#endif
+}
+
+} // namespace
+
+namespace Bench {
+
+void Suite::add(std::string group, std::string name, Case::Function luacpp, Case::Function baseline) {
+	m_cases.push_back(Case{std::move(group), std::move(name), std::move(luacpp), std::move(baseline)});
+}
+
+std::vector<Result> Suite::run(const Options& options, std::ostream& log) const {
+	std::vector<Result> results;
+	for (const Case& c : m_cases) {
+		const std::string fullName = c.group + "/" + c.name;
+		if (!options.filter.empty() && fullName.find(options.filter) == std::string::npos) {
+			continue;
+		}
+
+		Result result{c.group, c.name, 0, 0.0, -1.0};
+		result.nsPerOp = measure(c.luacpp, options, result.iterations);
+		if (c.baseline) {
+			uint64_t iterations = 0;
+			result.baselineNsPerOp = measure(c.baseline, options, iterations);
+		}
+
+		log << std::left << std::setw(48) << fullName << std::right << std::fixed << std::setprecision(2)
+			<< std::setw(12) << result.nsPerOp << " ns";
+		if (result.baselineNsPerOp >= 0.0) {
+			log << std::setw(12) << result.baselineNsPerOp << " ns raw  "
+				<< std::setw(8) << (result.nsPerOp - result.baselineNsPerOp) << " ns overhead";
+		}
+		log << std::endl;
+		results.push_back(result);
+	}
+	return results;
+}
+
+void Suite::writeJson(const std::vector<Result>& results, std::ostream& out) {
+	out << "{\n";
+	out << "  \"luacpp_version\": \"" << Lua::LuaCppVersion.asString().data() << "\",\n";
+	out << "  \"lua_version\": \"" << Lua::Version::getLuaVersion().asString().data() << "\",\n";
+	out << "  \"compiler\": \"" << escape(compilerName()) << "\",\n";
+#ifdef LUACPP_BENCH_BUILD_TYPE
+	out << "  \"build_type\": \"" << LUACPP_BENCH_BUILD_TYPE << "\",\n";
+#endif
+	out << "  \"benchmarks\": [";
+	char buffer[64];
+	for (size_t i = 0; i < results.size(); ++i) {
+		const Result& r = results[i];
+		out << (i == 0 ? "\n" : ",\n");
+		out << "    {\"group\": \"" << escape(r.group) << "\", \"name\": \"" << escape(r.name) << "\"";
+		out << ", \"iterations\": " << r.iterations;
+		std::snprintf(buffer, sizeof(buffer), "%.3f", r.nsPerOp);
+		out << ", \"ns_per_op\": " << buffer;
+		if (r.baselineNsPerOp >= 0.0) {
+			std::snprintf(buffer, sizeof(buffer), "%.3f", r.baselineNsPerOp);
+			out << ", \"baseline_ns_per_op\": " << buffer;
+			std::snprintf(buffer, sizeof(buffer), "%.3f", r.nsPerOp - r.baselineNsPerOp);
+			out << ", \"overhead_ns\": " << buffer;
+			std::snprintf(buffer, sizeof(buffer), "%.3f", r.baselineNsPerOp > 0.0 ? r.nsPerOp / r.baselineNsPerOp : 0.0);
+			out << ", \"overhead_ratio\": " << buffer;
+		}
+		out << "}";
+	}
+	out << "\n  ]\n}\n";
+}
+
+double Suite::measure(const Case::Function& func, const Options& options, uint64_t& iterations) {
+	using Clock = std::chrono::steady_clock;
+
+	//find the number of iterations that runs at least the minimum time
+	iterations = 1;
+	for (;;) {
+		const auto start = Clock::now();
+		func(iterations);
+		const auto elapsed = Clock::now() - start;
+		if (elapsed >= options.minTime || iterations >= (uint64_t(1) << 40)) {
+			break;
+		}
+		const double elapsedNs = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+		const double targetNs = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(options.minTime).count());
+		//grow at most by factor 10 per round, but at least double the iterations
+		const double factor = elapsedNs > 0.0 ? std::min(10.0, std::max(2.0, 1.2 * targetNs / elapsedNs)) : 10.0;
+		iterations = static_cast<uint64_t>(static_cast<double>(iterations) * factor);
+	}
+
+	std::vector<double> samples;
+	samples.reserve(options.repetitions);
+	for (uint32_t i = 0; i < std::max<uint32_t>(options.repetitions, 1); ++i) {
+		const auto start = Clock::now();
+		func(iterations);
+		const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start);
+		samples.push_back(static_cast<double>(elapsed.count()) / static_cast<double>(iterations));
+	}
+	std::sort(samples.begin(), samples.end());
+	return samples[samples.size() / 2];
+}
+
+} // namespace Bench
\ No newline at end of file
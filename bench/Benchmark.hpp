@@ -0,0 +1,78 @@
+#ifndef LUACPP_BENCHMARK_HPP
+#define LUACPP_BENCHMARK_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace Bench {
+
+/**
+ * @brief prevent the compiler from optimizing away the computation of a value
+*/
+template <typename T>
+inline void doNotOptimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+	asm volatile("" : : "r,m"(value) : "memory");
+#else
+	static volatile const void* sink;
+	sink = &value;
+#endif
+}
+
+/**
+ * @brief a single benchmark case
+ * Every case measures the luacpp code path and the equivalent code written against the raw Lua C API. Both functions
+ * receive the number of iterations to run, so all setup work can be done outside of the measured loop.
+*/
+struct Case {
+	using Function = std::function<void(size_t iterations)>;
+
+	std::string group;
+	std::string name;
+	Function luacpp;
+	Function baseline; ///< may be empty if there is no raw lua equivalent
+};
+
+struct Result {
+	std::string group;
+	std::string name;
+	uint64_t iterations;
+	double nsPerOp;
+	double baselineNsPerOp; ///< negative if the case has no baseline
+};
+
+struct Options {
+	std::chrono::milliseconds minTime{200}; ///< minimum time of a single measurement
+	uint32_t repetitions = 5; ///< number of measurements, the median is reported
+	std::string filter; ///< only run cases whose full name contains this string
+};
+
+class Suite {
+public:
+	void add(std::string group, std::string name, Case::Function luacpp, Case::Function baseline = Case::Function());
+
+	std::vector<Result> run(const Options& options, std::ostream& log) const;
+
+	static void writeJson(const std::vector<Result>& results, std::ostream& out);
+
+private:
+	static double measure(const Case::Function& func, const Options& options, uint64_t& iterations);
+
+	std::vector<Case> m_cases;
+};
+
+void registerMarshallingBenchmarks(Suite& suite);
+void registerTableBenchmarks(Suite& suite);
+void registerCallBenchmarks(Suite& suite);
+void registerScriptBenchmarks(Suite& suite);
+void registerHookBenchmarks(Suite& suite);
+void registerNumArrayBenchmarks(Suite& suite);
+void registerJsonBenchmarks(Suite& suite);
+
+} // namespace Bench
+
+#endif // LUACPP_BENCHMARK_HPP
\ No newline at end of file
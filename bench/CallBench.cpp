@@ -0,0 +1,236 @@
+#include "Benchmark.hpp"
+
+#include <luacpp/State.hpp>
+#include <luacpp/CoroutinePool.hpp>
+#include <luacpp/Memoizer.hpp>
+#include <luacpp/Parallel.hpp>
+#include <luacpp/StrandedState.hpp>
+#include <luacpp/Tracer.hpp>
+#include <lua/lua.hpp>
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Bench {
+
+namespace {
+
+constexpr const char* const Functions = R"(
+	function noop() end
+	function add(a, b) return a + b end
+	function tariff(zone, weight)
+		local price = #zone
+		for i = 1, weight do price = price + (i % 7) * 0.5 end
+		return price
+	end
+	function price(weight)
+		local price = 5
+		for i = 1, weight do price = price + (i % 7) * 0.5 end
+		return price
+	end
+	function callMethod(n)
+		for i = 1, n do
+			method(i)
+		end
+	end
+)";
+
+int rawMethod(lua_State* L) {
+	lua_pushinteger(L, lua_tointeger(L, 1) + 1);
+	return 1;
+}
+
+} // namespace
+
+void registerCallBenchmarks(Suite& suite) {
+	auto state = std::make_shared<Lua::State>();
+	lua_State* L = state->getState();
+	state->loadAndExecuteScript(Functions);
+
+	suite.add("call", "executeFunction/noop",
+		[state](size_t iterations) {
+			for (size_t i = 0; i < iterations; ++i) {
+				state->executeFunction("noop");
+			}
+		},
+		[state, L](size_t iterations) {
+			for (size_t i = 0; i < iterations; ++i) {
+				lua_getglobal(L, "noop");
+				lua_pcall(L, 0, 0, 0);
+			}
+		});
+
+	suite.add("call", "executeFunctionAndReadReturnVal/add",
+		[state](size_t iterations) {
+			for (size_t i = 0; i < iterations; ++i) {
+				int result = 0;
+				state->executeFunctionAndReadReturnVal(result, "add", static_cast<int>(i), 1);
+				doNotOptimize(result);
+			}
+		},
+		[state, L](size_t iterations) {
+			for (size_t i = 0; i < iterations; ++i) {
+				lua_getglobal(L, "add");
+				lua_pushinteger(L, static_cast<lua_Integer>(i));
+				lua_pushinteger(L, 1);
+				if (lua_pcall(L, 2, 1, 0) == LUA_OK) {
+					doNotOptimize(static_cast<int>(lua_tointeger(L, -1)));
+				}
+				lua_pop(L, 1);
+			}
+		});
+
+	//calls from lua into C++: the loop runs inside lua, so each iteration is one dispatch
+	auto methodState = std::make_shared<Lua::State>();
+	methodState->loadAndExecuteScript(Functions);
+	methodState->registerMethod("method", [](Lua::State& lua) {
+		return lua.setReturnValue(lua.getArgument<int64_t>(1) + 1);
+	});
+	auto nativeState = std::make_shared<Lua::State>();
+	nativeState->loadAndExecuteScript(Functions);
+	nativeState->registerNativeFunction("method", rawMethod);
+	auto rawState = std::make_shared<Lua::State>();
+	lua_State* rawL = rawState->getState();
+	rawState->loadAndExecuteScript(Functions);
+	lua_pushcfunction(rawL, rawMethod);
+	lua_setglobal(rawL, "method");
+
+	auto rawLoop = [rawState, rawL](size_t iterations) {
+		lua_getglobal(rawL, "callMethod");
+		lua_pushinteger(rawL, static_cast<lua_Integer>(iterations));
+		lua_pcall(rawL, 1, 0, 0);
+	};
+
+	suite.add("call", "registerMethod/dispatch",
+		[methodState](size_t iterations) {
+			methodState->executeFunction("callMethod", static_cast<int64_t>(iterations));
+		},
+		rawLoop);
+
+	suite.add("call", "registerNativeFunction/dispatch",
+		[nativeState](size_t iterations) {
+			nativeState->executeFunction("callMethod", static_cast<int64_t>(iterations));
+		},
+		rawLoop);
+
+	//the same dispatch with tracing enabled, the hooks record two events per lua and C function call
+	auto tracedState = std::make_shared<Lua::State>();
+	tracedState->loadAndExecuteScript(Functions);
+	tracedState->registerMethod("method", [](Lua::State& lua) {
+		return lua.setReturnValue(lua.getArgument<int64_t>(1) + 1);
+	});
+	Lua::Tracer::attach(tracedState->getState());
+	suite.add("call", "Tracer/registerMethod/dispatch",
+		[tracedState](size_t iterations) {
+			Lua::Tracer::enable();
+			tracedState->executeFunction("callMethod", static_cast<int64_t>(iterations));
+			Lua::Tracer::disable();
+			Lua::Tracer::clear();
+		},
+		[methodState](size_t iterations) {
+			methodState->executeFunction("callMethod", static_cast<int64_t>(iterations));
+		});
+
+	//per-request execution contexts: pooled threads against a new thread for every call
+	//the deleter keeps the state alive until the pool released its threads
+	std::shared_ptr<Lua::CoroutinePool> pool(new Lua::CoroutinePool(L), [state](Lua::CoroutinePool* p) { delete p; });
+	suite.add("call", "CoroutinePool/add",
+		[state, pool, L](size_t iterations) {
+			for (size_t i = 0; i < iterations; ++i) {
+				lua_getglobal(L, "add");
+				lua_pushinteger(L, static_cast<lua_Integer>(i));
+				lua_pushinteger(L, 1);
+				if (pool->call(2, 1) == LUA_OK) {
+					doNotOptimize(lua_tointeger(L, -1));
+					lua_pop(L, 1);
+				}
+			}
+		},
+		[state, L](size_t iterations) {
+			for (size_t i = 0; i < iterations; ++i) {
+				lua_State* thread = lua_newthread(L);
+				lua_getglobal(thread, "add");
+				lua_pushinteger(thread, static_cast<lua_Integer>(i));
+				lua_pushinteger(thread, 1);
+				int results = 0;
+				if (lua_resume(thread, L, 2, &results) == LUA_OK) {
+					doNotOptimize(lua_tointeger(thread, -1));
+				}
+				lua_pop(L, 1);
+			}
+		});
+
+	//calls from other threads: submission to the strand against a mutex around the state
+	auto strand = std::make_shared<Lua::StrandedState>();
+	strand->submit([](Lua::State& lua) { lua.loadAndExecuteScript(Functions); }).get();
+	auto mutex = std::make_shared<std::mutex>();
+	suite.add("call", "StrandedState/submit",
+		[strand](size_t iterations) {
+			std::future<int> last;
+			for (size_t i = 0; i < iterations; ++i) {
+				last = strand->submit([i](Lua::State& lua) {
+					int result = 0;
+					lua.executeFunctionAndReadReturnVal(result, "add", static_cast<int>(i), 1);
+					return result;
+				});
+			}
+			doNotOptimize(last.get());
+		},
+		[state, mutex, L](size_t iterations) {
+			for (size_t i = 0; i < iterations; ++i) {
+				std::lock_guard<std::mutex> lock(*mutex);
+				lua_getglobal(L, "add");
+				lua_pushinteger(L, static_cast<lua_Integer>(i));
+				lua_pushinteger(L, 1);
+				if (lua_pcall(L, 2, 1, 0) == LUA_OK) {
+					doNotOptimize(static_cast<int>(lua_tointeger(L, -1)));
+				}
+				lua_pop(L, 1);
+			}
+		});
+
+	//deterministic lookup with repeated arguments: cached results against calling the function every time
+	std::shared_ptr<Lua::Memoizer> memoizer(new Lua::Memoizer(*state), [state](Lua::Memoizer* m) { delete m; });
+	suite.add("call", "Memoizer/tariff",
+		[state, memoizer](size_t iterations) {
+			for (size_t i = 0; i < iterations; ++i) {
+				double price = 0.0;
+				memoizer->call(price, "tariff", "north", static_cast<int>(i % 64) + 1);
+				doNotOptimize(price);
+			}
+		},
+		[state](size_t iterations) {
+			for (size_t i = 0; i < iterations; ++i) {
+				double price = 0.0;
+				state->executeFunctionAndReadReturnVal(price, "tariff", "north", static_cast<int>(i % 64) + 1);
+				doNotOptimize(price);
+			}
+		});
+
+	//one transform over a large input: chunks on all cores against one call per element on a single state
+	auto workers = std::make_shared<Lua::Workers>([](Lua::State& worker) { worker.loadAndExecuteScript(Functions); });
+	suite.add("call", "parallelMap/price",
+		[workers](size_t iterations) {
+			std::vector<int> weights(iterations);
+			for (size_t i = 0; i < iterations; ++i) {
+				weights[i] = static_cast<int>(i % 64) + 1;
+			}
+			std::vector<double> prices;
+			Lua::parallelMap(*workers, "price", weights, prices);
+			doNotOptimize(prices.data());
+		},
+		[state](size_t iterations) {
+			std::vector<int> weights(iterations);
+			for (size_t i = 0; i < iterations; ++i) {
+				weights[i] = static_cast<int>(i % 64) + 1;
+			}
+			std::vector<double> prices(iterations);
+			for (size_t i = 0; i < iterations; ++i) {
+				state->executeFunctionAndReadReturnVal(prices[i], "price", weights[i]);
+			}
+			doNotOptimize(prices.data());
+		});
+}
+
+} // namespace Bench
@@ -0,0 +1,64 @@
+#include "Benchmark.hpp"
+
+#include <luacpp/State.hpp>
+#include <lua/lua.hpp>
+
+#include <memory>
+
+namespace Bench {
+
+namespace {
+
+constexpr const char* const Functions = R"(
+	function leaf(x) return x end
+	function loop(n)
+		local sum = 0
+		for i = 1, n do
+			sum = sum + leaf(i)
+		end
+		return sum
+	end
+)";
+
+uint64_t RawHookCount = 0;
+
+void rawHook(lua_State*, lua_Debug*) {
+	++RawHookCount;
+}
+
+} // namespace
+
+void registerHookBenchmarks(Suite& suite) {
+	//every iteration is one call of 'leaf' inside lua and therefore one call and one return event
+	auto plainState = std::make_shared<Lua::State>();
+	plainState->loadAndExecuteScript(Functions);
+
+	auto hookState = std::make_shared<Lua::State>();
+	hookState->loadAndExecuteScript(Functions);
+	auto hookCount = std::make_shared<uint64_t>(0);
+	hookState->registerDebugHook([hookCount](Lua::State&, const Lua::DebugInfo&) { ++*hookCount; }, Lua::MaskCall | Lua::MaskReturn);
+
+	auto rawState = std::make_shared<Lua::State>();
+	lua_State* rawL = rawState->getState();
+	rawState->loadAndExecuteScript(Functions);
+	lua_sethook(rawL, rawHook, LUA_MASKCALL | LUA_MASKRET, 0);
+
+	suite.add("hook", "none",
+		[plainState](size_t iterations) {
+			plainState->executeFunction("loop", static_cast<int64_t>(iterations));
+		});
+
+	suite.add("hook", "registerDebugHook/call+return",
+		[hookState, hookCount](size_t iterations) {
+			hookState->executeFunction("loop", static_cast<int64_t>(iterations));
+			doNotOptimize(*hookCount);
+		},
+		[rawState, rawL](size_t iterations) {
+			lua_getglobal(rawL, "loop");
+			lua_pushinteger(rawL, static_cast<lua_Integer>(iterations));
+			lua_pcall(rawL, 1, 0, 0);
+			doNotOptimize(RawHookCount);
+		});
+}
+
+} // namespace Bench
\ No newline at end of file
@@ -0,0 +1,64 @@
+#include "Benchmark.hpp"
+
+#include <luacpp/State.hpp>
+#include <luacpp/Json.hpp>
+#include <lua/lua.hpp>
+
+#include <memory>
+#include <string>
+
+namespace Bench {
+
+namespace {
+
+/**
+ * @brief creates a document of about 64 KiB with arrays, objects, numbers and strings (a few of them escaped)
+*/
+std::string createDocument() {
+	std::string text = "{\"items\":[";
+	for (int i = 0; i < 500; ++i) {
+		if (i > 0) {
+			text += ",";
+		}
+		text += "{\"id\":" + std::to_string(i) + ",\"price\":" + std::to_string(i * 0.25)
+			+ ",\"name\":\"item number " + std::to_string(i) + "\",\"tags\":[\"a\",\"b\",\"c\"],"
+			+ "\"description\":\"" + (i % 10 == 0 ? "line\\nbreak" : "plain description text") + "\"}";
+	}
+	text += "],\"count\":500}";
+	return text;
+}
+
+} // namespace
+
+void registerJsonBenchmarks(Suite& suite) {
+	auto state = std::make_shared<Lua::State>();
+	lua_State* L = state->getState();
+	auto document = std::make_shared<std::string>(createDocument());
+
+	suite.add("json", "decode/" + std::to_string(document->size() / 1024) + "KiB",
+		[state, L, document](size_t iterations) {
+			std::string error;
+			for (size_t i = 0; i < iterations; ++i) {
+				Lua::Json::decode(L, *document, error);
+				lua_pop(L, 1);
+			}
+		});
+
+	std::string error;
+	Lua::Json::decode(L, *document, error);
+	lua_setglobal(L, "document");
+	suite.add("json", "encode/" + std::to_string(document->size() / 1024) + "KiB",
+		[state, L](size_t iterations) {
+			std::string out;
+			std::string error;
+			lua_getglobal(L, "document");
+			for (size_t i = 0; i < iterations; ++i) {
+				out.clear();
+				Lua::Json::encode(L, -1, out, error);
+				doNotOptimize(out);
+			}
+			lua_pop(L, 1);
+		});
+}
+
+} // namespace Bench
\ No newline at end of file
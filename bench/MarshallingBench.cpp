@@ -0,0 +1,152 @@
+#include "Benchmark.hpp"
+
+#include <luacpp/State.hpp>
+#include <lua/lua.hpp>
+
+#include <memory>
+
+namespace Bench {
+
+namespace {
+
+template <typename T>
+void addPushCase(Suite& suite, const char* name, T value, void (*raw)(lua_State*, T)) {
+	auto state = std::make_shared<Lua::State>();
+	lua_State* L = state->getState();
+	suite.add("pushToStack", name,
+		[state, L, value](size_t iterations) {
+			for (size_t i = 0; i < iterations; ++i) {
+				Lua::Basics::pushToStack<T>(L, value);
+				Lua::Basics::popStack(L, 1);
+			}
+		},
+		[state, L, value, raw](size_t iterations) {
+			for (size_t i = 0; i < iterations; ++i) {
+				raw(L, value);
+				lua_pop(L, 1);
+			}
+		});
+}
+
+template <typename T, typename Raw>
+void addGetCase(Suite& suite, const char* name, void (*push)(lua_State*), Raw raw) {
+	auto state = std::make_shared<Lua::State>();
+	lua_State* L = state->getState();
+	push(L); //the value stays on the stack for the whole benchmark
+	suite.add("getStackValue", name,
+		[state, L](size_t iterations) {
+			for (size_t i = 0; i < iterations; ++i) {
+				doNotOptimize(Lua::Basics::getStackValue<T>(L, -1));
+			}
+		},
+		[state, L, raw](size_t iterations) {
+			for (size_t i = 0; i < iterations; ++i) {
+				doNotOptimize(raw(L));
+			}
+		});
+}
+
+} // namespace
+
+void registerMarshallingBenchmarks(Suite& suite) {
+	addPushCase<bool>(suite, "bool", true, [](lua_State* L, bool v) { lua_pushboolean(L, v); });
+	addPushCase<int>(suite, "int", 42, [](lua_State* L, int v) { lua_pushinteger(L, v); });
+	addPushCase<int64_t>(suite, "int64", 42, [](lua_State* L, int64_t v) { lua_pushinteger(L, v); });
+	addPushCase<double>(suite, "double", 3.1415, [](lua_State* L, double v) { lua_pushnumber(L, v); });
+	addPushCase<const char*>(suite, "const char*", "hello world", [](lua_State* L, const char* v) { lua_pushstring(L, v); });
+	addPushCase<std::string_view>(suite, "string_view", "hello world", [](lua_State* L, std::string_view v) { lua_pushlstring(L, v.data(), v.size()); });
+	addPushCase<std::string>(suite, "string", std::string(64, 'x'), [](lua_State* L, std::string v) { lua_pushlstring(L, v.data(), v.size()); });
+
+	addGetCase<bool>(suite, "bool", [](lua_State* L) { lua_pushboolean(L, 1); }, [](lua_State* L) { return lua_toboolean(L, -1) != 0; });
+	addGetCase<int>(suite, "int", [](lua_State* L) { lua_pushinteger(L, 42); }, [](lua_State* L) { return static_cast<int>(lua_tointeger(L, -1)); });
+	addGetCase<double>(suite, "double", [](lua_State* L) { lua_pushnumber(L, 3.1415); }, [](lua_State* L) { return lua_tonumber(L, -1); });
+	addGetCase<const char*>(suite, "const char*", [](lua_State* L) { lua_pushstring(L, "hello world"); }, [](lua_State* L) { return lua_tostring(L, -1); });
+	addGetCase<std::string_view>(suite, "string_view", [](lua_State* L) { lua_pushstring(L, "hello world"); }, [](lua_State* L) {
+		size_t len;
+		const char* str = lua_tolstring(L, -1, &len);
+		return std::string_view(str, len);
+	});
+	addGetCase<std::string>(suite, "string", [](lua_State* L) { lua_pushstring(L, std::string(64, 'x').c_str()); }, [](lua_State* L) {
+		size_t len;
+		const char* str = lua_tolstring(L, -1, &len);
+		return std::string(str, len);
+	});
+
+	{
+		auto state = std::make_shared<Lua::State>();
+		lua_State* L = state->getState();
+		state->writeVariable("x", 42);
+		suite.add("variable", "readVariable<int>",
+			[state](size_t iterations) {
+				for (size_t i = 0; i < iterations; ++i) {
+					doNotOptimize(state->readVariable<int>("x"));
+				}
+			},
+			[state, L](size_t iterations) {
+				for (size_t i = 0; i < iterations; ++i) {
+					lua_getglobal(L, "x");
+					doNotOptimize(static_cast<int>(lua_tointeger(L, -1)));
+					lua_pop(L, 1);
+				}
+			});
+		suite.add("variable", "writeVariable<int>",
+			[state](size_t iterations) {
+				for (size_t i = 0; i < iterations; ++i) {
+					state->writeVariable("x", static_cast<int>(i));
+				}
+			},
+			[state, L](size_t iterations) {
+				for (size_t i = 0; i < iterations; ++i) {
+					lua_pushinteger(L, static_cast<lua_Integer>(i));
+					lua_setglobal(L, "x");
+				}
+			});
+		suite.add("variable", "readVariable<string>",
+			[state](size_t iterations) {
+				state->writeVariable("s", "hello world");
+				for (size_t i = 0; i < iterations; ++i) {
+					doNotOptimize(state->readVariable<std::string>("s"));
+				}
+			},
+			[state, L](size_t iterations) {
+				state->writeVariable("s", "hello world");
+				for (size_t i = 0; i < iterations; ++i) {
+					lua_getglobal(L, "s");
+					size_t len;
+					const char* str = lua_tolstring(L, -1, &len);
+					doNotOptimize(std::string(str, len));
+					lua_pop(L, 1);
+				}
+			});
+	}
+
+	{
+		//a 64 KiB message passed to a handler which returns a part of it
+		auto state = std::make_shared<Lua::State>(Lua::State::LibString);
+		lua_State* L = state->getState();
+		state->loadAndExecuteScript("function handle(message) return message:sub(1, 1024) end");
+		auto payload = std::make_shared<std::string>(64 * 1024, 'x');
+		suite.add("payload", "Buffer/64KiB",
+			[state, L, payload](size_t iterations) {
+				Lua::Buffer::Lifetime lifetime;
+				for (size_t i = 0; i < iterations; ++i) {
+					state->executeFunction<1>("handle", Lua::Buffer::borrow(payload->data(), payload->size(), lifetime));
+					doNotOptimize(Lua::Buffer::viewFromStack(L, -1));
+					lua_pop(L, 1);
+				}
+			},
+			[state, L, payload](size_t iterations) {
+				for (size_t i = 0; i < iterations; ++i) {
+					lua_getglobal(L, "handle"); //works with strings as well
+					lua_pushlstring(L, payload->data(), payload->size());
+					lua_call(L, 1, 1);
+					size_t len;
+					const char* str = lua_tolstring(L, -1, &len);
+					doNotOptimize(std::string(str, len));
+					lua_pop(L, 1);
+				}
+			});
+	}
+}
+
+} // namespace Bench
\ No newline at end of file
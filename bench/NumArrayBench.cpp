@@ -0,0 +1,78 @@
+#include "Benchmark.hpp"
+
+#include <luacpp/State.hpp>
+#include <luacpp/NumArray.hpp>
+#include <lua/lua.hpp>
+
+#include <memory>
+
+namespace Bench {
+
+namespace {
+
+//the baseline of these cases is the same aggregation written as interpreted loop over a lua table
+constexpr const char* const Setup = R"(
+	local n = 65536
+	values = {}
+	weights = {}
+	array = numarray.new(n)
+	weightArray = numarray.new(n)
+	for i = 1, n do
+		values[i] = (i % 100) * 0.5
+		weights[i] = 1 / i
+		array[i] = values[i]
+		weightArray[i] = weights[i]
+	end
+
+	function sumArray() return array:sum() end
+	function sumTable()
+		local s = 0
+		for i = 1, #values do s = s + values[i] end
+		return s
+	end
+
+	function dotArray() return array:dot(weightArray) end
+	function dotTable()
+		local s = 0
+		for i = 1, #values do s = s + values[i] * weights[i] end
+		return s
+	end
+
+	function countArray() return array:gt(25):sum() end
+	function countTable()
+		local c = 0
+		for i = 1, #values do
+			if values[i] > 25 then c = c + 1 end
+		end
+		return c
+	end
+)";
+
+void addCase(Suite& suite, const std::shared_ptr<Lua::State>& state, const char* name, const char* arrayFunc, const char* tableFunc) {
+	lua_State* L = state->getState();
+	auto run = [state, L](const char* func, size_t iterations) {
+		for (size_t i = 0; i < iterations; ++i) {
+			lua_getglobal(L, func);
+			lua_call(L, 0, 1);
+			doNotOptimize(lua_tonumber(L, -1));
+			lua_pop(L, 1);
+		}
+	};
+	suite.add("numarray", name,
+		[run, arrayFunc](size_t iterations) { run(arrayFunc, iterations); },
+		[run, tableFunc](size_t iterations) { run(tableFunc, iterations); });
+}
+
+} // namespace
+
+void registerNumArrayBenchmarks(Suite& suite) {
+	auto state = std::make_shared<Lua::State>(Lua::State::LibBase);
+	Lua::NumArray::openLibrary(state->getState());
+	state->loadAndExecuteScript(Setup);
+
+	addCase(suite, state, "sum/64K", "sumArray", "sumTable");
+	addCase(suite, state, "dot/64K", "dotArray", "dotTable");
+	addCase(suite, state, "countGreater/64K", "countArray", "countTable");
+}
+
+} // namespace Bench
\ No newline at end of file
@@ -0,0 +1,121 @@
+#include "Benchmark.hpp"
+
+#include <luacpp/State.hpp>
+#include <luacpp/BulkLoader.hpp>
+#include <luacpp/AllocationProfiler.hpp>
+#include <lua/lua.hpp>
+
+#include <memory>
+#include <string>
+
+namespace Bench {
+
+namespace {
+
+constexpr const char* const Script = R"(
+	local t = {}
+	for i = 1, 16 do
+		t[i] = i * 2
+	end
+	counter = (counter or 0) + #t
+)";
+
+} // namespace
+
+void registerScriptBenchmarks(Suite& suite) {
+	auto state = std::make_shared<Lua::State>();
+	lua_State* L = state->getState();
+
+	suite.add("script", "loadScript",
+		[state](size_t iterations) {
+			for (size_t i = 0; i < iterations; ++i) {
+				state->loadScript("script", Script);
+			}
+		},
+		[state, L](size_t iterations) {
+			for (size_t i = 0; i < iterations; ++i) {
+				if (luaL_loadstring(L, Script) == LUA_OK) {
+					lua_setfield(L, LUA_REGISTRYINDEX, "script");
+				} else {
+					lua_pop(L, 1);
+				}
+			}
+		});
+
+	state->loadScript("script", Script);
+	suite.add("script", "executeScript",
+		[state](size_t iterations) {
+			for (size_t i = 0; i < iterations; ++i) {
+				state->executeScript("script");
+			}
+		},
+		[state, L](size_t iterations) {
+			for (size_t i = 0; i < iterations; ++i) {
+				lua_getfield(L, LUA_REGISTRYINDEX, "script");
+				if (lua_pcall(L, 0, 0, 0) != LUA_OK) {
+					lua_pop(L, 1);
+				}
+			}
+		});
+
+	suite.add("script", "loadAndExecuteScript",
+		[state](size_t iterations) {
+			for (size_t i = 0; i < iterations; ++i) {
+				state->loadAndExecuteScript(Script);
+			}
+		},
+		[state, L](size_t iterations) {
+			for (size_t i = 0; i < iterations; ++i) {
+				if (luaL_dostring(L, Script) != LUA_OK) {
+					lua_pop(L, 1);
+				}
+			}
+		});
+
+	//startup with many scripts: parallel compilation and one loading pass against loading one script after the other
+	suite.add("script", "BulkLoader/load",
+		[state, L](size_t iterations) {
+			Lua::BulkLoader loader;
+			for (size_t i = 0; i < iterations; ++i) {
+				loader.add("script" + std::to_string(i % 1024), Script);
+			}
+			loader.load(L);
+		},
+		[state](size_t iterations) {
+			for (size_t i = 0; i < iterations; ++i) {
+				state->loadScript(("script" + std::to_string(i % 1024)).c_str(), Script);
+			}
+		});
+
+	//cost of sampling the allocations of a script with the default interval
+	auto profiledState = std::make_shared<Lua::State>();
+	profiledState->loadScript("script", Script);
+	std::shared_ptr<Lua::AllocationProfiler> profiler(new Lua::AllocationProfiler(profiledState->getState()),
+		[profiledState](Lua::AllocationProfiler* p) { delete p; });
+	suite.add("script", "AllocationProfiler/executeScript",
+		[profiledState, profiler](size_t iterations) {
+			for (size_t i = 0; i < iterations; ++i) {
+				profiledState->executeScript("script");
+			}
+		},
+		[state](size_t iterations) {
+			for (size_t i = 0; i < iterations; ++i) {
+				state->executeScript("script");
+			}
+		});
+
+	//construction of short lived states with all libraries: opened on first access against opened right away
+	suite.add("script", "State/LibAll/lazy",
+		[](size_t iterations) {
+			for (size_t i = 0; i < iterations; ++i) {
+				Lua::State lazy(Lua::State::LibAll, Lua::State::LibraryLoading::Lazy);
+			}
+		},
+		[](size_t iterations) {
+			for (size_t i = 0; i < iterations; ++i) {
+				Lua::State eager(Lua::State::LibAll);
+			}
+		});
+}
+
+} // namespace Bench
\ No newline at end of file
@@ -0,0 +1,154 @@
+#include "Benchmark.hpp"
+
+#include <luacpp/State.hpp>
+#include <luacpp/HeapSnapshot.hpp>
+#include <lua/lua.hpp>
+
+#include <map>
+#include <memory>
+#include <variant>
+
+namespace Bench {
+
+namespace {
+
+using RawValue = std::variant<std::monostate, bool, int64_t, double, std::string, void*>;
+
+std::map<std::string, int> createMap(size_t size) {
+	std::map<std::string, int> map;
+	for (size_t i = 0; i < size; ++i) {
+		map["key" + std::to_string(i)] = static_cast<int>(i);
+	}
+	return map;
+}
+
+RawValue readRawValue(lua_State* L, int index) {
+	switch (lua_type(L, index)) {
+		case LUA_TBOOLEAN: return RawValue(lua_toboolean(L, index) != 0);
+		case LUA_TNUMBER:
+			if (lua_isinteger(L, index)) {
+				return RawValue(static_cast<int64_t>(lua_tointeger(L, index)));
+			}
+			return RawValue(lua_tonumber(L, index));
+		case LUA_TSTRING: {
+			size_t len;
+			const char* str = lua_tolstring(L, index, &len);
+			return RawValue(std::string(str, len));
+		}
+		case LUA_TLIGHTUSERDATA: return RawValue(lua_touserdata(L, index));
+		default: return RawValue();
+	}
+}
+
+void addSize(Suite& suite, size_t size) {
+	const std::string suffix = "/" + std::to_string(size);
+	auto state = std::make_shared<Lua::State>();
+	lua_State* L = state->getState();
+	const auto map = createMap(size);
+	state->writeTable("map", map);
+
+	suite.add("table", "read" + suffix,
+		[state, L](size_t iterations) {
+			lua_getglobal(L, "map");
+			Lua::Table table(L, -1);
+			for (size_t i = 0; i < iterations; ++i) {
+				doNotOptimize(table.read<std::string, int>());
+			}
+			lua_pop(L, 1);
+		},
+		[state, L](size_t iterations) {
+			lua_getglobal(L, "map");
+			for (size_t i = 0; i < iterations; ++i) {
+				std::map<std::string, int> result;
+				lua_pushnil(L);
+				while (lua_next(L, -2) != 0) {
+					if (lua_type(L, -2) != LUA_TSTRING || !lua_isinteger(L, -1)) {
+						lua_pop(L, 2);
+						break;
+					}
+					size_t len;
+					const char* key = lua_tolstring(L, -2, &len);
+					result[std::string(key, len)] = static_cast<int>(lua_tointeger(L, -1));
+					lua_pop(L, 1);
+				}
+				doNotOptimize(result);
+			}
+			lua_pop(L, 1);
+		});
+
+	suite.add("table", "readGeneric" + suffix,
+		[state, L](size_t iterations) {
+			lua_getglobal(L, "map");
+			Lua::Table table(L, -1);
+			for (size_t i = 0; i < iterations; ++i) {
+				doNotOptimize(table.readGeneric());
+			}
+			lua_pop(L, 1);
+		},
+		[state, L](size_t iterations) {
+			lua_getglobal(L, "map");
+			for (size_t i = 0; i < iterations; ++i) {
+				std::map<RawValue, RawValue> result;
+				lua_pushnil(L);
+				while (lua_next(L, -2) != 0) {
+					result[readRawValue(L, -2)] = readRawValue(L, -1);
+					lua_pop(L, 1);
+				}
+				doNotOptimize(result);
+			}
+			lua_pop(L, 1);
+		});
+
+	suite.add("table", "write" + suffix,
+		[state, L, map](size_t iterations) {
+			lua_newtable(L);
+			Lua::Table table(L, -1);
+			for (size_t i = 0; i < iterations; ++i) {
+				table.write(map);
+			}
+			lua_pop(L, 1);
+		},
+		[state, L, map](size_t iterations) {
+			lua_newtable(L);
+			for (size_t i = 0; i < iterations; ++i) {
+				for (const auto& [key, value] : map) {
+					lua_pushlstring(L, key.data(), key.size());
+					lua_pushinteger(L, value);
+					lua_rawset(L, -3);
+				}
+			}
+			lua_pop(L, 1);
+		});
+
+	suite.add("table", "State::readTable" + suffix,
+		[state](size_t iterations) {
+			for (size_t i = 0; i < iterations; ++i) {
+				doNotOptimize(state->readTable<std::string, int>("map"));
+			}
+		});
+}
+
+} // namespace
+
+void registerTableBenchmarks(Suite& suite) {
+	for (size_t size : {16, 256, 4096}) {
+		addSize(suite, size);
+	}
+
+	//walking the heap compared to a full garbage collection, which traverses the same objects
+	auto heapState = std::make_shared<Lua::State>();
+	heapState->loadAndExecuteScript("records = {} for i = 1, 20000 do records[i] = {id = i, name = 'record' .. i, tags = {i}} end");
+	suite.add("table", "HeapSnapshot/capture",
+		[heapState](size_t iterations) {
+			for (size_t i = 0; i < iterations; ++i) {
+				doNotOptimize(Lua::HeapSnapshot::capture(heapState->getState()).getObjectCount());
+			}
+		},
+		[heapState](size_t iterations) {
+			for (size_t i = 0; i < iterations; ++i) {
+				lua_gc(heapState->getState(), LUA_GCCOLLECT);
+			}
+		});
+}
+
+} // namespace Bench
\ No newline at end of file
@@ -0,0 +1,59 @@
+#include "Benchmark.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace {
+
+void printUsage(const char* name) {
+	std::cerr << "usage: " << name << " [--filter <substring>] [--min-time <ms>] [--repetitions <n>] [--out <file.json>]\n"
+		<< "  results are written as JSON to the given file or to stdout, the human readable log goes to stderr\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+	Bench::Options options;
+	const char* outFile = nullptr;
+
+	for (int i = 1; i < argc; ++i) {
+		const bool hasValue = i + 1 < argc;
+		if (std::strcmp(argv[i], "--filter") == 0 && hasValue) {
+			options.filter = argv[++i];
+		} else if (std::strcmp(argv[i], "--min-time") == 0 && hasValue) {
+			options.minTime = std::chrono::milliseconds(std::atoi(argv[++i]));
+		} else if (std::strcmp(argv[i], "--repetitions") == 0 && hasValue) {
+			options.repetitions = static_cast<uint32_t>(std::atoi(argv[++i]));
+		} else if (std::strcmp(argv[i], "--out") == 0 && hasValue) {
+			outFile = argv[++i];
+		} else {
+			printUsage(argv[0]);
+			return 1;
+		}
+	}
+
+	Bench::Suite suite;
+	Bench::registerMarshallingBenchmarks(suite);
+	Bench::registerTableBenchmarks(suite);
+	Bench::registerCallBenchmarks(suite);
+	Bench::registerScriptBenchmarks(suite);
+	Bench::registerHookBenchmarks(suite);
+	Bench::registerNumArrayBenchmarks(suite);
+	Bench::registerJsonBenchmarks(suite);
+
+	const std::vector<Bench::Result> results = suite.run(options, std::cerr);
+
+	if (outFile != nullptr) {
+		std::ofstream file(outFile);
+		if (!file) {
+			std::cerr << "failed to open " << outFile << std::endl;
+			return 1;
+		}
+		Bench::Suite::writeJson(results, file);
+	} else {
+		Bench::Suite::writeJson(results, std::cout);
+	}
+	return 0;
+}
\ No newline at end of file
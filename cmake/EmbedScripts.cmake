@@ -0,0 +1,60 @@
+# Precompiled lua modules linked into a binary (see include/luacpp/Bundle.hpp)
+#
+# luacpp_embed_scripts(<target> [NAME <name>] [BASE_DIR <dir>] [KEEP_DEBUG_INFO] <files>...)
+#
+# The files are compiled to bytecode by luacpp_bundler at build time and added to the target as one bundle, which is
+# returned by Lua::Bundles::<name>() declared in <luacpp_bundles/<name>.hpp>. NAME defaults to the name of the target
+# and has to be a valid C++ identifier.
+# Modules are named after their path relative to BASE_DIR (default: the current source directory) without the extension
+# and with the directory separators replaced by dots. A file init.lua names the module of its directory, like the
+# pattern ?/init.lua of package.path.
+# The debug information (line numbers and names of locals) is stripped unless KEEP_DEBUG_INFO is given.
+# The bytecode depends on the lua version and build of luacpp_bundler, so it has to run on the target platform.
+
+function(luacpp_embed_scripts target)
+	cmake_parse_arguments(EMBED "KEEP_DEBUG_INFO" "NAME;BASE_DIR" "" ${ARGN})
+	if(NOT EMBED_NAME)
+		set(EMBED_NAME ${target})
+	endif()
+	if(NOT EMBED_NAME MATCHES "^[A-Za-z_][A-Za-z0-9_]*$")
+		message(FATAL_ERROR "luacpp_embed_scripts: invalid bundle name ${EMBED_NAME}")
+	endif()
+	if(NOT EMBED_BASE_DIR)
+		set(EMBED_BASE_DIR ${CMAKE_CURRENT_SOURCE_DIR})
+	endif()
+	get_filename_component(EMBED_BASE_DIR ${EMBED_BASE_DIR} ABSOLUTE BASE_DIR ${CMAKE_CURRENT_SOURCE_DIR})
+	if(EMBED_KEEP_DEBUG_INFO)
+		set(strip 0)
+	else()
+		set(strip 1)
+	endif()
+
+	set(modules "")
+	set(files "")
+	foreach(file ${EMBED_UNPARSED_ARGUMENTS})
+		get_filename_component(path ${file} ABSOLUTE BASE_DIR ${CMAKE_CURRENT_SOURCE_DIR})
+		file(RELATIVE_PATH module ${EMBED_BASE_DIR} ${path})
+		string(REGEX REPLACE "\\.lua$" "" module ${module})
+		string(REGEX REPLACE "(^|/)init$" "" module ${module})
+		string(REPLACE "/" "." module ${module})
+		if(module STREQUAL "" OR module MATCHES "^\\.")
+			message(FATAL_ERROR "luacpp_embed_scripts: ${file} is not located in ${EMBED_BASE_DIR}")
+		endif()
+		list(APPEND modules "${module}=${path}")
+		list(APPEND files ${path})
+	endforeach()
+
+	set(includeDir ${CMAKE_CURRENT_BINARY_DIR}/luacpp_bundles_${EMBED_NAME})
+	set(header ${includeDir}/luacpp_bundles/${EMBED_NAME}.hpp)
+	set(source ${includeDir}/${EMBED_NAME}.cpp)
+	file(MAKE_DIRECTORY ${includeDir}/luacpp_bundles)
+	add_custom_command(
+		OUTPUT ${header} ${source}
+		COMMAND luacpp_bundler ${header} ${source} ${EMBED_NAME} ${strip} ${modules}
+		DEPENDS luacpp_bundler ${files}
+		COMMENT "Embedding lua bundle ${EMBED_NAME}"
+		VERBATIM
+	)
+	target_sources(${target} PRIVATE ${header} ${source})
+	target_include_directories(${target} PRIVATE ${includeDir})
+endfunction()
\ No newline at end of file
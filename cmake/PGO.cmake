@@ -0,0 +1,56 @@
+# Profile guided optimization for luacpp and the vendored lua interpreter
+#
+# LUACPP_PGO selects the phase of the build:
+#  OFF      - regular build
+#  GENERATE - instrumented build which writes profile data to LUACPP_PGO_PROFILE_DIR when a program exits
+#  USE      - optimized build using the profile data in LUACPP_PGO_PROFILE_DIR
+#
+# The target luacpp_pgo runs all phases (see RunPGO.cmake) in a separate build directory.
+
+set(LUACPP_PGO OFF CACHE STRING "Profile guided optimization phase (OFF, GENERATE, USE)")
+set_property(CACHE LUACPP_PGO PROPERTY STRINGS OFF GENERATE USE)
+set(LUACPP_PGO_PROFILE_DIR "${CMAKE_BINARY_DIR}/pgo-profile" CACHE PATH "Directory of the profile data used for profile guided optimization")
+
+function(luacpp_pgo_flags phase result)
+	set(flags "")
+	if(CMAKE_CXX_COMPILER_ID STREQUAL "GNU")
+		if(phase STREQUAL "GENERATE")
+			set(flags "-fprofile-generate=${LUACPP_PGO_PROFILE_DIR}" "-fprofile-update=prefer-atomic")
+		elseif(phase STREQUAL "USE")
+			set(flags "-fprofile-use=${LUACPP_PGO_PROFILE_DIR}" "-fprofile-correction" "-Wno-missing-profile")
+		endif()
+		if(flags AND CMAKE_CXX_COMPILER_VERSION VERSION_GREATER_EQUAL 11)
+			# name the profile files relative to the build directory, so the profile can be used by another build directory
+			list(APPEND flags "-fprofile-prefix-path=${CMAKE_BINARY_DIR}")
+		endif()
+	elseif(CMAKE_CXX_COMPILER_ID MATCHES "Clang")
+		if(phase STREQUAL "GENERATE")
+			set(flags "-fprofile-instr-generate")
+		elseif(phase STREQUAL "USE")
+			set(flags "-fprofile-instr-use=${LUACPP_PGO_PROFILE_DIR}/luacpp.profdata" "-Wno-profile-instr-unprofiled" "-Wno-profile-instr-out-of-date")
+		endif()
+	else()
+		message(FATAL_ERROR "Profile guided optimization is only supported with gcc and clang")
+	endif()
+	set(${result} ${flags} PARENT_SCOPE)
+endfunction()
+
+# Apply the flags of the current phase to the given targets. The link flags are propagated by the first target, so every
+# executable linking against it is linked with the instrumentation runtime.
+function(luacpp_enable_pgo interfaceTarget)
+	if(LUACPP_PGO STREQUAL "OFF" OR NOT LUACPP_PGO)
+		return()
+	endif()
+	if(NOT LUACPP_PGO STREQUAL "GENERATE" AND NOT LUACPP_PGO STREQUAL "USE")
+		message(FATAL_ERROR "Invalid value for LUACPP_PGO: ${LUACPP_PGO}")
+	endif()
+
+	luacpp_pgo_flags(${LUACPP_PGO} PGO_FLAGS)
+	foreach(target ${interfaceTarget} ${ARGN})
+		target_compile_options(${target} PRIVATE ${PGO_FLAGS})
+	endforeach()
+	if(LUACPP_PGO STREQUAL "GENERATE")
+		target_link_libraries(${interfaceTarget} INTERFACE ${PGO_FLAGS})
+	endif()
+	message(STATUS "Profile guided optimization: ${LUACPP_PGO} (${LUACPP_PGO_PROFILE_DIR})")
+endfunction()
\ No newline at end of file
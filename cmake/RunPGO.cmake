@@ -0,0 +1,73 @@
+# Runs all phases of the profile guided optimization. Invoked by the target luacpp_pgo with cmake -P.
+#
+# Expected variables:
+#  LUACPP_SOURCE_DIR  - source directory of luacpp
+#  PGO_BUILD_DIR      - build directory used for the instrumented and the optimized build
+#  PGO_PROFILE_DIR    - directory of the collected profile data
+#  PGO_GENERATOR      - cmake generator
+#  PGO_C_COMPILER     - c compiler
+#  PGO_CXX_COMPILER   - c++ compiler
+#  PGO_COMPILER_ID    - id of the c++ compiler (GNU or Clang)
+#  PGO_LLVM_PROFDATA  - llvm-profdata executable (clang only)
+#  PGO_REFERENCE      - training executable of the regular build, used to report the speedup (optional)
+
+function(run)
+	execute_process(COMMAND ${ARGN} RESULT_VARIABLE result)
+	if(NOT result EQUAL 0)
+		string(REPLACE ";" " " command "${ARGN}")
+		message(FATAL_ERROR "Command failed (${result}): ${command}")
+	endif()
+endfunction()
+
+function(configureAndBuild phase)
+	message(STATUS "PGO: building phase ${phase}")
+	run(${CMAKE_COMMAND}
+		-S ${LUACPP_SOURCE_DIR}
+		-B ${PGO_BUILD_DIR}
+		-G ${PGO_GENERATOR}
+		-DCMAKE_BUILD_TYPE=Release
+		-DCMAKE_C_COMPILER=${PGO_C_COMPILER}
+		-DCMAKE_CXX_COMPILER=${PGO_CXX_COMPILER}
+		-DBUILD_EXAMPLES=OFF
+		-DLUACPP_PGO=${phase}
+		-DLUACPP_PGO_PROFILE_DIR=${PGO_PROFILE_DIR}
+	)
+	run(${CMAKE_COMMAND} --build ${PGO_BUILD_DIR} --config Release --target luacpp luacpp_pgo_train)
+endfunction()
+
+set(TRAIN_SCRIPTS ${LUACPP_SOURCE_DIR}/pgo/scripts)
+set(TRAIN_EXE ${PGO_BUILD_DIR}/luacpp_pgo_train${CMAKE_EXECUTABLE_SUFFIX})
+
+# 1. instrumented build
+file(REMOVE_RECURSE ${PGO_PROFILE_DIR})
+file(MAKE_DIRECTORY ${PGO_PROFILE_DIR})
+configureAndBuild(GENERATE)
+
+# 2. training run
+message(STATUS "PGO: running training workload")
+if(PGO_COMPILER_ID MATCHES "Clang")
+	set(ENV{LLVM_PROFILE_FILE} ${PGO_PROFILE_DIR}/luacpp-%p.profraw)
+endif()
+run(${TRAIN_EXE} ${TRAIN_SCRIPTS})
+
+if(PGO_COMPILER_ID MATCHES "Clang")
+	if(NOT PGO_LLVM_PROFDATA)
+		message(FATAL_ERROR "llvm-profdata is required to merge the profile data of clang")
+	endif()
+	file(GLOB RAW_PROFILES ${PGO_PROFILE_DIR}/*.profraw)
+	run(${PGO_LLVM_PROFDATA} merge -output=${PGO_PROFILE_DIR}/luacpp.profdata ${RAW_PROFILES})
+endif()
+
+# 3. optimized build
+configureAndBuild(USE)
+
+# 4. report the effect on the training workload
+if(PGO_REFERENCE AND EXISTS ${PGO_REFERENCE})
+	message(STATUS "PGO: workload with the regular build")
+	run(${PGO_REFERENCE} ${TRAIN_SCRIPTS} --timing)
+endif()
+message(STATUS "PGO: workload with the optimized build")
+run(${TRAIN_EXE} ${TRAIN_SCRIPTS} --timing)
+
+message(STATUS "PGO: optimized build in ${PGO_BUILD_DIR}. To use the profile in another build configure it with "
+	"-DLUACPP_PGO=USE -DLUACPP_PGO_PROFILE_DIR=${PGO_PROFILE_DIR}")
\ No newline at end of file
@@ -0,0 +1,132 @@
+#ifndef LUACPP_ALLOCATIONPROFILER_HPP
+#define LUACPP_ALLOCATIONPROFILER_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct lua_State;
+
+namespace Lua {
+
+/**
+ * @brief sampling profiler attributing the allocations of the lua heap to source lines and call stacks
+ *
+ * The profiler replaces the allocator of the state by a wrapper which forwards every request to the original
+ * allocator. Allocations are sampled like a Poisson process: on average one sample is taken every sampleInterval
+ * bytes, independent of the size of the single allocations. A sample captures the lua call stack (and optionally the
+ * native stack) and stands for an estimate of the bytes allocated since the previous sample, so the totals per line and
+ * per stack are unbiased. Sampled blocks are tracked until they are freed, which gives the live bytes.
+ *
+ * Stacks are only captured for new blocks. A sample falling on a growing block (e.g. a table or the lua stack being
+ * resized) is taken at the next new block, because lua's internal pointers may be in an intermediate state during
+ * these reallocations. The stack of the main thread is captured, allocations made in coroutines are attributed to the
+ * call resuming them.
+ *
+ * The profiler is not thread-safe: use it from the thread running the state and destroy it before the state.
+*/
+class AllocationProfiler {
+public:
+	struct Options {
+		size_t sampleInterval = 512 * 1024; ///< mean number of bytes between two samples, 0 samples every allocation
+		size_t luaFrames = 32; ///< maximum number of lua frames captured per sample
+		size_t nativeFrames = 0; ///< maximum number of native frames captured per sample (only on glibc, 0 to disable)
+		uint64_t seed = 0; ///< seed of the sampling intervals, 0 uses a random seed
+	};
+
+	/**
+	 * @brief estimated allocations of a source line or call stack
+	*/
+	struct Site {
+		std::string location; ///< source:line or the frames of a stack separated by ';' (outermost first)
+		uint64_t allocatedBytes = 0; ///< estimated bytes allocated
+		uint64_t liveBytes = 0; ///< estimated bytes still allocated
+		uint64_t samples = 0; ///< number of samples taken here
+	};
+
+	AllocationProfiler(lua_State* state);
+	AllocationProfiler(lua_State* state, const Options& options);
+	AllocationProfiler(const AllocationProfiler&) = delete;
+	~AllocationProfiler();
+
+	AllocationProfiler& operator=(const AllocationProfiler&) = delete;
+
+	/**
+	 * @brief stop sampling and restore the original allocator
+	 * The collected data stays available.
+	*/
+	void stop();
+	bool isRunning() const { return m_running; }
+
+	/**
+	 * @brief sites by the innermost lua source line of the samples, sorted by allocated bytes (descending)
+	*/
+	std::vector<Site> getLines() const;
+
+	/**
+	 * @brief sites by complete call stack, sorted by allocated bytes (descending)
+	*/
+	std::vector<Site> getStacks() const;
+
+	/**
+	 * @brief the stacks in the folded format of flamegraph.pl, speedscope or inferno ("frame;frame;frame bytes")
+	 * @param live Report the live bytes instead of the allocated bytes
+	*/
+	std::string toFoldedStacks(bool live = false) const;
+
+	uint64_t getAllocatedBytes() const { return m_allocatedBytes; } ///< exact number of bytes allocated while running
+	uint64_t getSampleCount() const { return m_sampleCount; }
+
+	/**
+	 * @brief drop the collected data, blocks sampled so far are no longer tracked
+	*/
+	void reset();
+
+private:
+	struct Stack {
+		std::string folded;
+		std::string line;
+		uint64_t allocatedBytes = 0;
+		uint64_t liveBytes = 0;
+		uint64_t samples = 0;
+	};
+
+	struct Block {
+		size_t stack;
+		uint64_t weight; ///< estimated bytes the sample stands for
+	};
+
+	static void* allocate(void* userData, void* ptr, size_t oldSize, size_t newSize);
+
+	void account(void* ptr, size_t oldSize, void* result, size_t newSize);
+	void sample(void* block, uint64_t weight);
+	size_t captureStack();
+	uint64_t nextInterval();
+	static size_t filterSlot(const void* block);
+
+	lua_State* m_state;
+	Options m_options;
+	void* (*m_allocator)(void*, void*, size_t, size_t); ///< the original allocator (a lua_Alloc)
+	void* m_allocatorData;
+	bool m_running = false;
+
+	std::mt19937_64 m_random;
+	uint64_t m_untilSample = 0; ///< bytes left until the next sample
+	uint64_t m_pendingWeight = 0; ///< weight of a sample which fell on a reallocation, it is taken at the next new block
+
+	uint64_t m_allocatedBytes = 0;
+	uint64_t m_sampleCount = 0;
+	std::vector<Stack> m_stacks;
+	std::unordered_map<std::string, size_t> m_stackIndex;
+	std::unordered_map<void*, Block> m_blocks; ///< sampled blocks which weren't freed yet
+	std::array<uint32_t, 4096> m_filter{}; ///< number of sampled blocks per address hash, saves the lookup for most blocks
+	std::string m_key; ///< buffer for the folded stack of the current sample
+};
+
+} // namespace Lua
+
+#endif // LUACPP_ALLOCATIONPROFILER_HPP
\ No newline at end of file
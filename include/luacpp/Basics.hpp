@@ -10,6 +10,12 @@ import luacpp.Type;
 #include <cstdint>
 #include <string>
 
+#ifdef LUACPP_INLINE_BASICS
+#define LUACPP_BASICS_INLINE inline
+#else
+#define LUACPP_BASICS_INLINE
+#endif
+
 struct lua_State;
 
 namespace Lua {
@@ -103,6 +109,8 @@ public:
 
 	static void insert(lua_State* state, int index);
 	static void popStack(lua_State* state, int numValues);
+	static int getStackSize(lua_State* state);
+	static void setStackSize(lua_State* state, int size);
 
 	static void pushNil(lua_State* state);
 	static void pushBoolean(lua_State* state, bool value);
@@ -133,4 +141,8 @@ inline void Basics::pushToStack<const std::string&>(lua_State* state, const std:
 
 } //namespace Lua
 
+#ifdef LUACPP_INLINE_BASICS
+#include "BasicsImpl.hpp"
+#endif
+
 #endif //LUACPP_BASICS_HPP
\ No newline at end of file
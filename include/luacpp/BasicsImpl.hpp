@@ -0,0 +1,71 @@
+#ifndef LUACPP_BASICSIMPL_HPP
+#define LUACPP_BASICSIMPL_HPP
+
+// Implementation of the thin wrappers in Basics. The definitions are either compiled into the library (src/Basics.cpp)
+// or, if LUACPP_INLINE_BASICS is defined, included by Basics.hpp so they can be inlined into the calling code.
+
+#include "Basics.hpp"
+#include <lua/lua.hpp>
+
+namespace Lua {
+
+LUACPP_BASICS_INLINE bool Basics::isOfType(lua_State* state, Type type, int index) {
+	switch (type) {
+		case Type::Nil: return lua_isnil(state, index);
+		case Type::Boolean:	return lua_isboolean(state, index);
+		case Type::LightUserData: return lua_islightuserdata(state, index);
+		case Type::Number: return lua_isnumber(state, index);
+		case Type::String: return lua_isstring(state, index);
+		case Type::Table: return lua_istable(state, index);
+		case Type::Function: return lua_isfunction(state, index);
+		case Type::UserData: return lua_isuserdata(state, index);
+		case Type::Thread: return lua_isthread(state, index);
+		case Type::None: return false;
+	}
+	return false;
+}
+LUACPP_BASICS_INLINE bool Basics::isFunction(lua_State* state, int index) {
+	return lua_isfunction(state, index);
+}
+
+LUACPP_BASICS_INLINE Type Basics::getType(lua_State* state, int index) {
+	return static_cast<Type>(lua_type(state, index));
+}
+
+LUACPP_BASICS_INLINE void Basics::insert(lua_State* state, int index) {
+	lua_insert(state, index);
+}
+
+LUACPP_BASICS_INLINE void Basics::popStack(lua_State* state, int numValues) {
+	lua_pop(state, numValues);
+}
+
+LUACPP_BASICS_INLINE int Basics::getStackSize(lua_State* state) { return lua_gettop(state); }
+LUACPP_BASICS_INLINE void Basics::setStackSize(lua_State* state, int size) { lua_settop(state, size); }
+
+LUACPP_BASICS_INLINE void Basics::pushNil(lua_State* state) { lua_pushnil(state); }
+LUACPP_BASICS_INLINE void Basics::pushBoolean(lua_State* state, bool value) { lua_pushboolean(state, value); }
+LUACPP_BASICS_INLINE void Basics::pushNumber(lua_State* state, double value) { lua_pushnumber(state, value); }
+LUACPP_BASICS_INLINE void Basics::pushInteger(lua_State* state, int64_t value) { lua_pushinteger(state, value); }
+LUACPP_BASICS_INLINE void Basics::pushString(lua_State* state, const char* value) { lua_pushstring(state, value); }
+LUACPP_BASICS_INLINE void Basics::pushString(lua_State* state, const char* value, size_t len) { lua_pushlstring(state, value, len); }
+LUACPP_BASICS_INLINE void Basics::pushCFunction(lua_State* state, NativeFunction value) { lua_pushcfunction(state, value); }
+LUACPP_BASICS_INLINE void Basics::pushLightUserData(lua_State* state, void* value) { lua_pushlightuserdata(state, value); }
+
+LUACPP_BASICS_INLINE bool Basics::isInteger(lua_State* state, int index) { return lua_isinteger(state, index); }
+
+LUACPP_BASICS_INLINE void* Basics::asUserData(lua_State* state, int index) { return lua_touserdata(state, index); }
+LUACPP_BASICS_INLINE bool Basics::asBoolean(lua_State* state, int index) { return lua_toboolean(state, index) != 0; }
+LUACPP_BASICS_INLINE double Basics::asNumber(lua_State* state, int index) { return lua_tonumber(state, index); }
+LUACPP_BASICS_INLINE int64_t Basics::asInteger(lua_State* state, int index) { return lua_tointeger(state, index); }
+LUACPP_BASICS_INLINE const char* Basics::asString(lua_State* state, int index, size_t* len) { return lua_tolstring(state, index, len); }
+
+LUACPP_BASICS_INLINE void* Basics::allocateUserData(lua_State* state, size_t size, int userValues) {
+	return lua_newuserdatauv(state, size, userValues);
+}
+
+LUACPP_BASICS_INLINE int Basics::calcUpValueIndex(int index) { return lua_upvalueindex(index); }
+
+} //namespace Lua
+
+#endif //LUACPP_BASICSIMPL_HPP
\ No newline at end of file
@@ -0,0 +1,123 @@
+#ifndef LUACPP_BUFFER_HPP
+#define LUACPP_BUFFER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+
+struct lua_State;
+
+namespace Lua {
+
+/**
+ * @brief read-only view of binary data which can be passed to lua without copying it
+ *
+ * The memory of a buffer is either kept alive by an owner (reference counted) or borrowed from the caller. Borrowed
+ * memory is bound to a Lifetime object, once the lifetime ends all buffers referring to it become invalid and accessing
+ * them from lua raises an error instead of reading released memory.
+ *
+ * In lua a buffer supports the following operations (all positions are 1-based like in the string library):
+ * - #buf, buf[i] (byte value or nil)
+ * - buf:sub(i [, j]) returns a view of a part of the buffer without copying
+ * - buf:byte(i), buf:readu8(i), buf:readu16(i), buf:readu32(i), buf:readu64(i), buf:readi8(i), buf:readi16(i), buf:readi32(i),
+ *   buf:readi64(i), buf:readf32(i), buf:readf64(i) read little endian values at the given position
+ * - tostring(buf) and buf:tostring([i [, j]]) copy the content into a lua string
+*/
+class Buffer {
+public:
+	/**
+	 * @brief lifetime of borrowed memory
+	 * Buffers created with borrow() are valid until the lifetime is released or destroyed.
+	*/
+	class Lifetime {
+	public:
+		Lifetime() : m_token(std::make_shared<char>(0)) {}
+		Lifetime(const Lifetime&) = delete;
+		Lifetime& operator=(const Lifetime&) = delete;
+
+		/**
+		 * @brief invalidate all buffers referring to this lifetime
+		*/
+		void release() { m_token.reset(); }
+
+	private:
+		friend class Buffer;
+		std::shared_ptr<char> m_token;
+	};
+
+	Buffer() = default;
+
+	/**
+	 * @brief create a buffer whose memory is kept alive by the given owner
+	*/
+	Buffer(const void* data, size_t size, std::shared_ptr<const void> owner);
+
+	/**
+	 * @brief create a buffer of borrowed memory which is valid as long as the given lifetime
+	*/
+	static Buffer borrow(const void* data, size_t size, const Lifetime& lifetime);
+
+	/**
+	 * @brief create a reference counted buffer holding a copy of the given data
+	*/
+	static Buffer copy(const void* data, size_t size);
+
+	const char* data() const { return m_data; }
+	size_t size() const { return m_size; }
+	std::string_view view() const { return std::string_view(m_data, m_size); }
+
+	/**
+	 * @brief check if the memory of the buffer may still be accessed
+	*/
+	bool isValid() const { return !m_borrowed || !m_lifetime.expired(); }
+
+	/**
+	 * @brief returns a view of a part of the buffer (sharing the memory with this buffer)
+	 * The range is clamped to the size of the buffer.
+	 * @param offset The 0-based offset of the first byte
+	 * @param length The number of bytes
+	*/
+	Buffer slice(size_t offset, size_t length) const;
+
+	/**
+	 * @brief push the buffer as userdata onto the stack of the given state
+	*/
+	static void push(lua_State* state, Buffer buffer);
+
+	/**
+	 * @brief returns the buffer at the given stack index (null if the value isn't a buffer)
+	 * The pointer is valid as long as the userdata is alive.
+	*/
+	static const Buffer* fromStack(lua_State* state, int index);
+
+	/**
+	 * @brief returns the content of a buffer or a string at the given stack index without copying it
+	 * An empty view is returned for other types and invalid buffers.
+	*/
+	static std::string_view viewFromStack(lua_State* state, int index);
+
+private:
+	static const Buffer& checkBuffer(lua_State* state, int index);
+	static size_t checkPosition(lua_State* state, const Buffer& buffer, int arg, size_t width);
+	template <typename T>
+	static T readLittleEndian(const char* data);
+	template <typename T>
+	static int read(lua_State* state);
+	static void pushMetaTable(lua_State* state);
+	static int index(lua_State* state);
+	static int len(lua_State* state);
+	static int sub(lua_State* state);
+	static int toString(lua_State* state);
+	static int gc(lua_State* state);
+
+	const char* m_data = nullptr; ///< first byte of the buffer
+	size_t m_size = 0; ///< number of bytes
+	std::shared_ptr<const void> m_owner; ///< keeps owned memory alive
+	std::weak_ptr<char> m_lifetime; ///< lifetime of borrowed memory
+	bool m_borrowed = false; ///< true if the memory is bound to m_lifetime
+};
+
+} // namespace Lua
+
+#endif // LUACPP_BUFFER_HPP
\ No newline at end of file
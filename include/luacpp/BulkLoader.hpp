@@ -0,0 +1,109 @@
+#ifndef LUACPP_BULKLOADER_HPP
+#define LUACPP_BULKLOADER_HPP
+
+#ifdef USE_CPP20_MODULES
+import luacpp.Registry;
+#else
+#include "Registry.hpp"
+#endif
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <map>
+#include <string>
+#include <vector>
+
+struct lua_State;
+
+namespace Lua {
+
+/**
+ * @brief compiles large sets of registry scripts in parallel
+ *
+ * Scripts are collected with add, addFile or addDirectory and compiled to bytecode by a group of threads. Each thread
+ * reads its files and compiles on a scratch state of its own, so the threads share nothing but the index of the next
+ * script. load then puts the bytecode into the registry of the target state in a single pass on the calling thread,
+ * which is much cheaper than parsing.
+ *
+ * The bytecode is kept after loading, so the same set of scripts can be loaded into further states without compiling
+ * again.
+*/
+class BulkLoader {
+public:
+	struct Options {
+		size_t threads = 0; ///< number of threads compiling (including the calling thread), 0 uses one per core
+		bool stripDebugInfo = false; ///< leave out line numbers and names of locals, makes the bytecode smaller
+	};
+
+	struct Result {
+		size_t loaded = 0; ///< number of scripts stored in the registry
+		std::map<std::string, std::string> errors; ///< error messages by key of the scripts which failed
+		size_t threads = 0; ///< number of threads used to compile
+		std::chrono::nanoseconds compileTime{0};
+		std::chrono::nanoseconds loadTime{0};
+
+		bool isOk() const { return errors.empty(); }
+	};
+
+	BulkLoader();
+	explicit BulkLoader(const Options& options);
+
+	/**
+	 * @brief add a script given as source code
+	 * @param chunkName Name of the chunk in error messages, the key is used if it is empty
+	*/
+	void add(std::string key, std::string source, std::string chunkName = std::string());
+
+	/**
+	 * @brief add a script which is read from the given file by the compiling thread
+	*/
+	void addFile(std::string key, std::filesystem::path path);
+
+	/**
+	 * @brief add all files with the given extension in the directory and its subdirectories
+	 * The key of a file is its path relative to the directory without the extension, with '.' as separator
+	 * (e.g. rules/tariff/north.lua has the key tariff.north).
+	 * @return The number of files added
+	*/
+	size_t addDirectory(const std::filesystem::path& directory, const std::string& extension = ".lua");
+
+	/**
+	 * @brief compile all scripts which weren't compiled yet
+	 * @return The number of scripts which failed to compile
+	*/
+	size_t compile();
+
+	/**
+	 * @brief compile the scripts if necessary and store them in the registry of the state
+	 * Scripts which failed to compile are reported in the result, all others are loaded.
+	*/
+	Result load(lua_State* state);
+
+	size_t size() const { return m_scripts.size(); }
+	void clear();
+
+private:
+	struct Script {
+		std::string key;
+		std::string source;
+		std::filesystem::path path; ///< the source is read from this file if it is set
+		std::string chunkName;
+		std::string bytecode;
+		std::string error;
+		Registry::ErrorCode status = Registry::ErrorCode::Ok;
+		bool compiled = false;
+	};
+
+	void compileScripts(const std::vector<size_t>& pending, std::atomic<size_t>& next);
+	void compileScript(lua_State* scratch, Script& script);
+
+	Options m_options;
+	std::vector<Script> m_scripts;
+	size_t m_threads = 0;
+	std::chrono::nanoseconds m_compileTime{0};
+};
+
+} // namespace Lua
+
+#endif // LUACPP_BULKLOADER_HPP
\ No newline at end of file
@@ -0,0 +1,69 @@
+#ifndef LUACPP_BUNDLE_HPP
+#define LUACPP_BUNDLE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+struct lua_State;
+
+namespace Lua {
+
+/**
+ * @brief lua modules precompiled to bytecode and linked into the binary
+ *
+ * Bundles are generated at build time with the cmake function luacpp_embed_scripts (see cmake/EmbedScripts.cmake) and
+ * are accessible through Lua::Bundles::<name>(). The bytecode of all modules is stored in one array, the index of the
+ * modules is sorted by name, so a module is found with a binary search and loaded without copying or parsing text.
+ *
+ * install adds a searcher to package.searchers, so require finds the modules of the bundle before looking at the file
+ * system. Modules are only loaded when they are required.
+*/
+class Bundle {
+public:
+	struct Module {
+		const char* name; ///< module name as used by require, e.g. "rules.pricing"
+		uint32_t offset; ///< start of the bytecode in the data of the bundle
+		uint32_t size; ///< size of the bytecode in bytes
+	};
+
+	/**
+	 * @param modules Index of the modules, sorted by name
+	*/
+	constexpr Bundle(const Module* modules, size_t count, const unsigned char* data)
+	: m_modules(modules), m_count(count), m_data(data) {}
+
+	size_t size() const { return m_count; }
+	const Module& operator[](size_t index) const { return m_modules[index]; }
+
+	/**
+	 * @return The module with the given name or null if the bundle doesn't contain it
+	*/
+	const Module* find(std::string_view name) const;
+
+	/**
+	 * @brief load the module with the given name and push its main function onto the stack
+	 * @return true on success, false if the bundle doesn't contain the module or its bytecode is incompatible with the
+	 * lua version of the state (an error message is pushed in this case)
+	*/
+	bool load(lua_State* state, std::string_view name) const;
+
+	/**
+	 * @brief add a searcher for the modules of the bundle to package.searchers of the given state
+	 * The searcher is inserted right after the one for package.preload, so the bundle takes precedence over the files
+	 * of package.path and package.cpath.
+	 * @return false if the package library isn't loaded in the state
+	*/
+	bool install(lua_State* state) const;
+
+private:
+	static int searcher(lua_State* state);
+
+	const Module* m_modules;
+	size_t m_count;
+	const unsigned char* m_data;
+};
+
+} // namespace Lua
+
+#endif // LUACPP_BUNDLE_HPP
\ No newline at end of file
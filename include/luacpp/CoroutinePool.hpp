@@ -0,0 +1,109 @@
+#ifndef LUACPP_COROUTINEPOOL_HPP
+#define LUACPP_COROUTINEPOOL_HPP
+
+#ifdef USE_CPP20_MODULES
+import luacpp.Registry;
+#else
+#include "Registry.hpp"
+#endif
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+struct lua_State;
+
+namespace Lua {
+
+/**
+ * @brief pool of lua threads of one state which are reused as execution contexts
+ *
+ * Running every request on a new lua thread allocates the thread and its stack and leaves both to the garbage collector.
+ * The pool keeps up to getMaxIdle threads referenced from the registry. Returned threads are reset with lua_closethread
+ * (which closes pending to-be-closed variables and shrinks the stack) and handed out again by the next acquire.
+ *
+ * The pool must not outlive its state.
+*/
+class CoroutinePool {
+public:
+	struct Thread {
+		lua_State* state = nullptr; ///< the lua thread, null if the handle is empty
+		int reference = -2; ///< reference of the thread in the registry
+	};
+
+	struct Statistics {
+		size_t created = 0; ///< threads created because the pool was empty
+		size_t reused = 0; ///< threads taken from the pool
+		size_t discarded = 0; ///< threads left to the garbage collector because the pool was full
+		size_t idle = 0; ///< threads currently waiting in the pool
+		size_t active = 0; ///< threads currently acquired
+		size_t maxIdle = 0; ///< configured size of the pool
+	};
+
+	constexpr static int AllResults = -1; ///< numResults of call to keep all results (LUA_MULTRET)
+
+	/**
+	 * @param maxIdle Maximum number of threads kept in the pool
+	*/
+	explicit CoroutinePool(lua_State* state, size_t maxIdle = 16);
+	CoroutinePool(const CoroutinePool&) = delete;
+	~CoroutinePool();
+
+	CoroutinePool& operator=(const CoroutinePool&) = delete;
+
+	/**
+	 * @brief take a thread from the pool or create a new one if it is empty
+	*/
+	Thread acquire();
+
+	/**
+	 * @brief reset the thread and put it back into the pool
+	 * The thread must not be used afterwards.
+	*/
+	void release(Thread& thread);
+
+	/**
+	 * @brief call the function below the given number of arguments on the stack of the state on a pooled thread
+	 * Like lua_pcall the function and arguments are replaced by the results. On errors nothing is left on the stack and
+	 * the message can be read with getLastError. Yielding out of the function is reported as error, the function can
+	 * still use coroutines of its own.
+	 * @return The status of the lua virtual machine
+	*/
+	int call(int numArgs, int numResults);
+
+	/**
+	 * @brief execute a script of the registry on a pooled thread
+	*/
+	template <typename T>
+	int executeScript(T key) {
+		Registry registry(m_state);
+		if (registry.getScript(key) != Registry::ErrorCode::Ok) {
+			m_lastError = "script not found";
+			return static_cast<int>(Registry::ErrorCode::RuntimeError);
+		}
+		return call(0, 0);
+	}
+
+	/**
+	 * @brief change the number of threads kept in the pool, surplus idle threads are discarded
+	*/
+	void setMaxIdle(size_t maxIdle);
+	size_t getMaxIdle() const { return m_maxIdle; }
+
+	const Statistics& getStatistics() const { return m_statistics; }
+	const std::string& getLastError() const { return m_lastError; }
+
+private:
+	void discard(Thread& thread);
+	void setError(lua_State* thread);
+
+	lua_State* m_state;
+	size_t m_maxIdle;
+	std::vector<Thread> m_idle;
+	Statistics m_statistics;
+	std::string m_lastError;
+};
+
+} // namespace Lua
+
+#endif // LUACPP_COROUTINEPOOL_HPP
\ No newline at end of file
@@ -0,0 +1,105 @@
+#ifndef LUACPP_EVENTLOOP_HPP
+#define LUACPP_EVENTLOOP_HPP
+
+#ifdef USE_CPP20_MODULES
+import luacpp.Scheduler;
+#else
+#include "Scheduler.hpp"
+#endif
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+struct lua_State;
+
+namespace Lua {
+
+/**
+ * @brief epoll based event loop which drives the coroutines of a Scheduler (Linux only)
+ *
+ * The loop registers these functions in the state, all of them yield the calling coroutine instead of blocking:
+ * - sleep(ms): continue the coroutine after the given time
+ * - after(ms, fn): start fn as new coroutine after the given time, can be called outside of coroutines as well
+ * - wait_readable(fd): continue the coroutine once the file descriptor is readable (or closed)
+ *
+ * All timers share one heap ordered by deadline and one timerfd armed for the earliest of them, so a sleeping coroutine
+ * costs a heap entry and no thread or file descriptor. Operations completed by other threads wake up the loop through
+ * an eventfd.
+*/
+class EventLoop {
+public:
+	using Clock = std::chrono::steady_clock;
+
+	explicit EventLoop(lua_State* state);
+	EventLoop(const EventLoop&) = delete;
+	~EventLoop();
+
+	EventLoop& operator=(const EventLoop&) = delete;
+
+	/**
+	 * @brief start the function below the given number of arguments on the stack as coroutine
+	 * @see Scheduler::spawn
+	*/
+	int spawn(int numArgs) { return m_scheduler.spawn(numArgs); }
+
+	/**
+	 * @brief process events until all coroutines and timers finished, stop was called or the timeout expired
+	 * @return true if there is nothing left to do
+	*/
+	bool run(std::chrono::milliseconds timeout);
+
+	/**
+	 * @brief make run return, can be called from any thread
+	*/
+	void stop();
+
+	/**
+	 * @brief the scheduler of the loop, e.g. to register further asynchronous functions
+	*/
+	Scheduler& getScheduler() { return m_scheduler; }
+
+	size_t getTimerCount() const { return m_timers.size(); }
+	size_t getWaitCount() const { return m_waits.size(); }
+
+private:
+	struct Timer {
+		Clock::time_point deadline;
+		uint64_t sequence; ///< keeps timers with the same deadline in the order they were added
+		Scheduler::Completion completion; ///< coroutine waiting in sleep
+		int callback; ///< reference of the function passed to after or LUA_NOREF
+
+		bool operator>(const Timer& other) const {
+			return deadline != other.deadline ? deadline > other.deadline : sequence > other.sequence;
+		}
+	};
+
+	static int sleep(lua_State* state);
+	static int after(lua_State* state);
+	static int waitReadable(lua_State* state);
+
+	void addTimer(double milliseconds, Scheduler::Completion completion, int callback);
+	void armTimer();
+	void expireTimers();
+	void wait(int timeout);
+	void wakeup();
+	bool isDone() const { return m_scheduler.getCoroutineCount() == 0 && m_timers.empty(); }
+
+	lua_State* m_state;
+	Scheduler m_scheduler;
+	int m_epoll = -1;
+	int m_timerFd = -1;
+	int m_eventFd = -1;
+	std::vector<Timer> m_timers; ///< min-heap by deadline
+	uint64_t m_nextSequence = 0;
+	Clock::time_point m_armed; ///< deadline the timerfd is set to, default constructed if it is disarmed
+	std::unordered_map<int, Scheduler::Completion> m_waits; ///< coroutines waiting in wait_readable by descriptor
+	std::atomic<bool> m_sleeping{false};
+	std::atomic<bool> m_stop{false};
+};
+
+} // namespace Lua
+
+#endif // LUACPP_EVENTLOOP_HPP
\ No newline at end of file
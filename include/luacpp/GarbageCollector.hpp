@@ -0,0 +1,147 @@
+#ifndef LUACPP_GARBAGECOLLECTOR_HPP
+#define LUACPP_GARBAGECOLLECTOR_HPP
+
+#ifdef USE_CPP20_MODULES
+import luacpp.Metrics;
+import luacpp.Tracer;
+#else
+#include "Metrics.hpp"
+#include "Tracer.hpp"
+#endif
+
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+
+struct lua_State;
+
+namespace Lua {
+
+/**
+ * @brief typed access to the garbage collector of a lua state (lua_gc)
+ *
+ * Besides switching the collector mode and tuning its parameters this class allows to perform garbage collection work
+ * explicitly, e.g. while the application is idle. All explicit work is accounted in the statistics of the instance.
+*/
+class GarbageCollector {
+public:
+	enum class Mode {
+		Incremental,
+		Generational
+	};
+
+	/**
+	 * @brief parameters of the incremental mode
+	 * A value of 0 keeps the currently configured value.
+	*/
+	struct IncrementalParameters {
+		int pause = 0; ///< how long the collector waits before starting a new cycle (in percent, lua default 200)
+		int stepMultiplier = 0; ///< speed of the collector relative to memory allocation (in percent, lua default 100)
+		int stepSize = 0; ///< size of each incremental step (log2 of bytes, lua default 13)
+	};
+
+	/**
+	 * @brief parameters of the generational mode
+	 * A value of 0 keeps the currently configured value.
+	*/
+	struct GenerationalParameters {
+		int minorMultiplier = 0; ///< frequency of minor collections (in percent, lua default 20)
+		int majorMultiplier = 0; ///< threshold for major collections (in percent, lua default 100)
+	};
+
+	/**
+	 * @brief counters of the work that was explicitly requested through this instance
+	*/
+	struct Statistics {
+		uint64_t collections = 0; ///< number of completed collection cycles
+		uint64_t steps = 0; ///< number of performed steps
+		uint64_t bytesFreed = 0; ///< number of bytes released by explicit collections and steps
+		std::chrono::nanoseconds stepTime{0}; ///< time spent in explicit collections and steps
+	};
+
+	GarbageCollector(lua_State* state);
+
+	/**
+	 * @brief switch to the incremental mode
+	 * @param parameters The parameters to apply
+	 * @return The mode that was active before
+	*/
+	Mode setIncremental(const IncrementalParameters& parameters);
+	Mode setIncremental() { return setIncremental(IncrementalParameters()); }
+
+	/**
+	 * @brief switch to the generational mode
+	 * @param parameters The parameters to apply
+	 * @return The mode that was active before
+	*/
+	Mode setGenerational(const GenerationalParameters& parameters);
+	Mode setGenerational() { return setGenerational(GenerationalParameters()); }
+
+	/**
+	 * @brief returns the mode that was last set through this instance
+	 * Lua doesn't provide a way to query the mode without changing it. States start in incremental mode.
+	*/
+	Mode getMode() const { return m_mode; }
+
+	/**
+	 * @brief stop the automatic collection
+	 * Explicit collections and steps are still possible while the collector is stopped.
+	*/
+	void stop();
+
+	/**
+	 * @brief restart the automatic collection
+	*/
+	void restart();
+
+	/**
+	 * @brief check if the automatic collection is running
+	*/
+	bool isRunning() const;
+
+	/**
+	 * @brief perform a full garbage collection cycle
+	*/
+	void collect();
+
+	/**
+	 * @brief perform a single step of garbage collection
+	 * @param kilobytes The amount of work to do (as if the given amount of memory was allocated). A value of 0 performs a basic step.
+	 * @return true if the step finished a collection cycle
+	*/
+	bool step(int kilobytes = 0);
+
+	/**
+	 * @brief perform basic steps until the budget is exhausted or a cycle finished
+	 * The budget is checked between two basic steps, so a single step may exceed it. At least one step is performed.
+	 * @param budget The time to spend in the garbage collector
+	 * @return true if a collection cycle was finished
+	*/
+	bool stepFor(std::chrono::microseconds budget);
+
+	/**
+	 * @brief returns the memory currently used by the lua state (in bytes)
+	*/
+	size_t getMemoryUsage() const;
+
+	const Statistics& getStatistics() const { return m_statistics; }
+	void resetStatistics() { m_statistics = Statistics(); }
+
+	/**
+	 * @brief report the explicit work and the heap size after it to the given metrics as well
+	*/
+	void setMetrics(std::shared_ptr<Metrics> metrics) { m_metrics = std::move(metrics); }
+
+private:
+	void account(size_t memoryBefore, std::chrono::steady_clock::duration duration, uint64_t steps, bool finishedCycle);
+
+	lua_State* m_state; ///< instance of the lua virtual machine
+	Mode m_mode; ///< mode that was set last
+	Statistics m_statistics; ///< counters of explicit work
+	std::shared_ptr<Metrics> m_metrics; ///< metrics of the state (optional)
+};
+
+} // namespace Lua
+
+#endif // LUACPP_GARBAGECOLLECTOR_HPP
\ No newline at end of file
@@ -0,0 +1,101 @@
+#ifndef LUACPP_HEAPSNAPSHOT_HPP
+#define LUACPP_HEAPSNAPSHOT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+struct lua_State;
+
+namespace Lua {
+
+/**
+ * @brief snapshot of the objects reachable in a lua state with their shallow and retained sizes
+ *
+ * capture walks the object graph breadth first, starting at _G and the registry. It follows table keys and values,
+ * metatables, upvalues of closures, user values of userdata and the stacks of suspended coroutines. The retained size
+ * of an object is the size of everything that would be freed with it, computed from the dominator tree of the graph.
+ *
+ * Objects are named by the shortest path leading to them (e.g. _G.cache.entries). Only objects up to a given depth are
+ * kept in the snapshot, deeper objects are accounted in the retained size of their dominators. This keeps the snapshot
+ * small enough to store and compare snapshots of long running states, diff shows which paths grew in between.
+ *
+ * The sizes are estimates for 64 bit builds of lua 5.4, lua doesn't expose the exact size of its objects. Function
+ * prototypes (bytecode) are not accounted.
+*/
+class HeapSnapshot {
+public:
+	struct Options {
+		size_t maxDepth = 6; ///< objects further away from the roots are not stored (but retained by their ancestors)
+		uint64_t minRetainedSize = 1024; ///< objects retaining less are not stored
+	};
+
+	struct Entry {
+		std::string path;
+		std::string type;
+		uint64_t shallowSize = 0;
+		uint64_t retainedSize = 0;
+		uint64_t retainedObjects = 0;
+	};
+
+	struct Change {
+		std::string path;
+		uint64_t before = 0; ///< retained size in the first snapshot
+		uint64_t after = 0; ///< retained size in the second snapshot
+
+		int64_t getGrowth() const { return static_cast<int64_t>(after) - static_cast<int64_t>(before); }
+	};
+
+	/**
+	 * @brief walk all objects reachable in the state
+	 * The garbage collector is stopped during the walk.
+	*/
+	static HeapSnapshot capture(lua_State* state);
+	static HeapSnapshot capture(lua_State* state, const Options& options);
+
+	/**
+	 * @brief compare the retained sizes of the paths in two snapshots
+	 * @return The paths whose retained size changed, the largest growth first
+	*/
+	static std::vector<Change> diff(const HeapSnapshot& before, const HeapSnapshot& after);
+
+	/**
+	 * @brief the stored objects sorted by retained size (descending)
+	*/
+	const std::vector<Entry>& getEntries() const { return m_entries; }
+
+	/**
+	 * @brief find the entry with the given path, returns null if it isn't stored
+	*/
+	const Entry* find(const std::string& path) const;
+
+	uint64_t getObjectCount() const { return m_objectCount; }
+	uint64_t getTotalSize() const { return m_totalSize; } ///< estimated size of all reachable objects
+	uint64_t getHeapSize() const { return m_heapSize; } ///< size of the heap reported by lua
+	double getCaptureSeconds() const { return m_captureSeconds; }
+
+	/**
+	 * @brief write the snapshot to a text file (one line per entry)
+	 * @return true on success
+	*/
+	bool write(const std::filesystem::path& path) const;
+
+	/**
+	 * @brief replace the content of this snapshot with one written by write
+	 * @return true on success
+	*/
+	bool read(const std::filesystem::path& path);
+
+private:
+	uint64_t m_objectCount = 0;
+	uint64_t m_totalSize = 0;
+	uint64_t m_heapSize = 0;
+	double m_captureSeconds = 0.0;
+	std::vector<Entry> m_entries;
+};
+
+} // namespace Lua
+
+#endif // LUACPP_HEAPSNAPSHOT_HPP
\ No newline at end of file
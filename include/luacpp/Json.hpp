@@ -0,0 +1,78 @@
+#ifndef LUACPP_JSON_HPP
+#define LUACPP_JSON_HPP
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+struct lua_State;
+
+namespace Lua {
+
+/**
+ * @brief conversion between JSON text and lua values
+ *
+ * The decoder builds the lua values directly on the stack of the state: elements of arrays and objects are collected on
+ * the stack and moved into a table which is created with the final size (large containers are filled in chunks).
+ * Strings without escape sequences are pushed straight from the input text.
+ *
+ * The encoder walks a value on the stack and appends the text to an output buffer.
+ *
+ * JSON null is represented by a light userdata holding a null pointer (see pushNull), so it can also be stored in arrays.
+*/
+class Json {
+public:
+	enum class ArrayDetection : uint8_t {
+		Sequence, ///< tables whose keys are exactly 1..n are encoded as arrays
+		Length, ///< tables with a length (#t) > 0 are encoded as arrays of their first #t elements, other keys are ignored
+		Never ///< all tables are encoded as objects
+	};
+
+	struct EncodeOptions {
+		ArrayDetection arrays = ArrayDetection::Sequence;
+		bool emptyTableAsArray = false; ///< encode empty tables as [] instead of {}
+		int precision = 0; ///< significant digits of floating point numbers, 0 for the shortest text that reads back exactly
+		bool cyclesAsNull = false; ///< encode tables which reference themselves as null instead of failing
+		uint32_t maxDepth = 128; ///< maximum nesting of tables
+	};
+
+	struct DecodeOptions {
+		uint32_t maxDepth = 512; ///< maximum nesting of arrays and objects
+	};
+
+	/**
+	 * @brief decode the given text and push the resulting value onto the stack
+	 * @param error Receives the description of the error if the text isn't valid JSON
+	 * @return true on success, false otherwise (nothing is pushed in this case)
+	*/
+	static bool decode(lua_State* state, std::string_view text, std::string& error);
+	static bool decode(lua_State* state, std::string_view text, std::string& error, const DecodeOptions& options);
+
+	/**
+	 * @brief encode the value at the given stack index
+	 * The stack is left unchanged.
+	 * @param out The text is appended to this string
+	 * @param error Receives the description of the error if the value can't be encoded
+	 * @return true on success, false otherwise (out may contain a partial result in this case)
+	*/
+	static bool encode(lua_State* state, int index, std::string& out, std::string& error);
+	static bool encode(lua_State* state, int index, std::string& out, std::string& error, const EncodeOptions& options);
+
+	static void pushNull(lua_State* state);
+	static bool isNull(lua_State* state, int index);
+
+	/**
+	 * @brief register the json library (json.decode, json.encode and json.null) as global table of the given state
+	 * json.encode accepts an optional table of options: arrays ("sequence", "length" or "never"), emptyArray (boolean),
+	 * precision (integer), cycles ("error" or "null") and maxDepth (integer).
+	*/
+	static void openLibrary(lua_State* state);
+
+private:
+	static int luaDecode(lua_State* state);
+	static int luaEncode(lua_State* state);
+};
+
+} // namespace Lua
+
+#endif // LUACPP_JSON_HPP
\ No newline at end of file
@@ -0,0 +1,200 @@
+#ifndef LUACPP_MEMOIZER_HPP
+#define LUACPP_MEMOIZER_HPP
+
+#ifdef USE_CPP20_MODULES
+import luacpp.State;
+#else
+#include "State.hpp"
+#endif
+
+#include <any>
+#include <cstdint>
+#include <cstring>
+#include <list>
+#include <map>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+
+namespace Lua {
+
+/**
+ * @brief bounded cache for the results of deterministic lua functions called from C++
+ *
+ * call works like State::executeFunctionAndReadReturnVal, but looks up the function name and the arguments
+ * (numbers, booleans and strings) in a cache first and returns a stored result without running the function. The
+ * cache holds at most capacity results and drops the least recently used one when it is full.
+ *
+ * Cached results are invalidated
+ * - when the global function is replaced, e.g. because the script defining it was reloaded. The memoizer keeps a
+ *   reference to each function it called, so a new function can't reuse the address of an old one.
+ * - by invalidate, which starts a new epoch. Use it when a function depends on data that changed.
+ *
+ * Only use it for functions whose result depends on nothing but their arguments and the data covered by the epoch.
+*/
+class Memoizer {
+public:
+	struct Statistics {
+		uint64_t hits = 0;
+		uint64_t misses = 0;
+		uint64_t evictions = 0; ///< results dropped to make room for new ones
+		uint64_t reloads = 0; ///< number of times a function was found replaced
+		uint64_t epochs = 0; ///< number of calls of invalidate
+		size_t size = 0;
+		size_t capacity = 0;
+
+		double getHitRate() const { return hits + misses > 0 ? static_cast<double>(hits) / static_cast<double>(hits + misses) : 0.0; }
+	};
+
+	explicit Memoizer(State& state, size_t capacity = 1024);
+	Memoizer(const Memoizer&) = delete;
+	~Memoizer();
+
+	Memoizer& operator=(const Memoizer&) = delete;
+
+	/**
+	 * @brief call the global function with the arguments, or return the cached result of an earlier call
+	 * @return 0 on success or the error code of the call, the error message is available with getLastError
+	*/
+	template <typename T, typename... Args>
+	int call(T& result, std::string_view name, Args... args) {
+		static_assert(std::is_arithmetic_v<T> || std::is_same_v<T, std::string>, "only numbers, booleans and strings can be cached");
+		const int status = pushFunction(name);
+		if (status != 0) {
+			return status;
+		}
+		//the key is written in place with its size known in advance, this is several times faster than appending
+		const uintptr_t type = reinterpret_cast<uintptr_t>(&TypeTag<T>);
+		m_key.resize(keySize(m_generation) + keySize(type) + (keySize(args) + ... + 0));
+		m_hash = 0;
+		char* out = writeKey(m_key.data(), m_generation);
+		out = writeKey(out, type);
+		((out = writeKey(out, args)), ...);
+		if (const std::any* cached = find()) {
+			result = std::any_cast<const T&>(*cached);
+			m_state.popStack(1);
+			return 0;
+		}
+
+		(m_state.pushToStack(args), ...);
+		const int callStatus = callFunction(static_cast<int>(sizeof...(args)));
+		if (callStatus == 0) {
+			result = m_state.getStackValue<T>(-1);
+			m_state.popStack(1);
+			insert(std::any(result));
+		}
+		return callStatus;
+	}
+
+	/**
+	 * @brief start a new epoch, results cached before are not used anymore
+	 * This is O(1), the outdated results are dropped as the cache fills up.
+	*/
+	void invalidate();
+
+	/**
+	 * @brief drop all cached results and the references to the functions
+	*/
+	void clear();
+
+	void setCapacity(size_t capacity);
+	uint64_t getEpoch() const { return m_epoch; }
+	Statistics getStatistics() const;
+	const std::string& getLastError() const { return m_lastError; }
+
+private:
+	struct Function {
+		int reference;
+		const void* pointer; ///< identity of the function, used to detect a replacement
+		uint64_t generation; ///< part of the cache key, changes when the function is replaced or a new epoch starts
+		uint64_t epoch;
+	};
+
+	struct Key {
+		std::string_view bytes;
+		size_t hash;
+
+		bool operator==(const Key& other) const { return bytes == other.bytes; }
+	};
+
+	struct KeyHash {
+		size_t operator()(const Key& key) const { return key.hash; }
+	};
+
+	struct Entry {
+		std::string key;
+		size_t hash;
+		std::any value;
+	};
+
+	template <typename T>
+	static constexpr char TypeTag = 0; ///< the address identifies the result type in the key
+
+	template <typename T>
+	static size_t keySize(const T& value) {
+		if constexpr (std::is_arithmetic_v<T>) {
+			return 1 + sizeof(uint64_t);
+		} else {
+			return 1 + sizeof(uint64_t) + std::string_view(value).size();
+		}
+	}
+
+	/**
+	 * @brief write a tagged value to the key and mix it into the hash
+	 * Numbers are stored with their bits, so 1 and 1.0 are different keys like they are different values for math.type.
+	*/
+	template <typename T>
+	char* writeKey(char* out, const T& value) {
+		uint64_t bits = 0;
+		char tag = 's';
+		if constexpr (std::is_same_v<T, bool>) {
+			bits = value ? 1 : 0;
+			tag = 'b';
+		} else if constexpr (std::is_integral_v<T>) {
+			bits = static_cast<uint64_t>(value);
+			tag = 'i';
+		} else if constexpr (std::is_floating_point_v<T>) {
+			const double number = static_cast<double>(value);
+			std::memcpy(&bits, &number, sizeof(bits));
+			tag = 'd';
+		}
+		if constexpr (!std::is_arithmetic_v<T>) {
+			const std::string_view text(value);
+			bits = text.size();
+			std::memcpy(out + 1 + sizeof(bits), text.data(), text.size());
+			mix(std::hash<std::string_view>()(text));
+		}
+		*out = tag;
+		std::memcpy(out + 1, &bits, sizeof(bits));
+		mix(bits);
+		return out + keySize(value);
+	}
+
+	void mix(uint64_t bits) {
+		m_hash = (m_hash ^ bits) * 0x9E3779B97F4A7C15ull;
+		m_hash ^= m_hash >> 29;
+	}
+
+	int pushFunction(std::string_view name);
+	int callFunction(int numArgs);
+	const std::any* find();
+	void insert(std::any value);
+
+	State& m_state;
+	size_t m_capacity;
+	uint64_t m_epoch = 0;
+	uint64_t m_nextGeneration = 0;
+	std::map<std::string, Function, std::less<>> m_functions;
+	std::list<Entry> m_entries; ///< most recently used first
+	std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> m_index; ///< keys point into the entries
+	std::string m_key; ///< key of the current call, reused to avoid allocations
+	uint64_t m_hash = 0;
+	uint64_t m_generation = 0; ///< generation of the function of the current call
+	std::string m_lastError;
+	Statistics m_statistics;
+};
+
+} // namespace Lua
+
+#endif // LUACPP_MEMOIZER_HPP
\ No newline at end of file
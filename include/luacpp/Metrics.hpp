@@ -0,0 +1,129 @@
+#ifndef LUACPP_METRICS_HPP
+#define LUACPP_METRICS_HPP
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace Lua {
+
+/**
+ * @brief operational counters of a state
+ *
+ * The state updates the counters while it works, other threads read them at any time with getSnapshot. All counters are
+ * relaxed atomics, so updating them costs a few increments per call and never blocks. A snapshot is consistent per
+ * counter but not across counters.
+*/
+class Metrics {
+public:
+	constexpr static size_t StatusCount = 6; ///< number of lua status codes (LUA_OK to LUA_ERRERR)
+
+	struct Snapshot {
+		uint64_t scriptLoads = 0; ///< scripts compiled (loadScript and loadAndExecuteScript)
+		std::chrono::nanoseconds compileTime{0}; ///< time spent compiling scripts
+		uint64_t calls = 0; ///< functions and scripts called
+		std::array<uint64_t, StatusCount> errors{}; ///< failed loads and calls by lua status code
+		uint64_t errorListSize = 0; ///< current size of the error list of the state
+		uint64_t heapBytes = 0; ///< memory used by the lua heap after the last call
+		uint64_t gcSteps = 0; ///< explicit garbage collection steps
+		uint64_t gcCollections = 0; ///< garbage collection cycles finished by explicit steps or collections
+		uint64_t nativeCalls = 0; ///< invocations of registered methods
+		std::chrono::nanoseconds nativeTime{0}; ///< time spent in registered methods
+
+		uint64_t getErrorCount() const;
+	};
+
+	Metrics() = default;
+	Metrics(const Metrics&) = delete;
+	Metrics& operator=(const Metrics&) = delete;
+
+	void recordLoad(int status, std::chrono::nanoseconds compileTime) {
+		m_scriptLoads.fetch_add(1, std::memory_order_relaxed);
+		m_compileTime.fetch_add(static_cast<uint64_t>(compileTime.count()), std::memory_order_relaxed);
+		recordStatus(status);
+	}
+
+	void recordCall(int status) {
+		m_calls.fetch_add(1, std::memory_order_relaxed);
+		recordStatus(status);
+	}
+
+	void recordNativeCall(std::chrono::nanoseconds time) {
+		m_nativeCalls.fetch_add(1, std::memory_order_relaxed);
+		m_nativeTime.fetch_add(static_cast<uint64_t>(time.count()), std::memory_order_relaxed);
+	}
+
+	void recordGarbageCollection(uint64_t steps, bool finishedCycle) {
+		m_gcSteps.fetch_add(steps, std::memory_order_relaxed);
+		if (finishedCycle) {
+			m_gcCollections.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+	void setErrorListSize(size_t size) { m_errorListSize.store(size, std::memory_order_relaxed); }
+	void setHeapBytes(size_t bytes) { m_heapBytes.store(bytes, std::memory_order_relaxed); }
+
+	Snapshot getSnapshot() const;
+	void reset();
+
+private:
+	void recordStatus(int status) {
+		if (status > 1 && static_cast<size_t>(status) < StatusCount) { //LUA_YIELD isn't an error
+			m_errors[status].fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+	std::atomic<uint64_t> m_scriptLoads{0};
+	std::atomic<uint64_t> m_compileTime{0};
+	std::atomic<uint64_t> m_calls{0};
+	std::array<std::atomic<uint64_t>, StatusCount> m_errors{};
+	std::atomic<uint64_t> m_errorListSize{0};
+	std::atomic<uint64_t> m_heapBytes{0};
+	std::atomic<uint64_t> m_gcSteps{0};
+	std::atomic<uint64_t> m_gcCollections{0};
+	std::atomic<uint64_t> m_nativeCalls{0};
+	std::atomic<uint64_t> m_nativeTime{0};
+};
+
+/**
+ * @brief exports the metrics of several states in the Prometheus text format
+ *
+ * States are added under a name which becomes the label state="name" of their samples. The exporter only keeps weak
+ * references, metrics of destroyed states are dropped from the next export. All methods may be called from any thread.
+*/
+class MetricsExporter {
+public:
+	void add(std::string name, std::weak_ptr<const Metrics> metrics);
+	void remove(const std::string& name);
+
+	/**
+	 * @brief render all metrics in the Prometheus text exposition format
+	*/
+	std::string toPrometheus() const;
+
+	/**
+	 * @brief write the metrics to a file, e.g. for the textfile collector of the node exporter
+	 * The content is written to a temporary file which then replaces the target, so readers never see a partial file.
+	 * @return true on success
+	*/
+	bool writePrometheus(const std::filesystem::path& path) const;
+
+private:
+	struct Entry {
+		std::string name;
+		std::weak_ptr<const Metrics> metrics;
+	};
+
+	mutable std::mutex m_mutex;
+	mutable std::vector<Entry> m_entries;
+};
+
+} // namespace Lua
+
+#endif // LUACPP_METRICS_HPP
\ No newline at end of file
@@ -0,0 +1,221 @@
+#ifndef LUACPP_NUMARRAY_HPP
+#define LUACPP_NUMARRAY_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+
+#if __has_include(<version>)
+	#include <version>
+	#ifdef __cpp_lib_span
+		#include <span>
+	#endif
+#endif
+
+struct lua_State;
+
+namespace Lua {
+
+/**
+ * @brief contiguous array of numbers which can be processed by lua scripts without boxing every element
+ *
+ * The elements are stored as float64, float32 or int64. The builtin kernels (sum, min, max, dot, axpy, elementwise
+ * arithmetic and comparisons) use SIMD instructions if the cpu supports them (AVX2 + FMA, selected at runtime) and
+ * fall back to portable loops otherwise. Elementwise operations work in place.
+ *
+ * Scripts create arrays through the numarray library (see openLibrary):
+ * - numarray.new(n [, type]) creates a zero initialized array, type is "f64" (default), "f32" or "i64"
+ * - numarray.from(table [, type]) copies the sequence of a table
+ * - #a, a[i], a[i] = v, a:type(), a:fill(v), a:copy(), a:totable()
+ * - a:sum(), a:mean(), a:min(), a:max(), a:dot(b)
+ * - a:axpy(alpha, x) computes a = a + alpha * x, a:scale(s) computes a = a * s
+ * - a:add(b), a:sub(b), a:mul(b), a:div(b) with b being an array or a number (in place, returns a)
+ * - a:lt(b), a:le(b), a:gt(b), a:ge(b), a:eq(b), a:ne(b) return a new int64 mask of 0 and 1
+*/
+class NumArray {
+public:
+	enum class ElementType : uint8_t {
+		Float64,
+		Float32,
+		Int64
+	};
+
+	enum class Operation : uint8_t {
+		Add,
+		Subtract,
+		Multiply,
+		Divide
+	};
+
+	enum class Comparison : uint8_t {
+		Less,
+		LessEqual,
+		Greater,
+		GreaterEqual,
+		Equal,
+		NotEqual
+	};
+
+	/**
+	 * @brief create a zero initialized array
+	*/
+	NumArray(ElementType type, size_t size);
+	~NumArray();
+	NumArray(const NumArray&) = delete;
+	NumArray& operator=(const NumArray&) = delete;
+
+	/**
+	 * @brief create an array holding a copy of the given data (T is double, float or int64_t)
+	*/
+	template <typename T>
+	static std::shared_ptr<NumArray> create(const T* data, size_t size) {
+		return create(elementTypeOf<T>(), data, size);
+	}
+
+#ifdef __cpp_lib_span
+	template <typename T>
+	static std::shared_ptr<NumArray> create(std::span<const T> data) { return create(data.data(), data.size()); }
+
+	/**
+	 * @brief access the elements without copying them
+	 * @throws std::invalid_argument if T doesn't match the element type
+	*/
+	template <typename T>
+	std::span<T> span() { return std::span<T>(data<T>(), m_size); }
+	template <typename T>
+	std::span<const T> span() const { return std::span<const T>(data<T>(), m_size); }
+#endif
+
+	/**
+	 * @brief access the elements without copying them
+	 * @throws std::invalid_argument if T doesn't match the element type
+	*/
+	template <typename T>
+	T* data() { checkType(elementTypeOf<T>()); return static_cast<T*>(m_data); }
+	template <typename T>
+	const T* data() const { checkType(elementTypeOf<T>()); return static_cast<const T*>(m_data); }
+
+	ElementType getType() const { return m_type; }
+	size_t size() const { return m_size; }
+
+	double get(size_t index) const;
+	void set(size_t index, double value);
+	void fill(double value);
+	std::shared_ptr<NumArray> copy() const;
+
+	double sum() const;
+	double min() const; ///< NaN for empty arrays
+	double max() const; ///< NaN for empty arrays
+
+	/**
+	 * @throws std::invalid_argument if the arrays differ in type or size (the same applies to all binary operations)
+	*/
+	double dot(const NumArray& other) const;
+
+	/**
+	 * @brief computes this = this + alpha * x
+	*/
+	void axpy(double alpha, const NumArray& x);
+	void scale(double factor) { apply(Operation::Multiply, factor); }
+
+	/**
+	 * @brief elementwise operation in place (this = this op other)
+	 * @throws std::domain_error on integer division by zero, the array is left unchanged
+	*/
+	void apply(Operation op, const NumArray& other);
+	void apply(Operation op, double value);
+
+	/**
+	 * @brief elementwise comparison (this cmp other) into a new int64 array of 0 and 1
+	 * The elements of int64 arrays are compared exactly with integral values, also above 2^53.
+	*/
+	std::shared_ptr<NumArray> compare(Comparison cmp, const NumArray& other) const;
+	std::shared_ptr<NumArray> compare(Comparison cmp, double value) const;
+
+	/**
+	 * @brief returns the instruction set used by the kernels ("avx2" or "scalar")
+	*/
+	static const char* getInstructionSet();
+
+	/**
+	 * @brief enable or disable the SIMD kernels (they are only enabled if the cpu supports them)
+	 * Mainly useful to compare the results and the performance of both implementations.
+	*/
+	static void setSimdEnabled(bool enabled);
+
+	/**
+	 * @brief push the array as userdata onto the stack of the given state
+	 * The array is shared, modifications done by lua are visible in C++ and vice versa.
+	*/
+	static void push(lua_State* state, std::shared_ptr<NumArray> array);
+
+	/**
+	 * @brief returns the array at the given stack index (null if the value isn't an array)
+	*/
+	static std::shared_ptr<NumArray> fromStack(lua_State* state, int index);
+
+	/**
+	 * @brief register the numarray library as global table of the given state
+	*/
+	static void openLibrary(lua_State* state);
+
+private:
+	template <typename T>
+	constexpr static ElementType elementTypeOf() {
+		if constexpr (std::is_same_v<T, double>) {
+			return ElementType::Float64;
+		} else if constexpr (std::is_same_v<T, float>) {
+			return ElementType::Float32;
+		} else if constexpr (std::is_same_v<T, int64_t>) {
+			return ElementType::Int64;
+		} else {
+			static_assert(sizeof(T) != sizeof(T), "Unsupported element type");
+		}
+	}
+
+	static std::shared_ptr<NumArray> create(ElementType type, const void* data, size_t size);
+	static void* allocate(ElementType type, size_t size);
+	static size_t elementSize(ElementType type);
+
+	void checkType(ElementType type) const;
+	void checkCompatible(const NumArray& other) const;
+	bool applyUnchecked(Operation op, const NumArray* other, double value);
+	bool applyInteger(Operation op, int64_t value); ///< int64 arrays only, the value isn't converted to double
+	void compareUnchecked(Comparison cmp, const NumArray* other, double value, NumArray& mask) const;
+	void compareInteger(Comparison cmp, int64_t value, NumArray& mask) const; ///< int64 arrays only, like applyInteger
+
+	static NumArray* checkArray(lua_State* state, int index);
+	static NumArray* pushNew(lua_State* state, ElementType type, size_t size);
+	static void pushElement(lua_State* state, const NumArray& array, size_t index);
+	static void pushMetaTable(lua_State* state);
+	static int luaNew(lua_State* state);
+	static int luaFrom(lua_State* state);
+	static int index(lua_State* state);
+	static int newIndex(lua_State* state);
+	static int len(lua_State* state);
+	static int type(lua_State* state);
+	static int luaFill(lua_State* state);
+	static int luaCopy(lua_State* state);
+	static int toTable(lua_State* state);
+	static int luaSum(lua_State* state);
+	static int mean(lua_State* state);
+	static int luaMin(lua_State* state);
+	static int luaMax(lua_State* state);
+	static int luaDot(lua_State* state);
+	static int luaAxpy(lua_State* state);
+	static int luaScale(lua_State* state);
+	template <Operation Op>
+	static int luaApply(lua_State* state);
+	template <Comparison Cmp>
+	static int luaCompare(lua_State* state);
+	static int gc(lua_State* state);
+
+	ElementType m_type; ///< type of the elements
+	size_t m_size; ///< number of elements
+	void* m_data; ///< 32 byte aligned storage of the elements
+};
+
+} // namespace Lua
+
+#endif // LUACPP_NUMARRAY_HPP
\ No newline at end of file
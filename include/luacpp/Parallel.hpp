@@ -0,0 +1,215 @@
+#ifndef LUACPP_PARALLEL_HPP
+#define LUACPP_PARALLEL_HPP
+
+#ifdef USE_CPP20_MODULES
+import luacpp.State;
+#else
+#include "State.hpp"
+#endif
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+struct lua_State;
+
+namespace Lua {
+
+/**
+ * @brief a group of states, one per thread, which apply lua functions to large inputs in parallel
+ *
+ * Each worker owns a state which is created on first use by the thread running the worker and prepared by the setup
+ * function (e.g. loading the scripts defining the functions). The states are kept, so further calls reuse them.
+ *
+ * The input is split into chunks which the threads take one after the other, so slow chunks don't stall the others.
+ * A chunk is passed to lua in a table and the function is applied to all its elements by a small lua loop, which means
+ * one protected call per chunk instead of one per element. The tables are reused for every chunk.
+ *
+ * Use parallelMap and parallelReduce to run a function on all workers.
+*/
+class Workers {
+public:
+	using Setup = std::function<void(State&)>;
+
+	struct Options {
+		State::Library libraries = State::LibAll; ///< libraries opened when a worker state is created
+		size_t threads = 0; ///< number of threads (including the calling thread), 0 uses one per core
+		size_t chunkSize = 0; ///< number of elements passed to lua at once, 0 chooses it from the size of the input
+	};
+
+	/**
+	 * @brief the state of one worker thread
+	 * The bottom of the stack holds the tables of the chunk and must not be changed by the setup function.
+	*/
+	class Worker {
+	public:
+		explicit Worker(const Options& options, const Setup& setup);
+
+		State& getState() { return m_state; }
+		const std::string& getLastError() const { return m_lastError; }
+
+		/**
+		 * @brief store a value of the chunk in the input table
+		 * @param index Index of the element in the chunk (starting at 1)
+		*/
+		template <typename T>
+		void setInput(size_t index, const T& value) {
+			if constexpr (std::is_same_v<T, std::string>) {
+				Basics::pushToStack<std::string_view>(m_state.getState(), value);
+			} else {
+				Basics::pushToStack<T>(m_state.getState(), value);
+			}
+			storeInput(index);
+		}
+
+		/**
+		 * @brief read a result of the chunk from the output table
+		 * @param index Index of the element in the chunk (starting at 1)
+		*/
+		template <typename R>
+		R getOutput(size_t index) {
+			loadOutput(index);
+			R result = getTop<R>();
+			m_state.popStack(1);
+			return result;
+		}
+
+		/**
+		 * @brief apply the global function to the first count elements of the input table
+		 * The results are stored in the output table.
+		*/
+		int map(const char* function, size_t count);
+
+		/**
+		 * @brief fold the first count elements of the input table with the global function
+		 * The function is called as function(accumulator, value) and returns the new accumulator. The initial
+		 * accumulator is expected on top of the stack and replaced by the result on success (popped otherwise).
+		*/
+		int reduce(const char* function, size_t count);
+
+		template <typename R>
+		R getTop() {
+			if constexpr (std::is_same_v<R, std::string>) {
+				size_t len = 0;
+				const char* str = Basics::asString(m_state.getState(), -1, &len);
+				return str != nullptr ? std::string(str, len) : std::string();
+			} else {
+				return Basics::getStackValue<R>(m_state.getState(), -1);
+			}
+		}
+
+	private:
+		void storeInput(size_t index);
+		void loadOutput(size_t index);
+		int call(const char* function, int driver, int numArgs, int numResults);
+
+		State m_state;
+		std::string m_lastError;
+	};
+
+	/**
+	 * @brief work on a chunk, the arguments are the worker, the index of the chunk and the range of elements
+	 * @return 0 on success, the lua error code otherwise
+	*/
+	using ChunkFunction = std::function<int(Worker&, size_t, size_t, size_t)>;
+
+	Workers(Setup setup);
+	Workers(Setup setup, const Options& options);
+	Workers(const Workers&) = delete;
+	~Workers();
+
+	Workers& operator=(const Workers&) = delete;
+
+	/**
+	 * @brief split count elements into chunks and process them on all workers
+	 * The calling thread works on chunks as well. Once a chunk failed, no further chunks are started.
+	 * @return 0 if all chunks were processed, the error code of the first failed chunk otherwise
+	*/
+	int forEachChunk(size_t count, const ChunkFunction& function);
+
+	/**
+	 * @brief the number of elements per chunk for an input of the given size
+	*/
+	size_t getChunkSize(size_t count) const;
+	size_t getChunkCount(size_t count) const;
+
+	size_t getThreadCount() const { return m_workers.size(); }
+
+	/**
+	 * @brief the error message of the first chunk which failed in the last call
+	*/
+	const std::string& getLastError() const { return m_lastError; }
+
+private:
+	void work(size_t worker, size_t count, const ChunkFunction& function, std::atomic<size_t>& next, std::atomic<bool>& failed, int& status);
+
+	Setup m_setup;
+	Options m_options;
+	std::vector<std::unique_ptr<Worker>> m_workers;
+	std::mutex m_mutex; ///< protects the error of the current call
+	std::string m_lastError;
+};
+
+/**
+ * @brief apply a global lua function to every element of the input on all workers
+ * The results are stored in order, output[i] is function(input[i]).
+ * @return 0 on success, the lua error code otherwise (the error message is available from the workers)
+*/
+template <typename R, typename T>
+int parallelMap(Workers& workers, const char* function, const std::vector<T>& input, std::vector<R>& output) {
+	static_assert(!std::is_same_v<R, bool>, "std::vector<bool> can't be written by several threads, use another type");
+	output.resize(input.size());
+	return workers.forEachChunk(input.size(), [&](Workers::Worker& worker, size_t, size_t begin, size_t end) {
+		for (size_t i = begin; i < end; ++i) {
+			worker.setInput(i - begin + 1, input[i]);
+		}
+		const int status = worker.map(function, end - begin);
+		if (status == 0) {
+			for (size_t i = begin; i < end; ++i) {
+				output[i] = worker.getOutput<R>(i - begin + 1);
+			}
+		}
+		return status;
+	});
+}
+
+/**
+ * @brief fold the input with a global lua function on all workers and combine the partial results
+ * Every chunk is folded by lua starting with init as function(accumulator, value). The partial results of the chunks
+ * are then combined in order on the calling thread with combine(result, partial), starting with init as well. So init
+ * has to be neutral for both functions (e.g. 0 for a sum).
+ * @return 0 on success, the lua error code otherwise (the error message is available from the workers)
+*/
+template <typename R, typename T, typename Combine>
+int parallelReduce(Workers& workers, const char* function, const std::vector<T>& input, R init, Combine combine, R& result) {
+	static_assert(!std::is_same_v<R, bool>, "std::vector<bool> can't be written by several threads, use another type");
+	std::vector<R> partials(workers.getChunkCount(input.size()), init);
+	const int status = workers.forEachChunk(input.size(), [&](Workers::Worker& worker, size_t chunk, size_t begin, size_t end) {
+		for (size_t i = begin; i < end; ++i) {
+			worker.setInput(i - begin + 1, input[i]);
+		}
+		worker.getState().pushToStack(init);
+		const int status = worker.reduce(function, end - begin);
+		if (status == 0) {
+			partials[chunk] = worker.getTop<R>();
+			worker.getState().popStack(1);
+		}
+		return status;
+	});
+	if (status == 0) {
+		result = init;
+		for (R& partial : partials) {
+			result = combine(std::move(result), std::move(partial));
+		}
+	}
+	return status;
+}
+
+} // namespace Lua
+
+#endif // LUACPP_PARALLEL_HPP
\ No newline at end of file
@@ -12,6 +12,7 @@ import luacpp.Table;
 #endif
 
 #include <string>
+#include <string_view>
 #include <map>
 
 struct lua_State;
@@ -44,6 +45,36 @@ public:
 		return res;
 	}
 
+	/**
+	 * @brief load precompiled bytecode (see compile) and store the resulting function under the given key
+	 * An existing entry is only replaced if the bytecode could be loaded.
+	*/
+	template <typename T>
+	ErrorCode loadBytecode(T key, std::string_view bytecode, const char* chunkName) {
+		ErrorCode res = loadBinary(m_state, bytecode, chunkName);
+		if (res == ErrorCode::Ok) {
+			Basics::pushToStack(m_state, key);
+			Basics::insert(m_state, -2);
+			setTableRaw(m_state, m_tableIndex);
+		}
+		return res;
+	}
+
+	/**
+	 * @brief compile the given source into bytecode which can be loaded with loadBytecode
+	 * Compilation uses a temporary state, so it can run on any thread without touching an existing state.
+	 * @param error Receives the message of the compiler if the source is invalid
+	*/
+	static ErrorCode compile(std::string_view src, const char* chunkName, std::string& bytecode, std::string& error);
+
+	/**
+	 * @brief compile the given source on a scratch state owned by the caller
+	 * Reusing the scratch state avoids creating a state per script when many scripts are compiled. The stack of the
+	 * scratch state is left unchanged.
+	 * @param strip Leave out the debug information (line numbers, names of locals and upvalues)
+	*/
+	static ErrorCode compile(lua_State* scratch, std::string_view src, const char* chunkName, std::string& bytecode, std::string& error, bool strip = false);
+
 	ErrorCode getScript(Generic key);
 	
 	template <typename T>
@@ -59,6 +90,7 @@ public:
 
 private:
 	static ErrorCode loadString(lua_State* state, const char* src);
+	static ErrorCode loadBinary(lua_State* state, std::string_view bytecode, const char* chunkName);
 	static bool isUserDefinedEntry(const Registry& registry);
 	static void copyEntry(lua_State* src, lua_State* dst);	
 };
@@ -0,0 +1,130 @@
+#ifndef LUACPP_SANDBOX_HPP
+#define LUACPP_SANDBOX_HPP
+
+#ifdef USE_CPP20_MODULES
+import luacpp.Basics;
+import luacpp.Registry;
+#else
+#include "Basics.hpp"
+#include "Registry.hpp"
+#endif
+
+#include <string>
+#include <vector>
+
+struct lua_State;
+
+namespace Lua {
+
+/**
+ * @brief isolated global environment of a tenant inside a shared state
+ *
+ * Each sandbox owns an _ENV table for the globals of its tenant. Globals which aren't defined by the tenant are looked
+ * up in the shared view of the state (see share), which only contains the whitelisted globals. Tables of the view are
+ * replaced by read-only userdata proxies, also when reached through other tables, so a tenant can't modify the
+ * libraries used by the others, not even with rawset. All sandboxes of a state use the same metatable, a sandbox costs
+ * its _ENV table and an empty closure (the anchor) holding an upvalue bound to it.
+ *
+ * Functions run in a sandbox by joining their _ENV upvalue to the upvalue of the anchor for the duration of the call
+ * (lua_upvaluejoin), so registry scripts are compiled once and executed by every tenant. Closures created during the
+ * call share the upvalue of the anchor and keep resolving globals in the sandbox which created them, the function
+ * itself gets its own upvalue back afterwards. Stripped bytecode has no upvalue names, so apart from main chunks (whose
+ * only upvalue is _ENV) stripped functions with upvalues are refused.
+ *
+ * Note that the whitelist must not contain functions which reach the global table of the state or the original tables,
+ * like load without an environment, require, dofile, getmetatable (the string metatable refers to the string library)
+ * or the debug library.
+*/
+class Sandbox {
+public:
+	/**
+	 * @brief define the globals of the state that are visible in all of its sandboxes
+	 * Tables are wrapped in read-only proxies (userdata supporting indexing, # and pairs), tables read through a proxy
+	 * are wrapped as well. Other values are shared as they are. Calling it again replaces the view for all existing
+	 * sandboxes.
+	*/
+	static void share(lua_State* state, const std::vector<std::string>& globals);
+
+	explicit Sandbox(lua_State* state);
+	Sandbox(const Sandbox&) = delete;
+	Sandbox(Sandbox&& mv);
+	~Sandbox();
+
+	Sandbox& operator=(const Sandbox&) = delete;
+
+	/**
+	 * @brief call the function below the given number of arguments on the stack inside the sandbox
+	 * Like lua_pcall the function and arguments are replaced by the results, on errors nothing is left on the stack and
+	 * the message can be read with getLastError. Lua functions whose _ENV upvalue can't be identified aren't called.
+	 * @return The status of the lua virtual machine
+	*/
+	int call(int numArgs, int numResults);
+
+	/**
+	 * @brief execute a script of the registry inside the sandbox
+	*/
+	template <typename T>
+	int executeScript(T key) {
+		Registry registry(m_state);
+		if (registry.getScript(key) != Registry::ErrorCode::Ok) {
+			m_lastError = "script not found";
+			return static_cast<int>(Registry::ErrorCode::RuntimeError);
+		}
+		return call(0, 0);
+	}
+
+	int loadAndExecuteScript(const char* code);
+
+	template <typename T>
+	T readVariable(const char* name) {
+		pushVariable(name);
+		T value = Basics::getStackValue<T>(m_state, -1);
+		Basics::popStack(m_state, 1);
+		return value;
+	}
+
+	template <typename T>
+	void writeVariable(const char* name, T value) {
+		Basics::pushToStack(m_state, value);
+		setVariableFromStack(name);
+	}
+
+	/**
+	 * @brief remove all globals of the tenant
+	 * The _ENV table is cleared in place, so functions created by the tenant keep referring to it.
+	*/
+	void reset();
+
+	/**
+	 * @brief number of globals defined by the tenant
+	*/
+	size_t size() const;
+
+	void pushEnvironment() const;
+	const std::string& getLastError() const { return m_lastError; }
+
+private:
+	constexpr static const char* const MetaTableName = "luacpp.Sandbox";
+	constexpr static const char* const ProxyMetaTableName = "luacpp.Sandbox.proxy";
+
+	static void pushMetaTable(lua_State* state);
+	static void pushProxy(lua_State* state, int index); ///< the proxy of the table at the given index, one per table
+	static int readOnlyError(lua_State* state);
+	static int proxyIndex(lua_State* state);
+	static int proxyLen(lua_State* state);
+	static int proxyPairs(lua_State* state);
+	static int proxyNext(lua_State* state);
+
+	void popError();
+	void pushVariable(const char* name);
+	void setVariableFromStack(const char* name);
+
+	lua_State* m_state;
+	int m_reference; ///< reference of the _ENV table in the registry
+	int m_anchor; ///< reference of the closure whose upvalue is bound to the _ENV table
+	std::string m_lastError;
+};
+
+} // namespace Lua
+
+#endif // LUACPP_SANDBOX_HPP
\ No newline at end of file
@@ -0,0 +1,197 @@
+#ifndef LUACPP_SCHEDULER_HPP
+#define LUACPP_SCHEDULER_HPP
+
+#ifdef USE_CPP20_MODULES
+import luacpp.Generic;
+#else
+#include "Generic.hpp"
+#endif
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct lua_State;
+
+namespace Lua {
+
+/**
+ * @brief runs lua coroutines which wait for asynchronous native operations
+ *
+ * An asynchronous native function starts an operation and yields the calling coroutine (lua_yieldk) instead of blocking
+ * the thread. The operation is finished through a Completion from any thread; the next poll resumes the coroutine on
+ * the thread of the state with the results, or raises the error message of a rejected operation as lua error at the
+ * call site. So one thread can serve any number of outstanding slow operations.
+ *
+ * There are two ways to write asynchronous functions:
+ * - registerFunction registers a std::function which receives the arguments and a Completion.
+ * - functions registered with State::registerNativeFunction call begin and return yield, or return await with a future:
+ * @code
+ * int fetch(lua_State* L) {
+ *     {
+ *         Lua::Scheduler::Completion completion = Lua::Scheduler::begin(L);
+ *         startRequest(lua_tostring(L, 1), completion); //calls completion.resolve({...}) when done
+ *     }
+ *     return Lua::Scheduler::yield(L);
+ * }
+ * @endcode
+ * Like luaL_error, yield doesn't return, so no C++ objects with destructors may be alive in the calling function.
+ *
+ * Asynchronous functions can only be called from coroutines started with spawn. Coroutines which yield by other means
+ * (e.g. coroutine.yield) are resumed by the next poll. There can be one scheduler per state, which must not outlive it.
+*/
+class Scheduler {
+public:
+	using Values = std::vector<Generic>;
+
+	class Completion {
+	public:
+		Completion() = default;
+
+		/**
+		 * @brief finish the operation, the coroutine continues with the given values as results of the call
+		 * Only the first call of resolve or reject has an effect. Can be called from any thread.
+		*/
+		void resolve(Values results = Values()) const;
+
+		/**
+		 * @brief finish the operation with an error which is raised in the coroutine
+		*/
+		void reject(std::string message) const;
+
+		bool isPending() const;
+
+	private:
+		friend class Scheduler;
+		struct Operation;
+
+		explicit Completion(std::shared_ptr<Operation> operation) : m_operation(std::move(operation)) {}
+
+		std::shared_ptr<Operation> m_operation;
+	};
+
+	using AsyncFunction = std::function<void(Values arguments, Completion completion)>;
+
+	explicit Scheduler(lua_State* state);
+	Scheduler(const Scheduler&) = delete;
+	~Scheduler();
+
+	Scheduler& operator=(const Scheduler&) = delete;
+
+	/**
+	 * @brief start the function below the given number of arguments on the stack as coroutine
+	 * The coroutine runs until it finishes or waits for an operation for the first time.
+	 * @return The status of the coroutine (0 if it finished, LUA_YIELD if it is suspended or the error code)
+	*/
+	int spawn(int numArgs);
+
+	/**
+	 * @brief resume all coroutines whose operations completed or which yielded by other means
+	 * @return The number of coroutines resumed
+	*/
+	size_t poll();
+
+	/**
+	 * @brief poll until all coroutines finished or the timeout expired
+	 * The thread sleeps while no operation completes.
+	 * @return true if all coroutines finished
+	*/
+	bool run(std::chrono::milliseconds timeout);
+
+	/**
+	 * @brief register a global lua function which calls the given function and waits for its completion
+	 * Exceptions thrown by the function reject the operation (with the message "unknown exception" if they aren't
+	 * derived from std::exception).
+	*/
+	void registerFunction(const char* name, AsyncFunction function);
+
+	/**
+	 * @brief set a function which is called whenever an operation completes
+	 * It is called on the completing thread (with an internal lock held), so it should only wake up the thread of the
+	 * state, e.g. to integrate the scheduler into an event loop.
+	*/
+	void setNotifier(std::function<void()> notifier);
+
+	/**
+	 * @brief true if poll would resume a coroutine now
+	*/
+	bool hasWork() const;
+
+	/**
+	 * @brief number of futures passed to await which poll has to check
+	*/
+	size_t getFutureCount() const { return m_futures.size(); }
+
+	/**
+	 * @brief number of coroutines which didn't finish yet
+	*/
+	size_t getCoroutineCount() const { return m_coroutines.size(); }
+
+	/**
+	 * @brief errors of coroutines which failed
+	*/
+	const std::vector<std::string>& getErrorList() const { return m_errorList; }
+	void clearErrorList() { m_errorList.clear(); }
+
+	/**
+	 * @brief start an operation for the running coroutine
+	 * Raises a lua error if the coroutine wasn't started by the scheduler of the state.
+	*/
+	static Completion begin(lua_State* state);
+
+	/**
+	 * @brief suspend the running coroutine until the operation started with begin completed
+	 * Has to be used as return expression of a lua_CFunction.
+	*/
+	static int yield(lua_State* state);
+
+	/**
+	 * @brief suspend the running coroutine until the future is ready
+	 * The future is checked by poll, an exception of the future rejects the operation.
+	*/
+	static int await(lua_State* state, std::future<Values> future);
+
+	static Scheduler* fromState(lua_State* state);
+
+	/**
+	 * @brief raise a lua error unless the running coroutine was started by the scheduler of the state and can yield
+	 * Lets asynchronous functions check this before they acquire resources which begin would leak.
+	*/
+	static Scheduler* checkAwaitable(lua_State* state);
+
+private:
+	struct Core;
+	struct Result;
+
+	struct PendingFuture {
+		std::future<Values> future;
+		Completion completion;
+	};
+
+	static int dispatch(lua_State* state);
+	static int continuation(lua_State* state, int status, intptr_t base);
+
+	int resume(lua_State* thread, int numArgs);
+	void finish(lua_State* thread);
+	void pollFutures();
+
+	lua_State* m_state;
+	std::shared_ptr<Core> m_core; ///< shared with the operations, so they can be completed after the scheduler is gone
+	std::map<lua_State*, int> m_coroutines; ///< suspended coroutines and their references in the registry
+	std::vector<lua_State*> m_ready; ///< coroutines which yielded without waiting for an operation
+	std::vector<PendingFuture> m_futures;
+	std::vector<AsyncFunction> m_functions;
+	std::vector<std::string> m_errorList;
+	lua_State* m_awaiting = nullptr; ///< set by begin while a coroutine runs, so resume knows why it yielded
+};
+
+} // namespace Lua
+
+#endif // LUACPP_SCHEDULER_HPP
\ No newline at end of file
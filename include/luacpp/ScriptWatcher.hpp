@@ -0,0 +1,121 @@
+#ifndef LUACPP_SCRIPTWATCHER_HPP
+#define LUACPP_SCRIPTWATCHER_HPP
+
+#ifdef USE_CPP20_MODULES
+import luacpp.Registry;
+#else
+#include "Registry.hpp"
+#endif
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+
+struct lua_State;
+
+namespace Lua {
+
+/**
+ * @brief reloads registry scripts when the files backing them change
+ *
+ * Every watched file is bound to a key of the registry (see Registry::loadScript). When a file changes, only this file
+ * is compiled again, either by the background thread (see start) or by check. Compilation happens on a temporary state
+ * and produces bytecode, so the states running the scripts aren't touched. If the new version doesn't compile, the
+ * previous bytecode stays in place and the error can be queried with getError.
+ *
+ * States pick up new versions with apply, which should be called between calls (e.g. before executeScript). If nothing
+ * changed, apply is a single atomic load and a registry lookup; otherwise it loads the new bytecode and replaces the
+ * registry entries. The watcher has to outlive the states it applies to, or they must not call apply anymore.
+ *
+ * On Linux the files are watched with inotify, elsewhere (or if inotify is not available) the modification times and
+ * sizes of the files are polled in the configured interval.
+*/
+class ScriptWatcher {
+public:
+	struct Options {
+		std::chrono::milliseconds pollInterval{500}; ///< interval for polling the files if inotify isn't used
+		bool useInotify = true; ///< use inotify on Linux instead of polling
+	};
+
+	ScriptWatcher();
+	explicit ScriptWatcher(const Options& options);
+	~ScriptWatcher();
+
+	ScriptWatcher(const ScriptWatcher&) = delete;
+	ScriptWatcher& operator=(const ScriptWatcher&) = delete;
+
+	/**
+	 * @brief bind the given file to a registry key and compile it
+	 * Watching a key again replaces its file.
+	 * @return Ok if the file was compiled, the error otherwise (the key is watched anyway and loaded once it compiles)
+	*/
+	Registry::ErrorCode watch(const std::string& key, const std::filesystem::path& path);
+	void unwatch(const std::string& key);
+
+	/**
+	 * @brief start the background thread which recompiles changed files
+	*/
+	void start();
+	void stop();
+	bool isRunning() const { return m_thread.joinable(); }
+
+	/**
+	 * @brief compile all files that changed since the last check on the calling thread
+	 * @return The number of files compiled successfully
+	*/
+	size_t check();
+
+	/**
+	 * @brief install the newest versions of all watched scripts into the registry of the given state
+	 * @return The number of scripts replaced
+	*/
+	size_t apply(lua_State* state);
+
+	/**
+	 * @brief changes each time a file was compiled successfully
+	*/
+	uint64_t getVersion() const { return m_version.load(std::memory_order_acquire); }
+	std::string getError(const std::string& key) const;
+	bool isUsingInotify() const { return m_inotify >= 0; }
+
+private:
+	struct Script {
+		std::filesystem::path path;
+		std::filesystem::path absolutePath; ///< matched against the names reported by inotify
+		std::string chunkName; ///< "@path", used in error messages and tracebacks
+		std::filesystem::file_time_type modified;
+		uintmax_t fileSize = 0;
+		std::shared_ptr<const std::string> bytecode; ///< newest version that compiled, null if none did so far
+		uint64_t version = 0; ///< increasing number assigned when the bytecode was compiled
+		std::string error;
+	};
+
+	size_t compileChanged(const std::set<std::filesystem::path>& touched);
+	Registry::ErrorCode compileScript(const std::string& key);
+	void watchDirectory(const std::filesystem::path& path);
+	void run();
+
+	Options m_options;
+	mutable std::mutex m_mutex; ///< protects m_scripts, held only to copy or swap entries
+	std::mutex m_compileMutex; ///< serializes check and the background thread
+	std::map<std::string, Script> m_scripts;
+	std::atomic<uint64_t> m_version{0};
+	int m_inotify = -1;
+	int m_wakeup[2] = {-1, -1}; ///< pipe to interrupt the background thread waiting for inotify events
+	std::map<int, std::filesystem::path> m_directories; ///< watched directories by their watch descriptors
+	std::condition_variable m_stopCondition;
+	bool m_stopRequested = false;
+	std::thread m_thread;
+};
+
+} // namespace Lua
+
+#endif // LUACPP_SCRIPTWATCHER_HPP
\ No newline at end of file
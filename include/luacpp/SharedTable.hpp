@@ -0,0 +1,180 @@
+#ifndef LUACPP_SHAREDTABLE_HPP
+#define LUACPP_SHAREDTABLE_HPP
+
+#ifdef USE_CPP20_MODULES
+import luacpp.Generic;
+#else
+#include "Generic.hpp"
+#endif
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct lua_State;
+
+namespace Lua {
+
+/**
+ * @brief immutable hash table which lives outside of any lua state
+ *
+ * A shared table is built once in C++ and can be exposed to any number of lua states (also from different threads) at
+ * the same time. Lua scripts access it like a read-only table (indexing, #, pairs and ipairs). Values are only converted
+ * into lua values when they are accessed, so the memory of the table is paid once per process instead of once per state.
+ *
+ * Since the table never changes after it was built, all lookups are lock-free. The entries are stored in one contiguous
+ * array (the sequence part 1..n first, so it can be indexed directly) with an open addressing index on top of it. All
+ * strings are stored in a single buffer.
+ *
+ * Supported keys are booleans, numbers and strings. Values may additionally be nested shared tables.
+*/
+class SharedTable {
+public:
+	class Builder {
+	public:
+		Builder() = default;
+
+		/**
+		 * @brief reserve memory for the given number of entries
+		*/
+		Builder& reserve(size_t numEntries);
+
+		/**
+		 * @brief set the value for the given key
+		 * Setting a key twice overwrites the first value. Nil values remove the key.
+		 * @throws std::invalid_argument if the key is nil, NaN or of an unsupported type
+		*/
+		Builder& set(const Generic& key, const Generic& value);
+
+		/**
+		 * @brief set a nested table as value for the given key
+		*/
+		Builder& set(const Generic& key, std::shared_ptr<const SharedTable> table);
+
+		/**
+		 * @brief create the table
+		 * The builder is empty afterwards and can be reused.
+		*/
+		std::shared_ptr<const SharedTable> build();
+
+	private:
+		struct Item {
+			Generic key;
+			Generic value;
+			std::shared_ptr<const SharedTable> table;
+		};
+		std::vector<Item> m_items;
+	};
+
+	SharedTable(const SharedTable&) = delete;
+	SharedTable& operator=(const SharedTable&) = delete;
+
+	/**
+	 * @brief number of entries of the table
+	*/
+	size_t size() const { return m_entries.size(); }
+
+	/**
+	 * @brief length of the sequence part, which is the result of the length operator (#) in lua
+	*/
+	size_t length() const { return m_length; }
+
+	bool contains(const Generic& key) const;
+
+	/**
+	 * @brief returns the value of the given key (nil if the key doesn't exist or the value is a nested table)
+	*/
+	Generic get(const Generic& key) const;
+
+	/**
+	 * @brief returns the nested table of the given key (null if there is none)
+	*/
+	std::shared_ptr<const SharedTable> getTable(const Generic& key) const;
+
+	/**
+	 * @brief approximate number of bytes used by this table (without nested tables)
+	*/
+	size_t getMemoryUsage() const;
+
+	/**
+	 * @brief push the table as read-only userdata onto the stack of the given state
+	*/
+	static void push(lua_State* state, std::shared_ptr<const SharedTable> table);
+
+	/**
+	 * @brief returns the shared table at the given stack index (null if the value isn't a shared table)
+	*/
+	static std::shared_ptr<const SharedTable> fromStack(lua_State* state, int index);
+
+private:
+	enum class Kind : uint8_t {
+		Nil,
+		Boolean,
+		Integer,
+		Number,
+		String,
+		Table
+	};
+
+	/**
+	 * @brief a key or a value
+	 * The payload holds the value itself for booleans and numbers, the offset into the string buffer for strings and the
+	 * index of the nested table for tables.
+	*/
+	struct Cell {
+		uint64_t payload;
+		uint32_t length;
+		Kind kind;
+	};
+
+	struct Entry {
+		Cell key;
+		Cell value;
+	};
+
+	/**
+	 * @brief a key which was extracted from lua or C++ for a lookup
+	*/
+	struct Key {
+		Kind kind;
+		uint64_t payload;
+		std::string_view str;
+	};
+
+	constexpr static uint32_t NotFound = 0xFFFFFFFF;
+
+	SharedTable() = default;
+
+	static bool toKey(const Generic& key, Key& result, std::string& storage);
+	static uint64_t hash(const Key& key);
+
+	uint32_t find(const Key& key) const;
+	bool equals(const Entry& entry, const Key& key) const;
+	std::string_view getString(const Cell& cell) const;
+	Generic toGeneric(const Cell& cell) const;
+	void pushCell(lua_State* state, const Cell& cell) const;
+	void buildIndex();
+
+	static Key keyFromStack(lua_State* state, int index, bool& valid);
+	static const SharedTable* checkTable(lua_State* state, int index);
+	static void pushMetaTable(lua_State* state);
+	static int index(lua_State* state);
+	static int len(lua_State* state);
+	static int next(lua_State* state);
+	static int pairs(lua_State* state);
+	static int newIndex(lua_State* state);
+	static int gc(lua_State* state);
+
+	std::vector<Entry> m_entries; ///< all entries, the sequence part (keys 1..length) comes first
+	std::vector<uint64_t> m_index; ///< open addressing index: upper 32 bits hash tag, lower 32 bits entry index + 1
+	uint64_t m_mask = 0; ///< mask of the index (capacity - 1)
+	size_t m_length = 0; ///< length of the sequence part
+	std::string m_strings; ///< buffer of all strings (keys and values)
+	std::vector<std::shared_ptr<const SharedTable>> m_tables; ///< nested tables
+};
+
+} // namespace Lua
+
+#endif // LUACPP_SHAREDTABLE_HPP
\ No newline at end of file
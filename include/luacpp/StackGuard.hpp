@@ -0,0 +1,101 @@
+#ifndef LUACPP_STACKGUARD_HPP
+#define LUACPP_STACKGUARD_HPP
+
+#ifdef USE_CPP20_MODULES
+import luacpp.Basics;
+#else
+#include "Basics.hpp"
+#endif
+
+#ifdef LUACPP_CHECK_STACK
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#endif
+
+struct lua_State;
+
+namespace Lua {
+
+/**
+ * @brief restores the size of the lua stack when it goes out of scope
+ *
+ * The guard remembers the size of the stack on construction. Everything pushed after that is removed on every way out of
+ * the scope, including early returns and exceptions. Call release if the values pushed are meant to stay on the stack.
+ * The guard doesn't allocate, with LUACPP_INLINE_BASICS it is as cheap as the lua_settop it replaces.
+*/
+class StackGuard {
+public:
+	explicit StackGuard(lua_State* state) : m_state(state), m_top(Basics::getStackSize(state)) {}
+	~StackGuard() {
+		if (m_state != nullptr) {
+			Basics::setStackSize(m_state, m_top);
+		}
+	}
+
+	StackGuard(const StackGuard&) = delete;
+	StackGuard& operator=(const StackGuard&) = delete;
+
+	/**
+	 * @brief keep the stack as it is when the guard goes out of scope
+	*/
+	void release() { m_state = nullptr; }
+
+	/**
+	 * @brief the size of the stack the guard restores
+	*/
+	int getTop() const { return m_top; }
+
+private:
+	lua_State* m_state;
+	int m_top;
+};
+
+/**
+ * @brief verifies the stack balance of an api call
+ *
+ * The check compares the size of the stack at the end of the scope with the size at the beginning plus the expected
+ * difference and aborts with a message naming the function if they differ. It is only active if LUACPP_CHECK_STACK is
+ * defined (the default for debug builds), otherwise it does nothing and is optimized away. Scopes left by an exception
+ * are not checked.
+*/
+class StackCheck {
+public:
+#ifdef LUACPP_CHECK_STACK
+	StackCheck(lua_State* state, int delta, const char* function) :
+		m_state(state), m_top(Basics::getStackSize(state)), m_delta(delta), m_function(function),
+		m_exceptions(std::uncaught_exceptions()) {}
+
+	~StackCheck() {
+		const int size = Basics::getStackSize(m_state);
+		if (size != m_top + m_delta && std::uncaught_exceptions() == m_exceptions) {
+			std::fprintf(stderr, "luacpp: %s changed the stack size by %d instead of %d\n", m_function, size - m_top, m_delta);
+			std::abort();
+		}
+	}
+
+	/**
+	 * @brief change the expected difference, e.g. when an error leaves no results
+	*/
+	void expect(int delta) { m_delta = delta; }
+#else
+	StackCheck(lua_State*, int, const char*) {}
+	void expect(int) {}
+#endif
+
+	StackCheck(const StackCheck&) = delete;
+	StackCheck& operator=(const StackCheck&) = delete;
+
+#ifdef LUACPP_CHECK_STACK
+private:
+	lua_State* m_state;
+	int m_top;
+	int m_delta;
+	const char* m_function;
+	int m_exceptions;
+#endif
+};
+
+} // namespace Lua
+
+#endif // LUACPP_STACKGUARD_HPP
\ No newline at end of file
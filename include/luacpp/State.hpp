@@ -7,14 +7,27 @@ import luacpp.Registry;
 import luacpp.Table;
 import luacpp.Generic;
 import luacpp.Debug;
+import luacpp.GarbageCollector;
+import luacpp.SharedTable;
+import luacpp.Buffer;
+import luacpp.StackGuard;
+import luacpp.Metrics;
+import luacpp.Tracer;
 #else
 #include "Basics.hpp"
 #include "Table.hpp"
 #include "Registry.hpp"
 #include "Generic.hpp"
 #include "Debug.hpp"
+#include "GarbageCollector.hpp"
+#include "SharedTable.hpp"
+#include "Buffer.hpp"
+#include "StackGuard.hpp"
+#include "Metrics.hpp"
+#include "Tracer.hpp"
 #endif
 
+#include <chrono>
 #include <string>
 #include <vector>
 #include <functional>
@@ -36,6 +49,8 @@ public:
 	typedef std::function<void(Table&)> TableFunction;
 	typedef uint32_t Library;
 
+	constexpr static int AllResults = -1; ///< NumRet of executeFunction to keep all results (LUA_MULTRET)
+
 	constexpr static const Library LibNone = 0;
 	constexpr static const Library LibBase = bit(0);
 	constexpr static const Library LibPackage = bit(1);
@@ -50,6 +65,11 @@ public:
 	constexpr static const Library LibAll = 0xFFFFFFFF;
 	constexpr static size_t LibraryCount = 10;
 
+	enum class LibraryLoading {
+		Eager, ///< open the libraries right away
+		Lazy ///< open each library when a script accesses it first (the base library is opened right away)
+	};
+
 	struct MetaTable {
 		constexpr static const char* const Addition = "__add"; ///< addition operator (+)
 		constexpr static const char* const Substraction = "__sub"; ///< subtraction operator (-)
@@ -81,36 +101,42 @@ public:
 		constexpr static const char* const Close = "__close"; ///< close operator (close())
 	};
 
-	State(Library libraries = LibNone);
+	State(Library libraries = LibNone, LibraryLoading loading = LibraryLoading::Eager);
 	State(lua_State* state);
 	State(const State&) = delete;
 	State(State&& mv);
 
 	~State();
 
-	void openLibrary(Library library);
+	/**
+	 * @brief open the given libraries
+	 * Lazy loading sets an __index metamethod on _G and package.loaded, which opens a library when its global (or
+	 * require for the package library) is read or when it is required. Strings get a placeholder metatable which opens
+	 * the string library on the first method call or arithmetic. Raw accesses (rawget, pairs(_G)) don't see libraries
+	 * which weren't opened yet. If _G or package.loaded already have a metatable, the libraries are opened right away.
+	*/
+	void openLibrary(Library library, LibraryLoading loading = LibraryLoading::Eager);
 
 
 	template <typename T>
 	T readVariable(const char* variableName) {
+		StackCheck check(m_state, 0, __func__);
+		StackGuard guard(m_state); //pops the global, also if reading it throws
 		pushGlobalToStack(variableName);
-
-		T val = Basics::getStackValue<T>(m_state, -1);
-		popStack(1);
-		return val;
+		return Basics::getStackValue<T>(m_state, -1);
 	}
 
 	template <typename T>
 	void writeVariable(const char* variableName, T value) {
+		StackCheck check(m_state, 0, __func__);
 		pushToStack(value);
 		setGlobalFromStack(variableName);
 	}
 	
 	std::map<Generic, Generic> readTableGeneric(const char* tableName) {
+		StackCheck check(m_state, 0, __func__);
+		StackGuard guard(m_state);
 		std::map<Generic, Generic> result;
-
-		auto finallyGuard = std::shared_ptr<void>(nullptr, [&](...){ popStack(1); });
-
 		if (pushGlobalToStack(tableName) == Type::Table) {
 			Table table(m_state, -1);
 			result = table.readGeneric();
@@ -121,10 +147,9 @@ public:
 
 	template <typename Key, typename Value>
 	std::map<Key, Value> readTable(const char* tableName) {
+		StackCheck check(m_state, 0, __func__);
+		StackGuard guard(m_state);
 		std::map<Key, Value> result;
-
-		auto finallyGuard = std::shared_ptr<void>(nullptr, [&](...){ popStack(1); });
-
 		if (pushGlobalToStack(tableName) == Type::Table) {
 			Table table(m_state, -1);
 			result = table.read<Key, Value>();
@@ -135,13 +160,13 @@ public:
 
 	template <typename Key, typename Value>
 	std::map<Key, Value> readTableIfMatching(const std::string& tableName) { 
+		StackCheck check(m_state, 0, __func__);
+		StackGuard guard(m_state);
 		std::map<Key, Value> result;
-
 		if (pushGlobalToStack(tableName.c_str()) == Type::Table) {
 			Table table(m_state, -1);
 			result = table.readIfMatching<Key, Value>();
 		}
-		popStack(1);
 		return result;
 	}
 
@@ -152,6 +177,18 @@ public:
 		}, true);
 	}
 
+	/**
+	 * @brief expose a shared table as global variable
+	 * The table isn't copied into the lua state. Scripts access it as a read-only table.
+	 * @param name The name of the variable
+	 * @param table The table to expose
+	*/
+	void writeSharedTable(const char* name, std::shared_ptr<const SharedTable> table) {
+		StackCheck check(m_state, 0, __func__);
+		SharedTable::push(m_state, std::move(table));
+		setGlobalFromStack(name);
+	}
+
 	/**
 	 * @brief Register a native function to be callable from Lua
 	*/
@@ -162,6 +199,7 @@ public:
 	*/
 	template <typename... Args>
 	int registerNativeFunctionWithUpvalues(const char* name, NativeFunction func, Args... args) {
+		StackCheck check(m_state, 0, __func__);
 		(pushToStack(args), ...);  // Push all arguments to the Lua stack
 		int status = registerNativeFunction(name, func, sizeof...(args));
 		if (status != 0) {
@@ -196,12 +234,16 @@ public:
 
 	/**
 	 * @brief Load a script into the registry
+	 * Compile errors are added to the error list.
 	 * @param name The name of the script
 	 * @param code The source code of the script
 	*/
 	template <typename T>
 	int loadScript(T key, const char* code) {
-		return static_cast<int>(m_registry.loadScript<T>(key, code));
+		StackCheck check(m_state, 0, __func__);
+		const auto start = std::chrono::steady_clock::now();
+		const int status = static_cast<int>(m_registry.loadScript<T>(key, code));
+		return finishLoad(status, std::chrono::steady_clock::now() - start);
 	}
 
 	template <typename T>
@@ -210,17 +252,15 @@ public:
 	/**
 	 * @brief Execute a script from the registry
 	 * This method tries to load a script from the registry and executes it immediately. The script will be
-	 * popped from the stack after execution.
+	 * popped from the stack after execution. Errors are added to the error list.
 	 * @param name The key in the registry where the script is stored
 	 */
 	template <typename T>
 	int executeScript(T key) {
+		StackCheck check(m_state, 0, __func__);
 		int ec = static_cast<int>(m_registry.getScript(key));
 		if (ec == static_cast<int>(Registry::ErrorCode::Ok)) {
 			ec = callFunction(0, 0);
-			if (ec != 0) {
-				popStack(1); //pop the error message ToDo: improve error handling
-			}
 		}
 		return ec;
 	}
@@ -239,46 +279,63 @@ public:
 	*/
 	int loadAndExecuteScript(const std::string& code) { return loadAndExecuteScript(code.c_str()); }
 
+	/**
+	 * @brief Call a global function
+	 * On success the NumRet results are left on the stack. On failure the stack is left as it was and the error
+	 * message is added to the error list. Calling a global which is not a function fails with a runtime error.
+	 * NumRet = AllResults leaves all results of the function on the stack.
+	 * @return 0 on success, the lua error code otherwise
+	*/
 	template <int NumRet = 0, typename... Args>
 	int executeFunction(std::string_view name, Args... args) {
-		int status = 0;
-		if (loadFunction(name.data())) {
-			(pushToStack(args), ...);  // Push all arguments to the Lua stack
-			status = callFunction(sizeof...(args), NumRet);  // Call the function with the number of arguments
+		StackCheck check(m_state, 0, __func__);
+		const int top = NumRet == AllResults ? getStackSize() : 0;
+		if (!loadFunction(name.data())) {
+			return static_cast<int>(Registry::ErrorCode::RuntimeError);
+		}
+		(pushToStack(args), ...);  // Push all arguments to the Lua stack
+		int status = callFunction(sizeof...(args), NumRet);  // Call the function with the number of arguments
+		if (status == 0) {
+			check.expect(NumRet == AllResults ? getStackSize() - top : NumRet);
 		}
 		return status;
 	}
 
 	template <int NumRet = 0, typename T>
 	int executeFunctionWithArgsArray(std::string_view name, T* args, size_t numArgs) {
-		int status = 0;
-		if (loadFunction(name.data())) {
-			for (size_t i = 0; i < numArgs; ++i) {
-				pushToStack<T>(args[i]);
-			}
-			status = callFunction(0, NumRet);  // Call the function with the number of arguments
+		StackCheck check(m_state, 0, __func__);
+		const int top = NumRet == AllResults ? getStackSize() : 0;
+		if (!loadFunction(name.data())) {
+			return static_cast<int>(Registry::ErrorCode::RuntimeError);
+		}
+		for (size_t i = 0; i < numArgs; ++i) {
+			pushToStack<T>(args[i]);
+		}
+		int status = callFunction(static_cast<int>(numArgs), NumRet);  // Call the function with the number of arguments
+		if (status == 0) {
+			check.expect(NumRet == AllResults ? getStackSize() - top : NumRet);
 		}
 		return status;
 	}
 
 	template <typename T, typename... Args>
 	int executeFunctionAndReadReturnVal(T& result, std::string_view name, Args... args) {
+		StackCheck check(m_state, 0, __func__);
+		StackGuard guard(m_state); //pops the result, also if reading it throws
 		int status = executeFunction<1>(name, args...);
 		if (status == 0) {
 			result = getStackValue<T>(-1);
-			popStack(1);
-			return 0;
 		}
 		return status;
 	}
 
 	template <typename T>
 	int executeFunctionWithArgsArrayAndReadReturnVal(T& result, std::string_view name, T* args, size_t numArgs) {
+		StackCheck check(m_state, 0, __func__);
+		StackGuard guard(m_state);
 		int status = executeFunctionWithArgsArray<1>(name, args, numArgs);
 		if (status == 0) {
 			result = getStackValue<T>(-1);
-			popStack(1);
-			return 0;
 		}
 		return status;
 	}
@@ -405,6 +462,12 @@ public:
 	template <typename T>
 	void pushToStack(T value) { return Basics::pushToStack(m_state, value); }
 
+	/**
+	 * @brief Push a buffer to the stack without copying its content
+	 * This makes buffers usable as arguments of executeFunction and with writeVariable.
+	*/
+	void pushToStack(Buffer value) { Buffer::push(m_state, std::move(value)); }
+
 
 	/**
 	 * @brief reads the complete stack
@@ -425,7 +488,24 @@ public:
 	/**
 	 * \brief Clear the list of errors that occured during script execution
 	*/
-	void clearErrorList() { m_errorList.clear(); }
+	void clearErrorList();
+
+	/**
+	 * \brief start collecting metrics of this state
+	 * The counters can be read from any thread, e.g. by a MetricsExporter. Calling this again returns the same metrics.
+	*/
+	std::shared_ptr<Metrics> enableMetrics();
+
+	/**
+	 * \brief returns the metrics of the state or null if they were not enabled
+	*/
+	std::shared_ptr<Metrics> getMetrics() const { return m_metrics; }
+
+	/**
+	 * \brief returns the garbage collector of the lua state
+	*/
+	GarbageCollector& getGarbageCollector() { return m_gc; }
+	const GarbageCollector& getGarbageCollector() const { return m_gc; }
 
 	/**
 	 * \brief returns the internal lua state
@@ -437,9 +517,11 @@ private:
 	constexpr static const char* const GlobalScope = "_G";
 
 	static int dispatchMethod(lua_State* state);
+	static int invokeMethod(lua_State* state); ///< calls a method in protected mode for dispatchMethod
 
 	/**
 	 * @brief loads a function from the global scope onto the stack
+	 * If the global is not a function, nothing is left on the stack and an error is added to the error list.
 	 * @param funcName The name of the function
 	 * @return true if the function was found and loaded, false otherwise
 	*/
@@ -449,17 +531,26 @@ private:
 	 * @brief calls a function that is on the stack
 	 * @param numArgs The number of arguments that are on the stack
 	 * @param numResults The number of results that are expected
-	 * @return The status of the lua virtual machine
+	 * @return The status of the lua virtual machine, on failure the error message is moved to the error list
 	*/
 	int callFunction(int numArgs, int numResults);
 
+	/**
+	 * @brief moves the error message of a failed load to the error list and updates the metrics
+	*/
+	int finishLoad(int status, std::chrono::steady_clock::duration compileTime);
+
+	void addError(std::string message);
+
 	static std::map<lua_State*, DebugHook> s_debugHooks; ///< list of debug hooks (one per lua state)
 
 	lua_State* m_state; ///< instance of the lua virtual machine
 	Registry m_registry; ///< registry for user defined functions
+	GarbageCollector m_gc; ///< garbage collector of the lua virtual machine
 	bool m_externalState; ///< true if the state was provided by the user, false if it was created by this class
 	std::vector<Method> m_callbacks; ///< list of registered methods
 	std::vector<std::string> m_errorList; ///< list of errors that occured during script execution
+	std::shared_ptr<Metrics> m_metrics; ///< operational counters (only if enabled)
 };
 
 } // namespace Lua
@@ -0,0 +1,151 @@
+#ifndef LUACPP_STRANDEDSTATE_HPP
+#define LUACPP_STRANDEDSTATE_HPP
+
+#ifdef USE_CPP20_MODULES
+import luacpp.State;
+#else
+#include "State.hpp"
+#endif
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+namespace Lua {
+
+/**
+ * @brief state owned by a dedicated thread which executes calls submitted from any thread
+ *
+ * Calls are functions receiving the State. They are appended to a lock-free multi-producer single-consumer queue
+ * (an intrusive linked list where producers only exchange the head pointer), so submitting never blocks on other
+ * submitters or on the running call. The owner thread takes up to batchSize calls at a time and only goes to sleep when
+ * the queue is empty; producers wake it up only in this case, so a busy strand doesn't pay a wakeup per call.
+ *
+ * The state is created on the owner thread. Calls still in the queue when the strand is destroyed are executed before
+ * the thread ends.
+*/
+class StrandedState {
+public:
+	struct Options {
+		State::Library libraries = State::LibNone; ///< libraries opened when the state is created
+		size_t batchSize = 64; ///< maximum number of calls executed between two checks of the stop flag and the metrics
+	};
+
+	/**
+	 * @brief snapshot of the metrics of the strand
+	 * The latency is measured from the submission of a call until its execution starts.
+	*/
+	struct Statistics {
+		uint64_t submitted = 0;
+		uint64_t executed = 0;
+		uint64_t batches = 0; ///< number of times the owner thread took calls from the queue
+		uint64_t wakeups = 0; ///< number of times a producer had to wake up the owner thread
+		size_t queueDepth = 0; ///< calls waiting for execution
+		size_t maxQueueDepth = 0;
+		std::chrono::nanoseconds totalLatency{0};
+		std::chrono::nanoseconds maxLatency{0};
+	};
+
+	StrandedState();
+	explicit StrandedState(const Options& options);
+	StrandedState(const StrandedState&) = delete;
+	~StrandedState();
+
+	StrandedState& operator=(const StrandedState&) = delete;
+
+	/**
+	 * @brief queue a call for execution on the owner thread
+	 * @param function Callable with the signature R(State&)
+	 * @return A future for the result (or exception) of the call
+	*/
+	template <typename F>
+	std::future<std::invoke_result_t<F, State&>> submit(F&& function) {
+		using Result = std::invoke_result_t<F, State&>;
+		auto* task = new Task<std::decay_t<F>, Result>(std::forward<F>(function));
+		std::future<Result> future = task->promise.get_future();
+		enqueue(task);
+		return future;
+	}
+
+	Statistics getStatistics() const;
+	size_t getQueueDepth() const { return m_depth.load(std::memory_order_relaxed); }
+
+	/**
+	 * @return true if the calling thread is the owner thread of the state
+	*/
+	bool isOwnerThread() const { return std::this_thread::get_id() == m_thread.get_id(); }
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+	struct Node {
+		virtual ~Node() = default;
+		virtual void run(State&) {}
+
+		std::atomic<Node*> next{nullptr};
+		Clock::time_point submitted;
+	};
+
+	/**
+	 * @brief queued call holding the function and the promise of its result in one allocation
+	*/
+	template <typename F, typename R>
+	struct Task : Node {
+		template <typename Function>
+		explicit Task(Function&& fn) : function(std::forward<Function>(fn)) {}
+
+		void run(State& state) override {
+			try {
+				if constexpr (std::is_void_v<R>) {
+					function(state);
+					promise.set_value();
+				} else {
+					promise.set_value(function(state));
+				}
+			} catch (...) {
+				promise.set_exception(std::current_exception());
+			}
+		}
+
+		F function;
+		std::promise<R> promise;
+	};
+
+	void enqueue(Node* node);
+	void push(Node* node);
+	Node* pop();
+	void run();
+	void execute(Node* node, State& state);
+
+	Options m_options;
+	std::atomic<Node*> m_head; ///< last node of the queue, producers append here
+	Node* m_tail; ///< first node of the queue, only accessed by the owner thread
+	Node m_stub; ///< placeholder that keeps the queue non-empty, so producers and the consumer never touch the same node
+	std::atomic<size_t> m_depth{0};
+	std::atomic<bool> m_sleeping{false};
+	std::atomic<bool> m_stop{false};
+	std::mutex m_sleepMutex;
+	std::condition_variable m_wakeup;
+
+	std::atomic<uint64_t> m_submitted{0};
+	std::atomic<uint64_t> m_executed{0};
+	std::atomic<uint64_t> m_batches{0};
+	std::atomic<uint64_t> m_wakeups{0};
+	std::atomic<size_t> m_maxDepth{0};
+	std::atomic<int64_t> m_totalLatency{0};
+	std::atomic<int64_t> m_maxLatency{0};
+
+	std::thread m_thread;
+};
+
+} // namespace Lua
+
+#endif // LUACPP_STRANDEDSTATE_HPP
\ No newline at end of file
@@ -0,0 +1,116 @@
+#ifndef LUACPP_TRACER_HPP
+#define LUACPP_TRACER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+struct lua_State;
+
+namespace Lua {
+
+/**
+ * @brief process wide timeline of script calls, native callbacks, garbage collection and compilation
+ *
+ * Every thread records its events into a ring buffer of its own, which is created on its first event. An event takes
+ * 16 bytes: a timestamp of the monotonic clock, an interned name, a phase (begin or end) and a category. Recording
+ * doesn't take locks, the buffers keep the latest events and overwrite the oldest ones. toChromeJson collects the
+ * buffers of all threads at any time into the trace event format read by chrome://tracing and ui.perfetto.dev.
+ *
+ * The luacpp api records calls, loads, registered methods and explicit garbage collection. attach adds the lua call
+ * and return hooks, which record every lua and C function called by scripts. While the tracer is disabled each of these
+ * points costs a single branch on a relaxed atomic flag.
+*/
+class Tracer {
+public:
+	enum class Category : uint8_t {
+		Script, ///< lua functions and scripts
+		Native, ///< C functions and registered methods
+		GarbageCollection,
+		Compile,
+		User ///< events recorded by the application
+	};
+
+	constexpr static size_t DefaultCapacity = 64 * 1024; ///< events kept per thread
+
+	/**
+	 * @brief record events from now on
+	 * @param capacity Events kept per thread (rounded up to a power of two), used for threads recording their first event
+	*/
+	static void enable(size_t capacity = DefaultCapacity);
+	static void disable();
+	static bool isEnabled() { return s_enabled.load(std::memory_order_relaxed); }
+
+	/**
+	 * @brief record the begin of an event of the calling thread
+	 * The name is interned by its address, it must stay valid (e.g. a string literal).
+	 * @return The depth of the event, which has to be passed to end
+	*/
+	static uint32_t begin(Category category, const char* name);
+
+	/**
+	 * @brief record the end of the event begun at the given depth
+	 * Events begun later which didn't end are ended as well, e.g. lua functions left by an error.
+	*/
+	static void end(uint32_t depth);
+
+	/**
+	 * @brief record an event which started earlier, e.g. after its duration was measured anyway
+	*/
+	static void record(Category category, const char* name, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end);
+
+	/**
+	 * @brief records the begin and end of its scope if the tracer is enabled when it is created
+	*/
+	class Scope {
+	public:
+		Scope(Category category, const char* name) : m_active(isEnabled()) {
+			if (m_active) {
+				m_depth = begin(category, name);
+			}
+		}
+		Scope(const Scope&) = delete;
+		~Scope() {
+			if (m_active) {
+				end(m_depth);
+			}
+		}
+
+		Scope& operator=(const Scope&) = delete;
+
+	private:
+		bool m_active;
+		uint32_t m_depth = 0;
+	};
+
+	/**
+	 * @brief record the calls of lua and C functions in the state with the call and return hooks
+	 * This replaces other hooks of the state (e.g. State::registerDebugHook). Coroutines created later inherit the hooks.
+	 * The events of a coroutine are ended when it yields and begun again when it is resumed.
+	*/
+	static void attach(lua_State* state);
+	static void detach(lua_State* state);
+	static bool isAttached(lua_State* state); ///< whether the hooks of the state are those installed by attach
+
+	/**
+	 * @brief the recorded events of all threads in the chrome trace event format (JSON)
+	 * End events whose begin was overwritten are dropped.
+	*/
+	static std::string toChromeJson();
+	static bool writeChromeJson(const std::filesystem::path& path);
+
+	/**
+	 * @brief drop the events recorded so far
+	*/
+	static void clear();
+
+private:
+	static std::atomic<bool> s_enabled;
+};
+
+} // namespace Lua
+
+#endif // LUACPP_TRACER_HPP
\ No newline at end of file
@@ -0,0 +1,9 @@
+module;
+#include <AllocationProfiler.hpp>
+#include "../src/AllocationProfiler.cpp"
+
+export module luacpp.AllocationProfiler;
+
+export {
+	using Lua::AllocationProfiler;
+}
\ No newline at end of file
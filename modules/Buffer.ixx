@@ -0,0 +1,9 @@
+module;
+#include <Buffer.hpp>
+#include "../src/Buffer.cpp"
+
+export module luacpp.Buffer;
+
+export {
+	using Lua::Buffer;
+}
\ No newline at end of file
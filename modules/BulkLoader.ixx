@@ -0,0 +1,9 @@
+module;
+#include <BulkLoader.hpp>
+#include "../src/BulkLoader.cpp"
+
+export module luacpp.BulkLoader;
+
+export {
+	using Lua::BulkLoader;
+}
\ No newline at end of file
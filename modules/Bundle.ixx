@@ -0,0 +1,9 @@
+module;
+#include <Bundle.hpp>
+#include "../src/Bundle.cpp"
+
+export module luacpp.Bundle;
+
+export {
+	using Lua::Bundle;
+}
\ No newline at end of file
@@ -0,0 +1,9 @@
+module;
+#include <CoroutinePool.hpp>
+#include "../src/CoroutinePool.cpp"
+
+export module luacpp.CoroutinePool;
+
+export {
+	using Lua::CoroutinePool;
+}
\ No newline at end of file
@@ -0,0 +1,9 @@
+module;
+#include <EventLoop.hpp>
+#include "../src/EventLoop.cpp"
+
+export module luacpp.EventLoop;
+
+export {
+	using Lua::EventLoop;
+}
\ No newline at end of file
@@ -0,0 +1,9 @@
+module;
+#include <GarbageCollector.hpp>
+#include "../src/GarbageCollector.cpp"
+
+export module luacpp.GarbageCollector;
+
+export {
+	using Lua::GarbageCollector;
+}
\ No newline at end of file
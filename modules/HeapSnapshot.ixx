@@ -0,0 +1,9 @@
+module;
+#include <HeapSnapshot.hpp>
+#include "../src/HeapSnapshot.cpp"
+
+export module luacpp.HeapSnapshot;
+
+export {
+	using Lua::HeapSnapshot;
+}
\ No newline at end of file
@@ -0,0 +1,9 @@
+module;
+#include <Json.hpp>
+#include "../src/Json.cpp"
+
+export module luacpp.Json;
+
+export {
+	using Lua::Json;
+}
\ No newline at end of file
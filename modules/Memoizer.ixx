@@ -0,0 +1,9 @@
+module;
+#include <Memoizer.hpp>
+#include "../src/Memoizer.cpp"
+
+export module luacpp.Memoizer;
+
+export {
+	using Lua::Memoizer;
+}
\ No newline at end of file
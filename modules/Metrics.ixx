@@ -0,0 +1,10 @@
+module;
+#include <Metrics.hpp>
+#include "../src/Metrics.cpp"
+
+export module luacpp.Metrics;
+
+export {
+	using Lua::Metrics;
+	using Lua::MetricsExporter;
+}
\ No newline at end of file
@@ -0,0 +1,9 @@
+module;
+#include <NumArray.hpp>
+#include "../src/NumArray.cpp"
+
+export module luacpp.NumArray;
+
+export {
+	using Lua::NumArray;
+}
\ No newline at end of file
@@ -0,0 +1,11 @@
+module;
+#include <Parallel.hpp>
+#include "../src/Parallel.cpp"
+
+export module luacpp.Parallel;
+
+export {
+	using Lua::Workers;
+	using Lua::parallelMap;
+	using Lua::parallelReduce;
+}
\ No newline at end of file
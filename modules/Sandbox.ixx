@@ -0,0 +1,9 @@
+module;
+#include <Sandbox.hpp>
+#include "../src/Sandbox.cpp"
+
+export module luacpp.Sandbox;
+
+export {
+	using Lua::Sandbox;
+}
\ No newline at end of file
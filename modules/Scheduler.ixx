@@ -0,0 +1,9 @@
+module;
+#include <Scheduler.hpp>
+#include "../src/Scheduler.cpp"
+
+export module luacpp.Scheduler;
+
+export {
+	using Lua::Scheduler;
+}
\ No newline at end of file
@@ -0,0 +1,9 @@
+module;
+#include <ScriptWatcher.hpp>
+#include "../src/ScriptWatcher.cpp"
+
+export module luacpp.ScriptWatcher;
+
+export {
+	using Lua::ScriptWatcher;
+}
\ No newline at end of file
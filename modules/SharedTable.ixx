@@ -0,0 +1,9 @@
+module;
+#include <SharedTable.hpp>
+#include "../src/SharedTable.cpp"
+
+export module luacpp.SharedTable;
+
+export {
+	using Lua::SharedTable;
+}
\ No newline at end of file
@@ -0,0 +1,9 @@
+module;
+#include <StackGuard.hpp>
+
+export module luacpp.StackGuard;
+
+export {
+	using Lua::StackGuard;
+	using Lua::StackCheck;
+}
\ No newline at end of file
@@ -0,0 +1,9 @@
+module;
+#include <StrandedState.hpp>
+#include "../src/StrandedState.cpp"
+
+export module luacpp.StrandedState;
+
+export {
+	using Lua::StrandedState;
+}
\ No newline at end of file
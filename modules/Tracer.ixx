@@ -0,0 +1,9 @@
+module;
+#include <Tracer.hpp>
+#include "../src/Tracer.cpp"
+
+export module luacpp.Tracer;
+
+export {
+	using Lua::Tracer;
+}
\ No newline at end of file
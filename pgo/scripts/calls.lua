@@ -0,0 +1,60 @@
+-- call heavy workload: recursion, closures, varargs, metamethods and calls into C++
+
+local function fib(n)
+	if n < 2 then
+		return n
+	end
+	return fib(n - 1) + fib(n - 2)
+end
+
+local function counter()
+	local count = 0
+	return function(step)
+		count = count + (step or 1)
+		return count
+	end
+end
+
+local function sumAll(...)
+	local s = 0
+	for i = 1, select("#", ...) do
+		s = s + select(i, ...)
+	end
+	return s
+end
+
+local Vector = {}
+Vector.__index = Vector
+Vector.__add = function(a, b) return Vector.new(a.x + b.x, a.y + b.y) end
+
+function Vector.new(x, y)
+	return setmetatable({ x = x, y = y }, Vector)
+end
+
+function Vector:length2()
+	return self.x * self.x + self.y * self.y
+end
+
+local sum = fib(24)
+
+local c = counter()
+for i = 1, 200000 do
+	c(i % 3)
+end
+sum = sum + c(0)
+
+for i = 1, 50000 do
+	sum = sum + sumAll(i, 1, 2, 3)
+end
+
+local v = Vector.new(0, 0)
+for i = 1, 50000 do
+	v = v + Vector.new(1, 2)
+end
+sum = sum + v:length2()
+
+for i = 1, 100000 do
+	sum = sum + native_add(i, 1)
+end
+
+result = { sum = sum }
\ No newline at end of file
@@ -0,0 +1,38 @@
+-- string heavy workload: formatting, concatenation, pattern matching and conversions
+
+local parts = {}
+for i = 1, 20000 do
+	parts[#parts + 1] = string.format("%05d:%s", i, tostring(i * 3.5))
+end
+local text = table.concat(parts, ",")
+
+local count = 0
+for number in text:gmatch("(%d+):") do
+	count = count + tonumber(number) % 7
+end
+
+local replaced = text:gsub("%d", function(d) return d == "1" and "x" or nil end)
+
+local s = ""
+for i = 1, 2000 do
+	s = s .. string.char(65 + i % 26)
+end
+
+local upper, lower = 0, 0
+for i = 1, #s do
+	local b = s:byte(i)
+	if b >= 65 and b <= 90 then
+		upper = upper + 1
+	else
+		lower = lower + 1
+	end
+end
+
+local words = {}
+for i = 1, 5000 do
+	local w = string.rep("ab", i % 10) .. i
+	words[w] = (words[w] or 0) + 1
+	count = count + #w:upper() + (w:find("ba", 1, true) or 0)
+end
+
+result = { sum = count + #replaced + upper + lower + native_length(text) }
\ No newline at end of file
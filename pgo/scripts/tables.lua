@@ -0,0 +1,60 @@
+-- table heavy workload: array and hash part construction, lookups, sorting and nested tables
+
+local function buildArray(n)
+	local t = {}
+	for i = 1, n do
+		t[i] = (i * 7919) % 1000
+	end
+	return t
+end
+
+local function buildMap(n)
+	local t = {}
+	for i = 1, n do
+		t["key" .. i] = i
+	end
+	return t
+end
+
+local sum = 0
+for round = 1, 20 do
+	local array = buildArray(5000)
+	table.sort(array)
+	for i = 1, #array, 7 do
+		sum = sum + array[i]
+	end
+
+	local map = buildMap(2000)
+	for i = 1, 2000, 3 do
+		sum = sum + map["key" .. i]
+	end
+	for k, v in pairs(map) do
+		if v % 100 == 0 then
+			map[k] = nil
+		end
+	end
+
+	local matrix = {}
+	for y = 1, 40 do
+		local row = {}
+		for x = 1, 40 do
+			row[x] = { x = x, y = y, value = x * y }
+		end
+		matrix[y] = row
+	end
+	for y = 1, 40 do
+		for x = 1, 40 do
+			sum = sum + matrix[y][x].value
+		end
+	end
+
+	local queue = {}
+	for i = 1, 1000 do
+		table.insert(queue, i)
+	end
+	while #queue > 0 do
+		sum = sum + table.remove(queue)
+	end
+end
+
+result = { sum = sum }
\ No newline at end of file
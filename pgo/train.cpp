@@ -0,0 +1,91 @@
+// Training workload for the profile guided optimization (see cmake/RunPGO.cmake).
+// Every lua script of the given directory is executed through luacpp. With --timing the scripts are executed several
+// times and the best time of each script is reported.
+
+#include <luacpp/State.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+namespace {
+
+std::string readFile(const std::filesystem::path& path) {
+	std::ifstream file(path, std::ios::binary);
+	std::ostringstream content;
+	content << file.rdbuf();
+	return content.str();
+}
+
+bool runScript(const std::string& name, const std::string& code) {
+	Lua::State lua(Lua::State::LibAll);
+	lua.registerMethod("native_add", [](Lua::State& state) {
+		return state.setReturnValue(state.getArgument<int64_t>(1) + state.getArgument<int64_t>(2));
+	});
+	lua.registerMethod("native_length", [](Lua::State& state) {
+		return state.setReturnValue(static_cast<int64_t>(state.getArgument<std::string_view>(1).size()));
+	});
+
+	if (lua.loadScript(name.c_str(), code) != 0 || lua.executeScript(name.c_str()) != 0) {
+		for (const std::string& error : lua.getErrorList()) {
+			std::cerr << name << ": " << error << std::endl;
+		}
+		return false;
+	}
+
+	//read the result through the table api as well
+	double sum = 0;
+	lua.withTableDo("result", [&sum](Lua::Table& table) {
+		table.readValue<double>("sum", sum);
+	}, false);
+	return sum != 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+	if (argc < 2) {
+		std::cerr << "usage: " << argv[0] << " <script directory> [--timing]" << std::endl;
+		return 1;
+	}
+	const bool timing = argc > 2 && std::strcmp(argv[2], "--timing") == 0;
+	const int repetitions = timing ? 5 : 1;
+
+	std::vector<std::filesystem::path> scripts;
+	for (const auto& entry : std::filesystem::directory_iterator(argv[1])) {
+		if (entry.path().extension() == ".lua") {
+			scripts.push_back(entry.path());
+		}
+	}
+	std::sort(scripts.begin(), scripts.end());
+
+	double total = 0.0;
+	for (const auto& path : scripts) {
+		const std::string name = path.stem().string();
+		const std::string code = readFile(path);
+		double best = 0.0;
+		for (int i = 0; i < repetitions; ++i) {
+			const auto start = std::chrono::steady_clock::now();
+			if (!runScript(name, code)) {
+				std::cerr << "training script " << name << " failed" << std::endl;
+				return 1;
+			}
+			const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+			best = i == 0 ? ms : std::min(best, ms);
+		}
+		total += best;
+		if (timing) {
+			std::cout << name << ": " << best << " ms" << std::endl;
+		}
+	}
+	if (timing) {
+		std::cout << "total: " << total << " ms" << std::endl;
+	}
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,242 @@
+#include <AllocationProfiler.hpp>
+#include <lua/lua.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <map>
+
+#ifdef __GLIBC__
+#include <execinfo.h>
+#endif
+
+namespace Lua {
+
+namespace {
+
+constexpr const char* const HostFrame = "[host]"; ///< allocations made by the lua api outside of any function
+constexpr const char* const NativeFrame = "[C]";
+constexpr size_t SkippedNativeFrames = 4; ///< frames of the profiler itself
+
+std::vector<AllocationProfiler::Site> sortSites(std::vector<AllocationProfiler::Site> sites) {
+	std::sort(sites.begin(), sites.end(), [](const AllocationProfiler::Site& a, const AllocationProfiler::Site& b) {
+		return a.allocatedBytes != b.allocatedBytes ? a.allocatedBytes > b.allocatedBytes : a.location < b.location;
+	});
+	return sites;
+}
+
+} // namespace
+
+AllocationProfiler::AllocationProfiler(lua_State* state) : AllocationProfiler(state, Options()) {}
+
+AllocationProfiler::AllocationProfiler(lua_State* state, const Options& options)
+: m_state(state),
+  m_options(options),
+  m_random(options.seed != 0 ? options.seed : std::random_device()())
+{
+	m_allocator = lua_getallocf(m_state, &m_allocatorData);
+	m_untilSample = nextInterval();
+	lua_setallocf(m_state, &AllocationProfiler::allocate, this);
+	m_running = true;
+}
+
+AllocationProfiler::~AllocationProfiler() {
+	stop();
+}
+
+void AllocationProfiler::stop() {
+	if (m_running) {
+		lua_setallocf(m_state, m_allocator, m_allocatorData);
+		m_running = false;
+	}
+}
+
+std::vector<AllocationProfiler::Site> AllocationProfiler::getLines() const {
+	std::map<std::string, Site> lines;
+	for (const Stack& stack : m_stacks) {
+		Site& site = lines[stack.line];
+		site.location = stack.line;
+		site.allocatedBytes += stack.allocatedBytes;
+		site.liveBytes += stack.liveBytes;
+		site.samples += stack.samples;
+	}
+	std::vector<Site> sites;
+	sites.reserve(lines.size());
+	for (auto& [line, site] : lines) {
+		sites.push_back(std::move(site));
+	}
+	return sortSites(std::move(sites));
+}
+
+std::vector<AllocationProfiler::Site> AllocationProfiler::getStacks() const {
+	std::vector<Site> sites;
+	sites.reserve(m_stacks.size());
+	for (const Stack& stack : m_stacks) {
+		sites.push_back(Site{stack.folded, stack.allocatedBytes, stack.liveBytes, stack.samples});
+	}
+	return sortSites(std::move(sites));
+}
+
+std::string AllocationProfiler::toFoldedStacks(bool live) const {
+	std::string text;
+	for (const Site& site : getStacks()) {
+		const uint64_t bytes = live ? site.liveBytes : site.allocatedBytes;
+		if (bytes != 0) {
+			text += site.location + " " + std::to_string(bytes) + "\n";
+		}
+	}
+	return text;
+}
+
+void AllocationProfiler::reset() {
+	m_allocatedBytes = 0;
+	m_sampleCount = 0;
+	m_pendingWeight = 0;
+	m_stacks.clear();
+	m_stackIndex.clear();
+	m_blocks.clear();
+	m_filter.fill(0);
+}
+
+void* AllocationProfiler::allocate(void* userData, void* ptr, size_t oldSize, size_t newSize) {
+	AllocationProfiler* profiler = static_cast<AllocationProfiler*>(userData);
+	void* result = profiler->m_allocator(profiler->m_allocatorData, ptr, oldSize, newSize);
+	try {
+		profiler->account(ptr, oldSize, result, newSize);
+	} catch (...) {
+		//the profiler must never raise through lua, a sample lost to an out of memory situation is acceptable
+	}
+	return result;
+}
+
+void AllocationProfiler::account(void* ptr, size_t oldSize, void* result, size_t newSize) {
+	if (ptr == nullptr) {
+		oldSize = 0; //for new blocks lua passes the type of the object instead of a size
+	} else if ((newSize == 0 || result != nullptr) && m_filter[filterSlot(ptr)] != 0) {
+		auto it = m_blocks.find(ptr);
+		if (it != m_blocks.end()) {
+			Block block = it->second;
+			m_blocks.erase(it);
+			--m_filter[filterSlot(ptr)];
+			if (newSize == 0) {
+				Stack& stack = m_stacks[block.stack];
+				stack.liveBytes -= std::min(stack.liveBytes, block.weight);
+			} else {
+				m_blocks.emplace(result, block);
+				++m_filter[filterSlot(result)];
+			}
+		}
+	}
+	if (result == nullptr || newSize <= oldSize) {
+		return;
+	}
+
+	const uint64_t growth = newSize - oldSize;
+	m_allocatedBytes += growth;
+	uint64_t weight = 0;
+	if (m_options.sampleInterval == 0) {
+		weight = growth;
+	} else if (growth >= m_untilSample) {
+		//estimate of the bytes this sample stands for: sizes close to the interval are sampled almost always, so they
+		//only count once, smaller ones stand for all the bytes allocated since the previous sample
+		const double size = static_cast<double>(growth);
+		weight = static_cast<uint64_t>(size / -std::expm1(-size / static_cast<double>(m_options.sampleInterval)));
+		m_untilSample = nextInterval();
+	} else {
+		m_untilSample -= growth;
+	}
+
+	if (ptr == nullptr && (weight != 0 || m_pendingWeight != 0)) {
+		sample(result, weight + m_pendingWeight);
+		m_pendingWeight = 0;
+	} else {
+		m_pendingWeight += weight;
+	}
+}
+
+void AllocationProfiler::sample(void* block, uint64_t weight) {
+	const size_t index = captureStack();
+	Stack& stack = m_stacks[index];
+	stack.allocatedBytes += weight;
+	stack.liveBytes += weight;
+	++stack.samples;
+	++m_sampleCount;
+	if (m_blocks.insert_or_assign(block, Block{index, weight}).second) {
+		++m_filter[filterSlot(block)];
+	}
+}
+
+size_t AllocationProfiler::captureStack() {
+	std::vector<std::string> frames;
+	std::string line;
+#ifdef __GLIBC__
+	if (m_options.nativeFrames != 0) {
+		std::vector<void*> addresses(m_options.nativeFrames + SkippedNativeFrames);
+		const int count = backtrace(addresses.data(), static_cast<int>(addresses.size()));
+		if (count > static_cast<int>(SkippedNativeFrames)) {
+			char** symbols = backtrace_symbols(addresses.data() + SkippedNativeFrames, count - static_cast<int>(SkippedNativeFrames));
+			if (symbols != nullptr) {
+				for (int i = count - static_cast<int>(SkippedNativeFrames) - 1; i >= 0; --i) {
+					std::string frame = symbols[i];
+					std::replace(frame.begin(), frame.end(), ';', ':');
+					frames.push_back(std::move(frame));
+				}
+				std::free(symbols);
+			}
+		}
+	}
+#endif
+
+	//lua frames, innermost first
+	lua_Debug ar;
+	std::vector<std::string> luaFrames;
+	for (int level = 0; static_cast<size_t>(level) < m_options.luaFrames && lua_getstack(m_state, level, &ar) != 0; ++level) {
+		lua_getinfo(m_state, "Sl", &ar);
+		if (ar.currentline > 0) {
+			luaFrames.push_back(std::string(ar.short_src) + ":" + std::to_string(ar.currentline));
+			if (line.empty()) {
+				line = luaFrames.back();
+			}
+		} else {
+			luaFrames.push_back(NativeFrame);
+		}
+	}
+	if (luaFrames.empty()) {
+		luaFrames.push_back(HostFrame);
+	}
+	if (line.empty()) {
+		line = luaFrames.front();
+	}
+	frames.insert(frames.end(), luaFrames.rbegin(), luaFrames.rend());
+
+	m_key.clear();
+	for (const std::string& frame : frames) {
+		if (!m_key.empty()) {
+			m_key += ';';
+		}
+		m_key += frame;
+	}
+
+	auto it = m_stackIndex.find(m_key);
+	if (it != m_stackIndex.end()) {
+		return it->second;
+	}
+	m_stacks.push_back(Stack{m_key, std::move(line)});
+	m_stackIndex.emplace(m_key, m_stacks.size() - 1);
+	return m_stacks.size() - 1;
+}
+
+size_t AllocationProfiler::filterSlot(const void* block) {
+	const uintptr_t address = reinterpret_cast<uintptr_t>(block);
+	return ((address >> 4) ^ (address >> 16)) & 4095;
+}
+
+uint64_t AllocationProfiler::nextInterval() {
+	if (m_options.sampleInterval == 0) {
+		return 0;
+	}
+	std::exponential_distribution<double> distribution(1.0 / static_cast<double>(m_options.sampleInterval));
+	return static_cast<uint64_t>(distribution(m_random)) + 1;
+}
+
+} // namespace Lua
\ No newline at end of file
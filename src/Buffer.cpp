@@ -0,0 +1,219 @@
+#include <Buffer.hpp>
+#include <lua/lua.hpp>
+
+#include <cstring>
+#include <type_traits>
+
+namespace {
+
+constexpr const char* const MetaTableName = "luacpp.Buffer";
+
+/**
+ * @brief converts a 1-based (negative values count from the end) position into a 0-based offset
+ * Returns a negative value for positions in front of the buffer.
+*/
+lua_Integer toOffset(lua_Integer pos, size_t size) {
+	if (pos > 0) {
+		return pos - 1;
+	}
+	if (pos == 0) {
+		return -1;
+	}
+	return static_cast<lua_Integer>(size) + pos;
+}
+
+/**
+ * @brief reads the range arguments i [, j] with the semantics of string.sub
+*/
+void subRange(lua_State* state, size_t size, int arg, size_t& offset, size_t& length) {
+	lua_Integer first = toOffset(luaL_checkinteger(state, arg), size);
+	lua_Integer last = toOffset(luaL_optinteger(state, arg + 1, -1), size);
+	if (first < 0) {
+		first = 0;
+	}
+	if (last >= static_cast<lua_Integer>(size)) {
+		last = static_cast<lua_Integer>(size) - 1;
+	}
+	offset = static_cast<size_t>(first);
+	length = first <= last ? static_cast<size_t>(last - first + 1) : 0;
+}
+
+} // namespace
+
+namespace Lua {
+
+Buffer::Buffer(const void* data, size_t size, std::shared_ptr<const void> owner)
+	: m_data(static_cast<const char*>(data))
+	, m_size(size)
+	, m_owner(std::move(owner))
+{}
+
+Buffer Buffer::borrow(const void* data, size_t size, const Lifetime& lifetime) {
+	Buffer buffer(data, size, nullptr);
+	buffer.m_lifetime = lifetime.m_token;
+	buffer.m_borrowed = true;
+	return buffer;
+}
+
+Buffer Buffer::copy(const void* data, size_t size) {
+	std::shared_ptr<char[]> memory(new char[size > 0 ? size : 1]);
+	if (size > 0) {
+		std::memcpy(memory.get(), data, size);
+	}
+	const char* begin = memory.get();
+	return Buffer(begin, size, std::shared_ptr<const void>(std::move(memory), begin));
+}
+
+Buffer Buffer::slice(size_t offset, size_t length) const {
+	Buffer result(*this);
+	offset = offset < m_size ? offset : m_size;
+	result.m_data = m_data + offset;
+	result.m_size = length < m_size - offset ? length : m_size - offset;
+	return result;
+}
+
+void Buffer::push(lua_State* state, Buffer buffer) {
+	void* userData = lua_newuserdatauv(state, sizeof(Buffer), 0);
+	new (userData) Buffer(std::move(buffer));
+	pushMetaTable(state);
+	lua_setmetatable(state, -2);
+}
+
+const Buffer* Buffer::fromStack(lua_State* state, int index) {
+	return static_cast<const Buffer*>(luaL_testudata(state, index, MetaTableName));
+}
+
+std::string_view Buffer::viewFromStack(lua_State* state, int index) {
+	if (lua_type(state, index) == LUA_TSTRING) {
+		size_t len;
+		const char* str = lua_tolstring(state, index, &len);
+		return std::string_view(str, len);
+	}
+	const Buffer* buffer = fromStack(state, index);
+	if (buffer == nullptr || !buffer->isValid()) {
+		return std::string_view();
+	}
+	return buffer->view();
+}
+
+const Buffer& Buffer::checkBuffer(lua_State* state, int index) {
+	const Buffer* buffer = static_cast<const Buffer*>(luaL_checkudata(state, index, MetaTableName));
+	if (!buffer->isValid()) {
+		luaL_error(state, "attempt to access an expired buffer");
+	}
+	return *buffer;
+}
+
+size_t Buffer::checkPosition(lua_State* state, const Buffer& buffer, int arg, size_t width) {
+	const lua_Integer offset = toOffset(luaL_checkinteger(state, arg), buffer.m_size);
+	luaL_argcheck(state, offset >= 0 && static_cast<size_t>(offset) <= buffer.m_size
+		&& width <= buffer.m_size - static_cast<size_t>(offset), arg, "position out of range");
+	return static_cast<size_t>(offset);
+}
+
+template <typename T>
+T Buffer::readLittleEndian(const char* data) {
+	using Unsigned = std::conditional_t<sizeof(T) == 1, uint8_t,
+		std::conditional_t<sizeof(T) == 2, uint16_t,
+		std::conditional_t<sizeof(T) == 4, uint32_t, uint64_t>>>;
+	Unsigned bits = 0;
+	for (size_t i = 0; i < sizeof(T); ++i) {
+		bits |= static_cast<Unsigned>(static_cast<uint8_t>(data[i])) << (8 * i);
+	}
+	T value;
+	std::memcpy(&value, &bits, sizeof(T));
+	return value;
+}
+
+template <typename T>
+int Buffer::read(lua_State* state) {
+	const Buffer& buffer = checkBuffer(state, 1);
+	const T value = readLittleEndian<T>(buffer.m_data + checkPosition(state, buffer, 2, sizeof(T)));
+	if constexpr (std::is_floating_point_v<T>) {
+		lua_pushnumber(state, static_cast<lua_Number>(value));
+	} else {
+		lua_pushinteger(state, static_cast<lua_Integer>(value)); //readu64 wraps around like all lua integers
+	}
+	return 1;
+}
+
+void Buffer::pushMetaTable(lua_State* state) {
+	if (luaL_newmetatable(state, MetaTableName) == 0) {
+		return; //already registered in this state
+	}
+	const luaL_Reg methods[] = {
+		{"len", len},
+		{"sub", sub},
+		{"byte", read<uint8_t>},
+		{"readu8", read<uint8_t>},
+		{"readu16", read<uint16_t>},
+		{"readu32", read<uint32_t>},
+		{"readu64", read<uint64_t>},
+		{"readi8", read<int8_t>},
+		{"readi16", read<int16_t>},
+		{"readi32", read<int32_t>},
+		{"readi64", read<int64_t>},
+		{"readf32", read<float>},
+		{"readf64", read<double>},
+		{"tostring", toString},
+		{nullptr, nullptr}
+	};
+	luaL_newlib(state, methods);
+	lua_pushcclosure(state, index, 1);
+	lua_setfield(state, -2, "__index");
+
+	const luaL_Reg functions[] = {
+		{"__len", len},
+		{"__tostring", toString},
+		{"__gc", gc},
+		{nullptr, nullptr}
+	};
+	luaL_setfuncs(state, functions, 0);
+}
+
+int Buffer::index(lua_State* state) {
+	const Buffer& buffer = checkBuffer(state, 1);
+	if (lua_type(state, 2) == LUA_TSTRING) {
+		lua_pushvalue(state, 2);
+		lua_rawget(state, lua_upvalueindex(1));
+		return 1;
+	}
+	int isInteger = 0;
+	const lua_Integer pos = lua_tointegerx(state, 2, &isInteger);
+	if (isInteger == 0 || pos < 1 || static_cast<size_t>(pos) > buffer.m_size) {
+		lua_pushnil(state);
+	} else {
+		lua_pushinteger(state, static_cast<uint8_t>(buffer.m_data[pos - 1]));
+	}
+	return 1;
+}
+
+int Buffer::len(lua_State* state) {
+	lua_pushinteger(state, static_cast<lua_Integer>(checkBuffer(state, 1).m_size));
+	return 1;
+}
+
+int Buffer::sub(lua_State* state) {
+	const Buffer& buffer = checkBuffer(state, 1);
+	size_t offset, length;
+	subRange(state, buffer.m_size, 2, offset, length);
+	push(state, buffer.slice(offset, length));
+	return 1;
+}
+
+int Buffer::toString(lua_State* state) {
+	const Buffer& buffer = checkBuffer(state, 1);
+	size_t offset = 0, length = buffer.m_size;
+	if (!lua_isnoneornil(state, 2)) {
+		subRange(state, buffer.m_size, 2, offset, length);
+	}
+	lua_pushlstring(state, buffer.m_data + offset, length);
+	return 1;
+}
+
+int Buffer::gc(lua_State* state) {
+	static_cast<Buffer*>(luaL_checkudata(state, 1, MetaTableName))->~Buffer();
+	return 0;
+}
+
+} // namespace Lua
\ No newline at end of file
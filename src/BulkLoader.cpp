@@ -0,0 +1,153 @@
+#include <BulkLoader.hpp>
+#include <lua/lua.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <thread>
+
+namespace Lua {
+
+BulkLoader::BulkLoader() : BulkLoader(Options()) {}
+
+BulkLoader::BulkLoader(const Options& options) : m_options(options) {}
+
+void BulkLoader::add(std::string key, std::string source, std::string chunkName) {
+	Script script;
+	script.chunkName = chunkName.empty() ? "=" + key : std::move(chunkName);
+	script.key = std::move(key);
+	script.source = std::move(source);
+	m_scripts.push_back(std::move(script));
+}
+
+void BulkLoader::addFile(std::string key, std::filesystem::path path) {
+	Script script;
+	script.chunkName = "@" + path.string();
+	script.key = std::move(key);
+	script.path = std::move(path);
+	m_scripts.push_back(std::move(script));
+}
+
+size_t BulkLoader::addDirectory(const std::filesystem::path& directory, const std::string& extension) {
+	std::vector<std::filesystem::path> files;
+	std::error_code error;
+	for (auto it = std::filesystem::recursive_directory_iterator(directory, error); !error && it != std::filesystem::recursive_directory_iterator(); it.increment(error)) {
+		if (it->is_regular_file(error) && it->path().extension() == extension) {
+			files.push_back(it->path());
+		}
+	}
+	//sorted, so the keys are added in the same order on every platform
+	std::sort(files.begin(), files.end());
+
+	for (const std::filesystem::path& file : files) {
+		std::filesystem::path relative = file.lexically_relative(directory);
+		relative.replace_extension();
+		std::string key;
+		for (const std::filesystem::path& part : relative) {
+			if (!key.empty()) {
+				key += '.';
+			}
+			key += part.string();
+		}
+		addFile(std::move(key), file);
+	}
+	return files.size();
+}
+
+size_t BulkLoader::compile() {
+	std::vector<size_t> pending;
+	for (size_t i = 0; i < m_scripts.size(); ++i) {
+		if (!m_scripts[i].compiled) {
+			pending.push_back(i);
+		}
+	}
+
+	if (!pending.empty()) {
+		size_t threads = m_options.threads != 0 ? m_options.threads : std::max<size_t>(std::thread::hardware_concurrency(), 1);
+		threads = std::min(threads, pending.size());
+		m_threads = threads;
+
+		const auto start = std::chrono::steady_clock::now();
+		std::atomic<size_t> next{0};
+		std::vector<std::thread> workers;
+		workers.reserve(threads - 1);
+		for (size_t i = 1; i < threads; ++i) {
+			workers.emplace_back(&BulkLoader::compileScripts, this, std::cref(pending), std::ref(next));
+		}
+		compileScripts(pending, next);
+		for (std::thread& worker : workers) {
+			worker.join();
+		}
+		m_compileTime = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+	}
+
+	return static_cast<size_t>(std::count_if(m_scripts.begin(), m_scripts.end(), [](const Script& script) {
+		return script.status != Registry::ErrorCode::Ok;
+	}));
+}
+
+BulkLoader::Result BulkLoader::load(lua_State* state) {
+	Result result;
+	compile();
+	result.threads = m_threads;
+	result.compileTime = m_compileTime;
+
+	const auto start = std::chrono::steady_clock::now();
+	Registry registry(state);
+	for (const Script& script : m_scripts) {
+		if (script.status != Registry::ErrorCode::Ok) {
+			result.errors[script.key] = script.error;
+			continue;
+		}
+		if (registry.loadBytecode(script.key.c_str(), script.bytecode, script.chunkName.c_str()) == Registry::ErrorCode::Ok) {
+			++result.loaded;
+		} else {
+			const char* message = lua_tostring(state, -1);
+			result.errors[script.key] = message != nullptr ? message : "unknown error";
+			lua_pop(state, 1);
+		}
+	}
+	result.loadTime = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+	return result;
+}
+
+void BulkLoader::clear() {
+	m_scripts.clear();
+}
+
+void BulkLoader::compileScripts(const std::vector<size_t>& pending, std::atomic<size_t>& next) {
+	lua_State* scratch = luaL_newstate();
+	for (size_t i = next.fetch_add(1, std::memory_order_relaxed); i < pending.size(); i = next.fetch_add(1, std::memory_order_relaxed)) {
+		Script& script = m_scripts[pending[i]];
+		if (scratch == nullptr) {
+			script.status = Registry::ErrorCode::MemoryError;
+			script.error = "not enough memory";
+		} else {
+			compileScript(scratch, script);
+		}
+		script.compiled = true;
+	}
+	if (scratch != nullptr) {
+		lua_close(scratch);
+	}
+}
+
+void BulkLoader::compileScript(lua_State* scratch, Script& script) {
+	if (!script.path.empty()) {
+		std::ifstream file(script.path, std::ios::binary);
+		if (!file) {
+			script.status = Registry::ErrorCode::RuntimeError;
+			script.error = "cannot open " + script.path.string();
+			return;
+		}
+		script.source.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	}
+	script.status = Registry::compile(scratch, script.source, script.chunkName.c_str(), script.bytecode, script.error, m_options.stripDebugInfo);
+	if (script.status == Registry::ErrorCode::Ok) {
+		script.error.clear();
+	}
+	//only the bytecode is needed from now on
+	std::string().swap(script.source);
+}
+
+} // namespace Lua
\ No newline at end of file
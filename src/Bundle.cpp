@@ -0,0 +1,70 @@
+#include <Bundle.hpp>
+#include <lua/lua.hpp>
+
+#include <algorithm>
+
+namespace Lua {
+
+const Bundle::Module* Bundle::find(std::string_view name) const {
+	const Module* end = m_modules + m_count;
+	const Module* it = std::lower_bound(m_modules, end, name, [](const Module& module, std::string_view value) {
+		return std::string_view(module.name) < value;
+	});
+	return it != end && name == it->name ? it : nullptr;
+}
+
+bool Bundle::load(lua_State* state, std::string_view name) const {
+	const Module* module = find(name);
+	if (module == nullptr) {
+		lua_pushliteral(state, "no module '");
+		lua_pushlstring(state, name.data(), name.size());
+		lua_pushliteral(state, "' in bundle");
+		lua_concat(state, 3);
+		return false;
+	}
+	lua_pushfstring(state, "=%s", module->name);
+	const char* chunkName = lua_tostring(state, -1);
+	const char* data = reinterpret_cast<const char*>(m_data + module->offset);
+	const int res = luaL_loadbufferx(state, data, module->size, chunkName, "b");
+	lua_remove(state, -2);
+	return res == LUA_OK;
+}
+
+bool Bundle::install(lua_State* state) const {
+	const int top = lua_gettop(state);
+	luaL_getsubtable(state, LUA_REGISTRYINDEX, LUA_LOADED_TABLE);
+	if (lua_getfield(state, -1, LUA_LOADLIBNAME) != LUA_TTABLE || lua_getfield(state, -1, "searchers") != LUA_TTABLE) {
+		lua_settop(state, top);
+		return false;
+	}
+
+	//searchers[1] handles package.preload, the bundle comes right after it
+	const lua_Integer count = luaL_len(state, -1);
+	for (lua_Integer i = count; i >= 2; --i) {
+		lua_rawgeti(state, -1, i);
+		lua_rawseti(state, -2, i + 1);
+	}
+	lua_pushlightuserdata(state, const_cast<Bundle*>(this));
+	lua_pushcclosure(state, &Bundle::searcher, 1);
+	lua_rawseti(state, -2, count >= 1 ? 2 : 1);
+	lua_settop(state, top);
+	return true;
+}
+
+int Bundle::searcher(lua_State* state) {
+	const Bundle* bundle = static_cast<const Bundle*>(lua_touserdata(state, lua_upvalueindex(1)));
+	size_t length = 0;
+	const char* name = luaL_checklstring(state, 1, &length);
+	if (bundle->find(std::string_view(name, length)) == nullptr) {
+		lua_pushfstring(state, "no module '%s' in bundle", name);
+		return 1;
+	}
+	if (!bundle->load(state, std::string_view(name, length))) {
+		return luaL_error(state, "error loading module '%s' from bundle:\n\t%s", name, lua_tostring(state, -1));
+	}
+	//the second value is passed to the loader like the file name by the other searchers
+	lua_pushfstring(state, "bundle:%s", name);
+	return 2;
+}
+
+} // namespace Lua
\ No newline at end of file
@@ -0,0 +1,99 @@
+#include <CoroutinePool.hpp>
+#include <lua/lua.hpp>
+
+namespace Lua {
+
+CoroutinePool::CoroutinePool(lua_State* state, size_t maxIdle) : m_state(state), m_maxIdle(maxIdle) {
+	m_idle.reserve(maxIdle);
+	m_statistics.maxIdle = maxIdle;
+}
+
+CoroutinePool::~CoroutinePool() {
+	for (Thread& thread : m_idle) {
+		luaL_unref(m_state, LUA_REGISTRYINDEX, thread.reference);
+	}
+}
+
+CoroutinePool::Thread CoroutinePool::acquire() {
+	Thread thread;
+	if (!m_idle.empty()) {
+		thread = m_idle.back();
+		m_idle.pop_back();
+		++m_statistics.reused;
+	} else {
+		thread.state = lua_newthread(m_state);
+		thread.reference = luaL_ref(m_state, LUA_REGISTRYINDEX);
+		++m_statistics.created;
+	}
+	m_statistics.idle = m_idle.size();
+	++m_statistics.active;
+	return thread;
+}
+
+void CoroutinePool::release(Thread& thread) {
+	if (thread.state == nullptr) {
+		return;
+	}
+	--m_statistics.active;
+	if (m_idle.size() >= m_maxIdle) {
+		discard(thread);
+		return;
+	}
+	//the status returned is the one of the last error, the thread is usable again in any case
+	lua_closethread(thread.state, m_state);
+	m_idle.push_back(thread);
+	m_statistics.idle = m_idle.size();
+	thread = Thread();
+}
+
+int CoroutinePool::call(int numArgs, int numResults) {
+	Thread thread = acquire();
+	lua_xmove(m_state, thread.state, numArgs + 1);
+
+	int results = 0;
+	int status = lua_resume(thread.state, m_state, numArgs, &results);
+	if (status == LUA_OK) {
+		if (numResults != LUA_MULTRET) {
+			lua_settop(thread.state, lua_gettop(thread.state) - results + numResults);
+			results = numResults;
+		}
+		if (lua_checkstack(m_state, results)) {
+			lua_xmove(thread.state, m_state, results);
+		} else {
+			m_lastError = "stack overflow (too many results)";
+			status = LUA_ERRMEM;
+		}
+	} else if (status == LUA_YIELD) {
+		m_lastError = "attempt to yield from a pooled thread";
+		status = LUA_ERRRUN;
+	} else {
+		setError(thread.state);
+	}
+
+	release(thread);
+	return status;
+}
+
+void CoroutinePool::setMaxIdle(size_t maxIdle) {
+	m_maxIdle = maxIdle;
+	m_statistics.maxIdle = maxIdle;
+	while (m_idle.size() > m_maxIdle) {
+		discard(m_idle.back());
+		m_idle.pop_back();
+	}
+	m_statistics.idle = m_idle.size();
+}
+
+void CoroutinePool::discard(Thread& thread) {
+	//without the reference the garbage collector reclaims the thread
+	luaL_unref(m_state, LUA_REGISTRYINDEX, thread.reference);
+	thread = Thread();
+	++m_statistics.discarded;
+}
+
+void CoroutinePool::setError(lua_State* thread) {
+	const char* message = lua_tostring(thread, -1);
+	m_lastError = message != nullptr ? message : "error object is not a string";
+}
+
+} // namespace Lua
\ No newline at end of file
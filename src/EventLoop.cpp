@@ -0,0 +1,213 @@
+#include <EventLoop.hpp>
+#include <lua/lua.hpp>
+
+#ifdef __linux__
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <functional>
+#include <system_error>
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+namespace Lua {
+
+static EventLoop* getLoop(lua_State* state) {
+	return static_cast<EventLoop*>(lua_touserdata(state, lua_upvalueindex(1)));
+}
+
+EventLoop::EventLoop(lua_State* state) : m_state(state), m_scheduler(state) {
+	m_epoll = epoll_create1(EPOLL_CLOEXEC);
+	m_timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+	m_eventFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	for (int fd : {m_timerFd, m_eventFd}) {
+		epoll_event event{};
+		event.events = EPOLLIN;
+		event.data.fd = fd;
+		if (fd < 0 || m_epoll < 0 || epoll_ctl(m_epoll, EPOLL_CTL_ADD, fd, &event) != 0) {
+			const int error = errno;
+			for (int descriptor : {m_epoll, m_timerFd, m_eventFd}) {
+				if (descriptor >= 0) {
+					close(descriptor);
+				}
+			}
+			throw std::system_error(error, std::generic_category(), "failed to create the event loop");
+		}
+	}
+
+	m_scheduler.setNotifier([this]() {
+		if (m_sleeping.load()) {
+			wakeup();
+		}
+	});
+
+	const luaL_Reg functions[] = {{"sleep", &EventLoop::sleep}, {"after", &EventLoop::after}, {"wait_readable", &EventLoop::waitReadable}};
+	for (const luaL_Reg& function : functions) {
+		lua_pushlightuserdata(m_state, this);
+		lua_pushcclosure(m_state, function.func, 1);
+		lua_setglobal(m_state, function.name);
+	}
+}
+
+EventLoop::~EventLoop() {
+	m_scheduler.setNotifier(nullptr);
+	for (const char* name : {"sleep", "after", "wait_readable"}) {
+		lua_pushnil(m_state);
+		lua_setglobal(m_state, name);
+	}
+	for (const Timer& timer : m_timers) {
+		luaL_unref(m_state, LUA_REGISTRYINDEX, timer.callback);
+	}
+	m_timers.clear();
+	m_waits.clear();
+	close(m_eventFd);
+	close(m_timerFd);
+	close(m_epoll);
+}
+
+bool EventLoop::run(std::chrono::milliseconds timeout) {
+	const Clock::time_point deadline = Clock::now() + timeout;
+	while (true) {
+		m_scheduler.poll();
+		if (isDone()) {
+			return true;
+		}
+		if (m_stop.exchange(false)) {
+			return false;
+		}
+		const Clock::time_point now = Clock::now();
+		if (now >= deadline) {
+			return false;
+		}
+		int64_t remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now).count() + 1;
+		if (m_scheduler.getFutureCount() > 0) {
+			remaining = 1; //futures have no notification, so they are checked in short intervals
+		}
+		wait(static_cast<int>(std::min<int64_t>(remaining, INT_MAX)));
+	}
+}
+
+void EventLoop::stop() {
+	m_stop.store(true);
+	wakeup();
+}
+
+int EventLoop::sleep(lua_State* state) {
+	EventLoop* loop = getLoop(state);
+	const lua_Number milliseconds = luaL_checknumber(state, 1);
+	{
+		Scheduler::Completion completion = Scheduler::begin(state);
+		loop->addTimer(milliseconds, std::move(completion), LUA_NOREF);
+	}
+	return Scheduler::yield(state);
+}
+
+int EventLoop::after(lua_State* state) {
+	EventLoop* loop = getLoop(state);
+	const lua_Number milliseconds = luaL_checknumber(state, 1);
+	luaL_checktype(state, 2, LUA_TFUNCTION);
+	lua_pushvalue(state, 2);
+	const int callback = luaL_ref(state, LUA_REGISTRYINDEX);
+	loop->addTimer(milliseconds, Scheduler::Completion(), callback);
+	return 0;
+}
+
+int EventLoop::waitReadable(lua_State* state) {
+	EventLoop* loop = getLoop(state);
+	const int fd = static_cast<int>(luaL_checkinteger(state, 1));
+	Scheduler::checkAwaitable(state);
+	if (loop->m_waits.count(fd) != 0) {
+		return luaL_error(state, "a coroutine is already waiting for descriptor %d", fd);
+	}
+	epoll_event event{};
+	event.events = EPOLLIN;
+	event.data.fd = fd;
+	if (epoll_ctl(loop->m_epoll, EPOLL_CTL_ADD, fd, &event) != 0) {
+		return luaL_error(state, "cannot wait for descriptor %d: %s", fd, strerror(errno));
+	}
+	loop->m_waits.emplace(fd, Scheduler::begin(state));
+	return Scheduler::yield(state);
+}
+
+void EventLoop::addTimer(double milliseconds, Scheduler::Completion completion, int callback) {
+	const auto delay = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::milli>(std::max(milliseconds, 0.0)));
+	m_timers.push_back({Clock::now() + delay, m_nextSequence++, std::move(completion), callback});
+	std::push_heap(m_timers.begin(), m_timers.end(), std::greater<Timer>());
+}
+
+void EventLoop::armTimer() {
+	const Clock::time_point deadline = m_timers.empty() ? Clock::time_point() : m_timers.front().deadline;
+	if (deadline == m_armed) {
+		return;
+	}
+	//steady_clock is CLOCK_MONOTONIC, so the deadline can be used as absolute time of the timerfd
+	const auto sinceEpoch = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline.time_since_epoch()).count();
+	itimerspec spec{};
+	spec.it_value.tv_sec = static_cast<time_t>(sinceEpoch / 1000000000);
+	spec.it_value.tv_nsec = static_cast<long>(sinceEpoch % 1000000000);
+	if (!m_timers.empty() && spec.it_value.tv_sec == 0 && spec.it_value.tv_nsec == 0) {
+		spec.it_value.tv_nsec = 1; //a zero value would disarm the timer
+	}
+	timerfd_settime(m_timerFd, TFD_TIMER_ABSTIME, &spec, nullptr);
+	m_armed = deadline;
+}
+
+void EventLoop::expireTimers() {
+	const Clock::time_point now = Clock::now();
+	while (!m_timers.empty() && m_timers.front().deadline <= now) {
+		std::pop_heap(m_timers.begin(), m_timers.end(), std::greater<Timer>());
+		Timer timer = std::move(m_timers.back());
+		m_timers.pop_back();
+		if (timer.callback != LUA_NOREF) {
+			lua_rawgeti(m_state, LUA_REGISTRYINDEX, timer.callback);
+			luaL_unref(m_state, LUA_REGISTRYINDEX, timer.callback);
+			m_scheduler.spawn(0);
+		} else {
+			timer.completion.resolve();
+		}
+	}
+}
+
+void EventLoop::wait(int timeout) {
+	armTimer();
+	epoll_event events[64];
+	m_sleeping.store(true);
+	//checked after announcing the sleep, so a completion posted in between either is seen here or wakes up epoll_wait
+	if (m_scheduler.hasWork() || m_stop.load()) {
+		timeout = 0;
+	}
+	const int count = epoll_wait(m_epoll, events, 64, timeout);
+	m_sleeping.store(false);
+
+	for (int i = 0; i < count; ++i) {
+		const int fd = events[i].data.fd;
+		if (fd == m_timerFd || fd == m_eventFd) {
+			uint64_t value;
+			[[maybe_unused]] ssize_t size = read(fd, &value, sizeof(value));
+			if (fd == m_timerFd) {
+				m_armed = Clock::time_point();
+			}
+			continue;
+		}
+		auto it = m_waits.find(fd);
+		if (it != m_waits.end()) {
+			epoll_ctl(m_epoll, EPOLL_CTL_DEL, fd, nullptr);
+			it->second.resolve();
+			m_waits.erase(it);
+		}
+	}
+	expireTimers();
+}
+
+void EventLoop::wakeup() {
+	const uint64_t value = 1;
+	[[maybe_unused]] ssize_t size = write(m_eventFd, &value, sizeof(value));
+}
+
+} // namespace Lua
+
+#endif // __linux__
\ No newline at end of file
@@ -0,0 +1,95 @@
+#include <GarbageCollector.hpp>
+#include <lua/lua.hpp>
+
+namespace Lua {
+
+GarbageCollector::GarbageCollector(lua_State* state)
+: m_state(state),
+  m_mode(Mode::Incremental)
+{
+}
+
+GarbageCollector::Mode GarbageCollector::setIncremental(const IncrementalParameters& parameters) {
+	const int previous = lua_gc(m_state, LUA_GCINC, parameters.pause, parameters.stepMultiplier, parameters.stepSize);
+	m_mode = Mode::Incremental;
+	return previous == LUA_GCGEN ? Mode::Generational : Mode::Incremental;
+}
+
+GarbageCollector::Mode GarbageCollector::setGenerational(const GenerationalParameters& parameters) {
+	const int previous = lua_gc(m_state, LUA_GCGEN, parameters.minorMultiplier, parameters.majorMultiplier);
+	m_mode = Mode::Generational;
+	return previous == LUA_GCGEN ? Mode::Generational : Mode::Incremental;
+}
+
+void GarbageCollector::stop() {
+	lua_gc(m_state, LUA_GCSTOP);
+}
+
+void GarbageCollector::restart() {
+	lua_gc(m_state, LUA_GCRESTART);
+}
+
+bool GarbageCollector::isRunning() const {
+	return lua_gc(m_state, LUA_GCISRUNNING) != 0;
+}
+
+void GarbageCollector::collect() {
+	Tracer::Scope scope(Tracer::Category::GarbageCollection, "collect");
+	const size_t memoryBefore = getMemoryUsage();
+	const auto start = std::chrono::steady_clock::now();
+	lua_gc(m_state, LUA_GCCOLLECT);
+	account(memoryBefore, std::chrono::steady_clock::now() - start, 0, true);
+}
+
+bool GarbageCollector::step(int kilobytes) {
+	Tracer::Scope scope(Tracer::Category::GarbageCollection, "step");
+	const size_t memoryBefore = getMemoryUsage();
+	const auto start = std::chrono::steady_clock::now();
+	const bool finishedCycle = lua_gc(m_state, LUA_GCSTEP, kilobytes) != 0;
+	account(memoryBefore, std::chrono::steady_clock::now() - start, 1, finishedCycle);
+	return finishedCycle;
+}
+
+bool GarbageCollector::stepFor(std::chrono::microseconds budget) {
+	Tracer::Scope scope(Tracer::Category::GarbageCollection, "stepFor");
+	const size_t memoryBefore = getMemoryUsage();
+	const auto start = std::chrono::steady_clock::now();
+	const auto deadline = start + budget;
+
+	uint64_t steps = 0;
+	bool finishedCycle = false;
+	auto now = start;
+	do {
+		finishedCycle = lua_gc(m_state, LUA_GCSTEP, 0) != 0;
+		++steps;
+		now = std::chrono::steady_clock::now();
+	} while (!finishedCycle && now < deadline);
+
+	account(memoryBefore, now - start, steps, finishedCycle);
+	return finishedCycle;
+}
+
+size_t GarbageCollector::getMemoryUsage() const {
+	//lua reports the memory in two parts: the number of kilobytes and the remainder in bytes
+	const size_t kilobytes = static_cast<size_t>(lua_gc(m_state, LUA_GCCOUNT));
+	const size_t bytes = static_cast<size_t>(lua_gc(m_state, LUA_GCCOUNTB));
+	return kilobytes * 1024 + bytes;
+}
+
+void GarbageCollector::account(size_t memoryBefore, std::chrono::steady_clock::duration duration, uint64_t steps, bool finishedCycle) {
+	const size_t memoryAfter = getMemoryUsage();
+	if (memoryAfter < memoryBefore) {
+		m_statistics.bytesFreed += memoryBefore - memoryAfter;
+	}
+	m_statistics.steps += steps;
+	if (finishedCycle) {
+		++m_statistics.collections;
+	}
+	m_statistics.stepTime += std::chrono::duration_cast<std::chrono::nanoseconds>(duration);
+	if (m_metrics) {
+		m_metrics->recordGarbageCollection(steps, finishedCycle);
+		m_metrics->setHeapBytes(memoryAfter);
+	}
+}
+
+} // namespace Lua
\ No newline at end of file
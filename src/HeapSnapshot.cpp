@@ -0,0 +1,633 @@
+#include <HeapSnapshot.hpp>
+#include <lua/lua.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <exception>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <new>
+#include <system_error>
+#include <unordered_map>
+
+namespace Lua {
+
+namespace {
+
+constexpr const char* const Header = "luacpp-heap-snapshot 1";
+constexpr uint32_t Root = 0; ///< virtual node referencing _G and the registry
+constexpr uint32_t Undefined = std::numeric_limits<uint32_t>::max();
+constexpr size_t MaxKeyLength = 40; ///< longer string keys are shortened in paths
+
+//estimated sizes of the lua 5.4 objects on 64 bit platforms (see lobject.h and lstate.h)
+constexpr uint64_t StringSize = 24;
+constexpr uint64_t TableSize = 56;
+constexpr uint64_t ArraySlotSize = 16;
+constexpr uint64_t NodeSize = 32;
+constexpr uint64_t ClosureSize = 32;
+constexpr uint64_t UpvalueSize = 40;
+constexpr uint64_t UserdataSize = 40;
+constexpr uint64_t ThreadSize = 208;
+constexpr uint64_t StackSlotSize = 16;
+
+bool isIdentifier(const char* text, size_t length) {
+	if (length == 0 || (text[0] >= '0' && text[0] <= '9')) {
+		return false;
+	}
+	return std::all_of(text, text + length, [](char c) {
+		return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+	});
+}
+
+/**
+ * @brief name of the edge leading to an object, only formatted for the objects stored in the snapshot
+ * The texts belong to the state (keys, names of locals and upvalues). They stay valid because the state isn't modified
+ * and the garbage collector is stopped during the capture.
+*/
+struct Name {
+	enum Kind : uint8_t { None, Globals, Registry, Field, Integer, Number, Boolean, Object, Upvalue, Uservalue, Frame, Local, Stack, Metatable };
+
+	Kind kind = None;
+	bool key = false; ///< the edge leads to the key of a table entry instead of its value
+	int32_t index = 0;
+	const char* text = nullptr;
+	union {
+		size_t length = 0;
+		lua_Integer integer;
+		lua_Number number;
+	};
+
+	std::string format() const {
+		std::string name;
+		switch (kind) {
+		case None:
+			break;
+		case Globals:
+			name = "_G";
+			break;
+		case Registry:
+			name = "registry";
+			break;
+		case Field:
+			if (isIdentifier(text, length)) {
+				name = "." + std::string(text, length);
+			} else {
+				name = "[\"";
+				for (size_t i = 0; i < std::min(length, MaxKeyLength); ++i) {
+					const unsigned char c = static_cast<unsigned char>(text[i]);
+					if (c < 32 || c == 127 || c == '"' || c == '\\') {
+						name += "\\" + std::to_string(c);
+					} else {
+						name += static_cast<char>(c);
+					}
+				}
+				name += length > MaxKeyLength ? "...\"]" : "\"]";
+			}
+			break;
+		case Integer:
+			name = "[" + std::to_string(integer) + "]";
+			break;
+		case Number: {
+			char buffer[32];
+			std::snprintf(buffer, sizeof(buffer), "[%.14g]", static_cast<double>(number));
+			name = buffer;
+			break;
+		}
+		case Boolean:
+			name = index != 0 ? "[true]" : "[false]";
+			break;
+		case Object:
+			name = std::string("[") + text + "]";
+			break;
+		case Upvalue:
+			name = *text != '\0' ? std::string("(upvalue ") + text + ")" : "(upvalue " + std::to_string(index) + ")";
+			break;
+		case Uservalue:
+			name = "(uservalue " + std::to_string(index) + ")";
+			break;
+		case Frame:
+			name = "(frame " + std::to_string(index) + ")";
+			break;
+		case Local:
+			name = "(frame " + std::to_string(index) + " " + text + ")";
+			break;
+		case Stack:
+			name = "(stack " + std::to_string(index) + ")";
+			break;
+		case Metatable:
+			name = "(metatable)";
+			break;
+		}
+		return key ? name + "(key)" : name;
+	}
+};
+
+/**
+ * @brief ids of the objects found so far by their address
+ * Lua objects are larger than 16 bytes, so the address divided by 16 identifies them. The ids are stored in pages
+ * covering 1 MB of address space, allocated for the ranges in which objects are found. The walk finds objects roughly in
+ * the order they were allocated, so most lookups hit the page of the previous one instead of missing the cache.
+*/
+class ObjectIndex {
+public:
+	/**
+	 * @brief insert the id unless the object is already known
+	 * @return The id of the object and true if it was inserted
+	*/
+	std::pair<uint32_t, bool> insert(const void* object, uint32_t id) {
+		const uintptr_t address = reinterpret_cast<uintptr_t>(object);
+		if ((address >> PageBits) != m_lastPage) {
+			m_lastPage = address >> PageBits;
+			std::unique_ptr<uint32_t[]>& page = m_pages[m_lastPage];
+			if (!page) {
+				page = std::make_unique<uint32_t[]>(PageSize);
+			}
+			m_last = page.get();
+		}
+		uint32_t& slot = m_last[(address >> 4) & (PageSize - 1)];
+		if (slot != 0) {
+			return {slot, false};
+		}
+		slot = id;
+		return {id, true};
+	}
+
+private:
+	static constexpr unsigned PageBits = 20;
+	static constexpr size_t PageSize = size_t(1) << (PageBits - 4);
+
+	std::unordered_map<uintptr_t, std::unique_ptr<uint32_t[]>> m_pages;
+	uintptr_t m_lastPage = std::numeric_limits<uintptr_t>::max();
+	uint32_t* m_last = nullptr;
+};
+
+/**
+ * @brief walks the object graph, the nodes are numbered in the order they are found (breadth first)
+ * Objects are kept alive in a queue table on the stack until they are visited. Apart from the insertions into this table
+ * no lua function used by the walk raises errors. The visited entries of the queue are overwritten instead of cleared,
+ * the objects are reachable from the roots anyway.
+*/
+class Walker {
+public:
+	explicit Walker(lua_State* state) : m_state(state) {}
+
+	void walk() {
+		lua_State* L = m_state;
+		lua_createtable(L, static_cast<int>(m_capacity), 0);
+		m_queue = lua_gettop(L);
+		addNode(Root, LUA_TNONE, Name());
+		m_offsets.push_back(0);
+
+		Name name;
+		name.kind = Name::Globals;
+		lua_rawgeti(L, LUA_REGISTRYINDEX, LUA_RIDX_GLOBALS);
+		addEdge(Root, name);
+		name.kind = Name::Registry;
+		lua_pushvalue(L, LUA_REGISTRYINDEX);
+		addEdge(Root, name);
+		m_offsets.push_back(m_edges.size());
+
+		for (uint32_t node = 1; node < m_nodeCount; ++node) {
+			lua_rawgeti(L, m_queue, slot(node));
+			m_next = node + 1;
+			visit(node);
+			lua_pop(L, 1);
+			m_offsets.push_back(m_edges.size());
+		}
+	}
+
+	uint32_t getNodeCount() const { return m_nodeCount; }
+
+	/**
+	 * @brief immediate dominators (Cooper, Harvey and Kennedy)
+	 * The breadth first numbering puts every dominator before the nodes it dominates, which is what the intersection
+	 * of the dominator paths relies on.
+	*/
+	std::vector<uint32_t> getDominators() const {
+		std::vector<size_t> predecessorOffsets(m_nodeCount + 1, 0);
+		for (uint32_t target : m_edges) {
+			++predecessorOffsets[target + 1];
+		}
+		for (size_t i = 1; i < predecessorOffsets.size(); ++i) {
+			predecessorOffsets[i] += predecessorOffsets[i - 1];
+		}
+		std::vector<uint32_t> predecessors(m_edges.size());
+		std::vector<size_t> fill(predecessorOffsets.begin(), predecessorOffsets.end() - 1);
+		for (uint32_t node = 0; node < m_nodeCount; ++node) {
+			for (size_t edge = m_offsets[node]; edge < m_offsets[node + 1]; ++edge) {
+				predecessors[fill[m_edges[edge]]++] = node;
+			}
+		}
+
+		std::vector<uint32_t> dominators(m_nodeCount, Undefined);
+		dominators[Root] = Root;
+		auto intersect = [&dominators](uint32_t a, uint32_t b) {
+			while (a != b) {
+				while (a > b) {
+					a = dominators[a];
+				}
+				while (b > a) {
+					b = dominators[b];
+				}
+			}
+			return a;
+		};
+		for (bool changed = true; changed;) {
+			changed = false;
+			for (uint32_t node = 1; node < m_nodeCount; ++node) {
+				uint32_t dominator = Undefined;
+				for (size_t i = predecessorOffsets[node]; i < predecessorOffsets[node + 1]; ++i) {
+					const uint32_t predecessor = predecessors[i];
+					if (dominators[predecessor] != Undefined) {
+						dominator = dominator == Undefined ? predecessor : intersect(predecessor, dominator);
+					}
+				}
+				if (dominators[node] != dominator) {
+					dominators[node] = dominator;
+					changed = true;
+				}
+			}
+		}
+		return dominators;
+	}
+
+	/**
+	 * @brief the names of the edges on the shortest path from the roots
+	*/
+	std::string getPath(uint32_t node) const {
+		const uint32_t parent = m_parents[node];
+		return parent == Root ? m_names[node].format() : getPath(parent) + m_names[node].format();
+	}
+
+	uint32_t getDepth(uint32_t node) const { return m_depths[node]; }
+	uint64_t getShallowSize(uint32_t node) const { return m_sizes[node]; }
+	int getType(uint32_t node) const { return m_types[node]; }
+
+private:
+	void addNode(uint32_t parent, int type, const Name& name) {
+		m_parents.push_back(parent);
+		m_depths.push_back(m_nodeCount == Root ? 0 : m_depths[parent] + 1);
+		m_types.push_back(static_cast<int8_t>(type));
+		m_sizes.push_back(0);
+		m_names.push_back(name);
+		++m_nodeCount;
+	}
+
+	/**
+	 * @brief add an edge to the value on top of the stack and pop it
+	*/
+	void addEdge(uint32_t from, const Name& name) {
+		lua_State* L = m_state;
+		const int type = lua_type(L, -1);
+		if (type != LUA_TSTRING && type != LUA_TTABLE && type != LUA_TFUNCTION && type != LUA_TUSERDATA && type != LUA_TTHREAD) {
+			lua_pop(L, 1);
+			return;
+		}
+		const auto [id, inserted] = m_visited.insert(lua_topointer(L, -1), m_nodeCount);
+		m_edges.push_back(id);
+		if (inserted) {
+			addNode(from, type, name);
+			if (id - m_next >= m_capacity) {
+				growQueue(id);
+			}
+			lua_rawseti(L, m_queue, slot(id));
+		} else {
+			lua_pop(L, 1);
+		}
+	}
+
+	lua_Integer slot(uint32_t node) const { return slot(node, m_capacity); }
+	static lua_Integer slot(uint32_t node, uint32_t capacity) { return static_cast<lua_Integer>(node & (capacity - 1)) + 1; }
+
+	/**
+	 * @brief double the size of the queue, which holds the objects found but not visited yet in a ring
+	*/
+	void growQueue(uint32_t end) {
+		lua_State* L = m_state;
+		const uint32_t capacity = m_capacity * 2;
+		lua_createtable(L, static_cast<int>(capacity), 0);
+		for (uint32_t node = m_next; node < end; ++node) {
+			lua_rawgeti(L, m_queue, slot(node));
+			lua_rawseti(L, -2, slot(node, capacity));
+		}
+		lua_replace(L, m_queue);
+		m_capacity = capacity;
+	}
+
+	void visit(uint32_t node) {
+		lua_State* L = m_state;
+		const int object = lua_gettop(L);
+		Name name;
+		switch (m_types[node]) {
+		case LUA_TSTRING: {
+			size_t length = 0;
+			lua_tolstring(L, object, &length);
+			m_sizes[node] = StringSize + length + 1;
+			break;
+		}
+		case LUA_TTABLE:
+			visitTable(node, object);
+			break;
+		case LUA_TFUNCTION:
+			name.kind = Name::Upvalue;
+			while ((name.text = lua_getupvalue(L, object, name.index + 1)) != nullptr) {
+				++name.index;
+				addEdge(node, name);
+			}
+			m_sizes[node] = ClosureSize + static_cast<uint64_t>(name.index) * (lua_iscfunction(L, object) ? StackSlotSize : 8 + UpvalueSize);
+			break;
+		case LUA_TUSERDATA:
+			name.kind = Name::Uservalue;
+			while (lua_getiuservalue(L, object, name.index + 1) != LUA_TNONE) {
+				++name.index;
+				addEdge(node, name);
+			}
+			lua_pop(L, 1);
+			m_sizes[node] = UserdataSize + lua_rawlen(L, object) + static_cast<uint64_t>(name.index) * StackSlotSize;
+			addMetatable(node, object);
+			break;
+		case LUA_TTHREAD: {
+			lua_State* thread = lua_tothread(L, object);
+			if (thread != L) { //the stack of the walk itself is skipped
+				m_sizes[node] = ThreadSize + visitThread(node, thread) * StackSlotSize;
+			} else {
+				m_sizes[node] = ThreadSize;
+			}
+			break;
+		}
+		default:
+			break;
+		}
+	}
+
+	void visitTable(uint32_t node, int table) {
+		lua_State* L = m_state;
+		const lua_Integer length = static_cast<lua_Integer>(lua_rawlen(L, table));
+		uint64_t entries = 0;
+		lua_pushnil(L);
+		while (lua_next(L, table) != 0) {
+			++entries;
+			Name name = keyName(-2);
+			addEdge(node, name);
+			if (name.kind != Name::Integer || name.integer < 1 || name.integer > length) {
+				name.key = true;
+				lua_pushvalue(L, -1);
+				addEdge(node, name);
+			}
+		}
+		m_sizes[node] = TableSize + static_cast<uint64_t>(length) * ArraySlotSize + (entries - std::min<uint64_t>(entries, length)) * NodeSize;
+		addMetatable(node, table);
+	}
+
+	/**
+	 * @brief add the functions and locals of the frames of a suspended coroutine and the values on top of its stack
+	 * @return The number of stack slots found
+	*/
+	uint64_t visitThread(uint32_t node, lua_State* thread) {
+		lua_State* L = m_state;
+		uint64_t slots = 0;
+		lua_Debug ar;
+		Name name;
+		for (int level = 0; lua_getstack(thread, level, &ar) != 0; ++level) {
+			name.index = level;
+			if (lua_checkstack(thread, 1) != 0 && lua_getinfo(thread, "f", &ar) != 0) {
+				name.kind = Name::Frame;
+				lua_xmove(thread, L, 1);
+				addEdge(node, name);
+			}
+			name.kind = Name::Local;
+			for (int local = 1; lua_checkstack(thread, 1) != 0 && (name.text = lua_getlocal(thread, &ar, local)) != nullptr; ++local) {
+				++slots;
+				lua_xmove(thread, L, 1);
+				addEdge(node, name);
+			}
+		}
+		name.kind = Name::Stack;
+		const int top = lua_gettop(thread);
+		for (name.index = 1; name.index <= top && lua_checkstack(thread, 1) != 0; ++name.index) {
+			++slots;
+			lua_pushvalue(thread, name.index);
+			lua_xmove(thread, L, 1);
+			addEdge(node, name);
+		}
+		return slots;
+	}
+
+	void addMetatable(uint32_t node, int object) {
+		if (lua_getmetatable(m_state, object) != 0) {
+			Name name;
+			name.kind = Name::Metatable;
+			addEdge(node, name);
+		}
+	}
+
+	Name keyName(int index) const {
+		lua_State* L = m_state;
+		Name name;
+		switch (lua_type(L, index)) {
+		case LUA_TSTRING:
+			name.kind = Name::Field;
+			name.text = lua_tolstring(L, index, &name.length);
+			break;
+		case LUA_TNUMBER:
+			if (lua_isinteger(L, index) != 0) {
+				name.kind = Name::Integer;
+				name.integer = lua_tointeger(L, index);
+			} else {
+				name.kind = Name::Number;
+				name.number = lua_tonumber(L, index);
+			}
+			break;
+		case LUA_TBOOLEAN:
+			name.kind = Name::Boolean;
+			name.index = lua_toboolean(L, index);
+			break;
+		default:
+			name.kind = Name::Object;
+			name.text = lua_typename(L, lua_type(L, index));
+			break;
+		}
+		return name;
+	}
+
+	lua_State* m_state;
+	int m_queue = 0; ///< stack index of the table holding the objects found but not visited yet
+	uint32_t m_capacity = 1024; ///< size of the queue (a power of two)
+	uint32_t m_next = 1; ///< first object in the queue
+
+	uint32_t m_nodeCount = 0;
+	ObjectIndex m_visited; ///< the root isn't in the index, 0 marks objects not found yet
+	std::vector<uint32_t> m_parents; ///< node from which each node was found first (shortest path)
+	std::vector<uint32_t> m_depths;
+	std::vector<int8_t> m_types;
+	std::vector<uint64_t> m_sizes;
+	std::vector<Name> m_names; ///< name of the edge from the parent
+	std::vector<uint32_t> m_edges; ///< targets of the edges, grouped by source node
+	std::vector<size_t> m_offsets; ///< index of the first edge of each node
+};
+
+struct WalkCall {
+	Walker* walker;
+	std::exception_ptr exception;
+};
+
+int walk(lua_State* L) {
+	WalkCall* call = static_cast<WalkCall*>(lua_touserdata(L, 1));
+	lua_settop(L, 0);
+	try {
+		call->walker->walk();
+	} catch (...) {
+		call->exception = std::current_exception();
+	}
+	return 0;
+}
+
+} // namespace
+
+HeapSnapshot HeapSnapshot::capture(lua_State* state) {
+	return capture(state, Options());
+}
+
+HeapSnapshot HeapSnapshot::capture(lua_State* state, const Options& options) {
+	const auto start = std::chrono::steady_clock::now();
+	const bool collecting = lua_gc(state, LUA_GCISRUNNING) != 0;
+	lua_gc(state, LUA_GCSTOP);
+
+	HeapSnapshot snapshot;
+	snapshot.m_heapSize = static_cast<uint64_t>(lua_gc(state, LUA_GCCOUNT)) * 1024 + static_cast<uint64_t>(lua_gc(state, LUA_GCCOUNTB));
+	Walker walker(state);
+	WalkCall call{&walker, nullptr};
+	lua_pushcfunction(state, &walk);
+	lua_pushlightuserdata(state, &call);
+	const int status = lua_pcall(state, 1, 0, 0);
+	if (status != LUA_OK) {
+		lua_pop(state, 1);
+	}
+	if (collecting) {
+		lua_gc(state, LUA_GCRESTART);
+	}
+	if (call.exception) {
+		std::rethrow_exception(call.exception);
+	}
+	if (status != LUA_OK) {
+		throw std::bad_alloc(); //growing the queue table is the only thing that can fail
+	}
+
+	const uint32_t count = walker.getNodeCount();
+	const std::vector<uint32_t> dominators = walker.getDominators();
+	std::vector<uint64_t> retainedSizes(count);
+	std::vector<uint64_t> retainedObjects(count, 1);
+	for (uint32_t node = 0; node < count; ++node) {
+		retainedSizes[node] = walker.getShallowSize(node);
+	}
+	for (uint32_t node = count - 1; node > Root; --node) {
+		retainedSizes[dominators[node]] += retainedSizes[node];
+		retainedObjects[dominators[node]] += retainedObjects[node];
+	}
+
+	snapshot.m_objectCount = count - 1;
+	snapshot.m_totalSize = retainedSizes[Root];
+	for (uint32_t node = 1; node < count; ++node) {
+		if (walker.getDepth(node) <= options.maxDepth && retainedSizes[node] >= options.minRetainedSize) {
+			snapshot.m_entries.push_back(Entry{
+				walker.getPath(node), lua_typename(state, walker.getType(node)),
+				walker.getShallowSize(node), retainedSizes[node], retainedObjects[node]});
+		}
+	}
+	std::sort(snapshot.m_entries.begin(), snapshot.m_entries.end(), [](const Entry& a, const Entry& b) {
+		return a.retainedSize != b.retainedSize ? a.retainedSize > b.retainedSize : a.path < b.path;
+	});
+	snapshot.m_captureSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return snapshot;
+}
+
+std::vector<HeapSnapshot::Change> HeapSnapshot::diff(const HeapSnapshot& before, const HeapSnapshot& after) {
+	std::map<std::string, Change> paths;
+	for (const Entry& entry : before.m_entries) {
+		Change& change = paths[entry.path];
+		change.path = entry.path;
+		change.before += entry.retainedSize;
+	}
+	for (const Entry& entry : after.m_entries) {
+		Change& change = paths[entry.path];
+		change.path = entry.path;
+		change.after += entry.retainedSize;
+	}
+	std::vector<Change> changes;
+	for (auto& [path, change] : paths) {
+		if (change.before != change.after) {
+			changes.push_back(std::move(change));
+		}
+	}
+	std::stable_sort(changes.begin(), changes.end(), [](const Change& a, const Change& b) {
+		return a.getGrowth() > b.getGrowth();
+	});
+	return changes;
+}
+
+const HeapSnapshot::Entry* HeapSnapshot::find(const std::string& path) const {
+	auto it = std::find_if(m_entries.begin(), m_entries.end(), [&path](const Entry& entry) { return entry.path == path; });
+	return it != m_entries.end() ? &*it : nullptr;
+}
+
+bool HeapSnapshot::write(const std::filesystem::path& path) const {
+	std::filesystem::path temporary = path;
+	temporary += ".tmp";
+	{
+		std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+		file << Header << "\n"
+		     << m_objectCount << "\t" << m_totalSize << "\t" << m_heapSize << "\t" << m_captureSeconds << "\n";
+		for (const Entry& entry : m_entries) {
+			file << entry.retainedSize << "\t" << entry.retainedObjects << "\t" << entry.shallowSize << "\t"
+			     << entry.type << "\t" << entry.path << "\n";
+		}
+		if (!file) {
+			return false;
+		}
+	}
+	std::error_code error;
+	std::filesystem::rename(temporary, path, error);
+	return !error;
+}
+
+bool HeapSnapshot::read(const std::filesystem::path& path) {
+	std::ifstream file(path, std::ios::binary);
+	std::string line;
+	if (!std::getline(file, line) || line != Header) {
+		return false;
+	}
+	HeapSnapshot snapshot;
+	if (!(file >> snapshot.m_objectCount >> snapshot.m_totalSize >> snapshot.m_heapSize >> snapshot.m_captureSeconds)) {
+		return false;
+	}
+	file.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+	while (std::getline(file, line)) {
+		Entry entry;
+		size_t fields[4];
+		size_t position = 0;
+		for (size_t& field : fields) {
+			field = line.find('\t', position);
+			if (field == std::string::npos) {
+				return false;
+			}
+			position = field + 1;
+		}
+		try {
+			entry.retainedSize = std::stoull(line.substr(0, fields[0]));
+			entry.retainedObjects = std::stoull(line.substr(fields[0] + 1, fields[1] - fields[0] - 1));
+			entry.shallowSize = std::stoull(line.substr(fields[1] + 1, fields[2] - fields[1] - 1));
+		} catch (const std::exception&) {
+			return false;
+		}
+		entry.type = line.substr(fields[2] + 1, fields[3] - fields[2] - 1);
+		entry.path = line.substr(fields[3] + 1);
+		snapshot.m_entries.push_back(std::move(entry));
+	}
+	*this = std::move(snapshot);
+	return true;
+}
+
+} // namespace Lua
\ No newline at end of file
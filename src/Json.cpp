@@ -0,0 +1,833 @@
+#include <Json.hpp>
+#include <lua/lua.hpp>
+
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#if __has_include(<version>)
+	#include <version>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define LUACPP_JSON_SSE2
+	#include <emmintrin.h>
+	#ifdef _MSC_VER
+		#include <intrin.h>
+	#endif
+#endif
+
+namespace {
+
+using Lua::Json;
+
+constexpr int Chunk = 256; ///< maximum number of elements collected on the stack before they are moved into the table
+constexpr size_t MaxNumberLength = 64;
+
+uint32_t countTrailingZeros(uint32_t value) {
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward(&index, value);
+	return static_cast<uint32_t>(index);
+#else
+	return static_cast<uint32_t>(__builtin_ctz(value));
+#endif
+}
+
+/**
+ * @brief returns the first character which ends the plain part of a string: a quote, a backslash or a control character
+*/
+const char* scanString(const char* p, const char* end) {
+#ifdef LUACPP_JSON_SSE2
+	const __m128i quote = _mm_set1_epi8('"');
+	const __m128i backslash = _mm_set1_epi8('\\');
+	const __m128i control = _mm_set1_epi8(0x1F);
+	while (end - p >= 16) {
+		const __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+		const __m128i special = _mm_or_si128(
+			_mm_or_si128(_mm_cmpeq_epi8(chars, quote), _mm_cmpeq_epi8(chars, backslash)),
+			_mm_cmpeq_epi8(_mm_min_epu8(chars, control), chars)); //unsigned chars <= 0x1F
+		const uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(special));
+		if (mask != 0) {
+			return p + countTrailingZeros(mask);
+		}
+		p += 16;
+	}
+#else
+	//SWAR: check 8 characters at once
+	constexpr uint64_t Ones = 0x0101010101010101ull;
+	constexpr uint64_t High = 0x8080808080808080ull;
+	while (end - p >= 8) {
+		uint64_t chars;
+		std::memcpy(&chars, p, sizeof(chars));
+		const uint64_t quote = chars ^ (Ones * '"');
+		const uint64_t backslash = chars ^ (Ones * '\\');
+		const uint64_t special = ((quote - Ones) & ~quote) | ((backslash - Ones) & ~backslash) | ((chars - Ones * 0x20) & ~chars);
+		if ((special & High) != 0) {
+			break; //the exact position is determined by the loop below
+		}
+		p += 8;
+	}
+#endif
+	while (p < end) {
+		const unsigned char c = static_cast<unsigned char>(*p);
+		if (c == '"' || c == '\\' || c < 0x20) {
+			return p;
+		}
+		++p;
+	}
+	return end;
+}
+
+bool isDigit(char c) {
+	return c >= '0' && c <= '9';
+}
+
+void appendUtf8(luaL_Buffer& buffer, uint32_t codePoint) {
+	char bytes[4];
+	size_t len;
+	if (codePoint < 0x80) {
+		bytes[0] = static_cast<char>(codePoint);
+		len = 1;
+	} else if (codePoint < 0x800) {
+		bytes[0] = static_cast<char>(0xC0 | (codePoint >> 6));
+		bytes[1] = static_cast<char>(0x80 | (codePoint & 0x3F));
+		len = 2;
+	} else if (codePoint < 0x10000) {
+		bytes[0] = static_cast<char>(0xE0 | (codePoint >> 12));
+		bytes[1] = static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+		bytes[2] = static_cast<char>(0x80 | (codePoint & 0x3F));
+		len = 3;
+	} else {
+		bytes[0] = static_cast<char>(0xF0 | (codePoint >> 18));
+		bytes[1] = static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+		bytes[2] = static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+		bytes[3] = static_cast<char>(0x80 | (codePoint & 0x3F));
+		len = 4;
+	}
+	luaL_addlstring(&buffer, bytes, len);
+}
+
+/**
+ * @brief recursive descent parser which pushes the values onto the lua stack
+ * The decoder doesn't own any heap memory, so lua errors (e.g. out of memory) can't leak anything.
+*/
+class Decoder {
+public:
+	Decoder(lua_State* state, std::string_view text, uint32_t maxDepth)
+		: m_state(state), m_begin(text.data()), m_pos(text.data()), m_end(text.data() + text.size()), m_maxDepth(maxDepth) {}
+
+	bool run() {
+		const int top = lua_gettop(m_state);
+		skipWhitespace();
+		if (!parseValue(0)) {
+			lua_settop(m_state, top);
+			return false;
+		}
+		skipWhitespace();
+		if (m_pos != m_end) {
+			lua_settop(m_state, top);
+			return fail("unexpected trailing characters");
+		}
+		return true;
+	}
+
+	const char* getError() const { return m_error; }
+
+private:
+	bool fail(const char* message) {
+		std::snprintf(m_error, sizeof(m_error), "%s at offset %zu", message, static_cast<size_t>(m_pos - m_begin));
+		return false;
+	}
+
+	void skipWhitespace() {
+		while (m_pos < m_end && (*m_pos == ' ' || *m_pos == '\n' || *m_pos == '\r' || *m_pos == '\t')) {
+			++m_pos;
+		}
+	}
+
+	bool consumeLiteral(const char* literal, size_t len) {
+		if (static_cast<size_t>(m_end - m_pos) < len || std::memcmp(m_pos, literal, len) != 0) {
+			return fail("invalid literal");
+		}
+		m_pos += len;
+		return true;
+	}
+
+	bool parseValue(uint32_t depth) {
+		if (m_pos == m_end) {
+			return fail("unexpected end of input");
+		}
+		switch (*m_pos) {
+			case '{': return parseObject(depth + 1);
+			case '[': return parseArray(depth + 1);
+			case '"': return parseString();
+			case 't':
+				if (!consumeLiteral("true", 4)) {
+					return false;
+				}
+				lua_pushboolean(m_state, 1);
+				return true;
+			case 'f':
+				if (!consumeLiteral("false", 5)) {
+					return false;
+				}
+				lua_pushboolean(m_state, 0);
+				return true;
+			case 'n':
+				if (!consumeLiteral("null", 4)) {
+					return false;
+				}
+				Json::pushNull(m_state);
+				return true;
+			default:
+				return parseNumber();
+		}
+	}
+
+	/**
+	 * @brief moves the elements collected above the table (at tableIndex or on top if there is no table yet) into the table
+	*/
+	void flushArray(int& tableIndex, int base, lua_Integer& count) {
+		const int first = tableIndex == 0 ? base + 1 : tableIndex + 1;
+		const int last = lua_gettop(m_state);
+		if (tableIndex == 0) {
+			lua_createtable(m_state, last - first + 1, 0);
+		} else {
+			lua_pushvalue(m_state, tableIndex);
+		}
+		for (int i = first; i <= last; ++i) {
+			lua_pushvalue(m_state, i);
+			lua_rawseti(m_state, -2, ++count);
+		}
+		lua_replace(m_state, base + 1);
+		tableIndex = base + 1;
+		lua_settop(m_state, tableIndex);
+	}
+
+	void flushObject(int& tableIndex, int base) {
+		const int first = tableIndex == 0 ? base + 1 : tableIndex + 1;
+		const int last = lua_gettop(m_state);
+		if (tableIndex == 0) {
+			lua_createtable(m_state, 0, (last - first + 1) / 2);
+		} else {
+			lua_pushvalue(m_state, tableIndex);
+		}
+		//in order, so duplicate keys behave like in other decoders (the last one wins)
+		for (int i = first; i < last; i += 2) {
+			lua_pushvalue(m_state, i);
+			lua_pushvalue(m_state, i + 1);
+			lua_rawset(m_state, -3);
+		}
+		lua_replace(m_state, base + 1);
+		tableIndex = base + 1;
+		lua_settop(m_state, tableIndex);
+	}
+
+	bool enterContainer(uint32_t depth) {
+		if (depth > m_maxDepth) {
+			return fail("maximum nesting depth exceeded");
+		}
+		if (!lua_checkstack(m_state, 2 * Chunk + 8)) {
+			return fail("stack overflow");
+		}
+		++m_pos;
+		skipWhitespace();
+		return true;
+	}
+
+	bool parseArray(uint32_t depth) {
+		if (!enterContainer(depth)) {
+			return false;
+		}
+		const int base = lua_gettop(m_state);
+		int tableIndex = 0;
+		lua_Integer count = 0;
+		if (m_pos < m_end && *m_pos == ']') {
+			++m_pos;
+			lua_createtable(m_state, 0, 0);
+			return true;
+		}
+		while (true) {
+			if (!parseValue(depth)) {
+				return false;
+			}
+			if (lua_gettop(m_state) - (tableIndex == 0 ? base : tableIndex) >= Chunk) {
+				flushArray(tableIndex, base, count);
+			}
+			skipWhitespace();
+			if (m_pos == m_end) {
+				return fail("unexpected end of input in array");
+			}
+			if (*m_pos == ',') {
+				++m_pos;
+				skipWhitespace();
+			} else if (*m_pos == ']') {
+				++m_pos;
+				break;
+			} else {
+				return fail("expected ',' or ']'");
+			}
+		}
+		flushArray(tableIndex, base, count);
+		return true;
+	}
+
+	bool parseObject(uint32_t depth) {
+		if (!enterContainer(depth)) {
+			return false;
+		}
+		const int base = lua_gettop(m_state);
+		int tableIndex = 0;
+		if (m_pos < m_end && *m_pos == '}') {
+			++m_pos;
+			lua_createtable(m_state, 0, 0);
+			return true;
+		}
+		while (true) {
+			if (m_pos == m_end || *m_pos != '"') {
+				return fail("expected string key");
+			}
+			if (!parseString()) {
+				return false;
+			}
+			skipWhitespace();
+			if (m_pos == m_end || *m_pos != ':') {
+				return fail("expected ':'");
+			}
+			++m_pos;
+			skipWhitespace();
+			if (!parseValue(depth)) {
+				return false;
+			}
+			if (lua_gettop(m_state) - (tableIndex == 0 ? base : tableIndex) >= 2 * Chunk) {
+				flushObject(tableIndex, base);
+			}
+			skipWhitespace();
+			if (m_pos == m_end) {
+				return fail("unexpected end of input in object");
+			}
+			if (*m_pos == ',') {
+				++m_pos;
+				skipWhitespace();
+			} else if (*m_pos == '}') {
+				++m_pos;
+				break;
+			} else {
+				return fail("expected ',' or '}'");
+			}
+		}
+		flushObject(tableIndex, base);
+		return true;
+	}
+
+	bool parseHex4(uint32_t& value) {
+		if (m_end - m_pos < 4) {
+			return fail("invalid unicode escape");
+		}
+		value = 0;
+		for (int i = 0; i < 4; ++i) {
+			const char c = *m_pos++;
+			value <<= 4;
+			if (isDigit(c)) {
+				value |= static_cast<uint32_t>(c - '0');
+			} else if (c >= 'a' && c <= 'f') {
+				value |= static_cast<uint32_t>(c - 'a' + 10);
+			} else if (c >= 'A' && c <= 'F') {
+				value |= static_cast<uint32_t>(c - 'A' + 10);
+			} else {
+				return fail("invalid unicode escape");
+			}
+		}
+		return true;
+	}
+
+	bool parseString() {
+		++m_pos; //opening quote
+		const char* start = m_pos;
+		m_pos = scanString(m_pos, m_end);
+		if (m_pos < m_end && *m_pos == '"') {
+			//fast path: no escape sequences, the string is copied once (into lua)
+			lua_pushlstring(m_state, start, static_cast<size_t>(m_pos - start));
+			++m_pos;
+			return true;
+		}
+
+		luaL_Buffer buffer;
+		luaL_buffinit(m_state, &buffer);
+		luaL_addlstring(&buffer, start, static_cast<size_t>(m_pos - start));
+		while (true) {
+			if (m_pos == m_end) {
+				lua_pop(m_state, 1);
+				return fail("unterminated string");
+			}
+			const char c = *m_pos;
+			if (c == '"') {
+				++m_pos;
+				break;
+			}
+			if (c != '\\') {
+				lua_pop(m_state, 1);
+				return fail("control character in string");
+			}
+			if (++m_pos == m_end) {
+				lua_pop(m_state, 1);
+				return fail("unterminated string");
+			}
+			const char escaped = *m_pos++;
+			switch (escaped) {
+				case '"': luaL_addchar(&buffer, '"'); break;
+				case '\\': luaL_addchar(&buffer, '\\'); break;
+				case '/': luaL_addchar(&buffer, '/'); break;
+				case 'b': luaL_addchar(&buffer, '\b'); break;
+				case 'f': luaL_addchar(&buffer, '\f'); break;
+				case 'n': luaL_addchar(&buffer, '\n'); break;
+				case 'r': luaL_addchar(&buffer, '\r'); break;
+				case 't': luaL_addchar(&buffer, '\t'); break;
+				case 'u': {
+					uint32_t codePoint;
+					if (!parseHex4(codePoint)) {
+						lua_pop(m_state, 1);
+						return false;
+					}
+					if (codePoint >= 0xD800 && codePoint <= 0xDBFF) {
+						//surrogate pair
+						uint32_t low;
+						if (m_end - m_pos < 2 || m_pos[0] != '\\' || m_pos[1] != 'u') {
+							lua_pop(m_state, 1);
+							return fail("invalid surrogate pair");
+						}
+						m_pos += 2;
+						if (!parseHex4(low)) {
+							lua_pop(m_state, 1);
+							return false;
+						}
+						if (low < 0xDC00 || low > 0xDFFF) {
+							lua_pop(m_state, 1);
+							return fail("invalid surrogate pair");
+						}
+						codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+					} else if (codePoint >= 0xDC00 && codePoint <= 0xDFFF) {
+						lua_pop(m_state, 1);
+						return fail("invalid surrogate pair");
+					}
+					appendUtf8(buffer, codePoint);
+					break;
+				}
+				default:
+					lua_pop(m_state, 1);
+					return fail("invalid escape sequence");
+			}
+			const char* plain = m_pos;
+			m_pos = scanString(m_pos, m_end);
+			luaL_addlstring(&buffer, plain, static_cast<size_t>(m_pos - plain));
+		}
+		luaL_pushresult(&buffer);
+		return true;
+	}
+
+	bool parseNumber() {
+		const char* start = m_pos;
+		if (*m_pos == '-') {
+			++m_pos;
+		}
+		if (m_pos == m_end || !isDigit(*m_pos)) {
+			return fail("unexpected character");
+		}
+		if (*m_pos == '0') {
+			++m_pos;
+			if (m_pos < m_end && isDigit(*m_pos)) {
+				return fail("leading zeros are not allowed");
+			}
+		} else {
+			while (m_pos < m_end && isDigit(*m_pos)) {
+				++m_pos;
+			}
+		}
+		bool isFloat = false;
+		if (m_pos < m_end && *m_pos == '.') {
+			isFloat = true;
+			++m_pos;
+			if (m_pos == m_end || !isDigit(*m_pos)) {
+				return fail("invalid number");
+			}
+			while (m_pos < m_end && isDigit(*m_pos)) {
+				++m_pos;
+			}
+		}
+		if (m_pos < m_end && (*m_pos == 'e' || *m_pos == 'E')) {
+			isFloat = true;
+			++m_pos;
+			if (m_pos < m_end && (*m_pos == '+' || *m_pos == '-')) {
+				++m_pos;
+			}
+			if (m_pos == m_end || !isDigit(*m_pos)) {
+				return fail("invalid number");
+			}
+			while (m_pos < m_end && isDigit(*m_pos)) {
+				++m_pos;
+			}
+		}
+
+		if (!isFloat) {
+			int64_t value;
+			const auto result = std::from_chars(start, m_pos, value);
+			if (result.ec == std::errc() && result.ptr == m_pos) {
+				lua_pushinteger(m_state, static_cast<lua_Integer>(value));
+				return true;
+			}
+			//out of the integer range, continue as float
+		}
+
+		double value;
+#if defined(__cpp_lib_to_chars)
+		const auto result = std::from_chars(start, m_pos, value);
+		if (result.ec == std::errc::invalid_argument) {
+			return fail("invalid number");
+		}
+		if (result.ec == std::errc::result_out_of_range) {
+			value = *start == '-' ? -HUGE_VAL : HUGE_VAL;
+		}
+#else
+		//strtod needs a terminated string
+		char text[MaxNumberLength];
+		const size_t len = static_cast<size_t>(m_pos - start);
+		if (len >= sizeof(text)) {
+			return fail("number too long");
+		}
+		std::memcpy(text, start, len);
+		text[len] = '\0';
+		value = std::strtod(text, nullptr);
+#endif
+		lua_pushnumber(m_state, static_cast<lua_Number>(value));
+		return true;
+	}
+
+	lua_State* m_state;
+	const char* m_begin;
+	const char* m_pos;
+	const char* m_end;
+	uint32_t m_maxDepth;
+	char m_error[128] = {};
+};
+
+class Encoder {
+public:
+	Encoder(lua_State* state, std::string& out, const Json::EncodeOptions& options)
+		: m_state(state), m_out(out), m_options(options) {}
+
+	bool run(int index) {
+		const int top = lua_gettop(m_state);
+		const bool ok = encodeValue(lua_absindex(m_state, index), 0);
+		lua_settop(m_state, top);
+		return ok;
+	}
+
+	const std::string& getError() const { return m_error; }
+
+private:
+	bool fail(std::string message) {
+		m_error = std::move(message);
+		return false;
+	}
+
+	void appendString(const char* str, size_t len) {
+		static const char* const Hex = "0123456789abcdef";
+		const char* end = str + len;
+		m_out.push_back('"');
+		while (str < end) {
+			const char* special = scanString(str, end);
+			m_out.append(str, static_cast<size_t>(special - str));
+			if (special == end) {
+				break;
+			}
+			const unsigned char c = static_cast<unsigned char>(*special);
+			switch (c) {
+				case '"': m_out.append("\\\""); break;
+				case '\\': m_out.append("\\\\"); break;
+				case '\b': m_out.append("\\b"); break;
+				case '\f': m_out.append("\\f"); break;
+				case '\n': m_out.append("\\n"); break;
+				case '\r': m_out.append("\\r"); break;
+				case '\t': m_out.append("\\t"); break;
+				default: {
+					const char escaped[] = {'\\', 'u', '0', '0', Hex[c >> 4], Hex[c & 0xF]};
+					m_out.append(escaped, sizeof(escaped));
+				}
+			}
+			str = special + 1;
+		}
+		m_out.push_back('"');
+	}
+
+	bool appendNumber(int index) {
+		char text[MaxNumberLength];
+		if (lua_isinteger(m_state, index)) {
+			const auto result = std::to_chars(text, text + sizeof(text), static_cast<int64_t>(lua_tointeger(m_state, index)));
+			m_out.append(text, static_cast<size_t>(result.ptr - text));
+			return true;
+		}
+		const double value = static_cast<double>(lua_tonumber(m_state, index));
+		if (!std::isfinite(value)) {
+			return fail("cannot encode non-finite number");
+		}
+#if defined(__cpp_lib_to_chars)
+		const auto result = m_options.precision > 0
+			? std::to_chars(text, text + sizeof(text), value, std::chars_format::general, m_options.precision)
+			: std::to_chars(text, text + sizeof(text), value);
+		m_out.append(text, static_cast<size_t>(result.ptr - text));
+#else
+		const int len = std::snprintf(text, sizeof(text), "%.*g", m_options.precision > 0 ? m_options.precision : 17, value);
+		for (int i = 0; i < len; ++i) {
+			if (text[i] == ',') {
+				text[i] = '.'; //locales with a decimal comma
+			}
+		}
+		m_out.append(text, static_cast<size_t>(len));
+#endif
+		return true;
+	}
+
+	/**
+	 * @brief returns the length of the array or -1 if the table has to be encoded as object
+	*/
+	lua_Integer arrayLength(int index) {
+		switch (m_options.arrays) {
+			case Json::ArrayDetection::Never:
+				return -1;
+			case Json::ArrayDetection::Length: {
+				const lua_Integer len = static_cast<lua_Integer>(lua_rawlen(m_state, index));
+				return len > 0 ? len : (isEmpty(index) ? 0 : -1);
+			}
+			default: {
+				lua_Integer count = 0;
+				lua_Integer max = 0;
+				lua_pushnil(m_state);
+				while (lua_next(m_state, index) != 0) {
+					lua_pop(m_state, 1);
+					if (!lua_isinteger(m_state, -1) || lua_tointeger(m_state, -1) < 1) {
+						lua_pop(m_state, 1);
+						return -1;
+					}
+					const lua_Integer key = lua_tointeger(m_state, -1);
+					max = key > max ? key : max;
+					++count;
+				}
+				return count == max ? count : -1;
+			}
+		}
+	}
+
+	bool isEmpty(int index) {
+		lua_pushnil(m_state);
+		if (lua_next(m_state, index) == 0) {
+			return true;
+		}
+		lua_pop(m_state, 2);
+		return false;
+	}
+
+	bool encodeTable(int index, uint32_t depth) {
+		const void* table = lua_topointer(m_state, index);
+		for (const void* parent : m_path) {
+			if (parent == table) {
+				if (m_options.cyclesAsNull) {
+					m_out.append("null");
+					return true;
+				}
+				return fail("cannot encode cyclic table");
+			}
+		}
+		if (depth >= m_options.maxDepth) {
+			return fail("maximum nesting depth exceeded");
+		}
+		if (!lua_checkstack(m_state, 4)) {
+			return fail("stack overflow");
+		}
+		m_path.push_back(table);
+
+		const lua_Integer length = arrayLength(index);
+		if (length == 0) {
+			m_out.append(m_options.emptyTableAsArray ? "[]" : "{}");
+		} else if (length > 0) {
+			m_out.push_back('[');
+			for (lua_Integer i = 1; i <= length; ++i) {
+				if (i > 1) {
+					m_out.push_back(',');
+				}
+				lua_rawgeti(m_state, index, i);
+				if (!encodeValue(lua_gettop(m_state), depth + 1)) {
+					return false;
+				}
+				lua_pop(m_state, 1);
+			}
+			m_out.push_back(']');
+		} else {
+			m_out.push_back('{');
+			bool first = true;
+			lua_pushnil(m_state);
+			while (lua_next(m_state, index) != 0) {
+				if (!first) {
+					m_out.push_back(',');
+				}
+				first = false;
+				const int keyType = lua_type(m_state, -2);
+				if (keyType == LUA_TSTRING) {
+					size_t len;
+					const char* key = lua_tolstring(m_state, -2, &len);
+					appendString(key, len);
+				} else if (keyType == LUA_TNUMBER) {
+					m_out.push_back('"');
+					if (!appendNumber(lua_gettop(m_state) - 1)) {
+						return false;
+					}
+					m_out.push_back('"');
+				} else {
+					return fail(std::string("cannot encode table key of type ") + lua_typename(m_state, keyType));
+				}
+				m_out.push_back(':');
+				if (!encodeValue(lua_gettop(m_state), depth + 1)) {
+					return false;
+				}
+				lua_pop(m_state, 1);
+			}
+			m_out.push_back('}');
+		}
+
+		m_path.pop_back();
+		return true;
+	}
+
+	bool encodeValue(int index, uint32_t depth) {
+		switch (lua_type(m_state, index)) {
+			case LUA_TNIL:
+				m_out.append("null");
+				return true;
+			case LUA_TBOOLEAN:
+				m_out.append(lua_toboolean(m_state, index) ? "true" : "false");
+				return true;
+			case LUA_TNUMBER:
+				return appendNumber(index);
+			case LUA_TSTRING: {
+				size_t len;
+				const char* str = lua_tolstring(m_state, index, &len);
+				appendString(str, len);
+				return true;
+			}
+			case LUA_TTABLE:
+				return encodeTable(index, depth);
+			case LUA_TLIGHTUSERDATA:
+				if (lua_touserdata(m_state, index) == nullptr) {
+					m_out.append("null");
+					return true;
+				}
+				[[fallthrough]];
+			default:
+				return fail(std::string("cannot encode value of type ") + luaL_typename(m_state, index));
+		}
+	}
+
+	lua_State* m_state;
+	std::string& m_out;
+	const Json::EncodeOptions& m_options;
+	std::vector<const void*> m_path; ///< tables currently being encoded (for the cycle detection)
+	std::string m_error;
+};
+
+} // namespace
+
+namespace Lua {
+
+bool Json::decode(lua_State* state, std::string_view text, std::string& error) {
+	return decode(state, text, error, DecodeOptions());
+}
+
+bool Json::decode(lua_State* state, std::string_view text, std::string& error, const DecodeOptions& options) {
+	Decoder decoder(state, text, options.maxDepth);
+	if (!decoder.run()) {
+		error = decoder.getError();
+		return false;
+	}
+	return true;
+}
+
+bool Json::encode(lua_State* state, int index, std::string& out, std::string& error) {
+	return encode(state, index, out, error, EncodeOptions());
+}
+
+bool Json::encode(lua_State* state, int index, std::string& out, std::string& error, const EncodeOptions& options) {
+	Encoder encoder(state, out, options);
+	if (!encoder.run(index)) {
+		error = encoder.getError();
+		return false;
+	}
+	return true;
+}
+
+void Json::pushNull(lua_State* state) {
+	lua_pushlightuserdata(state, nullptr);
+}
+
+bool Json::isNull(lua_State* state, int index) {
+	return lua_islightuserdata(state, index) && lua_touserdata(state, index) == nullptr;
+}
+
+void Json::openLibrary(lua_State* state) {
+	const luaL_Reg functions[] = {
+		{"decode", luaDecode},
+		{"encode", luaEncode},
+		{nullptr, nullptr}
+	};
+	luaL_newlib(state, functions);
+	pushNull(state);
+	lua_setfield(state, -2, "null");
+	lua_setglobal(state, "json");
+}
+
+int Json::luaDecode(lua_State* state) {
+	size_t len;
+	const char* text = luaL_checklstring(state, 1, &len);
+	Decoder decoder(state, std::string_view(text, len), DecodeOptions().maxDepth);
+	if (!decoder.run()) {
+		return luaL_error(state, "%s", decoder.getError());
+	}
+	return 1;
+}
+
+int Json::luaEncode(lua_State* state) {
+	luaL_checkany(state, 1);
+	EncodeOptions options;
+	if (lua_istable(state, 2)) {
+		const char* const arrayModes[] = {"sequence", "length", "never", nullptr};
+		lua_getfield(state, 2, "arrays");
+		options.arrays = static_cast<ArrayDetection>(luaL_checkoption(state, -1, "sequence", arrayModes));
+		lua_getfield(state, 2, "emptyArray");
+		options.emptyTableAsArray = lua_toboolean(state, -1) != 0;
+		lua_getfield(state, 2, "precision");
+		options.precision = static_cast<int>(luaL_optinteger(state, -1, 0));
+		const char* const cycleModes[] = {"error", "null", nullptr};
+		lua_getfield(state, 2, "cycles");
+		options.cyclesAsNull = luaL_checkoption(state, -1, "error", cycleModes) == 1;
+		lua_getfield(state, 2, "maxDepth");
+		options.maxDepth = static_cast<uint32_t>(luaL_optinteger(state, -1, options.maxDepth));
+		lua_pop(state, 5);
+	}
+
+	//the strings are released before a lua error is raised
+	bool ok;
+	{
+		std::string out;
+		std::string error;
+		ok = encode(state, 1, out, error, options);
+		lua_pushlstring(state, ok ? out.data() : error.data(), ok ? out.size() : error.size());
+	}
+	if (!ok) {
+		return lua_error(state);
+	}
+	return 1;
+}
+
+} // namespace Lua
\ No newline at end of file
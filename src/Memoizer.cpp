@@ -0,0 +1,116 @@
+#include <Memoizer.hpp>
+#include <lua/lua.hpp>
+
+namespace Lua {
+
+Memoizer::Memoizer(State& state, size_t capacity) : m_state(state), m_capacity(capacity) {
+	m_index.reserve(capacity);
+}
+
+Memoizer::~Memoizer() {
+	clear();
+}
+
+void Memoizer::invalidate() {
+	++m_epoch;
+	++m_statistics.epochs;
+}
+
+void Memoizer::clear() {
+	m_index.clear();
+	m_entries.clear();
+	for (const auto& [name, function] : m_functions) {
+		luaL_unref(m_state.getState(), LUA_REGISTRYINDEX, function.reference);
+	}
+	m_functions.clear();
+}
+
+void Memoizer::setCapacity(size_t capacity) {
+	m_capacity = capacity;
+	while (m_entries.size() > m_capacity) {
+		m_index.erase(Key{m_entries.back().key, m_entries.back().hash});
+		m_entries.pop_back();
+		++m_statistics.evictions;
+	}
+}
+
+Memoizer::Statistics Memoizer::getStatistics() const {
+	Statistics statistics = m_statistics;
+	statistics.size = m_entries.size();
+	statistics.capacity = m_capacity;
+	return statistics;
+}
+
+int Memoizer::pushFunction(std::string_view name) {
+	lua_State* L = m_state.getState();
+	lua_pushglobaltable(L);
+	lua_pushlstring(L, name.data(), name.size());
+	const int type = lua_gettable(L, -2);
+	lua_remove(L, -2);
+	if (type != LUA_TFUNCTION) {
+		m_lastError = "attempt to call a " + std::string(lua_typename(L, type)) + " value (global '" + std::string(name) + "')";
+		lua_pop(L, 1);
+		return LUA_ERRRUN;
+	}
+
+	const void* pointer = lua_topointer(L, -1);
+	auto it = m_functions.find(name);
+	if (it == m_functions.end()) {
+		lua_pushvalue(L, -1);
+		it = m_functions.emplace(std::string(name), Function{luaL_ref(L, LUA_REGISTRYINDEX), pointer, m_nextGeneration++, m_epoch}).first;
+	} else if (it->second.pointer != pointer) {
+		//the function was replaced, the results of the old one are never looked up again
+		luaL_unref(L, LUA_REGISTRYINDEX, it->second.reference);
+		lua_pushvalue(L, -1);
+		it->second = Function{luaL_ref(L, LUA_REGISTRYINDEX), pointer, m_nextGeneration++, m_epoch};
+		++m_statistics.reloads;
+	} else if (it->second.epoch != m_epoch) {
+		it->second.generation = m_nextGeneration++;
+		it->second.epoch = m_epoch;
+	}
+	m_generation = it->second.generation;
+	return 0;
+}
+
+int Memoizer::callFunction(int numArgs) {
+	lua_State* L = m_state.getState();
+	const int status = lua_pcall(L, numArgs, 1, 0);
+	if (status != LUA_OK) {
+		const char* message = lua_tostring(L, -1);
+		m_lastError = message != nullptr ? message : "error object is not a string";
+		lua_pop(L, 1);
+	}
+	return status;
+}
+
+const std::any* Memoizer::find() {
+	auto it = m_index.find(Key{m_key, m_hash});
+	if (it == m_index.end()) {
+		++m_statistics.misses;
+		return nullptr;
+	}
+	++m_statistics.hits;
+	m_entries.splice(m_entries.begin(), m_entries, it->second);
+	return &it->second->value;
+}
+
+void Memoizer::insert(std::any value) {
+	if (m_capacity == 0) {
+		return;
+	}
+	if (m_entries.size() >= m_capacity) {
+		//outdated results are never used, so they end up at the back and are dropped first. The node of the dropped
+		//result is reused, so a full cache doesn't allocate for new results with short keys.
+		m_index.erase(Key{m_entries.back().key, m_entries.back().hash});
+		m_entries.splice(m_entries.begin(), m_entries, std::prev(m_entries.end()));
+		m_entries.front().key.assign(m_key);
+		m_entries.front().hash = m_hash;
+		m_entries.front().value = std::move(value);
+		++m_statistics.evictions;
+	} else {
+		m_entries.push_front(Entry{m_key, m_hash, std::move(value)});
+	}
+	m_index.emplace(Key{m_entries.front().key, m_hash}, m_entries.begin());
+}
+
+} // namespace Lua
\ No newline at end of file
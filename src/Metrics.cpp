@@ -0,0 +1,159 @@
+#include <Metrics.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <system_error>
+
+namespace Lua {
+
+namespace {
+
+//label values of the error codes, indexed by lua status (LUA_OK and LUA_YIELD are no errors)
+constexpr const char* const ErrorCodeNames[Metrics::StatusCount] = { nullptr, nullptr, "runtime", "syntax", "memory", "error" };
+
+std::string escapeLabel(const std::string& value) {
+	std::string result;
+	result.reserve(value.size());
+	for (char c : value) {
+		switch (c) {
+			case '\\': result += "\\\\"; break;
+			case '"': result += "\\\""; break;
+			case '\n': result += "\\n"; break;
+			default: result += c; break;
+		}
+	}
+	return result;
+}
+
+std::string formatSeconds(std::chrono::nanoseconds time) {
+	char buffer[32];
+	std::snprintf(buffer, sizeof(buffer), "%.9f", std::chrono::duration<double>(time).count());
+	return buffer;
+}
+
+struct Family {
+	const char* name;
+	const char* type;
+	const char* help;
+	std::function<std::string(const Metrics::Snapshot&)> value;
+};
+
+} // namespace
+
+uint64_t Metrics::Snapshot::getErrorCount() const {
+	uint64_t count = 0;
+	for (uint64_t errors : this->errors) {
+		count += errors;
+	}
+	return count;
+}
+
+Metrics::Snapshot Metrics::getSnapshot() const {
+	Snapshot snapshot;
+	snapshot.scriptLoads = m_scriptLoads.load(std::memory_order_relaxed);
+	snapshot.compileTime = std::chrono::nanoseconds(m_compileTime.load(std::memory_order_relaxed));
+	snapshot.calls = m_calls.load(std::memory_order_relaxed);
+	for (size_t i = 0; i < StatusCount; ++i) {
+		snapshot.errors[i] = m_errors[i].load(std::memory_order_relaxed);
+	}
+	snapshot.errorListSize = m_errorListSize.load(std::memory_order_relaxed);
+	snapshot.heapBytes = m_heapBytes.load(std::memory_order_relaxed);
+	snapshot.gcSteps = m_gcSteps.load(std::memory_order_relaxed);
+	snapshot.gcCollections = m_gcCollections.load(std::memory_order_relaxed);
+	snapshot.nativeCalls = m_nativeCalls.load(std::memory_order_relaxed);
+	snapshot.nativeTime = std::chrono::nanoseconds(m_nativeTime.load(std::memory_order_relaxed));
+	return snapshot;
+}
+
+void Metrics::reset() {
+	m_scriptLoads.store(0, std::memory_order_relaxed);
+	m_compileTime.store(0, std::memory_order_relaxed);
+	m_calls.store(0, std::memory_order_relaxed);
+	for (std::atomic<uint64_t>& errors : m_errors) {
+		errors.store(0, std::memory_order_relaxed);
+	}
+	m_gcSteps.store(0, std::memory_order_relaxed);
+	m_gcCollections.store(0, std::memory_order_relaxed);
+	m_nativeCalls.store(0, std::memory_order_relaxed);
+	m_nativeTime.store(0, std::memory_order_relaxed);
+	//the error list size and the heap size are current values, not counters
+}
+
+void MetricsExporter::add(std::string name, std::weak_ptr<const Metrics> metrics) {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	auto it = std::find_if(m_entries.begin(), m_entries.end(), [&name](const Entry& entry) { return entry.name == name; });
+	if (it != m_entries.end()) {
+		it->metrics = std::move(metrics);
+	} else {
+		m_entries.push_back(Entry{std::move(name), std::move(metrics)});
+	}
+}
+
+void MetricsExporter::remove(const std::string& name) {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_entries.erase(std::remove_if(m_entries.begin(), m_entries.end(), [&name](const Entry& entry) { return entry.name == name; }), m_entries.end());
+}
+
+std::string MetricsExporter::toPrometheus() const {
+	std::vector<std::pair<std::string, Metrics::Snapshot>> snapshots;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_entries.erase(std::remove_if(m_entries.begin(), m_entries.end(), [](const Entry& entry) { return entry.metrics.expired(); }), m_entries.end());
+		for (const Entry& entry : m_entries) {
+			if (std::shared_ptr<const Metrics> metrics = entry.metrics.lock()) {
+				snapshots.emplace_back(escapeLabel(entry.name), metrics->getSnapshot());
+			}
+		}
+	}
+
+	const Family families[] = {
+		{"luacpp_script_loads_total", "counter", "Scripts compiled", [](const Metrics::Snapshot& s) { return std::to_string(s.scriptLoads); }},
+		{"luacpp_compile_seconds_total", "counter", "Time spent compiling scripts", [](const Metrics::Snapshot& s) { return formatSeconds(s.compileTime); }},
+		{"luacpp_calls_total", "counter", "Functions and scripts called", [](const Metrics::Snapshot& s) { return std::to_string(s.calls); }},
+		{"luacpp_error_list_size", "gauge", "Entries in the error list of the state", [](const Metrics::Snapshot& s) { return std::to_string(s.errorListSize); }},
+		{"luacpp_heap_bytes", "gauge", "Memory used by the lua heap", [](const Metrics::Snapshot& s) { return std::to_string(s.heapBytes); }},
+		{"luacpp_gc_steps_total", "counter", "Explicit garbage collection steps", [](const Metrics::Snapshot& s) { return std::to_string(s.gcSteps); }},
+		{"luacpp_gc_collections_total", "counter", "Garbage collection cycles finished explicitly", [](const Metrics::Snapshot& s) { return std::to_string(s.gcCollections); }},
+		{"luacpp_native_calls_total", "counter", "Invocations of registered methods", [](const Metrics::Snapshot& s) { return std::to_string(s.nativeCalls); }},
+		{"luacpp_native_seconds_total", "counter", "Time spent in registered methods", [](const Metrics::Snapshot& s) { return formatSeconds(s.nativeTime); }},
+	};
+
+	std::string text;
+	for (const Family& family : families) {
+		text += std::string("# HELP ") + family.name + " " + family.help + "\n";
+		text += std::string("# TYPE ") + family.name + " " + family.type + "\n";
+		for (const auto& [name, snapshot] : snapshots) {
+			text += std::string(family.name) + "{state=\"" + name + "\"} " + family.value(snapshot) + "\n";
+		}
+	}
+
+	text += "# HELP luacpp_errors_total Failed loads and calls by error code\n";
+	text += "# TYPE luacpp_errors_total counter\n";
+	for (const auto& [name, snapshot] : snapshots) {
+		for (size_t status = 0; status < Metrics::StatusCount; ++status) {
+			if (ErrorCodeNames[status] != nullptr) {
+				text += "luacpp_errors_total{state=\"" + name + "\",code=\"" + ErrorCodeNames[status] + "\"} " + std::to_string(snapshot.errors[status]) + "\n";
+			}
+		}
+	}
+	return text;
+}
+
+bool MetricsExporter::writePrometheus(const std::filesystem::path& path) const {
+	const std::string text = toPrometheus();
+	std::filesystem::path temporary = path;
+	temporary += ".tmp";
+	{
+		std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+		if (!file || !file.write(text.data(), static_cast<std::streamsize>(text.size()))) {
+			return false;
+		}
+	}
+	std::error_code error;
+	std::filesystem::rename(temporary, path, error);
+	return !error;
+}
+
+} // namespace Lua
\ No newline at end of file
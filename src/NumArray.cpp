@@ -0,0 +1,1155 @@
+#include <NumArray.hpp>
+#include <lua/lua.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <new>
+#include <stdexcept>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+	#define LUACPP_NUMARRAY_AVX2
+	#define LUACPP_TARGET_AVX2 __attribute__((target("avx2,fma")))
+	#include <immintrin.h>
+#endif
+
+namespace {
+
+using Lua::NumArray;
+using Operation = NumArray::Operation;
+using Comparison = NumArray::Comparison;
+
+constexpr const char* const MetaTableName = "luacpp.NumArray";
+constexpr size_t Alignment = 32;
+
+template <typename T>
+struct Kernels {
+	double (*sum)(const T* a, size_t n);
+	double (*dot)(const T* a, const T* b, size_t n);
+	T (*min)(const T* a, size_t n);
+	T (*max)(const T* a, size_t n);
+	void (*axpy)(T alpha, const T* x, T* y, size_t n);
+	bool (*apply)(Operation op, const T* b, T* a, size_t n); ///< false on integer division by zero
+	bool (*applyValue)(Operation op, T b, T* a, size_t n);
+	void (*compare)(Comparison cmp, const T* a, const T* b, int64_t* mask, size_t n);
+	void (*compareValue)(Comparison cmp, const T* a, double b, int64_t* mask, size_t n);
+};
+
+// --- portable kernels ---
+
+template <typename T, Operation Op>
+inline bool applyOp(T& a, T b) {
+	if constexpr (std::is_integral_v<T>) {
+		//wrap around like lua integers
+		const uint64_t x = static_cast<uint64_t>(a);
+		const uint64_t y = static_cast<uint64_t>(b);
+		if constexpr (Op == Operation::Add) {
+			a = static_cast<T>(x + y);
+		} else if constexpr (Op == Operation::Subtract) {
+			a = static_cast<T>(x - y);
+		} else if constexpr (Op == Operation::Multiply) {
+			a = static_cast<T>(x * y);
+		} else {
+			//floor division like the // operator of lua
+			if (b == 0) {
+				return false;
+			}
+			if (b == -1) {
+				a = static_cast<T>(0 - x);
+			} else {
+				T q = a / b;
+				if ((a % b != 0) && ((a ^ b) < 0)) {
+					q -= 1;
+				}
+				a = q;
+			}
+		}
+	} else {
+		if constexpr (Op == Operation::Add) {
+			a += b;
+		} else if constexpr (Op == Operation::Subtract) {
+			a -= b;
+		} else if constexpr (Op == Operation::Multiply) {
+			a *= b;
+		} else {
+			a /= b;
+		}
+	}
+	return true;
+}
+
+template <Comparison Cmp, typename T>
+inline bool compareOp(T a, T b) {
+	if constexpr (Cmp == Comparison::Less) {
+		return a < b;
+	} else if constexpr (Cmp == Comparison::LessEqual) {
+		return a <= b;
+	} else if constexpr (Cmp == Comparison::Greater) {
+		return a > b;
+	} else if constexpr (Cmp == Comparison::GreaterEqual) {
+		return a >= b;
+	} else if constexpr (Cmp == Comparison::Equal) {
+		return a == b;
+	} else {
+		return a != b;
+	}
+}
+
+int64_t sumInteger(const int64_t* a, size_t n) {
+	uint64_t sum = 0;
+	for (size_t i = 0; i < n; ++i) {
+		sum += static_cast<uint64_t>(a[i]);
+	}
+	return static_cast<int64_t>(sum);
+}
+
+template <typename T>
+double sumScalar(const T* a, size_t n) {
+	if constexpr (std::is_integral_v<T>) {
+		return static_cast<double>(sumInteger(a, n));
+	} else {
+		double s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0;
+		size_t i = 0;
+		for (; i + 4 <= n; i += 4) {
+			s0 += a[i];
+			s1 += a[i + 1];
+			s2 += a[i + 2];
+			s3 += a[i + 3];
+		}
+		for (; i < n; ++i) {
+			s0 += a[i];
+		}
+		return (s0 + s1) + (s2 + s3);
+	}
+}
+
+template <typename T>
+double dotScalar(const T* a, const T* b, size_t n) {
+	double s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0;
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+		s0 += static_cast<double>(a[i]) * static_cast<double>(b[i]);
+		s1 += static_cast<double>(a[i + 1]) * static_cast<double>(b[i + 1]);
+		s2 += static_cast<double>(a[i + 2]) * static_cast<double>(b[i + 2]);
+		s3 += static_cast<double>(a[i + 3]) * static_cast<double>(b[i + 3]);
+	}
+	for (; i < n; ++i) {
+		s0 += static_cast<double>(a[i]) * static_cast<double>(b[i]);
+	}
+	return (s0 + s1) + (s2 + s3);
+}
+
+template <typename T>
+T minScalar(const T* a, size_t n) {
+	T result = a[0];
+	for (size_t i = 1; i < n; ++i) {
+		result = a[i] < result ? a[i] : result;
+	}
+	return result;
+}
+
+template <typename T>
+T maxScalar(const T* a, size_t n) {
+	T result = a[0];
+	for (size_t i = 1; i < n; ++i) {
+		result = a[i] > result ? a[i] : result;
+	}
+	return result;
+}
+
+template <typename T>
+void axpyScalar(T alpha, const T* x, T* y, size_t n) {
+	for (size_t i = 0; i < n; ++i) {
+		if constexpr (std::is_integral_v<T>) {
+			y[i] = static_cast<T>(static_cast<uint64_t>(y[i]) + static_cast<uint64_t>(alpha) * static_cast<uint64_t>(x[i]));
+		} else {
+			y[i] += alpha * x[i];
+		}
+	}
+}
+
+template <typename T, Operation Op>
+bool applyLoop(const T* b, T* a, size_t n) {
+	for (size_t i = 0; i < n; ++i) {
+		if (!applyOp<T, Op>(a[i], b[i])) {
+			return false;
+		}
+	}
+	return true;
+}
+
+template <typename T, Operation Op>
+bool applyValueLoop(T b, T* a, size_t n) {
+	for (size_t i = 0; i < n; ++i) {
+		if (!applyOp<T, Op>(a[i], b)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+template <typename T>
+bool applyScalar(Operation op, const T* b, T* a, size_t n) {
+	switch (op) {
+		case Operation::Add: return applyLoop<T, Operation::Add>(b, a, n);
+		case Operation::Subtract: return applyLoop<T, Operation::Subtract>(b, a, n);
+		case Operation::Multiply: return applyLoop<T, Operation::Multiply>(b, a, n);
+		default: return applyLoop<T, Operation::Divide>(b, a, n);
+	}
+}
+
+template <typename T>
+bool applyValueScalar(Operation op, T b, T* a, size_t n) {
+	switch (op) {
+		case Operation::Add: return applyValueLoop<T, Operation::Add>(b, a, n);
+		case Operation::Subtract: return applyValueLoop<T, Operation::Subtract>(b, a, n);
+		case Operation::Multiply: return applyValueLoop<T, Operation::Multiply>(b, a, n);
+		default: return applyValueLoop<T, Operation::Divide>(b, a, n);
+	}
+}
+
+template <typename T, Comparison Cmp>
+void compareLoop(const T* a, const T* b, int64_t* mask, size_t n) {
+	for (size_t i = 0; i < n; ++i) {
+		mask[i] = compareOp<Cmp>(a[i], b[i]) ? 1 : 0;
+	}
+}
+
+template <typename T, Comparison Cmp>
+void compareValueLoop(const T* a, double b, int64_t* mask, size_t n) {
+	//integers are compared as numbers, floats in their own precision
+	using C = std::conditional_t<std::is_integral_v<T>, double, T>;
+	const C value = static_cast<C>(b);
+	for (size_t i = 0; i < n; ++i) {
+		mask[i] = compareOp<Cmp>(static_cast<C>(a[i]), value) ? 1 : 0;
+	}
+}
+
+template <typename T>
+void compareScalar(Comparison cmp, const T* a, const T* b, int64_t* mask, size_t n) {
+	switch (cmp) {
+		case Comparison::Less: return compareLoop<T, Comparison::Less>(a, b, mask, n);
+		case Comparison::LessEqual: return compareLoop<T, Comparison::LessEqual>(a, b, mask, n);
+		case Comparison::Greater: return compareLoop<T, Comparison::Greater>(a, b, mask, n);
+		case Comparison::GreaterEqual: return compareLoop<T, Comparison::GreaterEqual>(a, b, mask, n);
+		case Comparison::Equal: return compareLoop<T, Comparison::Equal>(a, b, mask, n);
+		default: return compareLoop<T, Comparison::NotEqual>(a, b, mask, n);
+	}
+}
+
+template <typename T>
+void compareValueScalar(Comparison cmp, const T* a, double b, int64_t* mask, size_t n) {
+	switch (cmp) {
+		case Comparison::Less: return compareValueLoop<T, Comparison::Less>(a, b, mask, n);
+		case Comparison::LessEqual: return compareValueLoop<T, Comparison::LessEqual>(a, b, mask, n);
+		case Comparison::Greater: return compareValueLoop<T, Comparison::Greater>(a, b, mask, n);
+		case Comparison::GreaterEqual: return compareValueLoop<T, Comparison::GreaterEqual>(a, b, mask, n);
+		case Comparison::Equal: return compareValueLoop<T, Comparison::Equal>(a, b, mask, n);
+		default: return compareValueLoop<T, Comparison::NotEqual>(a, b, mask, n);
+	}
+}
+
+template <Comparison Cmp>
+void compareIntegerLoop(const int64_t* a, int64_t b, int64_t* mask, size_t n) {
+	for (size_t i = 0; i < n; ++i) {
+		mask[i] = compareOp<Cmp>(a[i], b) ? 1 : 0;
+	}
+}
+
+/**
+ * @brief compareValue of int64 arrays without converting the value to double, which is inexact above 2^53
+*/
+void compareInteger(Comparison cmp, const int64_t* a, int64_t b, int64_t* mask, size_t n) {
+	switch (cmp) {
+		case Comparison::Less: return compareIntegerLoop<Comparison::Less>(a, b, mask, n);
+		case Comparison::LessEqual: return compareIntegerLoop<Comparison::LessEqual>(a, b, mask, n);
+		case Comparison::Greater: return compareIntegerLoop<Comparison::Greater>(a, b, mask, n);
+		case Comparison::GreaterEqual: return compareIntegerLoop<Comparison::GreaterEqual>(a, b, mask, n);
+		case Comparison::Equal: return compareIntegerLoop<Comparison::Equal>(a, b, mask, n);
+		default: return compareIntegerLoop<Comparison::NotEqual>(a, b, mask, n);
+	}
+}
+
+template <typename T>
+constexpr Kernels<T> scalarKernels() {
+	return Kernels<T>{
+		sumScalar<T>, dotScalar<T>, minScalar<T>, maxScalar<T>, axpyScalar<T>,
+		applyScalar<T>, applyValueScalar<T>, compareScalar<T>, compareValueScalar<T>
+	};
+}
+
+// --- AVX2 kernels ---
+
+#ifdef LUACPP_NUMARRAY_AVX2
+
+constexpr int predicate(Comparison cmp) {
+	switch (cmp) {
+		case Comparison::Less: return _CMP_LT_OQ;
+		case Comparison::LessEqual: return _CMP_LE_OQ;
+		case Comparison::Greater: return _CMP_GT_OQ;
+		case Comparison::GreaterEqual: return _CMP_GE_OQ;
+		case Comparison::Equal: return _CMP_EQ_OQ;
+		default: return _CMP_NEQ_UQ; //true for NaN like the != operator
+	}
+}
+
+struct Avx2Double {
+	using T = double;
+	using V = __m256d;
+	constexpr static size_t Width = 4;
+
+	LUACPP_TARGET_AVX2 static V load(const T* p) { return _mm256_loadu_pd(p); }
+	LUACPP_TARGET_AVX2 static void store(T* p, V v) { _mm256_storeu_pd(p, v); }
+	LUACPP_TARGET_AVX2 static V set(T v) { return _mm256_set1_pd(v); }
+	LUACPP_TARGET_AVX2 static V add(V a, V b) { return _mm256_add_pd(a, b); }
+	LUACPP_TARGET_AVX2 static V sub(V a, V b) { return _mm256_sub_pd(a, b); }
+	LUACPP_TARGET_AVX2 static V mul(V a, V b) { return _mm256_mul_pd(a, b); }
+	LUACPP_TARGET_AVX2 static V div(V a, V b) { return _mm256_div_pd(a, b); }
+	LUACPP_TARGET_AVX2 static V min(V a, V b) { return _mm256_min_pd(a, b); }
+	LUACPP_TARGET_AVX2 static V max(V a, V b) { return _mm256_max_pd(a, b); }
+	LUACPP_TARGET_AVX2 static V fmadd(V a, V b, V c) { return _mm256_fmadd_pd(a, b, c); }
+	template <Comparison Cmp>
+	LUACPP_TARGET_AVX2 static V compare(V a, V b) {
+		constexpr int Predicate = predicate(Cmp); //has to be an immediate, also in unoptimized builds
+		return _mm256_cmp_pd(a, b, Predicate);
+	}
+	LUACPP_TARGET_AVX2 static void storeMask(int64_t* p, V mask) {
+		const __m256i bits = _mm256_and_si256(_mm256_castpd_si256(mask), _mm256_set1_epi64x(1));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(p), bits);
+	}
+};
+
+struct Avx2Float {
+	using T = float;
+	using V = __m256;
+	constexpr static size_t Width = 8;
+
+	LUACPP_TARGET_AVX2 static V load(const T* p) { return _mm256_loadu_ps(p); }
+	LUACPP_TARGET_AVX2 static void store(T* p, V v) { _mm256_storeu_ps(p, v); }
+	LUACPP_TARGET_AVX2 static V set(T v) { return _mm256_set1_ps(v); }
+	LUACPP_TARGET_AVX2 static V add(V a, V b) { return _mm256_add_ps(a, b); }
+	LUACPP_TARGET_AVX2 static V sub(V a, V b) { return _mm256_sub_ps(a, b); }
+	LUACPP_TARGET_AVX2 static V mul(V a, V b) { return _mm256_mul_ps(a, b); }
+	LUACPP_TARGET_AVX2 static V div(V a, V b) { return _mm256_div_ps(a, b); }
+	LUACPP_TARGET_AVX2 static V min(V a, V b) { return _mm256_min_ps(a, b); }
+	LUACPP_TARGET_AVX2 static V max(V a, V b) { return _mm256_max_ps(a, b); }
+	LUACPP_TARGET_AVX2 static V fmadd(V a, V b, V c) { return _mm256_fmadd_ps(a, b, c); }
+	template <Comparison Cmp>
+	LUACPP_TARGET_AVX2 static V compare(V a, V b) {
+		constexpr int Predicate = predicate(Cmp); //has to be an immediate, also in unoptimized builds
+		return _mm256_cmp_ps(a, b, Predicate);
+	}
+	LUACPP_TARGET_AVX2 static void storeMask(int64_t* p, V mask) {
+		//widen the 32 bit lanes (0 or -1) to 64 bit
+		const __m256i lanes = _mm256_castps_si256(mask);
+		const __m256i one = _mm256_set1_epi64x(1);
+		const __m256i low = _mm256_cvtepi32_epi64(_mm256_castsi256_si128(lanes));
+		const __m256i high = _mm256_cvtepi32_epi64(_mm256_extracti128_si256(lanes, 1));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(p), _mm256_and_si256(low, one));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(p + 4), _mm256_and_si256(high, one));
+	}
+};
+
+LUACPP_TARGET_AVX2 double horizontalSum(__m256d v) {
+	const __m128d pair = _mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+	return _mm_cvtsd_f64(_mm_add_sd(pair, _mm_unpackhi_pd(pair, pair)));
+}
+
+LUACPP_TARGET_AVX2 double sumAvx2(const double* a, size_t n) {
+	__m256d s0 = _mm256_setzero_pd(), s1 = _mm256_setzero_pd(), s2 = _mm256_setzero_pd(), s3 = _mm256_setzero_pd();
+	size_t i = 0;
+	for (; i + 16 <= n; i += 16) {
+		s0 = _mm256_add_pd(s0, _mm256_loadu_pd(a + i));
+		s1 = _mm256_add_pd(s1, _mm256_loadu_pd(a + i + 4));
+		s2 = _mm256_add_pd(s2, _mm256_loadu_pd(a + i + 8));
+		s3 = _mm256_add_pd(s3, _mm256_loadu_pd(a + i + 12));
+	}
+	for (; i + 4 <= n; i += 4) {
+		s0 = _mm256_add_pd(s0, _mm256_loadu_pd(a + i));
+	}
+	double sum = horizontalSum(_mm256_add_pd(_mm256_add_pd(s0, s1), _mm256_add_pd(s2, s3)));
+	for (; i < n; ++i) {
+		sum += a[i];
+	}
+	return sum;
+}
+
+LUACPP_TARGET_AVX2 double sumAvx2(const float* a, size_t n) {
+	//accumulate in double precision like the portable kernel
+	__m256d s0 = _mm256_setzero_pd(), s1 = _mm256_setzero_pd(), s2 = _mm256_setzero_pd(), s3 = _mm256_setzero_pd();
+	size_t i = 0;
+	for (; i + 16 <= n; i += 16) {
+		const __m256 v0 = _mm256_loadu_ps(a + i);
+		const __m256 v1 = _mm256_loadu_ps(a + i + 8);
+		s0 = _mm256_add_pd(s0, _mm256_cvtps_pd(_mm256_castps256_ps128(v0)));
+		s1 = _mm256_add_pd(s1, _mm256_cvtps_pd(_mm256_extractf128_ps(v0, 1)));
+		s2 = _mm256_add_pd(s2, _mm256_cvtps_pd(_mm256_castps256_ps128(v1)));
+		s3 = _mm256_add_pd(s3, _mm256_cvtps_pd(_mm256_extractf128_ps(v1, 1)));
+	}
+	double sum = horizontalSum(_mm256_add_pd(_mm256_add_pd(s0, s1), _mm256_add_pd(s2, s3)));
+	for (; i < n; ++i) {
+		sum += a[i];
+	}
+	return sum;
+}
+
+LUACPP_TARGET_AVX2 double dotAvx2(const double* a, const double* b, size_t n) {
+	__m256d s0 = _mm256_setzero_pd(), s1 = _mm256_setzero_pd(), s2 = _mm256_setzero_pd(), s3 = _mm256_setzero_pd();
+	size_t i = 0;
+	for (; i + 16 <= n; i += 16) {
+		s0 = _mm256_fmadd_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i), s0);
+		s1 = _mm256_fmadd_pd(_mm256_loadu_pd(a + i + 4), _mm256_loadu_pd(b + i + 4), s1);
+		s2 = _mm256_fmadd_pd(_mm256_loadu_pd(a + i + 8), _mm256_loadu_pd(b + i + 8), s2);
+		s3 = _mm256_fmadd_pd(_mm256_loadu_pd(a + i + 12), _mm256_loadu_pd(b + i + 12), s3);
+	}
+	for (; i + 4 <= n; i += 4) {
+		s0 = _mm256_fmadd_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i), s0);
+	}
+	double sum = horizontalSum(_mm256_add_pd(_mm256_add_pd(s0, s1), _mm256_add_pd(s2, s3)));
+	for (; i < n; ++i) {
+		sum += a[i] * b[i];
+	}
+	return sum;
+}
+
+LUACPP_TARGET_AVX2 double dotAvx2(const float* a, const float* b, size_t n) {
+	__m256d s0 = _mm256_setzero_pd(), s1 = _mm256_setzero_pd();
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		const __m256 x = _mm256_loadu_ps(a + i);
+		const __m256 y = _mm256_loadu_ps(b + i);
+		s0 = _mm256_fmadd_pd(_mm256_cvtps_pd(_mm256_castps256_ps128(x)), _mm256_cvtps_pd(_mm256_castps256_ps128(y)), s0);
+		s1 = _mm256_fmadd_pd(_mm256_cvtps_pd(_mm256_extractf128_ps(x, 1)), _mm256_cvtps_pd(_mm256_extractf128_ps(y, 1)), s1);
+	}
+	double sum = horizontalSum(_mm256_add_pd(s0, s1));
+	for (; i < n; ++i) {
+		sum += static_cast<double>(a[i]) * static_cast<double>(b[i]);
+	}
+	return sum;
+}
+
+template <typename S, bool Min>
+LUACPP_TARGET_AVX2 typename S::T extremeAvx2(const typename S::T* a, size_t n) {
+	using T = typename S::T;
+	if (n < S::Width) {
+		return Min ? minScalar(a, n) : maxScalar(a, n);
+	}
+	typename S::V acc = S::load(a);
+	size_t i = S::Width;
+	for (; i + S::Width <= n; i += S::Width) {
+		acc = Min ? S::min(S::load(a + i), acc) : S::max(S::load(a + i), acc);
+	}
+	T lanes[S::Width];
+	S::store(lanes, acc);
+	T result = Min ? minScalar(lanes, S::Width) : maxScalar(lanes, S::Width);
+	for (; i < n; ++i) {
+		result = Min ? (a[i] < result ? a[i] : result) : (a[i] > result ? a[i] : result);
+	}
+	return result;
+}
+
+template <typename S>
+LUACPP_TARGET_AVX2 typename S::T minAvx2(const typename S::T* a, size_t n) { return extremeAvx2<S, true>(a, n); }
+
+template <typename S>
+LUACPP_TARGET_AVX2 typename S::T maxAvx2(const typename S::T* a, size_t n) { return extremeAvx2<S, false>(a, n); }
+
+template <typename S>
+LUACPP_TARGET_AVX2 void axpyAvx2(typename S::T alpha, const typename S::T* x, typename S::T* y, size_t n) {
+	const typename S::V factor = S::set(alpha);
+	size_t i = 0;
+	for (; i + S::Width <= n; i += S::Width) {
+		S::store(y + i, S::fmadd(factor, S::load(x + i), S::load(y + i)));
+	}
+	axpyScalar(alpha, x + i, y + i, n - i);
+}
+
+template <typename S, Operation Op>
+LUACPP_TARGET_AVX2 typename S::V applyVector(typename S::V a, typename S::V b) {
+	if constexpr (Op == Operation::Add) {
+		return S::add(a, b);
+	} else if constexpr (Op == Operation::Subtract) {
+		return S::sub(a, b);
+	} else if constexpr (Op == Operation::Multiply) {
+		return S::mul(a, b);
+	} else {
+		return S::div(a, b);
+	}
+}
+
+template <typename S, Operation Op>
+LUACPP_TARGET_AVX2 bool applyLoopAvx2(const typename S::T* b, typename S::T* a, size_t n) {
+	size_t i = 0;
+	for (; i + S::Width <= n; i += S::Width) {
+		S::store(a + i, applyVector<S, Op>(S::load(a + i), S::load(b + i)));
+	}
+	return applyLoop<typename S::T, Op>(b + i, a + i, n - i);
+}
+
+template <typename S, Operation Op>
+LUACPP_TARGET_AVX2 bool applyValueLoopAvx2(typename S::T b, typename S::T* a, size_t n) {
+	const typename S::V value = S::set(b);
+	size_t i = 0;
+	for (; i + S::Width <= n; i += S::Width) {
+		S::store(a + i, applyVector<S, Op>(S::load(a + i), value));
+	}
+	return applyValueLoop<typename S::T, Op>(b, a + i, n - i);
+}
+
+template <typename S>
+LUACPP_TARGET_AVX2 bool applyAvx2(Operation op, const typename S::T* b, typename S::T* a, size_t n) {
+	switch (op) {
+		case Operation::Add: return applyLoopAvx2<S, Operation::Add>(b, a, n);
+		case Operation::Subtract: return applyLoopAvx2<S, Operation::Subtract>(b, a, n);
+		case Operation::Multiply: return applyLoopAvx2<S, Operation::Multiply>(b, a, n);
+		default: return applyLoopAvx2<S, Operation::Divide>(b, a, n);
+	}
+}
+
+template <typename S>
+LUACPP_TARGET_AVX2 bool applyValueAvx2(Operation op, typename S::T b, typename S::T* a, size_t n) {
+	switch (op) {
+		case Operation::Add: return applyValueLoopAvx2<S, Operation::Add>(b, a, n);
+		case Operation::Subtract: return applyValueLoopAvx2<S, Operation::Subtract>(b, a, n);
+		case Operation::Multiply: return applyValueLoopAvx2<S, Operation::Multiply>(b, a, n);
+		default: return applyValueLoopAvx2<S, Operation::Divide>(b, a, n);
+	}
+}
+
+template <typename S, Comparison Cmp>
+LUACPP_TARGET_AVX2 void compareLoopAvx2(const typename S::T* a, const typename S::T* b, int64_t* mask, size_t n) {
+	size_t i = 0;
+	for (; i + S::Width <= n; i += S::Width) {
+		S::storeMask(mask + i, S::template compare<Cmp>(S::load(a + i), S::load(b + i)));
+	}
+	compareLoop<typename S::T, Cmp>(a + i, b + i, mask + i, n - i);
+}
+
+template <typename S, Comparison Cmp>
+LUACPP_TARGET_AVX2 void compareValueLoopAvx2(const typename S::T* a, double b, int64_t* mask, size_t n) {
+	const typename S::V value = S::set(static_cast<typename S::T>(b));
+	size_t i = 0;
+	for (; i + S::Width <= n; i += S::Width) {
+		S::storeMask(mask + i, S::template compare<Cmp>(S::load(a + i), value));
+	}
+	compareValueLoop<typename S::T, Cmp>(a + i, b, mask + i, n - i);
+}
+
+template <typename S>
+LUACPP_TARGET_AVX2 void compareAvx2(Comparison cmp, const typename S::T* a, const typename S::T* b, int64_t* mask, size_t n) {
+	switch (cmp) {
+		case Comparison::Less: return compareLoopAvx2<S, Comparison::Less>(a, b, mask, n);
+		case Comparison::LessEqual: return compareLoopAvx2<S, Comparison::LessEqual>(a, b, mask, n);
+		case Comparison::Greater: return compareLoopAvx2<S, Comparison::Greater>(a, b, mask, n);
+		case Comparison::GreaterEqual: return compareLoopAvx2<S, Comparison::GreaterEqual>(a, b, mask, n);
+		case Comparison::Equal: return compareLoopAvx2<S, Comparison::Equal>(a, b, mask, n);
+		default: return compareLoopAvx2<S, Comparison::NotEqual>(a, b, mask, n);
+	}
+}
+
+template <typename S>
+LUACPP_TARGET_AVX2 void compareValueAvx2(Comparison cmp, const typename S::T* a, double b, int64_t* mask, size_t n) {
+	switch (cmp) {
+		case Comparison::Less: return compareValueLoopAvx2<S, Comparison::Less>(a, b, mask, n);
+		case Comparison::LessEqual: return compareValueLoopAvx2<S, Comparison::LessEqual>(a, b, mask, n);
+		case Comparison::Greater: return compareValueLoopAvx2<S, Comparison::Greater>(a, b, mask, n);
+		case Comparison::GreaterEqual: return compareValueLoopAvx2<S, Comparison::GreaterEqual>(a, b, mask, n);
+		case Comparison::Equal: return compareValueLoopAvx2<S, Comparison::Equal>(a, b, mask, n);
+		default: return compareValueLoopAvx2<S, Comparison::NotEqual>(a, b, mask, n);
+	}
+}
+
+template <typename S>
+Kernels<typename S::T> avx2Kernels() {
+	using T = typename S::T;
+	return Kernels<T>{
+		static_cast<double (*)(const T*, size_t)>(sumAvx2), static_cast<double (*)(const T*, const T*, size_t)>(dotAvx2),
+		minAvx2<S>, maxAvx2<S>, axpyAvx2<S>, applyAvx2<S>, applyValueAvx2<S>, compareAvx2<S>, compareValueAvx2<S>
+	};
+}
+
+bool cpuSupportsAvx2() {
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+}
+
+#else
+
+bool cpuSupportsAvx2() {
+	return false;
+}
+
+#endif // LUACPP_NUMARRAY_AVX2
+
+std::atomic<bool> s_simdEnabled{cpuSupportsAvx2()};
+
+template <typename T>
+const Kernels<T>& kernels() {
+	static const Kernels<T> scalar = scalarKernels<T>();
+#ifdef LUACPP_NUMARRAY_AVX2
+	if constexpr (std::is_same_v<T, double> || std::is_same_v<T, float>) {
+		using S = std::conditional_t<std::is_same_v<T, double>, Avx2Double, Avx2Float>;
+		static const Kernels<T> avx2 = avx2Kernels<S>();
+		if (s_simdEnabled.load(std::memory_order_relaxed)) {
+			return avx2;
+		}
+	}
+#endif
+	return scalar;
+}
+
+template <typename T>
+struct Tag {
+	using Type = T;
+};
+
+/**
+ * @brief calls the given function with a Tag of the c++ type matching the element type
+*/
+template <typename Func>
+auto visit(NumArray::ElementType type, Func&& func) {
+	switch (type) {
+		case NumArray::ElementType::Float64: return func(Tag<double>());
+		case NumArray::ElementType::Float32: return func(Tag<float>());
+		default: return func(Tag<int64_t>());
+	}
+}
+
+int parseType(lua_State* state, int arg) {
+	const char* const names[] = {"f64", "f32", "i64", nullptr};
+	return luaL_checkoption(state, arg, "f64", names);
+}
+
+} // namespace
+
+namespace Lua {
+
+NumArray::NumArray(ElementType type, size_t size)
+	: m_type(type)
+	, m_size(size)
+	, m_data(allocate(type, size))
+{
+	std::memset(m_data, 0, size * elementSize(type));
+}
+
+NumArray::~NumArray() {
+	::operator delete(m_data, std::align_val_t(Alignment));
+}
+
+std::shared_ptr<NumArray> NumArray::create(ElementType type, const void* data, size_t size) {
+	auto array = std::make_shared<NumArray>(type, size);
+	if (size > 0) {
+		std::memcpy(array->m_data, data, size * elementSize(type));
+	}
+	return array;
+}
+
+void* NumArray::allocate(ElementType type, size_t size) {
+	if (size > std::numeric_limits<size_t>::max() / elementSize(type)) {
+		throw std::bad_array_new_length();
+	}
+	void* data = ::operator new(size > 0 ? size * elementSize(type) : Alignment, std::align_val_t(Alignment), std::nothrow);
+	if (data == nullptr) {
+		throw std::bad_alloc();
+	}
+	return data;
+}
+
+size_t NumArray::elementSize(ElementType type) {
+	return type == ElementType::Float32 ? sizeof(float) : sizeof(double);
+}
+
+void NumArray::checkType(ElementType type) const {
+	if (type != m_type) {
+		throw std::invalid_argument("element type of the array doesn't match");
+	}
+}
+
+void NumArray::checkCompatible(const NumArray& other) const {
+	if (other.m_type != m_type || other.m_size != m_size) {
+		throw std::invalid_argument("arrays differ in element type or size");
+	}
+}
+
+double NumArray::get(size_t index) const {
+	return visit(m_type, [&](auto tag) {
+		using T = typename decltype(tag)::Type;
+		return static_cast<double>(static_cast<const T*>(m_data)[index]);
+	});
+}
+
+void NumArray::set(size_t index, double value) {
+	visit(m_type, [&](auto tag) {
+		using T = typename decltype(tag)::Type;
+		static_cast<T*>(m_data)[index] = static_cast<T>(value);
+	});
+}
+
+void NumArray::fill(double value) {
+	visit(m_type, [&](auto tag) {
+		using T = typename decltype(tag)::Type;
+		T* data = static_cast<T*>(m_data);
+		const T element = static_cast<T>(value);
+		for (size_t i = 0; i < m_size; ++i) {
+			data[i] = element;
+		}
+	});
+}
+
+std::shared_ptr<NumArray> NumArray::copy() const {
+	return create(m_type, m_data, m_size);
+}
+
+double NumArray::sum() const {
+	return visit(m_type, [&](auto tag) {
+		using T = typename decltype(tag)::Type;
+		return kernels<T>().sum(static_cast<const T*>(m_data), m_size);
+	});
+}
+
+double NumArray::min() const {
+	if (m_size == 0) {
+		return std::numeric_limits<double>::quiet_NaN();
+	}
+	return visit(m_type, [&](auto tag) {
+		using T = typename decltype(tag)::Type;
+		return static_cast<double>(kernels<T>().min(static_cast<const T*>(m_data), m_size));
+	});
+}
+
+double NumArray::max() const {
+	if (m_size == 0) {
+		return std::numeric_limits<double>::quiet_NaN();
+	}
+	return visit(m_type, [&](auto tag) {
+		using T = typename decltype(tag)::Type;
+		return static_cast<double>(kernels<T>().max(static_cast<const T*>(m_data), m_size));
+	});
+}
+
+double NumArray::dot(const NumArray& other) const {
+	checkCompatible(other);
+	return visit(m_type, [&](auto tag) {
+		using T = typename decltype(tag)::Type;
+		return kernels<T>().dot(static_cast<const T*>(m_data), static_cast<const T*>(other.m_data), m_size);
+	});
+}
+
+void NumArray::axpy(double alpha, const NumArray& x) {
+	checkCompatible(x);
+	visit(m_type, [&](auto tag) {
+		using T = typename decltype(tag)::Type;
+		kernels<T>().axpy(static_cast<T>(alpha), static_cast<const T*>(x.m_data), static_cast<T*>(m_data), m_size);
+	});
+}
+
+void NumArray::apply(Operation op, const NumArray& other) {
+	checkCompatible(other);
+	if (!applyUnchecked(op, &other, 0.0)) {
+		throw std::domain_error("integer division by zero");
+	}
+}
+
+void NumArray::apply(Operation op, double value) {
+	if (!applyUnchecked(op, nullptr, value)) {
+		throw std::domain_error("integer division by zero");
+	}
+}
+
+bool NumArray::applyUnchecked(Operation op, const NumArray* other, double value) {
+	return visit(m_type, [&](auto tag) {
+		using T = typename decltype(tag)::Type;
+		T* data = static_cast<T*>(m_data);
+		if (other != nullptr) {
+			const T* b = static_cast<const T*>(other->m_data);
+			if constexpr (std::is_integral_v<T>) {
+				//the kernels stop at the first zero, the divisors are checked before to leave the array unchanged
+				if (op == Operation::Divide && std::find(b, b + m_size, T(0)) != b + m_size) {
+					return false;
+				}
+			}
+			return kernels<T>().apply(op, b, data, m_size);
+		}
+		return kernels<T>().applyValue(op, static_cast<T>(value), data, m_size);
+	});
+}
+
+bool NumArray::applyInteger(Operation op, int64_t value) {
+	return kernels<int64_t>().applyValue(op, value, static_cast<int64_t*>(m_data), m_size);
+}
+
+std::shared_ptr<NumArray> NumArray::compare(Comparison cmp, const NumArray& other) const {
+	checkCompatible(other);
+	auto mask = std::make_shared<NumArray>(ElementType::Int64, m_size);
+	compareUnchecked(cmp, &other, 0.0, *mask);
+	return mask;
+}
+
+std::shared_ptr<NumArray> NumArray::compare(Comparison cmp, double value) const {
+	auto mask = std::make_shared<NumArray>(ElementType::Int64, m_size);
+	compareUnchecked(cmp, nullptr, value, *mask);
+	return mask;
+}
+
+void NumArray::compareUnchecked(Comparison cmp, const NumArray* other, double value, NumArray& mask) const {
+	//integral values are compared exactly with int64 elements, values outside of their range are above or below all of
+	//them. Other values can't be equal to any element and their order doesn't change when the elements are rounded.
+	constexpr double Limit = 9223372036854775808.0; //2^63
+	if (m_type == ElementType::Int64 && other == nullptr && !std::isnan(value)) {
+		if (value >= Limit || value < -Limit) {
+			const bool above = value > 0.0;
+			const bool result = cmp == Comparison::NotEqual
+				|| (above ? cmp == Comparison::Less || cmp == Comparison::LessEqual : cmp == Comparison::Greater || cmp == Comparison::GreaterEqual);
+			std::fill_n(static_cast<int64_t*>(mask.m_data), m_size, result ? 1 : 0);
+			return;
+		}
+		if (std::floor(value) == value) {
+			compareInteger(cmp, static_cast<int64_t>(value), mask);
+			return;
+		}
+	}
+	visit(m_type, [&](auto tag) {
+		using T = typename decltype(tag)::Type;
+		const T* data = static_cast<const T*>(m_data);
+		int64_t* result = static_cast<int64_t*>(mask.m_data);
+		if (other != nullptr) {
+			kernels<T>().compare(cmp, data, static_cast<const T*>(other->m_data), result, m_size);
+		} else {
+			kernels<T>().compareValue(cmp, data, value, result, m_size);
+		}
+	});
+}
+
+void NumArray::compareInteger(Comparison cmp, int64_t value, NumArray& mask) const {
+	::compareInteger(cmp, static_cast<const int64_t*>(m_data), value, static_cast<int64_t*>(mask.m_data), m_size);
+}
+
+const char* NumArray::getInstructionSet() {
+	return s_simdEnabled.load(std::memory_order_relaxed) ? "avx2" : "scalar";
+}
+
+void NumArray::setSimdEnabled(bool enabled) {
+	s_simdEnabled.store(enabled && cpuSupportsAvx2(), std::memory_order_relaxed);
+}
+
+void NumArray::push(lua_State* state, std::shared_ptr<NumArray> array) {
+	void* userData = lua_newuserdatauv(state, sizeof(std::shared_ptr<NumArray>), 0);
+	new (userData) std::shared_ptr<NumArray>(std::move(array));
+	pushMetaTable(state);
+	lua_setmetatable(state, -2);
+}
+
+std::shared_ptr<NumArray> NumArray::fromStack(lua_State* state, int index) {
+	void* userData = luaL_testudata(state, index, MetaTableName);
+	if (userData == nullptr) {
+		return nullptr;
+	}
+	return *static_cast<std::shared_ptr<NumArray>*>(userData);
+}
+
+void NumArray::openLibrary(lua_State* state) {
+	const luaL_Reg functions[] = {
+		{"new", luaNew},
+		{"from", luaFrom},
+		{nullptr, nullptr}
+	};
+	luaL_newlib(state, functions);
+	lua_setglobal(state, "numarray");
+}
+
+NumArray* NumArray::checkArray(lua_State* state, int index) {
+	return static_cast<std::shared_ptr<NumArray>*>(luaL_checkudata(state, index, MetaTableName))->get();
+}
+
+NumArray* NumArray::pushNew(lua_State* state, ElementType type, size_t size) {
+	//the userdata is created first, so a memory error of lua can't leak the array
+	void* userData = lua_newuserdatauv(state, sizeof(std::shared_ptr<NumArray>), 0);
+	std::shared_ptr<NumArray>* pointer = nullptr;
+	try {
+		pointer = new (userData) std::shared_ptr<NumArray>(std::make_shared<NumArray>(type, size));
+	} catch (const std::bad_alloc&) {
+		//the error is raised outside of the handler, the exception must not be skipped by lua's longjmp
+	}
+	if (pointer == nullptr) {
+		luaL_error(state, "not enough memory for an array of %I elements", static_cast<lua_Integer>(size));
+	}
+	pushMetaTable(state);
+	lua_setmetatable(state, -2);
+	//the elements aren't allocated by lua, so the collector has to be told about the memory of larger arrays
+	const size_t kiloBytes = size * elementSize(type) / 1024;
+	if (kiloBytes > 0) {
+		lua_gc(state, LUA_GCSTEP, static_cast<int>(std::min<size_t>(kiloBytes, std::numeric_limits<int>::max())));
+	}
+	return pointer->get();
+}
+
+void NumArray::pushElement(lua_State* state, const NumArray& array, size_t index) {
+	if (array.m_type == ElementType::Int64) {
+		lua_pushinteger(state, static_cast<const int64_t*>(array.m_data)[index]);
+	} else {
+		lua_pushnumber(state, array.get(index));
+	}
+}
+
+void NumArray::pushMetaTable(lua_State* state) {
+	if (luaL_newmetatable(state, MetaTableName) == 0) {
+		return; //already registered in this state
+	}
+	const luaL_Reg methods[] = {
+		{"type", type},
+		{"fill", luaFill},
+		{"copy", luaCopy},
+		{"totable", toTable},
+		{"sum", luaSum},
+		{"mean", mean},
+		{"min", luaMin},
+		{"max", luaMax},
+		{"dot", luaDot},
+		{"axpy", luaAxpy},
+		{"scale", luaScale},
+		{"add", luaApply<Operation::Add>},
+		{"sub", luaApply<Operation::Subtract>},
+		{"mul", luaApply<Operation::Multiply>},
+		{"div", luaApply<Operation::Divide>},
+		{"lt", luaCompare<Comparison::Less>},
+		{"le", luaCompare<Comparison::LessEqual>},
+		{"gt", luaCompare<Comparison::Greater>},
+		{"ge", luaCompare<Comparison::GreaterEqual>},
+		{"eq", luaCompare<Comparison::Equal>},
+		{"ne", luaCompare<Comparison::NotEqual>},
+		{nullptr, nullptr}
+	};
+	luaL_newlib(state, methods);
+	lua_pushcclosure(state, index, 1);
+	lua_setfield(state, -2, "__index");
+
+	const luaL_Reg functions[] = {
+		{"__newindex", newIndex},
+		{"__len", len},
+		{"__gc", gc},
+		{nullptr, nullptr}
+	};
+	luaL_setfuncs(state, functions, 0);
+}
+
+int NumArray::luaNew(lua_State* state) {
+	const lua_Integer size = luaL_checkinteger(state, 1);
+	luaL_argcheck(state, size >= 0, 1, "size must not be negative");
+	const ElementType elementType = static_cast<ElementType>(parseType(state, 2));
+	pushNew(state, elementType, static_cast<size_t>(size));
+	return 1;
+}
+
+int NumArray::luaFrom(lua_State* state) {
+	luaL_checktype(state, 1, LUA_TTABLE);
+	const ElementType elementType = static_cast<ElementType>(parseType(state, 2));
+	const size_t size = static_cast<size_t>(luaL_len(state, 1));
+	NumArray* array = pushNew(state, elementType, size);
+	for (size_t i = 0; i < size; ++i) {
+		lua_geti(state, 1, static_cast<lua_Integer>(i + 1));
+		if (elementType == ElementType::Int64) {
+			static_cast<int64_t*>(array->m_data)[i] = luaL_checkinteger(state, -1);
+		} else {
+			array->set(i, luaL_checknumber(state, -1));
+		}
+		lua_pop(state, 1);
+	}
+	return 1;
+}
+
+int NumArray::index(lua_State* state) {
+	const NumArray* array = checkArray(state, 1);
+	if (lua_type(state, 2) == LUA_TSTRING) {
+		lua_pushvalue(state, 2);
+		lua_rawget(state, lua_upvalueindex(1));
+		return 1;
+	}
+	int isInteger = 0;
+	const lua_Integer pos = lua_tointegerx(state, 2, &isInteger);
+	if (isInteger == 0 || pos < 1 || static_cast<size_t>(pos) > array->m_size) {
+		lua_pushnil(state);
+	} else {
+		pushElement(state, *array, static_cast<size_t>(pos - 1));
+	}
+	return 1;
+}
+
+int NumArray::newIndex(lua_State* state) {
+	NumArray* array = checkArray(state, 1);
+	const lua_Integer pos = luaL_checkinteger(state, 2);
+	luaL_argcheck(state, pos >= 1 && static_cast<size_t>(pos) <= array->m_size, 2, "index out of range");
+	if (array->m_type == ElementType::Int64) {
+		static_cast<int64_t*>(array->m_data)[pos - 1] = luaL_checkinteger(state, 3);
+	} else {
+		array->set(static_cast<size_t>(pos - 1), luaL_checknumber(state, 3));
+	}
+	return 0;
+}
+
+int NumArray::len(lua_State* state) {
+	lua_pushinteger(state, static_cast<lua_Integer>(checkArray(state, 1)->m_size));
+	return 1;
+}
+
+int NumArray::type(lua_State* state) {
+	const char* const names[] = {"f64", "f32", "i64"};
+	lua_pushstring(state, names[static_cast<int>(checkArray(state, 1)->m_type)]);
+	return 1;
+}
+
+int NumArray::luaFill(lua_State* state) {
+	NumArray* array = checkArray(state, 1);
+	if (array->m_type == ElementType::Int64) {
+		const int64_t value = luaL_checkinteger(state, 2);
+		int64_t* data = static_cast<int64_t*>(array->m_data);
+		for (size_t i = 0; i < array->m_size; ++i) {
+			data[i] = value;
+		}
+	} else {
+		array->fill(luaL_checknumber(state, 2));
+	}
+	lua_settop(state, 1);
+	return 1;
+}
+
+int NumArray::luaCopy(lua_State* state) {
+	const NumArray* array = checkArray(state, 1);
+	NumArray* result = pushNew(state, array->m_type, array->m_size);
+	std::memcpy(result->m_data, array->m_data, array->m_size * elementSize(array->m_type));
+	return 1;
+}
+
+int NumArray::toTable(lua_State* state) {
+	const NumArray* array = checkArray(state, 1);
+	lua_createtable(state, static_cast<int>(array->m_size), 0);
+	for (size_t i = 0; i < array->m_size; ++i) {
+		pushElement(state, *array, i);
+		lua_rawseti(state, -2, static_cast<lua_Integer>(i + 1));
+	}
+	return 1;
+}
+
+int NumArray::luaSum(lua_State* state) {
+	const NumArray* array = checkArray(state, 1);
+	if (array->m_type == ElementType::Int64) {
+		lua_pushinteger(state, sumInteger(static_cast<const int64_t*>(array->m_data), array->m_size));
+	} else {
+		lua_pushnumber(state, array->sum());
+	}
+	return 1;
+}
+
+int NumArray::mean(lua_State* state) {
+	const NumArray* array = checkArray(state, 1);
+	lua_pushnumber(state, array->m_size > 0 ? array->sum() / static_cast<double>(array->m_size) : std::nan(""));
+	return 1;
+}
+
+int NumArray::luaMin(lua_State* state) {
+	const NumArray* array = checkArray(state, 1);
+	if (array->m_size == 0) {
+		lua_pushnil(state);
+	} else if (array->m_type == ElementType::Int64) {
+		lua_pushinteger(state, kernels<int64_t>().min(static_cast<const int64_t*>(array->m_data), array->m_size));
+	} else {
+		lua_pushnumber(state, array->min());
+	}
+	return 1;
+}
+
+int NumArray::luaMax(lua_State* state) {
+	const NumArray* array = checkArray(state, 1);
+	if (array->m_size == 0) {
+		lua_pushnil(state);
+	} else if (array->m_type == ElementType::Int64) {
+		lua_pushinteger(state, kernels<int64_t>().max(static_cast<const int64_t*>(array->m_data), array->m_size));
+	} else {
+		lua_pushnumber(state, array->max());
+	}
+	return 1;
+}
+
+int NumArray::luaDot(lua_State* state) {
+	const NumArray* array = checkArray(state, 1);
+	const NumArray* other = checkArray(state, 2);
+	luaL_argcheck(state, other->m_type == array->m_type && other->m_size == array->m_size, 2, "arrays differ in type or size");
+	lua_pushnumber(state, array->dot(*other));
+	return 1;
+}
+
+int NumArray::luaAxpy(lua_State* state) {
+	NumArray* array = checkArray(state, 1);
+	const NumArray* x = checkArray(state, 3);
+	luaL_argcheck(state, x->m_type == array->m_type && x->m_size == array->m_size, 3, "arrays differ in type or size");
+	if (array->m_type == ElementType::Int64) {
+		//integers above 2^53 would lose precision as double
+		kernels<int64_t>().axpy(luaL_checkinteger(state, 2), static_cast<const int64_t*>(x->m_data), static_cast<int64_t*>(array->m_data), array->m_size);
+	} else {
+		array->axpy(luaL_checknumber(state, 2), *x);
+	}
+	lua_settop(state, 1);
+	return 1;
+}
+
+int NumArray::luaScale(lua_State* state) {
+	NumArray* array = checkArray(state, 1);
+	if (array->m_type == ElementType::Int64) {
+		array->applyInteger(Operation::Multiply, luaL_checkinteger(state, 2));
+	} else {
+		array->applyUnchecked(Operation::Multiply, nullptr, luaL_checknumber(state, 2));
+	}
+	lua_settop(state, 1);
+	return 1;
+}
+
+template <NumArray::Operation Op>
+int NumArray::luaApply(lua_State* state) {
+	NumArray* array = checkArray(state, 1);
+	bool ok;
+	if (lua_type(state, 2) == LUA_TNUMBER) {
+		ok = array->m_type == ElementType::Int64
+			? array->applyInteger(Op, luaL_checkinteger(state, 2)) : array->applyUnchecked(Op, nullptr, lua_tonumber(state, 2));
+	} else {
+		const NumArray* other = checkArray(state, 2);
+		luaL_argcheck(state, other->m_type == array->m_type && other->m_size == array->m_size, 2, "arrays differ in type or size");
+		ok = array->applyUnchecked(Op, other, 0.0);
+	}
+	if (!ok) {
+		return luaL_error(state, "attempt to perform 'n//0'");
+	}
+	lua_settop(state, 1);
+	return 1;
+}
+
+template <NumArray::Comparison Cmp>
+int NumArray::luaCompare(lua_State* state) {
+	const NumArray* array = checkArray(state, 1);
+	const NumArray* other = nullptr;
+	double value = 0.0;
+	int isInteger = 0;
+	lua_Integer integer = 0;
+	if (lua_type(state, 2) == LUA_TNUMBER) {
+		integer = lua_tointegerx(state, 2, &isInteger);
+		value = lua_tonumber(state, 2);
+	} else {
+		other = checkArray(state, 2);
+		luaL_argcheck(state, other->m_type == array->m_type && other->m_size == array->m_size, 2, "arrays differ in type or size");
+	}
+	NumArray* mask = pushNew(state, ElementType::Int64, array->m_size);
+	if (array->m_type == ElementType::Int64 && other == nullptr && isInteger != 0) {
+		array->compareInteger(Cmp, integer, *mask);
+	} else {
+		array->compareUnchecked(Cmp, other, value, *mask);
+	}
+	return 1;
+}
+
+int NumArray::gc(lua_State* state) {
+	using Pointer = std::shared_ptr<NumArray>;
+	static_cast<Pointer*>(luaL_checkudata(state, 1, MetaTableName))->~Pointer();
+	return 0;
+}
+
+} // namespace Lua
\ No newline at end of file
@@ -0,0 +1,168 @@
+#include <Parallel.hpp>
+#include <lua/lua.hpp>
+
+#include <algorithm>
+#include <exception>
+#include <thread>
+
+namespace Lua {
+
+namespace {
+
+//stack layout of a worker state, set up once when the worker is created
+constexpr int MapDriverIndex = 1;
+constexpr int ReduceDriverIndex = 2;
+constexpr int InputIndex = 3;
+constexpr int OutputIndex = 4;
+
+constexpr size_t MaxChunkSize = 1024;
+constexpr size_t ChunksPerThread = 4;
+
+//the loops applying the function to a chunk, running them in lua saves a protected call per element
+constexpr const char* const Drivers = R"(
+	local function map(f, input, output, n)
+		for i = 1, n do
+			output[i] = f(input[i])
+		end
+	end
+	local function reduce(f, input, n, acc)
+		for i = 1, n do
+			acc = f(acc, input[i])
+		end
+		return acc
+	end
+	return map, reduce
+)";
+
+} // namespace
+
+Workers::Worker::Worker(const Options& options, const Setup& setup) : m_state(options.libraries) {
+	lua_State* L = m_state.getState();
+	luaL_loadstring(L, Drivers);
+	lua_call(L, 0, 2);
+	const int chunkSize = static_cast<int>(options.chunkSize != 0 ? options.chunkSize : MaxChunkSize);
+	lua_createtable(L, chunkSize, 0);
+	lua_createtable(L, chunkSize, 0);
+	if (setup) {
+		setup(m_state);
+	}
+}
+
+int Workers::Worker::map(const char* function, size_t count) {
+	lua_State* L = m_state.getState();
+	lua_pushvalue(L, InputIndex);
+	lua_pushvalue(L, OutputIndex);
+	lua_pushinteger(L, static_cast<lua_Integer>(count));
+	return call(function, MapDriverIndex, 3, 0);
+}
+
+int Workers::Worker::reduce(const char* function, size_t count) {
+	lua_State* L = m_state.getState();
+	lua_pushvalue(L, InputIndex);
+	lua_pushinteger(L, static_cast<lua_Integer>(count));
+	lua_rotate(L, -3, -1); //move the accumulator behind the arguments
+	return call(function, ReduceDriverIndex, 3, 1);
+}
+
+void Workers::Worker::storeInput(size_t index) {
+	lua_rawseti(m_state.getState(), InputIndex, static_cast<lua_Integer>(index));
+}
+
+void Workers::Worker::loadOutput(size_t index) {
+	lua_rawgeti(m_state.getState(), OutputIndex, static_cast<lua_Integer>(index));
+}
+
+int Workers::Worker::call(const char* function, int driver, int numArgs, int numResults) {
+	lua_State* L = m_state.getState();
+	const int base = lua_gettop(L) - numArgs;
+	lua_pushvalue(L, driver);
+	const int type = lua_getglobal(L, function);
+	if (type != LUA_TFUNCTION) {
+		m_lastError = std::string("attempt to call a ") + lua_typename(L, type) + " value (global '" + function + "')";
+		lua_settop(L, base);
+		return LUA_ERRRUN;
+	}
+	//driver and function have to be in front of the arguments
+	lua_rotate(L, base + 1, 2);
+	const int status = lua_pcall(L, numArgs + 1, numResults, 0);
+	if (status != LUA_OK) {
+		const char* message = lua_tostring(L, -1);
+		m_lastError = message != nullptr ? message : "error object is not a string";
+		lua_settop(L, base);
+	}
+	return status;
+}
+
+Workers::Workers(Setup setup) : Workers(std::move(setup), Options()) {}
+
+Workers::Workers(Setup setup, const Options& options) : m_setup(std::move(setup)), m_options(options) {
+	const size_t threads = m_options.threads != 0 ? m_options.threads : std::max<size_t>(std::thread::hardware_concurrency(), 1);
+	m_workers.resize(threads);
+}
+
+Workers::~Workers() = default;
+
+size_t Workers::getChunkSize(size_t count) const {
+	if (m_options.chunkSize != 0) {
+		return m_options.chunkSize;
+	}
+	const size_t chunks = m_workers.size() * ChunksPerThread;
+	return std::clamp<size_t>((count + chunks - 1) / chunks, 1, MaxChunkSize);
+}
+
+size_t Workers::getChunkCount(size_t count) const {
+	const size_t chunkSize = getChunkSize(count);
+	return (count + chunkSize - 1) / chunkSize;
+}
+
+int Workers::forEachChunk(size_t count, const ChunkFunction& function) {
+	m_lastError.clear();
+	if (count == 0) {
+		return 0;
+	}
+
+	const size_t threads = std::min(m_workers.size(), getChunkCount(count));
+	std::atomic<size_t> next{0};
+	std::atomic<bool> failed{false};
+	int status = 0;
+	std::vector<std::thread> helpers;
+	helpers.reserve(threads - 1);
+	for (size_t i = 1; i < threads; ++i) {
+		helpers.emplace_back(&Workers::work, this, i, count, std::cref(function), std::ref(next), std::ref(failed), std::ref(status));
+	}
+	work(0, count, function, next, failed, status);
+	for (std::thread& helper : helpers) {
+		helper.join();
+	}
+	return status;
+}
+
+void Workers::work(size_t worker, size_t count, const ChunkFunction& function, std::atomic<size_t>& next, std::atomic<bool>& failed, int& status) {
+	const size_t chunkSize = getChunkSize(count);
+	const size_t chunks = (count + chunkSize - 1) / chunkSize;
+	try {
+		if (!m_workers[worker]) {
+			m_workers[worker] = std::make_unique<Worker>(m_options, m_setup);
+		}
+		Worker& state = *m_workers[worker];
+		for (size_t chunk = next.fetch_add(1, std::memory_order_relaxed); chunk < chunks && !failed.load(std::memory_order_relaxed); chunk = next.fetch_add(1, std::memory_order_relaxed)) {
+			const size_t begin = chunk * chunkSize;
+			const int result = function(state, chunk, begin, std::min(begin + chunkSize, count));
+			if (result != 0) {
+				std::lock_guard<std::mutex> lock(m_mutex);
+				if (!failed.exchange(true)) {
+					status = result;
+					m_lastError = state.getLastError();
+				}
+			}
+		}
+	} catch (const std::exception& e) {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (!failed.exchange(true)) {
+			status = LUA_ERRRUN;
+			m_lastError = e.what();
+		}
+	}
+}
+
+} // namespace Lua
\ No newline at end of file
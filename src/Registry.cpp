@@ -48,6 +48,39 @@ Registry::ErrorCode Registry::loadString(lua_State* state, const char* src) {
 	return static_cast<ErrorCode>(luaL_loadstring(state, src));
 }
 
+Registry::ErrorCode Registry::loadBinary(lua_State* state, std::string_view bytecode, const char* chunkName) {
+	return static_cast<ErrorCode>(luaL_loadbufferx(state, bytecode.data(), bytecode.size(), chunkName, "b"));
+}
+
+static int writeBytecode(lua_State*, const void* data, size_t size, void* userData) {
+	static_cast<std::string*>(userData)->append(static_cast<const char*>(data), size);
+	return 0;
+}
+
+Registry::ErrorCode Registry::compile(std::string_view src, const char* chunkName, std::string& bytecode, std::string& error) {
+	lua_State* state = luaL_newstate();
+	if (state == nullptr) {
+		return ErrorCode::MemoryError;
+	}
+	ErrorCode res = compile(state, src, chunkName, bytecode, error);
+	lua_close(state);
+	return res;
+}
+
+Registry::ErrorCode Registry::compile(lua_State* scratch, std::string_view src, const char* chunkName, std::string& bytecode, std::string& error, bool strip) {
+	const int top = lua_gettop(scratch);
+	ErrorCode res = static_cast<ErrorCode>(luaL_loadbufferx(scratch, src.data(), src.size(), chunkName, "t"));
+	if (res == ErrorCode::Ok) {
+		bytecode.clear();
+		lua_dump(scratch, writeBytecode, &bytecode, strip ? 1 : 0);
+	} else {
+		const char* message = lua_tostring(scratch, -1);
+		error = message != nullptr ? message : "unknown error";
+	}
+	lua_settop(scratch, top);
+	return res;
+}
+
 bool Registry::isUserDefinedEntry(const Registry& registry) {
 	int type = lua_type(registry.m_state, -2);
 	switch (type) {
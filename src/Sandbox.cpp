@@ -0,0 +1,307 @@
+#include <Sandbox.hpp>
+#include <lua/lua.hpp>
+
+#include <cstring>
+#include <new>
+
+namespace Lua {
+
+namespace {
+constexpr const char* const KeepersKey = "luacpp.Sandbox.keepers"; ///< registry key of the unused keeper closures
+constexpr const char* const ProxiesKey = "luacpp.Sandbox.proxies"; ///< registry key of the proxies by their table
+
+/**
+ * @brief pushes a new lua closure with a single upvalue (an empty chunk)
+*/
+void pushEmptyClosure(lua_State* state) {
+	if (luaL_loadbuffer(state, "", 0, "=sandbox") != LUA_OK) {
+		lua_pop(state, 1);
+		throw std::bad_alloc();
+	}
+}
+
+/**
+ * @brief pushes a closure used to hold on to the upvalue of another function, taken from the unused ones if possible
+ * The keepers table holds an empty closure at index 0, released keepers are detached by joining them to its upvalue.
+*/
+void pushKeeper(lua_State* state) {
+	if (luaL_getsubtable(state, LUA_REGISTRYINDEX, KeepersKey) == 0) {
+		pushEmptyClosure(state);
+		lua_pushnil(state);
+		lua_setupvalue(state, -2, 1);
+		lua_rawseti(state, -2, 0);
+	}
+	const lua_Integer count = static_cast<lua_Integer>(lua_rawlen(state, -1));
+	if (count > 0) {
+		lua_rawgeti(state, -1, count);
+		lua_pushnil(state);
+		lua_rawseti(state, -3, count);
+	} else {
+		pushEmptyClosure(state);
+	}
+	lua_remove(state, -2);
+}
+
+/**
+ * @brief returns the index of the _ENV upvalue of the function, 0 if it has none and -1 if it can't be identified
+ * The names of upvalues are missing in stripped bytecode, only the single upvalue of a main chunk is known to be _ENV.
+*/
+int findEnvironment(lua_State* state, int function) {
+	if (!lua_isfunction(state, function) || lua_iscfunction(state, function)) {
+		return 0;
+	}
+	bool named = true;
+	const char* name = nullptr;
+	for (int i = 1; (name = lua_getupvalue(state, function, i)) != nullptr; ++i) {
+		lua_pop(state, 1);
+		if (std::strcmp(name, "_ENV") == 0) {
+			return i;
+		}
+		named = named && std::strcmp(name, "(no name)") != 0;
+	}
+	if (named) {
+		return 0;
+	}
+	lua_Debug info;
+	lua_pushvalue(state, function);
+	lua_getinfo(state, ">S", &info);
+	return std::strcmp(info.what, "main") == 0 ? 1 : -1;
+}
+
+void releaseKeeper(lua_State* state, int keeper) {
+	keeper = lua_absindex(state, keeper);
+	luaL_getsubtable(state, LUA_REGISTRYINDEX, KeepersKey);
+	lua_rawgeti(state, -1, 0);
+	lua_upvaluejoin(state, keeper, 1, -1, 1);
+	lua_pop(state, 1);
+	lua_pushvalue(state, keeper);
+	lua_rawseti(state, -2, static_cast<lua_Integer>(lua_rawlen(state, -2)) + 1);
+	lua_pop(state, 1);
+}
+} // namespace
+
+void Sandbox::share(lua_State* state, const std::vector<std::string>& globals) {
+	pushMetaTable(state);
+	lua_createtable(state, 0, static_cast<int>(globals.size()));
+	for (const std::string& name : globals) {
+		if (lua_getglobal(state, name.c_str()) == LUA_TTABLE) {
+			pushProxy(state, -1);
+			lua_remove(state, -2);
+		}
+		lua_setfield(state, -2, name.c_str());
+	}
+	lua_setfield(state, -2, "__index");
+	lua_pop(state, 1);
+}
+
+Sandbox::Sandbox(lua_State* state) : m_state(state) {
+	pushEmptyClosure(m_state);
+	lua_newtable(m_state);
+	pushMetaTable(m_state);
+	lua_setmetatable(m_state, -2);
+	lua_pushvalue(m_state, -1);
+	m_reference = luaL_ref(m_state, LUA_REGISTRYINDEX);
+	lua_setupvalue(m_state, -2, 1);
+	m_anchor = luaL_ref(m_state, LUA_REGISTRYINDEX);
+}
+
+Sandbox::Sandbox(Sandbox&& mv)
+: m_state(mv.m_state), m_reference(mv.m_reference), m_anchor(mv.m_anchor), m_lastError(std::move(mv.m_lastError))
+{
+	mv.m_state = nullptr;
+	mv.m_reference = LUA_NOREF;
+	mv.m_anchor = LUA_NOREF;
+}
+
+Sandbox::~Sandbox() {
+	if (m_state != nullptr) {
+		luaL_unref(m_state, LUA_REGISTRYINDEX, m_reference);
+		luaL_unref(m_state, LUA_REGISTRYINDEX, m_anchor);
+	}
+}
+
+int Sandbox::call(int numArgs, int numResults) {
+	const int function = lua_absindex(m_state, -(numArgs + 1));
+	const int upvalue = findEnvironment(m_state, function);
+	if (upvalue < 0) {
+		//calling it as it is could reach the globals of the state
+		lua_pop(m_state, numArgs + 1);
+		m_lastError = "can't identify the upvalues of a stripped function";
+		return LUA_ERRRUN;
+	}
+	if (upvalue == 0) {
+		//C functions and functions which don't access globals are called as they are
+		const int status = lua_pcall(m_state, numArgs, numResults, 0);
+		if (status != LUA_OK) {
+			popError();
+		}
+		return status;
+	}
+
+	//the function shares its _ENV upvalue with the closures it creates, so the value of the upvalue isn't changed.
+	//The function is joined to the upvalue of the anchor of the sandbox instead, and a keeper holds on to its own
+	//upvalue to join it back afterwards: keeper, function, function, arguments...
+	pushKeeper(m_state);
+	lua_upvaluejoin(m_state, -1, 1, function, upvalue);
+	lua_insert(m_state, function);
+	lua_rawgeti(m_state, LUA_REGISTRYINDEX, m_anchor);
+	lua_upvaluejoin(m_state, function + 1, upvalue, -1, 1);
+	lua_pop(m_state, 1);
+	lua_pushvalue(m_state, function + 1);
+	lua_insert(m_state, function + 2);
+
+	const int status = lua_pcall(m_state, numArgs, numResults, 0);
+	if (status != LUA_OK) {
+		popError();
+	}
+
+	lua_upvaluejoin(m_state, function + 1, upvalue, function, 1);
+	releaseKeeper(m_state, function);
+	lua_rotate(m_state, function, -2);
+	lua_pop(m_state, 2);
+	return status;
+}
+
+int Sandbox::loadAndExecuteScript(const char* code) {
+	const int status = luaL_loadstring(m_state, code);
+	if (status != LUA_OK) {
+		popError();
+		return status;
+	}
+	return call(0, 0);
+}
+
+void Sandbox::reset() {
+	pushEnvironment();
+	lua_pushnil(m_state);
+	while (lua_next(m_state, -2) != 0) {
+		//assigning nil to existing fields is allowed while traversing
+		lua_pop(m_state, 1);
+		lua_pushvalue(m_state, -1);
+		lua_pushnil(m_state);
+		lua_rawset(m_state, -4);
+	}
+	lua_pop(m_state, 1);
+}
+
+size_t Sandbox::size() const {
+	size_t count = 0;
+	pushEnvironment();
+	lua_pushnil(m_state);
+	while (lua_next(m_state, -2) != 0) {
+		lua_pop(m_state, 1);
+		++count;
+	}
+	lua_pop(m_state, 1);
+	return count;
+}
+
+void Sandbox::pushEnvironment() const {
+	lua_rawgeti(m_state, LUA_REGISTRYINDEX, m_reference);
+}
+
+void Sandbox::pushMetaTable(lua_State* state) {
+	if (luaL_newmetatable(state, MetaTableName) != 0) {
+		lua_newtable(state);
+		lua_setfield(state, -2, "__index");
+		lua_pushboolean(state, 0);
+		lua_setfield(state, -2, "__metatable");
+	}
+}
+
+void Sandbox::pushProxy(lua_State* state, int index) {
+	index = lua_absindex(state, index);
+	if (luaL_getsubtable(state, LUA_REGISTRYINDEX, ProxiesKey) == 0) {
+		//a proxy refers to its table, the cache is an ephemeron table to let both be collected
+		lua_createtable(state, 0, 1);
+		lua_pushliteral(state, "k");
+		lua_setfield(state, -2, "__mode");
+		lua_setmetatable(state, -2);
+	}
+	lua_pushvalue(state, index);
+	if (lua_rawget(state, -2) == LUA_TNIL) {
+		lua_pop(state, 1);
+		lua_newuserdatauv(state, 0, 1);
+		lua_pushvalue(state, index);
+		lua_setiuservalue(state, -2, 1);
+		if (luaL_newmetatable(state, ProxyMetaTableName) != 0) {
+			const luaL_Reg methods[] = {
+				{"__index", &Sandbox::proxyIndex},
+				{"__newindex", &Sandbox::readOnlyError},
+				{"__len", &Sandbox::proxyLen},
+				{"__pairs", &Sandbox::proxyPairs},
+				{nullptr, nullptr}
+			};
+			luaL_setfuncs(state, methods, 0);
+			lua_pushboolean(state, 0);
+			lua_setfield(state, -2, "__metatable");
+		}
+		lua_setmetatable(state, -2);
+		lua_pushvalue(state, index);
+		lua_pushvalue(state, -2);
+		lua_rawset(state, -4);
+	}
+	lua_remove(state, -2);
+}
+
+int Sandbox::readOnlyError(lua_State* state) {
+	return luaL_error(state, "attempt to modify a read-only table");
+}
+
+int Sandbox::proxyIndex(lua_State* state) {
+	lua_getiuservalue(state, 1, 1);
+	lua_pushvalue(state, 2);
+	if (lua_gettable(state, -2) == LUA_TTABLE) {
+		pushProxy(state, -1);
+	}
+	return 1;
+}
+
+int Sandbox::proxyLen(lua_State* state) {
+	lua_getiuservalue(state, 1, 1);
+	lua_len(state, -1);
+	return 1;
+}
+
+int Sandbox::proxyPairs(lua_State* state) {
+	lua_pushcfunction(state, &Sandbox::proxyNext);
+	lua_pushvalue(state, 1);
+	lua_pushnil(state);
+	return 3;
+}
+
+int Sandbox::proxyNext(lua_State* state) {
+	lua_settop(state, 2);
+	lua_getiuservalue(state, 1, 1);
+	lua_pushvalue(state, 2);
+	if (lua_next(state, -2) == 0) {
+		lua_pushnil(state);
+		return 1;
+	}
+	if (lua_type(state, -1) == LUA_TTABLE) {
+		pushProxy(state, -1);
+		lua_replace(state, -2);
+	}
+	return 2;
+}
+
+void Sandbox::popError() {
+	const char* message = lua_tostring(m_state, -1);
+	m_lastError = message != nullptr ? message : "error object is not a string";
+	lua_pop(m_state, 1);
+}
+
+void Sandbox::pushVariable(const char* name) {
+	pushEnvironment();
+	lua_getfield(m_state, -1, name);
+	lua_remove(m_state, -2);
+}
+
+void Sandbox::setVariableFromStack(const char* name) {
+	pushEnvironment();
+	lua_insert(m_state, -2);
+	lua_setfield(m_state, -2, name);
+	lua_pop(m_state, 1);
+}
+
+} // namespace Lua
\ No newline at end of file
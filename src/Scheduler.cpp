@@ -0,0 +1,307 @@
+#include <Scheduler.hpp>
+#include <lua/lua.hpp>
+
+#include <atomic>
+#include <exception>
+
+namespace Lua {
+
+static const char RegistryKey = 0; ///< address used as key of the scheduler in the registry
+
+struct Scheduler::Result {
+	lua_State* thread;
+	bool success;
+	Values values;
+	std::string error;
+};
+
+struct Scheduler::Core {
+	std::mutex mutex;
+	std::condition_variable completed;
+	std::vector<Result> results;
+	std::function<void()> notifier;
+	bool closed = false;
+
+	void post(Result result) {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (closed) {
+				return;
+			}
+			results.push_back(std::move(result));
+			if (notifier) {
+				notifier();
+			}
+		}
+		completed.notify_one();
+	}
+};
+
+struct Scheduler::Completion::Operation {
+	Operation(std::shared_ptr<Core> core, lua_State* thread) : core(std::move(core)), thread(thread) {}
+
+	~Operation() {
+		if (!done.exchange(true)) {
+			core->post({thread, false, {}, "asynchronous operation was abandoned"});
+		}
+	}
+
+	std::shared_ptr<Core> core;
+	lua_State* thread;
+	std::atomic<bool> done{false};
+};
+
+void Scheduler::Completion::resolve(Values results) const {
+	if (m_operation && !m_operation->done.exchange(true)) {
+		m_operation->core->post({m_operation->thread, true, std::move(results), {}});
+	}
+}
+
+void Scheduler::Completion::reject(std::string message) const {
+	if (m_operation && !m_operation->done.exchange(true)) {
+		m_operation->core->post({m_operation->thread, false, {}, std::move(message)});
+	}
+}
+
+bool Scheduler::Completion::isPending() const {
+	return m_operation && !m_operation->done.load();
+}
+
+static void pushValue(lua_State* state, const Generic& value) {
+	switch (value.getType()) {
+		case Type::Boolean: lua_pushboolean(state, value.get<bool>()); break;
+		case Type::Number:
+			if (value.isInteger()) {
+				lua_pushinteger(state, value.get<int64_t>());
+			} else {
+				lua_pushnumber(state, value.get<double>());
+			}
+			break;
+		case Type::String: {
+			const std::string& text = value.get<std::string>();
+			lua_pushlstring(state, text.data(), text.size());
+			break;
+		}
+		case Type::LightUserData: lua_pushlightuserdata(state, value.get<void*>()); break;
+		default: lua_pushnil(state); break;
+	}
+}
+
+Scheduler::Scheduler(lua_State* state) : m_state(state), m_core(std::make_shared<Core>()) {
+	lua_pushlightuserdata(m_state, this);
+	lua_rawsetp(m_state, LUA_REGISTRYINDEX, &RegistryKey);
+}
+
+Scheduler::~Scheduler() {
+	{
+		std::lock_guard<std::mutex> lock(m_core->mutex);
+		m_core->closed = true;
+	}
+	for (const auto& [thread, reference] : m_coroutines) {
+		luaL_unref(m_state, LUA_REGISTRYINDEX, reference);
+	}
+	lua_pushnil(m_state);
+	lua_rawsetp(m_state, LUA_REGISTRYINDEX, &RegistryKey);
+}
+
+int Scheduler::spawn(int numArgs) {
+	lua_State* thread = lua_newthread(m_state);
+	m_coroutines.emplace(thread, luaL_ref(m_state, LUA_REGISTRYINDEX));
+	lua_xmove(m_state, thread, numArgs + 1);
+	return resume(thread, numArgs);
+}
+
+size_t Scheduler::poll() {
+	pollFutures();
+
+	std::vector<Result> results;
+	{
+		std::lock_guard<std::mutex> lock(m_core->mutex);
+		results.swap(m_core->results);
+	}
+	std::vector<lua_State*> ready;
+	ready.swap(m_ready);
+
+	for (Result& result : results) {
+		if (m_coroutines.count(result.thread) == 0) {
+			continue;
+		}
+		//the continuation receives a success flag followed by the results or the error message
+		lua_State* thread = result.thread;
+		lua_checkstack(thread, static_cast<int>(result.values.size()) + 1);
+		lua_pushboolean(thread, result.success);
+		if (result.success) {
+			for (const Generic& value : result.values) {
+				pushValue(thread, value);
+			}
+		} else {
+			lua_pushlstring(thread, result.error.data(), result.error.size());
+		}
+		resume(thread, result.success ? static_cast<int>(result.values.size()) + 1 : 2);
+	}
+	for (lua_State* thread : ready) {
+		if (m_coroutines.count(thread) != 0) {
+			resume(thread, 0);
+		}
+	}
+	return results.size() + ready.size();
+}
+
+bool Scheduler::run(std::chrono::milliseconds timeout) {
+	const auto deadline = std::chrono::steady_clock::now() + timeout;
+	while (true) {
+		poll();
+		if (m_coroutines.empty()) {
+			return true;
+		}
+		if (!m_ready.empty()) {
+			continue;
+		}
+		//futures have no notification, so they are checked in short intervals
+		auto wakeup = deadline;
+		if (!m_futures.empty()) {
+			wakeup = std::min(wakeup, std::chrono::steady_clock::now() + std::chrono::milliseconds(1));
+		}
+		std::unique_lock<std::mutex> lock(m_core->mutex);
+		if (!m_core->completed.wait_until(lock, wakeup, [this]() { return !m_core->results.empty(); })
+			&& std::chrono::steady_clock::now() >= deadline) {
+			return false;
+		}
+	}
+}
+
+void Scheduler::setNotifier(std::function<void()> notifier) {
+	std::lock_guard<std::mutex> lock(m_core->mutex);
+	m_core->notifier = std::move(notifier);
+}
+
+bool Scheduler::hasWork() const {
+	if (!m_ready.empty()) {
+		return true;
+	}
+	std::lock_guard<std::mutex> lock(m_core->mutex);
+	return !m_core->results.empty();
+}
+
+void Scheduler::registerFunction(const char* name, AsyncFunction function) {
+	m_functions.push_back(std::move(function));
+	lua_pushlightuserdata(m_state, this);
+	lua_pushinteger(m_state, static_cast<lua_Integer>(m_functions.size() - 1));
+	lua_pushcclosure(m_state, &Scheduler::dispatch, 2);
+	lua_setglobal(m_state, name);
+}
+
+Scheduler::Completion Scheduler::begin(lua_State* state) {
+	Scheduler* scheduler = checkAwaitable(state);
+	scheduler->m_awaiting = state;
+	return Completion(std::make_shared<Completion::Operation>(scheduler->m_core, state));
+}
+
+int Scheduler::yield(lua_State* state) {
+	return lua_yieldk(state, 0, static_cast<lua_KContext>(lua_gettop(state)), &Scheduler::continuation);
+}
+
+int Scheduler::await(lua_State* state, std::future<Values> future) {
+	{
+		Completion completion = begin(state);
+		fromState(state)->m_futures.push_back({std::move(future), std::move(completion)});
+	}
+	return yield(state);
+}
+
+Scheduler* Scheduler::fromState(lua_State* state) {
+	lua_rawgetp(state, LUA_REGISTRYINDEX, &RegistryKey);
+	Scheduler* scheduler = static_cast<Scheduler*>(lua_touserdata(state, -1));
+	lua_pop(state, 1);
+	return scheduler;
+}
+
+int Scheduler::dispatch(lua_State* state) {
+	Scheduler* scheduler = checkAwaitable(state);
+	{
+		const size_t index = static_cast<size_t>(lua_tointeger(state, lua_upvalueindex(2)));
+		Values arguments;
+		const int top = lua_gettop(state);
+		arguments.reserve(static_cast<size_t>(top));
+		for (int i = 1; i <= top; ++i) {
+			arguments.push_back(Generic::fromStack(i, state));
+		}
+		Completion completion = begin(state);
+		try {
+			scheduler->m_functions[index](std::move(arguments), completion);
+		} catch (const std::exception& e) {
+			completion.reject(e.what());
+		} catch (...) {
+			//no exception may unwind through lua
+			completion.reject("unknown exception");
+		}
+	}
+	return yield(state);
+}
+
+int Scheduler::continuation(lua_State* state, int, lua_KContext base) {
+	const int first = static_cast<int>(base) + 1;
+	if (!lua_toboolean(state, first)) {
+		return lua_error(state); //the message is on top of the stack
+	}
+	return lua_gettop(state) - first;
+}
+
+Scheduler* Scheduler::checkAwaitable(lua_State* state) {
+	Scheduler* scheduler = fromState(state);
+	if (scheduler == nullptr) {
+		luaL_error(state, "asynchronous functions need a scheduler");
+	}
+	if (scheduler->m_coroutines.count(state) == 0 || !lua_isyieldable(state)) {
+		luaL_error(state, "asynchronous functions can only be called from coroutines started by the scheduler");
+	}
+	return scheduler;
+}
+
+int Scheduler::resume(lua_State* thread, int numArgs) {
+	m_awaiting = nullptr;
+	int results = 0;
+	const int status = lua_resume(thread, m_state, numArgs, &results);
+	if (status == LUA_YIELD) {
+		lua_pop(thread, results);
+		if (m_awaiting != thread) {
+			m_ready.push_back(thread);
+		}
+		return status;
+	}
+	if (status != LUA_OK) {
+		const char* message = lua_tostring(thread, -1);
+		m_errorList.emplace_back(message != nullptr ? message : "error object is not a string");
+	}
+	finish(thread);
+	return status;
+}
+
+void Scheduler::finish(lua_State* thread) {
+	auto it = m_coroutines.find(thread);
+	if (it != m_coroutines.end()) {
+		luaL_unref(m_state, LUA_REGISTRYINDEX, it->second);
+		m_coroutines.erase(it);
+	}
+}
+
+void Scheduler::pollFutures() {
+	for (size_t i = 0; i < m_futures.size();) {
+		PendingFuture& pending = m_futures[i];
+		if (pending.future.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+			++i;
+			continue;
+		}
+		try {
+			pending.completion.resolve(pending.future.get());
+		} catch (const std::exception& e) {
+			pending.completion.reject(e.what());
+		} catch (...) {
+			pending.completion.reject("unknown exception");
+		}
+		m_futures[i] = std::move(m_futures.back());
+		m_futures.pop_back();
+	}
+}
+
+} // namespace Lua
\ No newline at end of file
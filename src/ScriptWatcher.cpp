@@ -0,0 +1,327 @@
+#include <ScriptWatcher.hpp>
+#include <lua/lua.hpp>
+
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace Lua {
+
+//versions are unique across all watchers, so a state never mistakes the versions of a destroyed watcher for the
+//ones of a new watcher created at the same address
+static std::atomic<uint64_t> s_nextVersion{1};
+
+ScriptWatcher::ScriptWatcher() : ScriptWatcher(Options()) {}
+
+ScriptWatcher::ScriptWatcher(const Options& options) : m_options(options) {
+#ifdef __linux__
+	if (m_options.useInotify) {
+		m_inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		if (m_inotify >= 0 && pipe2(m_wakeup, O_CLOEXEC | O_NONBLOCK) != 0) {
+			close(m_inotify);
+			m_inotify = -1;
+		}
+	}
+#endif
+}
+
+ScriptWatcher::~ScriptWatcher() {
+	stop();
+#ifdef __linux__
+	if (m_inotify >= 0) {
+		close(m_inotify);
+		close(m_wakeup[0]);
+		close(m_wakeup[1]);
+	}
+#endif
+}
+
+Registry::ErrorCode ScriptWatcher::watch(const std::string& key, const std::filesystem::path& path) {
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		Script& script = m_scripts[key];
+		script.path = path;
+		std::error_code error;
+		script.absolutePath = std::filesystem::absolute(path, error).lexically_normal();
+		script.chunkName = "@" + path.string();
+		script.modified = {};
+		script.fileSize = 0;
+	}
+	watchDirectory(path);
+
+	std::lock_guard<std::mutex> lock(m_compileMutex);
+	return compileScript(key);
+}
+
+void ScriptWatcher::unwatch(const std::string& key) {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_scripts.erase(key);
+}
+
+void ScriptWatcher::start() {
+	if (m_thread.joinable()) {
+		return;
+	}
+	m_stopRequested = false;
+	m_thread = std::thread(&ScriptWatcher::run, this);
+}
+
+void ScriptWatcher::stop() {
+	if (!m_thread.joinable()) {
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stopRequested = true;
+	}
+	m_stopCondition.notify_all();
+#ifdef __linux__
+	if (m_inotify >= 0) {
+		const char signal = 1;
+		[[maybe_unused]] ssize_t written = write(m_wakeup[1], &signal, 1);
+	}
+#endif
+	m_thread.join();
+#ifdef __linux__
+	if (m_inotify >= 0) {
+		char signal;
+		while (read(m_wakeup[0], &signal, 1) > 0) {}
+	}
+#endif
+}
+
+size_t ScriptWatcher::check() {
+	return compileChanged({});
+}
+
+size_t ScriptWatcher::compileChanged(const std::set<std::filesystem::path>& touched) {
+	std::lock_guard<std::mutex> compileLock(m_compileMutex);
+
+	std::vector<std::string> changed;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		for (const auto& [key, script] : m_scripts) {
+			std::error_code error;
+			const auto modified = std::filesystem::last_write_time(script.path, error);
+			if (error) {
+				continue; //the file may be replaced right now, the next event or poll will pick it up
+			}
+			const auto size = std::filesystem::file_size(script.path, error);
+			//the modification time has the granularity of the kernel clock, files reported by inotify are always compiled
+			if (!error && (modified != script.modified || size != script.fileSize || touched.count(script.absolutePath) != 0)) {
+				changed.push_back(key);
+			}
+		}
+	}
+
+	size_t compiled = 0;
+	for (const std::string& key : changed) {
+		if (compileScript(key) == Registry::ErrorCode::Ok) {
+			++compiled;
+		}
+	}
+	return compiled;
+}
+
+size_t ScriptWatcher::apply(lua_State* state) {
+	const uint64_t version = getVersion();
+
+	//the versions installed in this state are kept in a table of its registry: [0] holds the version of the watcher
+	//the state was last updated to, the script keys hold the versions of the individual scripts
+	lua_rawgetp(state, LUA_REGISTRYINDEX, this);
+	if (!lua_istable(state, -1)) {
+		lua_pop(state, 1);
+		lua_createtable(state, 0, 4);
+		lua_pushvalue(state, -1);
+		lua_rawsetp(state, LUA_REGISTRYINDEX, this);
+	}
+	lua_rawgeti(state, -1, 0);
+	const uint64_t applied = static_cast<uint64_t>(lua_tointeger(state, -1));
+	lua_pop(state, 1);
+	if (applied == version) {
+		lua_pop(state, 1);
+		return 0;
+	}
+
+	struct Update {
+		std::string key;
+		std::string chunkName;
+		std::shared_ptr<const std::string> bytecode;
+		uint64_t version;
+	};
+	std::vector<Update> updates;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		updates.reserve(m_scripts.size());
+		for (const auto& [key, script] : m_scripts) {
+			if (script.bytecode) {
+				updates.push_back({key, script.chunkName, script.bytecode, script.version});
+			}
+		}
+	}
+
+	Registry registry(state);
+	size_t replaced = 0;
+	bool failed = false;
+	for (const Update& update : updates) {
+		lua_getfield(state, -1, update.key.c_str());
+		const uint64_t installed = static_cast<uint64_t>(lua_tointeger(state, -1));
+		lua_pop(state, 1);
+		if (installed >= update.version) {
+			continue;
+		}
+		if (registry.loadBytecode(update.key.c_str(), *update.bytecode, update.chunkName.c_str()) == Registry::ErrorCode::Ok) {
+			lua_pushinteger(state, static_cast<lua_Integer>(update.version));
+			lua_setfield(state, -2, update.key.c_str());
+			++replaced;
+		} else {
+			const char* message = lua_tostring(state, -1);
+			std::string error = message != nullptr ? message : "unknown error";
+			lua_pop(state, 1);
+			std::lock_guard<std::mutex> lock(m_mutex);
+			auto it = m_scripts.find(update.key);
+			if (it != m_scripts.end()) {
+				it->second.error = std::move(error);
+			}
+			failed = true;
+		}
+	}
+
+	//the version isn't marked as applied if a script failed to load, so the next call tries again
+	if (!failed) {
+		lua_pushinteger(state, static_cast<lua_Integer>(version));
+		lua_rawseti(state, -2, 0);
+	}
+	lua_pop(state, 1);
+	return replaced;
+}
+
+std::string ScriptWatcher::getError(const std::string& key) const {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	auto it = m_scripts.find(key);
+	return it != m_scripts.end() ? it->second.error : std::string();
+}
+
+Registry::ErrorCode ScriptWatcher::compileScript(const std::string& key) {
+	std::filesystem::path path;
+	std::string chunkName;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		auto it = m_scripts.find(key);
+		if (it == m_scripts.end()) {
+			return Registry::ErrorCode::RuntimeError;
+		}
+		path = it->second.path;
+		chunkName = it->second.chunkName;
+	}
+
+	//the time is taken before reading, so a write in progress results in another compilation once it is finished
+	std::error_code fileError;
+	const auto modified = std::filesystem::last_write_time(path, fileError);
+	const auto size = std::filesystem::file_size(path, fileError);
+	std::ifstream file(path, std::ios::binary);
+
+	Registry::ErrorCode res = Registry::ErrorCode::RuntimeError;
+	std::string bytecode;
+	std::string error;
+	if (fileError || !file) {
+		error = "cannot open " + path.string();
+	} else {
+		const std::string src((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+		res = Registry::compile(src, chunkName.c_str(), bytecode, error);
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	auto it = m_scripts.find(key);
+	if (it == m_scripts.end() || it->second.path != path) {
+		return res; //unwatched or rebound while compiling
+	}
+	Script& script = it->second;
+	if (!fileError) {
+		script.modified = modified;
+		script.fileSize = size;
+	}
+	if (res == Registry::ErrorCode::Ok) {
+		script.bytecode = std::make_shared<const std::string>(std::move(bytecode));
+		script.version = s_nextVersion.fetch_add(1, std::memory_order_relaxed);
+		m_version.store(script.version, std::memory_order_release);
+		script.error.clear();
+	} else {
+		script.error = std::move(error);
+	}
+	return res;
+}
+
+void ScriptWatcher::watchDirectory(const std::filesystem::path& path) {
+#ifdef __linux__
+	if (m_inotify < 0) {
+		return;
+	}
+	std::error_code error;
+	const std::filesystem::path directory = std::filesystem::absolute(path, error).lexically_normal().parent_path();
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if (error) {
+		return;
+	}
+	for (const auto& watched : m_directories) {
+		if (watched.second == directory) {
+			return;
+		}
+	}
+	//the directory is watched instead of the file, so files replaced by a rename (as most editors do) are noticed
+	const int descriptor = inotify_add_watch(m_inotify, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_ATTRIB);
+	if (descriptor >= 0) {
+		m_directories.emplace(descriptor, directory);
+	}
+#else
+	(void)path;
+#endif
+}
+
+void ScriptWatcher::run() {
+	while (true) {
+#ifdef __linux__
+		if (m_inotify >= 0) {
+			pollfd fds[2] = {{m_inotify, POLLIN, 0}, {m_wakeup[0], POLLIN, 0}};
+			if (poll(fds, 2, -1) < 0) {
+				continue;
+			}
+			if (fds[1].revents != 0) {
+				return;
+			}
+			alignas(inotify_event) char events[4096];
+			std::set<std::filesystem::path> touched;
+			ssize_t length;
+			while ((length = read(m_inotify, events, sizeof(events))) > 0) {
+				std::lock_guard<std::mutex> lock(m_mutex);
+				for (ssize_t offset = 0; offset < length;) {
+					const auto* event = reinterpret_cast<const inotify_event*>(events + offset);
+					auto directory = m_directories.find(event->wd);
+					if (event->len > 0 && directory != m_directories.end()) {
+						touched.insert(directory->second / event->name);
+					}
+					offset += sizeof(inotify_event) + event->len;
+				}
+			}
+			compileChanged(touched);
+			continue;
+		}
+#endif
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			if (m_stopCondition.wait_for(lock, m_options.pollInterval, [this]() { return m_stopRequested; })) {
+				return;
+			}
+		}
+		check();
+	}
+}
+
+} // namespace Lua
\ No newline at end of file
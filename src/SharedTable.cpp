@@ -0,0 +1,501 @@
+#include <SharedTable.hpp>
+#include <lua/lua.hpp>
+
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+
+constexpr const char* const MetaTableName = "luacpp.SharedTable";
+
+uint64_t mix(uint64_t x) {
+	//finalizer of splitmix64
+	x ^= x >> 30;
+	x *= 0xBF58476D1CE4E5B9ull;
+	x ^= x >> 27;
+	x *= 0x94D049BB133111EBull;
+	x ^= x >> 31;
+	return x;
+}
+
+uint64_t hashBytes(const char* data, size_t len) {
+	uint64_t h = 0x9E3779B97F4A7C15ull ^ len;
+	while (len >= 8) {
+		uint64_t block;
+		std::memcpy(&block, data, 8);
+		h = mix(h ^ block);
+		data += 8;
+		len -= 8;
+	}
+	uint64_t tail = 0;
+	std::memcpy(&tail, data, len);
+	return mix(h ^ tail);
+}
+
+uint64_t doubleBits(double value) {
+	uint64_t bits;
+	std::memcpy(&bits, &value, sizeof(bits));
+	return bits;
+}
+
+/**
+ * @brief converts a float to an integer if it has an exact integer representation (like lua does for table keys)
+*/
+bool floatToInteger(double value, int64_t& result) {
+	if (std::floor(value) != value || value < -9223372036854775808.0 || value >= 9223372036854775808.0) {
+		return false;
+	}
+	result = static_cast<int64_t>(value);
+	return true;
+}
+
+} // namespace
+
+namespace Lua {
+
+SharedTable::Builder& SharedTable::Builder::reserve(size_t numEntries) {
+	m_items.reserve(numEntries);
+	return *this;
+}
+
+SharedTable::Builder& SharedTable::Builder::set(const Generic& key, const Generic& value) {
+	Key k;
+	std::string storage;
+	if (!toKey(key, k, storage)) {
+		throw std::invalid_argument("invalid key for a shared table");
+	}
+	if (value.getType() == Type::LightUserData) {
+		throw std::invalid_argument("light userdata can't be stored in a shared table");
+	}
+	m_items.push_back(Item{key, value, nullptr});
+	return *this;
+}
+
+SharedTable::Builder& SharedTable::Builder::set(const Generic& key, std::shared_ptr<const SharedTable> table) {
+	Key k;
+	std::string storage;
+	if (!toKey(key, k, storage)) {
+		throw std::invalid_argument("invalid key for a shared table");
+	}
+	m_items.push_back(Item{key, Generic(), std::move(table)});
+	return *this;
+}
+
+std::shared_ptr<const SharedTable> SharedTable::Builder::build() {
+	std::shared_ptr<SharedTable> table(new SharedTable());
+	std::vector<Entry> entries;
+	entries.reserve(m_items.size());
+
+	std::string storage;
+	for (const Item& item : m_items) {
+		Entry entry{};
+		Key key;
+		toKey(item.key, key, storage);
+		entry.key.kind = key.kind;
+		if (key.kind == Kind::String) {
+			entry.key.payload = table->m_strings.size();
+			entry.key.length = static_cast<uint32_t>(key.str.size());
+			table->m_strings.append(key.str);
+		} else {
+			entry.key.payload = key.payload;
+		}
+
+		if (item.table) {
+			entry.value.kind = Kind::Table;
+			entry.value.payload = table->m_tables.size();
+			table->m_tables.push_back(item.table);
+		} else {
+			switch (item.value.getType()) {
+				case Type::Boolean:
+					entry.value.kind = Kind::Boolean;
+					entry.value.payload = item.value.get<bool>() ? 1 : 0;
+					break;
+				case Type::Number:
+					if (item.value.isInteger()) {
+						entry.value.kind = Kind::Integer;
+						entry.value.payload = static_cast<uint64_t>(item.value.get<int64_t>());
+					} else {
+						entry.value.kind = Kind::Number;
+						entry.value.payload = doubleBits(item.value.get<double>());
+					}
+					break;
+				case Type::String: {
+					const std::string str = item.value.get<std::string>();
+					entry.value.kind = Kind::String;
+					entry.value.payload = table->m_strings.size();
+					entry.value.length = static_cast<uint32_t>(str.size());
+					table->m_strings.append(str);
+					break;
+				}
+				default:
+					entry.value.kind = Kind::Nil;
+					break;
+			}
+		}
+		entries.push_back(entry);
+	}
+	m_items.clear();
+
+	//remove duplicates (the last assignment wins) and nil values
+	table->m_entries.reserve(entries.size());
+	for (auto it = entries.rbegin(); it != entries.rend(); ++it) {
+		table->m_entries.push_back(*it);
+	}
+	table->buildIndex(); //keeps the first occurrence of each key, which is the last assignment
+	std::vector<bool> keep(entries.size(), false);
+	for (uint64_t slot : table->m_index) {
+		if (slot != 0) {
+			keep[static_cast<uint32_t>(slot) - 1] = true;
+		}
+	}
+	std::vector<Entry> unique;
+	unique.reserve(entries.size());
+	for (size_t i = table->m_entries.size(); i-- > 0;) {
+		if (keep[i] && table->m_entries[i].value.kind != Kind::Nil) {
+			unique.push_back(table->m_entries[i]);
+		}
+	}
+	table->m_entries.swap(unique);
+	table->buildIndex();
+
+	//move the sequence part to the front, so it can be indexed directly
+	size_t length = 0;
+	while (table->find(Key{Kind::Integer, static_cast<uint64_t>(length + 1), std::string_view()}) != NotFound) {
+		++length;
+	}
+	if (length > 0) {
+		std::vector<Entry> ordered(length);
+		ordered.reserve(table->m_entries.size());
+		for (const Entry& entry : table->m_entries) {
+			const int64_t key = static_cast<int64_t>(entry.key.payload);
+			if (entry.key.kind == Kind::Integer && key >= 1 && static_cast<size_t>(key) <= length) {
+				ordered[static_cast<size_t>(key) - 1] = entry;
+			} else {
+				ordered.push_back(entry);
+			}
+		}
+		table->m_entries.swap(ordered);
+		table->m_length = length;
+		table->buildIndex();
+	}
+	table->m_entries.shrink_to_fit();
+	table->m_strings.shrink_to_fit();
+	return table;
+}
+
+bool SharedTable::contains(const Generic& key) const {
+	Key k;
+	std::string storage;
+	return toKey(key, k, storage) && find(k) != NotFound;
+}
+
+Generic SharedTable::get(const Generic& key) const {
+	Key k;
+	std::string storage;
+	if (!toKey(key, k, storage)) {
+		return Generic();
+	}
+	const uint32_t idx = find(k);
+	return idx == NotFound ? Generic() : toGeneric(m_entries[idx].value);
+}
+
+std::shared_ptr<const SharedTable> SharedTable::getTable(const Generic& key) const {
+	Key k;
+	std::string storage;
+	if (!toKey(key, k, storage)) {
+		return nullptr;
+	}
+	const uint32_t idx = find(k);
+	if (idx == NotFound || m_entries[idx].value.kind != Kind::Table) {
+		return nullptr;
+	}
+	return m_tables[m_entries[idx].value.payload];
+}
+
+size_t SharedTable::getMemoryUsage() const {
+	return sizeof(SharedTable)
+		+ m_entries.capacity() * sizeof(Entry)
+		+ m_index.capacity() * sizeof(uint64_t)
+		+ m_strings.capacity()
+		+ m_tables.capacity() * sizeof(std::shared_ptr<const SharedTable>);
+}
+
+void SharedTable::push(lua_State* state, std::shared_ptr<const SharedTable> table) {
+	void* userData = lua_newuserdatauv(state, sizeof(std::shared_ptr<const SharedTable>), 0);
+	new (userData) std::shared_ptr<const SharedTable>(std::move(table));
+	pushMetaTable(state);
+	lua_setmetatable(state, -2);
+}
+
+std::shared_ptr<const SharedTable> SharedTable::fromStack(lua_State* state, int index) {
+	void* userData = luaL_testudata(state, index, MetaTableName);
+	if (userData == nullptr) {
+		return nullptr;
+	}
+	return *static_cast<std::shared_ptr<const SharedTable>*>(userData);
+}
+
+bool SharedTable::toKey(const Generic& key, Key& result, std::string& storage) {
+	result.str = std::string_view();
+	switch (key.getType()) {
+		case Type::Boolean:
+			result.kind = Kind::Boolean;
+			result.payload = key.get<bool>() ? 1 : 0;
+			return true;
+		case Type::Number: {
+			if (key.isInteger()) {
+				result.kind = Kind::Integer;
+				result.payload = static_cast<uint64_t>(key.get<int64_t>());
+				return true;
+			}
+			const double value = key.get<double>();
+			if (std::isnan(value)) {
+				return false;
+			}
+			int64_t integer;
+			if (floatToInteger(value, integer)) {
+				result.kind = Kind::Integer;
+				result.payload = static_cast<uint64_t>(integer);
+			} else {
+				result.kind = Kind::Number;
+				result.payload = doubleBits(value);
+			}
+			return true;
+		}
+		case Type::String:
+			storage = key.get<std::string>();
+			result.kind = Kind::String;
+			result.payload = 0;
+			result.str = storage;
+			return true;
+		default:
+			return false;
+	}
+}
+
+uint64_t SharedTable::hash(const Key& key) {
+	switch (key.kind) {
+		case Kind::String: return hashBytes(key.str.data(), key.str.size());
+		case Kind::Number: return mix(key.payload ^ 0x5555555555555555ull);
+		case Kind::Boolean: return mix(key.payload + 0xAAAAAAAAAAAAAAAAull);
+		default: return mix(key.payload);
+	}
+}
+
+uint32_t SharedTable::find(const Key& key) const {
+	//the sequence part is stored in order, so there is no need to hash
+	if (key.kind == Kind::Integer && key.payload - 1 < m_length) {
+		return static_cast<uint32_t>(key.payload - 1);
+	}
+	if (m_index.empty()) {
+		return NotFound;
+	}
+
+	const uint64_t h = hash(key);
+	const uint64_t tag = h >> 32;
+	for (uint64_t pos = h & m_mask;; pos = (pos + 1) & m_mask) {
+		const uint64_t slot = m_index[pos];
+		if (slot == 0) {
+			return NotFound;
+		}
+		if ((slot >> 32) == tag) {
+			const uint32_t idx = static_cast<uint32_t>(slot) - 1;
+			if (equals(m_entries[idx], key)) {
+				return idx;
+			}
+		}
+	}
+}
+
+bool SharedTable::equals(const Entry& entry, const Key& key) const {
+	if (entry.key.kind != key.kind) {
+		return false;
+	}
+	if (key.kind == Kind::String) {
+		return entry.key.length == key.str.size() && std::memcmp(m_strings.data() + entry.key.payload, key.str.data(), key.str.size()) == 0;
+	}
+	return entry.key.payload == key.payload;
+}
+
+std::string_view SharedTable::getString(const Cell& cell) const {
+	return std::string_view(m_strings.data() + cell.payload, cell.length);
+}
+
+Generic SharedTable::toGeneric(const Cell& cell) const {
+	switch (cell.kind) {
+		case Kind::Boolean: return Generic(cell.payload != 0);
+		case Kind::Integer: return Generic(static_cast<int64_t>(cell.payload));
+		case Kind::Number: {
+			double value;
+			std::memcpy(&value, &cell.payload, sizeof(value));
+			return Generic(value);
+		}
+		case Kind::String: return Generic(std::string(getString(cell)));
+		case Kind::Nil:
+		case Kind::Table:
+			break;
+	}
+	return Generic();
+}
+
+void SharedTable::pushCell(lua_State* state, const Cell& cell) const {
+	switch (cell.kind) {
+		case Kind::Nil: lua_pushnil(state); break;
+		case Kind::Boolean: lua_pushboolean(state, cell.payload != 0); break;
+		case Kind::Integer: lua_pushinteger(state, static_cast<lua_Integer>(cell.payload)); break;
+		case Kind::Number: {
+			double value;
+			std::memcpy(&value, &cell.payload, sizeof(value));
+			lua_pushnumber(state, value);
+			break;
+		}
+		case Kind::String: lua_pushlstring(state, m_strings.data() + cell.payload, cell.length); break;
+		case Kind::Table: push(state, m_tables[cell.payload]); break;
+	}
+}
+
+void SharedTable::buildIndex() {
+	//the sequence part is accessed directly and doesn't need to be indexed
+	const size_t first = m_length;
+
+	//keep the load factor below 0.5
+	uint64_t capacity = 8;
+	while (capacity < (m_entries.size() - first) * 2) {
+		capacity <<= 1;
+	}
+	m_index.assign(capacity, 0);
+	m_mask = capacity - 1;
+
+	for (size_t i = first; i < m_entries.size(); ++i) {
+		const Entry& entry = m_entries[i];
+		const Key key{entry.key.kind, entry.key.payload, entry.key.kind == Kind::String ? getString(entry.key) : std::string_view()};
+		if (find(key) != NotFound) {
+			continue; //duplicate, the first entry wins
+		}
+		const uint64_t h = hash(key);
+		uint64_t pos = h & m_mask;
+		while (m_index[pos] != 0) {
+			pos = (pos + 1) & m_mask;
+		}
+		m_index[pos] = ((h >> 32) << 32) | (static_cast<uint64_t>(i) + 1);
+	}
+}
+
+SharedTable::Key SharedTable::keyFromStack(lua_State* state, int index, bool& valid) {
+	Key key{Kind::Nil, 0, std::string_view()};
+	valid = true;
+	switch (lua_type(state, index)) {
+		case LUA_TNUMBER: {
+			if (lua_isinteger(state, index)) {
+				key.kind = Kind::Integer;
+				key.payload = static_cast<uint64_t>(lua_tointeger(state, index));
+				break;
+			}
+			const double value = lua_tonumber(state, index);
+			int64_t integer;
+			if (floatToInteger(value, integer)) {
+				key.kind = Kind::Integer;
+				key.payload = static_cast<uint64_t>(integer);
+			} else {
+				key.kind = Kind::Number;
+				key.payload = doubleBits(value);
+			}
+			break;
+		}
+		case LUA_TSTRING: {
+			size_t len;
+			const char* str = lua_tolstring(state, index, &len);
+			key.kind = Kind::String;
+			key.str = std::string_view(str, len);
+			break;
+		}
+		case LUA_TBOOLEAN:
+			key.kind = Kind::Boolean;
+			key.payload = lua_toboolean(state, index) ? 1 : 0;
+			break;
+		default:
+			valid = false;
+			break;
+	}
+	return key;
+}
+
+const SharedTable* SharedTable::checkTable(lua_State* state, int index) {
+	return static_cast<std::shared_ptr<const SharedTable>*>(luaL_checkudata(state, index, MetaTableName))->get();
+}
+
+void SharedTable::pushMetaTable(lua_State* state) {
+	if (luaL_newmetatable(state, MetaTableName) == 0) {
+		return; //already registered in this state
+	}
+	const luaL_Reg functions[] = {
+		{"__index", index},
+		{"__len", len},
+		{"__pairs", pairs},
+		{"__newindex", newIndex},
+		{"__gc", gc},
+		{nullptr, nullptr}
+	};
+	luaL_setfuncs(state, functions, 0);
+}
+
+int SharedTable::index(lua_State* state) {
+	const SharedTable* table = checkTable(state, 1);
+	bool valid;
+	const Key key = keyFromStack(state, 2, valid);
+	const uint32_t idx = valid ? table->find(key) : NotFound;
+	if (idx == NotFound) {
+		lua_pushnil(state);
+	} else {
+		table->pushCell(state, table->m_entries[idx].value);
+	}
+	return 1;
+}
+
+int SharedTable::len(lua_State* state) {
+	const SharedTable* table = checkTable(state, 1);
+	lua_pushinteger(state, static_cast<lua_Integer>(table->m_length));
+	return 1;
+}
+
+int SharedTable::next(lua_State* state) {
+	const SharedTable* table = checkTable(state, 1);
+	size_t idx = 0;
+	if (!lua_isnoneornil(state, 2)) {
+		bool valid;
+		const Key key = keyFromStack(state, 2, valid);
+		const uint32_t found = valid ? table->find(key) : NotFound;
+		if (found == NotFound) {
+			return luaL_error(state, "invalid key to 'next'");
+		}
+		idx = static_cast<size_t>(found) + 1;
+	}
+	if (idx >= table->m_entries.size()) {
+		lua_pushnil(state);
+		return 1;
+	}
+	table->pushCell(state, table->m_entries[idx].key);
+	table->pushCell(state, table->m_entries[idx].value);
+	return 2;
+}
+
+int SharedTable::pairs(lua_State* state) {
+	checkTable(state, 1);
+	lua_pushcfunction(state, next);
+	lua_pushvalue(state, 1);
+	lua_pushnil(state);
+	return 3;
+}
+
+int SharedTable::newIndex(lua_State* state) {
+	return luaL_error(state, "attempt to modify a read-only shared table");
+}
+
+int SharedTable::gc(lua_State* state) {
+	using Pointer = std::shared_ptr<const SharedTable>;
+	static_cast<Pointer*>(luaL_checkudata(state, 1, MetaTableName))->~Pointer();
+	return 0;
+}
+
+} // namespace Lua
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include <string>
 #include <array>
 #include <limits> //std::numeric_limits
+#include <utility> //std::move, std::pair
 
 namespace {
 struct LibraryLoadingFunction {
@@ -11,23 +12,147 @@ struct LibraryLoadingFunction {
 	const char* name;
 	int (*func)(lua_State*);
 };
+
+constexpr const char* const LazyLibrariesKey = "luacpp.LazyLibraries"; ///< registry key of the __index function opening libraries
+
+/**
+ * @brief __index of _G and package.loaded while libraries are loaded lazily
+ * upvalue 1: names of the globals opening a library -> name of the library
+ * upvalue 2: name of a library -> function opening it
+*/
+int openLazyLibrary(lua_State* L) {
+	if (lua_type(L, 2) != LUA_TSTRING) {
+		return 0;
+	}
+	lua_pushvalue(L, 2);
+	if (lua_rawget(L, lua_upvalueindex(1)) != LUA_TSTRING) {
+		return 0;
+	}
+	const int library = lua_gettop(L);
+	lua_pushvalue(L, library);
+	lua_rawget(L, lua_upvalueindex(2));
+	lua_CFunction open = lua_tocfunction(L, -1);
+	lua_pop(L, 1);
+
+	//forget the library before opening it, luaL_requiref looks it up in package.loaded
+	lua_pushnil(L);
+	while (lua_next(L, lua_upvalueindex(1)) != 0) {
+		if (lua_rawequal(L, -1, library) != 0) {
+			lua_pushvalue(L, -2);
+			lua_pushnil(L);
+			lua_rawset(L, lua_upvalueindex(1));
+		}
+		lua_pop(L, 1);
+	}
+	lua_pushvalue(L, library);
+	lua_pushnil(L);
+	lua_rawset(L, lua_upvalueindex(2));
+
+	luaL_requiref(L, lua_tostring(L, library), open, 1);
+	lua_pushvalue(L, 2);
+	lua_rawget(L, 1);
+	return 1;
+}
+
+/**
+ * @brief opens the string library which replaces the placeholder metatable of strings
+*/
+void openLazyString(lua_State* L) {
+	if (lua_getglobal(L, LUA_STRLIBNAME) != LUA_TTABLE) {
+		luaL_error(L, "the string library is not available");
+	}
+}
+
+int indexLazyString(lua_State* L) {
+	openLazyString(L);
+	lua_pushvalue(L, 2);
+	lua_gettable(L, -2);
+	return 1;
+}
+
+int arithLazyString(lua_State* L) {
+	openLazyString(L);
+	const int operation = static_cast<int>(lua_tointeger(L, lua_upvalueindex(1)));
+	lua_settop(L, operation == LUA_OPUNM ? 1 : 2);
+	lua_arith(L, operation);
+	return 1;
+}
+
+/**
+ * @brief placeholder metatable of strings until the string library is opened
+ * Method calls (s:upper()) and the arithmetic on strings, which the string library implements by metamethods, open it.
+*/
+void setLazyStringMetaTable(lua_State* L) {
+	static const std::array<std::pair<const char*, int>, 8> operations = {
+		std::pair<const char*, int>{"__add", LUA_OPADD}, {"__sub", LUA_OPSUB}, {"__mul", LUA_OPMUL}, {"__mod", LUA_OPMOD},
+		{"__pow", LUA_OPPOW}, {"__div", LUA_OPDIV}, {"__idiv", LUA_OPIDIV}, {"__unm", LUA_OPUNM}
+	};
+	lua_pushliteral(L, "");
+	if (lua_getmetatable(L, -1) != 0) {
+		lua_pop(L, 2);
+		return;
+	}
+	lua_createtable(L, 0, static_cast<int>(operations.size()) + 1);
+	lua_pushcfunction(L, indexLazyString);
+	lua_setfield(L, -2, "__index");
+	for (const auto& [event, operation] : operations) {
+		lua_pushinteger(L, operation);
+		lua_pushcclosure(L, arithLazyString, 1);
+		lua_setfield(L, -2, event);
+	}
+	lua_setmetatable(L, -2);
+	lua_pop(L, 1);
+}
+
+/**
+ * @brief pushes the function opening lazy libraries, it is created and set as __index of _G and package.loaded once
+ * @return false if _G or package.loaded already have a metatable (nothing is pushed then)
+*/
+bool pushLazyLibraryLoader(lua_State* L) {
+	if (lua_getfield(L, LUA_REGISTRYINDEX, LazyLibrariesKey) == LUA_TFUNCTION) {
+		return true;
+	}
+	lua_pop(L, 1);
+	lua_pushglobaltable(L);
+	luaL_getsubtable(L, LUA_REGISTRYINDEX, LUA_LOADED_TABLE);
+	if (lua_getmetatable(L, -1) != 0 || lua_getmetatable(L, -2) != 0) {
+		lua_pop(L, 3);
+		return false;
+	}
+	lua_newtable(L);
+	lua_newtable(L);
+	lua_pushcclosure(L, openLazyLibrary, 2);
+	for (int table = -3; table <= -2; ++table) {
+		lua_createtable(L, 0, 1);
+		lua_pushvalue(L, -2);
+		lua_setfield(L, -2, "__index");
+		lua_setmetatable(L, table - 1);
+	}
+	lua_pushvalue(L, -1);
+	lua_setfield(L, LUA_REGISTRYINDEX, LazyLibrariesKey);
+	lua_replace(L, -3);
+	lua_pop(L, 1);
+	return true;
+}
 } // namespace
 
 namespace Lua {
 
 std::map<lua_State*, State::DebugHook> State::s_debugHooks;
 
-State::State(Library libraries) 
+State::State(Library libraries, LibraryLoading loading) 
 : m_state(luaL_newstate()),
   m_registry(m_state),
+  m_gc(m_state),
   m_externalState(false)
 { 
-	openLibrary(libraries);
+	openLibrary(libraries, loading);
 }
 
 State::State(lua_State* state)
 : m_state(state),
   m_registry(state),
+  m_gc(state),
   m_externalState(true)
 {
 }
@@ -35,8 +160,10 @@ State::State(lua_State* state)
 State::State(State&& mv)
 : m_state(mv.m_state),
   m_registry(m_state),
+  m_gc(mv.m_gc),
   m_externalState(mv.m_externalState),
-  m_errorList(std::move(mv.m_errorList))
+  m_errorList(std::move(mv.m_errorList)),
+  m_metrics(std::move(mv.m_metrics))
 {
 	mv.m_state = nullptr;
 	mv.m_externalState = true;
@@ -52,7 +179,7 @@ State::~State() {
 	}
 }
 
-void State::openLibrary(Library library) {
+void State::openLibrary(Library library, LibraryLoading loading) {
 	static const std::array<LibraryLoadingFunction, LibraryCount> libraries = {
 		LibraryLoadingFunction{LibBase, LUA_GNAME, luaopen_base},
 		LibraryLoadingFunction{LibPackage, LUA_LOADLIBNAME, luaopen_package},
@@ -66,6 +193,36 @@ void State::openLibrary(Library library) {
 		LibraryLoadingFunction{LibDebug, LUA_DBLIBNAME, luaopen_debug}	
 	};
 
+	if (loading == LibraryLoading::Lazy && (library & ~LibBase) != 0) {
+		StackCheck check(m_state, 0, __func__);
+		if (library & LibBase) {
+			luaL_requiref(m_state, LUA_GNAME, luaopen_base, 1);
+			lua_pop(m_state, 1);
+		}
+		if (pushLazyLibraryLoader(m_state)) {
+			lua_getupvalue(m_state, -1, 1); //globals opening a library
+			lua_getupvalue(m_state, -2, 2); //functions opening the libraries
+			for (const auto& lib : libraries) {
+				if ((library & lib.mask) && lib.mask != LibBase) {
+					lua_pushcfunction(m_state, lib.func);
+					lua_setfield(m_state, -2, lib.name);
+					lua_pushstring(m_state, lib.name);
+					lua_setfield(m_state, -3, lib.name);
+				}
+			}
+			if (library & LibPackage) {
+				lua_pushstring(m_state, LUA_LOADLIBNAME);
+				lua_setfield(m_state, -3, "require");
+			}
+			lua_pop(m_state, 3);
+			if (library & LibString) {
+				setLazyStringMetaTable(m_state);
+			}
+			return;
+		}
+		//_G or package.loaded have a metatable of their own, the libraries are opened right away
+	}
+
 	if (library == LibAll) {
 		luaL_openlibs(m_state);
 		return;
@@ -80,13 +237,14 @@ void State::openLibrary(Library library) {
 }
 
 int State::registerNativeFunction(const char* name, NativeFunction func, int numUpValues) {
+	StackCheck check(m_state, -numUpValues, __func__);
 	lua_pushcclosure(m_state, func, numUpValues);
 	lua_setglobal(m_state, name);
 	return 0;
 }
 
 int State::registerMethod(const char* name, Method method) {
-	m_callbacks.push_back(method);
+	m_callbacks.push_back(std::move(method));
 	return registerNativeFunctionWithUpvalues(name, dispatchMethod, m_callbacks.size() - 1, this);
 }
 
@@ -106,6 +264,7 @@ void State::registerDebugHook(DebugHook hook, int mask, int count) {
 }
 
 int State::overrideLuaFunction(const char* name, NativeFunction func) {
+	StackCheck check(m_state, 0, __func__);
 	lua_getglobal(m_state, GlobalScope); //load global scope to stack
 	lua_pushcclosure(m_state, func, 0); //push function to stack
     lua_setfield(m_state, -2, name); //register the function under the given name
@@ -114,18 +273,32 @@ int State::overrideLuaFunction(const char* name, NativeFunction func) {
 }
 
 int State::loadAndExecuteScript(const char* code) {
-	int status = luaL_dostring(m_state, code);
-	if (status != LUA_OK) {
-		//lua failed to load the script and push an error message on the stack
-		//we store the message in our error log and clean up the stack
-		while (lua_isstring(m_state, -1)) {
-			m_errorList.emplace_back(lua_tostring(m_state, -1));
-			lua_pop(m_state, 1);
-		}
+	StackCheck check(m_state, 0, __func__);
+	const auto start = std::chrono::steady_clock::now();
+	int status = finishLoad(luaL_loadstring(m_state, code), std::chrono::steady_clock::now() - start);
+	if (status == LUA_OK) {
+		status = callFunction(0, 0); //values returned by the script are dropped
 	}
 	return status;
 }
 
+void State::clearErrorList() {
+	m_errorList.clear();
+	if (m_metrics) {
+		m_metrics->setErrorListSize(0);
+	}
+}
+
+std::shared_ptr<Metrics> State::enableMetrics() {
+	if (!m_metrics) {
+		m_metrics = std::make_shared<Metrics>();
+		m_metrics->setErrorListSize(m_errorList.size());
+		m_metrics->setHeapBytes(m_gc.getMemoryUsage());
+		m_gc.setMetrics(m_metrics);
+	}
+	return m_metrics;
+}
+
 Type State::getType(int index) const {
 	return static_cast<Type>(lua_type(m_state, index));
 }
@@ -143,23 +316,23 @@ int State::getStackSize() const {
 }
 
 void State::withTableDo(std::string_view tableName, TableFunction workOnTable, bool createIfMissing) {
+	StackCheck check(m_state, 0, __func__);
+	StackGuard guard(m_state); //pops the table (or the value which isn't a table), also if workOnTable throws
 	if (lua_getglobal(m_state, tableName.data()) != LUA_TTABLE) {
-		if (createIfMissing) {
-			lua_newtable(m_state); // Create a new table and push it onto the stack
-			lua_pushvalue(m_state, -1); // Duplicate the table because setglobal pops the value
-			lua_setglobal(m_state, tableName.data()); // Set the new table as a global variable
-		} else {
-			lua_pop(m_state, 1); // Pop the nil from the stack to clean up
+		if (!createIfMissing) {
 			return; // Exit the function as there's no table to work with and creation is not requested
 		}
+		lua_newtable(m_state); // Create a new table and push it onto the stack
+		lua_pushvalue(m_state, -1); // Duplicate the table because setglobal pops the value
+		lua_setglobal(m_state, tableName.data()); // Set the new table as a global variable
 	}
 
 	Table table(m_state, -1); //the table is on top of the stack
 	workOnTable(table);
-	lua_pop(m_state, 1);
 }
 
 void State::withTableDo(int index, TableFunction workOnTable) {
+	StackCheck check(m_state, 0, __func__);
 	if (lua_istable(m_state, index)) {
 		Table table(m_state, index); //the table is on top of the stack
 		workOnTable(table);
@@ -167,6 +340,7 @@ void State::withTableDo(int index, TableFunction workOnTable) {
 }
 
 void State::createTable(const char* name, TableFunction workOnTable) {
+	StackCheck check(m_state, name != nullptr ? 0 : 1, __func__);
 	lua_newtable(m_state);
 	Table table(m_state, -1); //the table is on top of the stack
 	workOnTable(table);
@@ -176,13 +350,15 @@ void State::createTable(const char* name, TableFunction workOnTable) {
 }
 
 void State::createMetaTable(const char* name, TableFunction workOnTable) {
+	StackCheck check(m_state, 0, __func__);
+	StackGuard guard(m_state);
 	luaL_newmetatable(m_state, name);
 	Table table(m_state, -1, true); //the table is on top of the stack
 	workOnTable(table);
-	lua_pop(m_state, 1);
 }
 
 bool State::assignMetaTable(const char* name) {
+	StackCheck check(m_state, 0, __func__);
 	if (luaL_getmetatable(m_state, name) == LUA_TTABLE) {
 		//stack assumption:
 		//-1: metatable
@@ -190,21 +366,104 @@ bool State::assignMetaTable(const char* name) {
 		lua_setmetatable(m_state, -2);
 		return true;
 	}
+	lua_pop(m_state, 1); //pop the nil pushed instead of the metatable
 	return false;
 }
 
 int State::dispatchMethod(lua_State* state) {
 	const int32_t index = static_cast<int32_t>(lua_tointeger(state, lua_upvalueindex(1)));
 	State* luaState = static_cast<State*>(lua_touserdata(state, lua_upvalueindex(2)));
+	Metrics* metrics = luaState->m_metrics.get();
+	const bool tracing = Tracer::isEnabled();
+	if (metrics == nullptr && !tracing) {
+		return luaState->m_callbacks[index](*luaState);
+	}
+	//methods raising a lua error don't return, so only the time of those that returned is accounted. The trace event
+	//is ended by the hook of the tracer when the function catching the error returns. Without the hook the method is
+	//called in protected mode, to end the event before raising the error again.
+	const uint32_t depth = tracing ? Tracer::begin(Tracer::Category::Native, "method") : 0;
+	const auto start = std::chrono::steady_clock::now();
+	int numResults = 0;
+	if (tracing && !Tracer::isAttached(state)) {
+		const int numArgs = lua_gettop(state);
+		lua_pushcfunction(state, &State::invokeMethod);
+		lua_insert(state, 1);
+		lua_pushvalue(state, lua_upvalueindex(1));
+		lua_pushlightuserdata(state, luaState);
+		if (lua_pcall(state, numArgs + 2, LUA_MULTRET, 0) != LUA_OK) {
+			Tracer::end(depth);
+			return lua_error(state);
+		}
+		numResults = lua_gettop(state);
+	} else {
+		numResults = luaState->m_callbacks[index](*luaState);
+	}
+	if (tracing) {
+		Tracer::end(depth);
+	}
+	if (metrics != nullptr) {
+		metrics->recordNativeCall(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start));
+	}
+	return numResults;
+}
+
+int State::invokeMethod(lua_State* state) {
+	//the index of the callback and the state follow the arguments
+	const int32_t index = static_cast<int32_t>(lua_tointeger(state, -2));
+	State* luaState = static_cast<State*>(lua_touserdata(state, -1));
+	lua_pop(state, 2);
 	return luaState->m_callbacks[index](*luaState);
 }
 
 bool State::loadFunction(const char* funcName) { 
-	return lua_getglobal(m_state, funcName) == LUA_TFUNCTION;
+	const int type = lua_getglobal(m_state, funcName);
+	if (type != LUA_TFUNCTION) {
+		addError(std::string("attempt to call a ") + lua_typename(m_state, type) + " value (global '" + funcName + "')");
+		lua_pop(m_state, 1);
+		if (m_metrics) {
+			m_metrics->recordCall(LUA_ERRRUN);
+		}
+		return false;
+	}
+	return true;
 }
 
 int State::callFunction(int numArgs, int numResults) {
-	return lua_pcall(m_state, numArgs, numResults, 0);
+	Tracer::Scope scope(Tracer::Category::Script, "call");
+	const int status = lua_pcall(m_state, numArgs, numResults, 0);
+	if (status != LUA_OK) {
+		const char* message = lua_tostring(m_state, -1);
+		addError(message != nullptr ? message : "error object is not a string");
+		lua_pop(m_state, 1);
+	}
+	if (m_metrics) {
+		m_metrics->recordCall(status);
+		m_metrics->setHeapBytes(m_gc.getMemoryUsage());
+	}
+	return status;
+}
+
+int State::finishLoad(int status, std::chrono::steady_clock::duration compileTime) {
+	if (status != LUA_OK) {
+		const char* message = lua_tostring(m_state, -1);
+		addError(message != nullptr ? message : "error object is not a string");
+		lua_pop(m_state, 1);
+	}
+	if (m_metrics) {
+		m_metrics->recordLoad(status, std::chrono::duration_cast<std::chrono::nanoseconds>(compileTime));
+	}
+	if (Tracer::isEnabled()) {
+		const auto now = std::chrono::steady_clock::now();
+		Tracer::record(Tracer::Category::Compile, "compile", now - compileTime, now);
+	}
+	return status;
+}
+
+void State::addError(std::string message) {
+	m_errorList.push_back(std::move(message));
+	if (m_metrics) {
+		m_metrics->setErrorListSize(m_errorList.size());
+	}
 }
 
 
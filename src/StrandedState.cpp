@@ -0,0 +1,135 @@
+#include <StrandedState.hpp>
+
+namespace Lua {
+
+template <typename T>
+static void updateMaximum(std::atomic<T>& maximum, T value) {
+	T current = maximum.load(std::memory_order_relaxed);
+	while (value > current && !maximum.compare_exchange_weak(current, value, std::memory_order_relaxed)) {}
+}
+
+StrandedState::StrandedState() : StrandedState(Options()) {}
+
+StrandedState::StrandedState(const Options& options) : m_options(options), m_head(&m_stub), m_tail(&m_stub) {
+	if (m_options.batchSize == 0) {
+		m_options.batchSize = 1;
+	}
+	m_thread = std::thread(&StrandedState::run, this);
+}
+
+StrandedState::~StrandedState() {
+	{
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+		m_stop.store(true);
+	}
+	m_wakeup.notify_one();
+	m_thread.join();
+}
+
+StrandedState::Statistics StrandedState::getStatistics() const {
+	Statistics statistics;
+	statistics.submitted = m_submitted.load(std::memory_order_relaxed);
+	statistics.executed = m_executed.load(std::memory_order_relaxed);
+	statistics.batches = m_batches.load(std::memory_order_relaxed);
+	statistics.wakeups = m_wakeups.load(std::memory_order_relaxed);
+	statistics.queueDepth = m_depth.load(std::memory_order_relaxed);
+	statistics.maxQueueDepth = m_maxDepth.load(std::memory_order_relaxed);
+	statistics.totalLatency = std::chrono::nanoseconds(m_totalLatency.load(std::memory_order_relaxed));
+	statistics.maxLatency = std::chrono::nanoseconds(m_maxLatency.load(std::memory_order_relaxed));
+	return statistics;
+}
+
+void StrandedState::enqueue(Node* node) {
+	node->submitted = Clock::now();
+	//counted before the node is linked, so the owner thread doesn't go to sleep while a node is on its way
+	const size_t depth = m_depth.fetch_add(1) + 1;
+	m_submitted.fetch_add(1, std::memory_order_relaxed);
+	updateMaximum(m_maxDepth, depth);
+	push(node);
+
+	if (m_sleeping.load() && m_sleeping.exchange(false)) {
+		{
+			std::lock_guard<std::mutex> lock(m_sleepMutex);
+		}
+		m_wakeup.notify_one();
+		m_wakeups.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+void StrandedState::push(Node* node) {
+	node->next.store(nullptr, std::memory_order_relaxed);
+	Node* previous = m_head.exchange(node, std::memory_order_acq_rel);
+	previous->next.store(node, std::memory_order_release);
+}
+
+StrandedState::Node* StrandedState::pop() {
+	Node* tail = m_tail;
+	Node* next = tail->next.load(std::memory_order_acquire);
+	if (tail == &m_stub) {
+		if (next == nullptr) {
+			return nullptr;
+		}
+		m_tail = next;
+		tail = next;
+		next = next->next.load(std::memory_order_acquire);
+	}
+	if (next != nullptr) {
+		m_tail = next;
+		return tail;
+	}
+	if (tail != m_head.load(std::memory_order_acquire)) {
+		return nullptr; //a producer has exchanged the head but not linked its node yet
+	}
+	//tail is the last node: put the stub behind it, so it can be handed out without a producer referencing it
+	push(&m_stub);
+	next = tail->next.load(std::memory_order_acquire);
+	if (next != nullptr) {
+		m_tail = next;
+		return tail;
+	}
+	return nullptr;
+}
+
+void StrandedState::run() {
+	State state(m_options.libraries);
+	while (true) {
+		size_t count = 0;
+		while (count < m_options.batchSize) {
+			Node* node = pop();
+			if (node == nullptr) {
+				break;
+			}
+			m_depth.fetch_sub(1, std::memory_order_relaxed);
+			execute(node, state);
+			++count;
+		}
+		if (count > 0) {
+			m_batches.fetch_add(1, std::memory_order_relaxed);
+			continue;
+		}
+		if (m_depth.load() > 0) {
+			std::this_thread::yield(); //a node is counted but not linked yet
+			continue;
+		}
+		if (m_stop.load()) {
+			break;
+		}
+
+		m_sleeping.store(true);
+		std::unique_lock<std::mutex> lock(m_sleepMutex);
+		m_wakeup.wait(lock, [this]() { return m_depth.load() > 0 || m_stop.load(); });
+		m_sleeping.store(false);
+	}
+}
+
+void StrandedState::execute(Node* node, State& state) {
+	const int64_t latency = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - node->submitted).count();
+	m_totalLatency.fetch_add(latency, std::memory_order_relaxed);
+	updateMaximum(m_maxLatency, latency);
+
+	m_executed.fetch_add(1, std::memory_order_relaxed);
+	node->run(state);
+	delete node;
+}
+
+} // namespace Lua
\ No newline at end of file
@@ -0,0 +1,470 @@
+#include <Tracer.hpp>
+#include <lua/lua.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <system_error>
+#include <unordered_map>
+#include <vector>
+
+namespace Lua {
+
+std::atomic<bool> Tracer::s_enabled{false};
+
+namespace {
+
+enum Phase : uint8_t {
+	Begin,
+	End
+};
+
+constexpr const char* const CategoryNames[] = { "script", "native", "gc", "compile", "user" };
+constexpr uint32_t NoName = 0;
+
+uint64_t toTimestamp(std::chrono::steady_clock::time_point time) {
+	return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count());
+}
+
+uint64_t packEvent(Phase phase, Tracer::Category category, uint32_t name) {
+	return static_cast<uint64_t>(name) << 16 | static_cast<uint64_t>(category) << 8 | phase;
+}
+
+/**
+ * @brief the parts of a function seen by the hook which make up its event name
+ * They are compared by content: the strings belong to lua, their addresses are reused once they were collected (e.g.
+ * after a script was reloaded or in the next state).
+*/
+struct FunctionKey {
+	std::string_view source; ///< short_src
+	int line;
+	std::string_view name; ///< empty if the function has no name
+	char what;
+
+	size_t hash() const {
+		const std::hash<std::string_view> hash;
+		return hash(source) ^ (hash(name) * 31) ^ (static_cast<size_t>(line) << 8) ^ static_cast<size_t>(what);
+	}
+};
+
+/**
+ * @brief interned event name of a function with the content of its key
+*/
+struct FunctionName {
+	std::string source;
+	int line;
+	std::string name;
+	char what;
+	uint32_t id;
+
+	bool matches(const FunctionKey& key) const { return line == key.line && what == key.what && name == key.name && source == key.source; }
+};
+
+/**
+ * @brief event begun by the hook, it is ended when the function returns or its coroutine yields
+*/
+struct OpenEvent {
+	uint32_t depth; ///< depth of the buffer before the event began
+	int level; ///< number of active functions of the lua thread, including the traced one
+	Tracer::Category category;
+	uint32_t name;
+};
+
+/**
+ * @brief ring buffer of the events of one thread
+ * Only the owning thread writes. The words are atomics, so readers on other threads copy them without a data race and
+ * then drop the events which may have been overwritten while they copied.
+*/
+class EventBuffer {
+public:
+	struct Event {
+		uint64_t timestamp;
+		uint64_t info; ///< name, category and phase (see packEvent)
+	};
+
+	EventBuffer(size_t capacity, uint32_t thread)
+	: m_capacity(capacity),
+	  m_words(std::make_unique<std::atomic<uint64_t>[]>(capacity * 2)),
+	  m_thread(thread)
+	{
+	}
+
+	void push(uint64_t timestamp, uint64_t info) {
+		const uint64_t head = m_head.load(std::memory_order_relaxed);
+		const size_t slot = static_cast<size_t>(head & (m_capacity - 1)) * 2;
+		m_words[slot].store(timestamp, std::memory_order_relaxed);
+		m_words[slot + 1].store(info, std::memory_order_relaxed);
+		m_head.store(head + 1, std::memory_order_release);
+	}
+
+	std::vector<Event> read() const {
+		const uint64_t head = m_head.load(std::memory_order_acquire);
+		uint64_t first = std::max(m_start.load(std::memory_order_relaxed), head > m_capacity ? head - m_capacity : 0);
+		std::vector<Event> events;
+		events.reserve(static_cast<size_t>(head - first));
+		for (uint64_t index = first; index < head; ++index) {
+			const size_t slot = static_cast<size_t>(index & (m_capacity - 1)) * 2;
+			events.push_back(Event{m_words[slot].load(std::memory_order_relaxed), m_words[slot + 1].load(std::memory_order_relaxed)});
+		}
+		//the writer may have overwritten the oldest events meanwhile, including the one it is writing right now
+		std::atomic_thread_fence(std::memory_order_acquire);
+		const uint64_t written = m_head.load(std::memory_order_relaxed) + 1;
+		if (written > m_capacity && written - m_capacity > first) {
+			const size_t overwritten = static_cast<size_t>(std::min(written - m_capacity - first, head - first));
+			events.erase(events.begin(), events.begin() + static_cast<std::ptrdiff_t>(overwritten));
+		}
+		return events;
+	}
+
+	void clear() { m_start.store(m_head.load(std::memory_order_acquire), std::memory_order_relaxed); }
+	uint32_t getThread() const { return m_thread; }
+
+	//used by the owning thread only
+	uint32_t depth = 0; ///< number of events which began and didn't end
+	std::unordered_map<const void*, uint32_t> names; ///< interned names by address
+	std::unordered_map<size_t, std::vector<FunctionName>> functions; ///< names of the functions seen by the hook by the hash of their key
+	std::unordered_map<const lua_State*, std::vector<OpenEvent>> open; ///< events begun by the hook per lua thread
+	std::vector<const lua_State*> running; ///< lua threads seen by the hook, each one resumed by the one before it
+	std::vector<OpenEvent>* current = nullptr; ///< open events of the last lua thread of running
+
+private:
+	const size_t m_capacity;
+	std::unique_ptr<std::atomic<uint64_t>[]> m_words;
+	std::atomic<uint64_t> m_head{0}; ///< number of events written
+	std::atomic<uint64_t> m_start{0}; ///< first event after the last clear
+	const uint32_t m_thread;
+};
+
+struct SharedState {
+	std::mutex mutex;
+	std::vector<std::shared_ptr<EventBuffer>> buffers; ///< kept after their threads ended
+	std::vector<std::string> names{""};
+	std::unordered_map<std::string, uint32_t> nameIds;
+	size_t capacity = Tracer::DefaultCapacity;
+};
+
+SharedState& sharedState() {
+	static SharedState instance;
+	return instance;
+}
+
+thread_local std::shared_ptr<EventBuffer> t_buffer;
+
+EventBuffer& getBuffer() {
+	if (!t_buffer) {
+		SharedState& shared = sharedState();
+		std::lock_guard<std::mutex> lock(shared.mutex);
+		t_buffer = std::make_shared<EventBuffer>(shared.capacity, static_cast<uint32_t>(shared.buffers.size() + 1));
+		shared.buffers.push_back(t_buffer);
+	}
+	return *t_buffer;
+}
+
+uint32_t internName(const std::string& name) {
+	SharedState& shared = sharedState();
+	std::lock_guard<std::mutex> lock(shared.mutex);
+	auto [it, inserted] = shared.nameIds.try_emplace(name, static_cast<uint32_t>(shared.names.size()));
+	if (inserted) {
+		shared.names.push_back(name);
+	}
+	return it->second;
+}
+
+uint32_t internName(EventBuffer& buffer, const char* name) {
+	auto it = buffer.names.find(name);
+	if (it == buffer.names.end()) {
+		it = buffer.names.emplace(name, internName(std::string(name))).first;
+	}
+	return it->second;
+}
+
+void pushBegin(EventBuffer& buffer, uint64_t timestamp, Tracer::Category category, uint32_t name) {
+	buffer.push(timestamp, packEvent(Begin, category, name));
+	++buffer.depth;
+}
+
+void pushEnd(EventBuffer& buffer, uint64_t timestamp) {
+	if (buffer.depth > 0) { //ends of functions which began before the tracer was enabled are dropped
+		buffer.push(timestamp, packEvent(End, Tracer::Category::Script, NoName));
+		--buffer.depth;
+	}
+}
+
+void endOpenEvents(EventBuffer& buffer, uint32_t depth, uint64_t timestamp) {
+	while (buffer.depth > depth) {
+		pushEnd(buffer, timestamp);
+	}
+}
+
+/**
+ * @brief switch the hook to the events of the given lua thread
+ * Returning to a thread which resumed the current one means that the coroutines resumed after it yielded (or
+ * finished): their events are ended and begun again when they are resumed, so the nesting of the events stays intact.
+ * @param resumed The hook reports a return, the thread continues a function which began earlier
+*/
+std::vector<OpenEvent>& enterThread(EventBuffer& buffer, const lua_State* L, bool resumed, uint64_t timestamp) {
+	if (!buffer.running.empty() && buffer.running.back() == L) {
+		return *buffer.current;
+	}
+	if (std::find(buffer.running.begin(), buffer.running.end(), L) != buffer.running.end()) {
+		while (buffer.running.back() != L) {
+			auto it = buffer.open.find(buffer.running.back());
+			if (it != buffer.open.end()) {
+				if (it->second.empty()) {
+					buffer.open.erase(it);
+				} else {
+					endOpenEvents(buffer, it->second.front().depth, timestamp);
+				}
+			}
+			buffer.running.pop_back();
+		}
+	} else {
+		std::vector<OpenEvent>& open = buffer.open[L];
+		if (!resumed) {
+			open.clear(); //a new coroutine, possibly at the address of one which was never resumed again
+		}
+		for (OpenEvent& event : open) {
+			event.depth = buffer.depth;
+			pushBegin(buffer, timestamp, event.category, event.name);
+		}
+		buffer.running.push_back(L);
+	}
+	buffer.current = &buffer.open[L];
+	return *buffer.current;
+}
+
+/**
+ * @brief number of active functions of the lua thread (the level of the last one for lua_getstack plus one)
+ * lua_getstack walks the call chain, so the last level is searched like luaL_traceback does.
+*/
+int stackLevels(lua_State* L) {
+	lua_Debug ar;
+	int low = 1;
+	int high = 1;
+	while (lua_getstack(L, high, &ar) != 0) {
+		low = high;
+		high *= 2;
+	}
+	while (low < high) {
+		const int middle = (low + high) / 2;
+		if (lua_getstack(L, middle, &ar) != 0) {
+			low = middle + 1;
+		} else {
+			high = middle;
+		}
+	}
+	return high;
+}
+
+/**
+ * @brief ends the event of the function at the given level and those of the functions above it
+ * Errors unwind functions without reporting their returns, so the events of the functions above the returning one
+ * are still open if one of them raised an error which was caught in between. Returns of functions which began before
+ * the hook was attached are dropped.
+*/
+void endFunction(EventBuffer& buffer, std::vector<OpenEvent>& open, int level, uint64_t timestamp) {
+	auto first = std::find_if(open.begin(), open.end(), [level](const OpenEvent& event) { return event.level >= level; });
+	if (first != open.end()) {
+		endOpenEvents(buffer, first->depth, timestamp);
+		open.erase(first, open.end());
+	}
+}
+
+uint32_t internFunction(EventBuffer& buffer, const lua_Debug* ar) {
+	const bool native = ar->what[0] == 'C';
+	const FunctionKey key{ar->short_src, ar->linedefined, ar->name != nullptr ? ar->name : "", ar->what[0]};
+	std::vector<FunctionName>& candidates = buffer.functions[key.hash()];
+	for (const FunctionName& function : candidates) {
+		if (function.matches(key)) {
+			return function.id;
+		}
+	}
+	//functions called from C have no name
+	std::string name = ar->name != nullptr ? ar->name : (native ? "[C]" : (ar->what[0] == 'm' ? "main chunk" : "function"));
+	if (!native) {
+		name += std::string(" (") + ar->short_src + ":" + std::to_string(ar->linedefined) + ")";
+	}
+	const uint32_t id = internName(name);
+	candidates.push_back(FunctionName{std::string(key.source), key.line, std::string(key.name), key.what, id});
+	return id;
+}
+
+void hook(lua_State* L, lua_Debug* ar) {
+	if (!Tracer::isEnabled()) {
+		return;
+	}
+	try {
+		const uint64_t timestamp = toTimestamp(std::chrono::steady_clock::now());
+		EventBuffer& buffer = getBuffer();
+		std::vector<OpenEvent>& open = enterThread(buffer, L, ar->event == LUA_HOOKRET, timestamp);
+		const int level = stackLevels(L);
+		if (ar->event == LUA_HOOKRET) {
+			endFunction(buffer, open, level, timestamp);
+			return;
+		}
+		if (ar->event == LUA_HOOKTAILCALL) {
+			endFunction(buffer, open, level, timestamp); //the called function replaces the caller
+		}
+
+		lua_getinfo(L, "Sn", ar);
+		const Tracer::Category category = ar->what[0] == 'C' ? Tracer::Category::Native : Tracer::Category::Script;
+		const uint32_t name = internFunction(buffer, ar);
+		open.push_back(OpenEvent{buffer.depth, level, category, name});
+		pushBegin(buffer, timestamp, category, name);
+	} catch (...) {
+		//the hook must never raise through lua, an event lost to an out of memory situation is acceptable
+	}
+}
+
+void appendEscaped(std::string& json, const std::string& text) {
+	for (char c : text) {
+		switch (c) {
+			case '"': json += "\\\""; break;
+			case '\\': json += "\\\\"; break;
+			case '\n': json += "\\n"; break;
+			default:
+				if (static_cast<unsigned char>(c) < 0x20) {
+					char escaped[8];
+					std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned>(c));
+					json += escaped;
+				} else {
+					json += c;
+				}
+				break;
+		}
+	}
+}
+
+} // namespace
+
+void Tracer::enable(size_t capacity) {
+	size_t size = 1;
+	while (size < capacity) {
+		size *= 2;
+	}
+	{
+		SharedState& shared = sharedState();
+		std::lock_guard<std::mutex> lock(shared.mutex);
+		shared.capacity = size;
+	}
+	s_enabled.store(true, std::memory_order_relaxed);
+}
+
+void Tracer::disable() {
+	s_enabled.store(false, std::memory_order_relaxed);
+}
+
+uint32_t Tracer::begin(Category category, const char* name) {
+	EventBuffer& buffer = getBuffer();
+	const uint32_t depth = buffer.depth;
+	pushBegin(buffer, toTimestamp(std::chrono::steady_clock::now()), category, internName(buffer, name));
+	return depth;
+}
+
+void Tracer::end(uint32_t depth) {
+	EventBuffer& buffer = getBuffer();
+	const uint64_t timestamp = toTimestamp(std::chrono::steady_clock::now());
+	while (buffer.depth > depth) {
+		pushEnd(buffer, timestamp);
+	}
+}
+
+void Tracer::record(Category category, const char* name, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end) {
+	EventBuffer& buffer = getBuffer();
+	pushBegin(buffer, toTimestamp(start), category, internName(buffer, name));
+	pushEnd(buffer, toTimestamp(end));
+}
+
+void Tracer::attach(lua_State* state) {
+	lua_sethook(state, &hook, LUA_MASKCALL | LUA_MASKRET, 0);
+}
+
+void Tracer::detach(lua_State* state) {
+	lua_sethook(state, nullptr, 0, 0);
+}
+
+bool Tracer::isAttached(lua_State* state) {
+	return lua_gethook(state) == &hook;
+}
+
+std::string Tracer::toChromeJson() {
+	std::vector<std::shared_ptr<EventBuffer>> buffers;
+	std::vector<std::string> names;
+	{
+		SharedState& shared = sharedState();
+		std::lock_guard<std::mutex> lock(shared.mutex);
+		buffers = shared.buffers;
+		names = shared.names;
+	}
+
+	std::vector<std::vector<EventBuffer::Event>> events;
+	uint64_t origin = std::numeric_limits<uint64_t>::max();
+	for (const std::shared_ptr<EventBuffer>& buffer : buffers) {
+		events.push_back(buffer->read());
+		if (!events.back().empty()) {
+			origin = std::min(origin, events.back().front().timestamp);
+		}
+	}
+
+	std::string json = "{\"traceEvents\":[";
+	bool first = true;
+	char number[64];
+	for (size_t i = 0; i < buffers.size(); ++i) {
+		const std::string thread = std::to_string(buffers[i]->getThread());
+		json += first ? "\n" : ",\n";
+		first = false;
+		json += "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" + thread + ",\"args\":{\"name\":\"luacpp thread " + thread + "\"}}";
+
+		uint32_t depth = 0;
+		for (const EventBuffer::Event& event : events[i]) {
+			const uint8_t phase = static_cast<uint8_t>(event.info & 0xff);
+			std::snprintf(number, sizeof(number), "%.3f", static_cast<double>(event.timestamp - origin) / 1000.0);
+			if (phase == Begin) {
+				const uint32_t name = static_cast<uint32_t>(event.info >> 16);
+				const size_t category = static_cast<size_t>((event.info >> 8) & 0xff);
+				json += ",\n{\"ph\":\"B\",\"name\":\"";
+				appendEscaped(json, name < names.size() ? names[name] : std::string());
+				json += std::string("\",\"cat\":\"") + CategoryNames[std::min<size_t>(category, std::size(CategoryNames) - 1)] + "\"";
+				++depth;
+			} else if (depth > 0) { //the begin of the others was overwritten
+				json += ",\n{\"ph\":\"E\"";
+				--depth;
+			} else {
+				continue;
+			}
+			json += std::string(",\"ts\":") + number + ",\"pid\":1,\"tid\":" + thread + "}";
+		}
+	}
+	json += "\n],\"displayTimeUnit\":\"ns\"}\n";
+	return json;
+}
+
+bool Tracer::writeChromeJson(const std::filesystem::path& path) {
+	const std::string json = toChromeJson();
+	std::filesystem::path temporary = path;
+	temporary += ".tmp";
+	{
+		std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+		if (!file || !file.write(json.data(), static_cast<std::streamsize>(json.size()))) {
+			return false;
+		}
+	}
+	std::error_code error;
+	std::filesystem::rename(temporary, path, error);
+	return !error;
+}
+
+void Tracer::clear() {
+	SharedState& shared = sharedState();
+	std::lock_guard<std::mutex> lock(shared.mutex);
+	for (const std::shared_ptr<EventBuffer>& buffer : shared.buffers) {
+		buffer->clear();
+	}
+}
+
+} // namespace Lua
\ No newline at end of file
@@ -0,0 +1,177 @@
+#include <gtest/gtest.h>
+#include <array>
+#include <cstdlib>
+#include <functional>
+#include <new>
+#include <string_view>
+
+#ifdef USE_CPP20_MODULES
+import luacpp.State;
+import luacpp.Generic;
+#else
+#include <luacpp/State.hpp>
+#include <luacpp/Generic.hpp>
+#endif
+
+#include <lua/lua.hpp>
+
+namespace {
+thread_local size_t NewCalls = 0; ///< calls of operator new by the current thread
+} // namespace
+
+//the replaced operators count the allocations of the whole test binary, the budgets only look at the difference
+void* operator new(std::size_t size) {
+	++NewCalls;
+	if (void* block = std::malloc(size > 0 ? size : 1)) {
+		return block;
+	}
+	throw std::bad_alloc();
+}
+void* operator new[](std::size_t size) { return ::operator new(size); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+	++NewCalls;
+	return std::malloc(size > 0 ? size : 1);
+}
+void* operator new[](std::size_t size, const std::nothrow_t& tag) noexcept { return ::operator new(size, tag); }
+void operator delete(void* block) noexcept { std::free(block); }
+void operator delete[](void* block) noexcept { std::free(block); }
+void operator delete(void* block, std::size_t) noexcept { std::free(block); }
+void operator delete[](void* block, std::size_t) noexcept { std::free(block); }
+void operator delete(void* block, const std::nothrow_t&) noexcept { std::free(block); }
+void operator delete[](void* block, const std::nothrow_t&) noexcept { std::free(block); }
+
+namespace Lua {
+
+/**
+ * @brief counts the calls of operator new and of the lua allocator while measuring a function
+*/
+class AllocationCounter {
+public:
+	struct Count {
+		size_t native = 0; ///< calls of operator new
+		size_t lua = 0; ///< allocations and reallocations by the lua allocator
+	};
+
+	AllocationCounter(lua_State* state) : m_state(state) {
+		m_allocator = lua_getallocf(state, &m_allocatorData);
+		lua_setallocf(state, allocate, this);
+	}
+	AllocationCounter(const AllocationCounter&) = delete;
+	~AllocationCounter() { lua_setallocf(m_state, m_allocator, m_allocatorData); }
+
+	AllocationCounter& operator=(const AllocationCounter&) = delete;
+
+	/**
+	 * @brief the allocations of the given number of calls, after a first call which may fill caches
+	*/
+	template <typename Function>
+	Count measure(Function&& function, size_t calls = 100) {
+		function();
+		m_luaCalls = 0;
+		const size_t newCalls = NewCalls;
+		for (size_t i = 0; i < calls; ++i) {
+			function();
+		}
+		return Count{NewCalls - newCalls, m_luaCalls};
+	}
+
+private:
+	static void* allocate(void* userData, void* ptr, size_t oldSize, size_t newSize) {
+		AllocationCounter* counter = static_cast<AllocationCounter*>(userData);
+		if (newSize > 0) {
+			++counter->m_luaCalls;
+		}
+		return counter->m_allocator(counter->m_allocatorData, ptr, oldSize, newSize);
+	}
+
+	lua_State* m_state;
+	lua_Alloc m_allocator;
+	void* m_allocatorData;
+	size_t m_luaCalls = 0;
+};
+
+class AllocationBudgetTest : public ::testing::Test {
+protected:
+	AllocationBudgetTest() : m_state(State::LibBase), m_counter(m_state.getState()) {
+		EXPECT_EQ(m_state.loadAndExecuteScript(R"(
+			x = 42
+			name = "a string longer than the small string buffer"
+			function add(a, b) return a + b end
+			function callMethod() return method(7) end
+		)"), 0);
+	}
+
+	State m_state;
+	AllocationCounter m_counter;
+};
+
+TEST_F(AllocationBudgetTest, readAndWriteVariables) {
+	int x = 0;
+	AllocationCounter::Count count = m_counter.measure([&]() { x += m_state.readVariable<int>("x"); });
+	EXPECT_EQ(count.native, 0);
+	EXPECT_EQ(count.lua, 0);
+
+	count = m_counter.measure([&]() { m_state.writeVariable<int>("x", 7); });
+	EXPECT_EQ(count.native, 0);
+	EXPECT_EQ(count.lua, 0);
+
+	size_t length = 0;
+	count = m_counter.measure([&]() { length += m_state.readVariable<std::string_view>("name").size(); });
+	EXPECT_EQ(count.native, 0);
+	EXPECT_EQ(count.lua, 0);
+
+	count = m_counter.measure([&]() {
+		m_state.pushGlobalToStack("x");
+		Generic value = Generic::fromStack(-1, m_state.getState());
+		m_state.popStack(1);
+		x += value.get<int>();
+	});
+	EXPECT_EQ(count.native, 0);
+	EXPECT_EQ(count.lua, 0);
+}
+
+TEST_F(AllocationBudgetTest, executeFunction) {
+	AllocationCounter::Count count = m_counter.measure([&]() {
+		EXPECT_EQ(m_state.executeFunction("add", 1, 2.5), 0);
+	});
+	EXPECT_EQ(count.native, 0);
+	EXPECT_EQ(count.lua, 0);
+
+	int sum = 0;
+	count = m_counter.measure([&]() { m_state.executeFunctionAndReadReturnVal(sum, "add", 1, 2); });
+	EXPECT_EQ(sum, 3);
+	EXPECT_EQ(count.native, 0);
+	EXPECT_EQ(count.lua, 0);
+}
+
+TEST_F(AllocationBudgetTest, registerMethod) {
+	std::array<int, 32> captured{}; //too large for the small buffer of std::function
+	captured[0] = 1;
+	for (const char* name : {"method", "second", "third"}) {
+		m_state.registerMethod(name, [captured](State& state) { return state.setReturnValue(state.getArgument<int>(1) + captured[0]); });
+	}
+
+	//dispatching a registered method from a script
+	int result = 0;
+	AllocationCounter::Count count = m_counter.measure([&]() { m_state.executeFunctionAndReadReturnVal(result, "callMethod"); });
+	EXPECT_EQ(result, 8);
+	EXPECT_EQ(count.native, 0);
+	EXPECT_EQ(count.lua, 0);
+
+	//the method is moved into the state: registering it allocates as much as registering a method without captures
+	//in a state with the same methods, whatever the growth of the list of callbacks
+	State other(State::LibBase);
+	for (const char* name : {"method", "second", "third"}) {
+		other.registerMethod(name, [](State& state) { return state.setReturnValue(1); });
+	}
+	State::Method large = [captured](State& state) { return state.setReturnValue(captured[0]); };
+	State::Method small = [](State& state) { return state.setReturnValue(1); };
+	size_t newCalls = NewCalls;
+	m_state.registerMethod("fourth", std::move(large));
+	const size_t largeCalls = NewCalls - newCalls;
+	newCalls = NewCalls;
+	other.registerMethod("fourth", std::move(small));
+	EXPECT_EQ(largeCalls, NewCalls - newCalls);
+}
+
+} // namespace Lua
\ No newline at end of file
@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+#include <lua/lua.hpp>
+#include <cstring>
+#include <string>
+
+#ifdef USE_CPP20_MODULES
+import luacpp.State;
+import luacpp.AllocationProfiler;
+#else
+#include <luacpp/State.hpp>
+#include <luacpp/AllocationProfiler.hpp>
+#endif
+
+namespace Lua {
+
+class AllocationProfilerTest : public ::testing::Test {
+protected:
+	AllocationProfilerTest() : m_state(State::LibBase | State::LibString) {}
+
+	int run(const char* code) {
+		lua_State* L = m_state.getState();
+		int status = luaL_loadbuffer(L, code, std::strlen(code), "=alloc");
+		if (status == LUA_OK) {
+			status = lua_pcall(L, 0, 0, 0);
+		}
+		if (status != LUA_OK) {
+			lua_pop(L, 1);
+		}
+		return status;
+	}
+
+	static constexpr const char* const Script = R"(local function build(n)
+	local t = {}
+	for i = 1, n do
+		t[i] = string.rep("x", 100) .. i
+	end
+	return t
+end
+kept = build(200)
+local dropped = build(300)
+)";
+
+	State m_state;
+};
+
+TEST_F(AllocationProfilerTest, attributeToLines) {
+	AllocationProfiler::Options options;
+	options.sampleInterval = 0; //every allocation
+	AllocationProfiler profiler(m_state.getState(), options);
+	ASSERT_EQ(run(Script), 0);
+	lua_gc(m_state.getState(), LUA_GCCOLLECT);
+
+	std::vector<AllocationProfiler::Site> lines = profiler.getLines();
+	ASSERT_FALSE(lines.empty());
+	EXPECT_EQ(lines.front().location, "alloc:4");
+	EXPECT_GE(lines.front().allocatedBytes, 500u * 200u); //the result of string.rep and of the concatenation
+
+	uint64_t keptLive = 0;
+	uint64_t droppedLive = 0;
+	uint64_t droppedAllocated = 0;
+	for (const AllocationProfiler::Site& stack : profiler.getStacks()) {
+		if (stack.location.rfind("alloc:8;alloc:4", 0) == 0) {
+			keptLive += stack.liveBytes;
+		} else if (stack.location.rfind("alloc:9;alloc:4", 0) == 0) {
+			droppedLive += stack.liveBytes;
+			droppedAllocated += stack.allocatedBytes;
+		}
+	}
+	EXPECT_GE(keptLive, 200u * 100u);
+	EXPECT_GE(droppedAllocated, 300u * 200u);
+	EXPECT_EQ(droppedLive, 0u);
+
+	const std::string folded = profiler.toFoldedStacks();
+	EXPECT_NE(folded.find("\nalloc:9;alloc:4;[C] "), std::string::npos);
+	EXPECT_EQ(profiler.toFoldedStacks(true).find("alloc:9;"), std::string::npos);
+}
+
+TEST_F(AllocationProfilerTest, unbiasedSampling) {
+	AllocationProfiler::Options options;
+	options.sampleInterval = 4096;
+	options.seed = 42;
+	options.nativeFrames = 4; //only used with glibc
+	AllocationProfiler profiler(m_state.getState(), options);
+	for (int i = 0; i < 10; ++i) {
+		ASSERT_EQ(run(Script), 0);
+	}
+
+	uint64_t estimate = 0;
+	for (const AllocationProfiler::Site& line : profiler.getLines()) {
+		estimate += line.allocatedBytes;
+	}
+	const double actual = static_cast<double>(profiler.getAllocatedBytes());
+	EXPECT_NEAR(static_cast<double>(estimate), actual, actual * 0.2);
+	EXPECT_LT(profiler.getSampleCount(), actual / 1024);
+
+	profiler.stop();
+	EXPECT_FALSE(profiler.isRunning());
+	const uint64_t allocated = profiler.getAllocatedBytes();
+	ASSERT_EQ(run(Script), 0);
+	EXPECT_EQ(profiler.getAllocatedBytes(), allocated);
+}
+
+} // namespace Lua
\ No newline at end of file
@@ -0,0 +1,133 @@
+#include <gtest/gtest.h>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#ifdef USE_CPP20_MODULES
+import luacpp.State;
+import luacpp.Buffer;
+#else
+#include <luacpp/State.hpp>
+#include <luacpp/Buffer.hpp>
+#endif
+
+namespace Lua {
+
+class BufferTest : public ::testing::Test {
+protected:
+	static std::vector<char> createPayload() {
+		std::vector<char> payload(64 * 1024);
+		for (size_t i = 0; i < payload.size(); ++i) {
+			payload[i] = static_cast<char>(i & 0xFF);
+		}
+		const uint32_t magic = 0xCAFEBABE;
+		const double value = 2.5;
+		std::memcpy(payload.data(), &magic, sizeof(magic)); //the tests run on little endian machines
+		std::memcpy(payload.data() + 8, &value, sizeof(value));
+		return payload;
+	}
+};
+
+TEST_F(BufferTest, slice) {
+	const char text[] = "hello world";
+	Buffer buffer = Buffer::copy(text, 11);
+	EXPECT_EQ(buffer.view(), "hello world");
+	EXPECT_NE(buffer.data(), text);
+	EXPECT_EQ(buffer.slice(6, 5).view(), "world");
+	EXPECT_EQ(buffer.slice(6, 100).view(), "world");
+	EXPECT_EQ(buffer.slice(20, 1).size(), 0u);
+	EXPECT_EQ(buffer.slice(6, 5).data(), buffer.data() + 6);
+}
+
+TEST_F(BufferTest, accessFromLua) {
+	const char* src = R"(
+		size = #payload
+		first = payload[1]
+		outside = payload[size + 1] == nil
+		magic = payload:readu32(1)
+		value = payload:readf64(9)
+		byte = payload:byte(17)
+		part = payload:sub(17, 20)
+		partSize = #part
+		partFirst = part[1]
+		partString = tostring(payload:sub(-3))
+		copy = payload:tostring(17, 18)
+		signed = part:readi8(-1)
+		ok, err = pcall(function() return payload:readu32(size - 2) end)
+	)";
+
+	const std::vector<char> payload = createPayload();
+	Buffer::Lifetime lifetime;
+	State state(State::LibBase);
+	state.writeVariable("payload", Buffer::borrow(payload.data(), payload.size(), lifetime));
+	ASSERT_EQ(state.loadAndExecuteScript(src), 0);
+	EXPECT_EQ(state.readVariable<int>("size"), 64 * 1024);
+	EXPECT_EQ(state.readVariable<int>("first"), 0xBE);
+	EXPECT_TRUE(state.readVariable<bool>("outside"));
+	EXPECT_EQ(state.readVariable<int64_t>("magic"), int64_t(0xCAFEBABE));
+	EXPECT_DOUBLE_EQ(state.readVariable<double>("value"), 2.5);
+	EXPECT_EQ(state.readVariable<int>("byte"), 16);
+	EXPECT_EQ(state.readVariable<int>("partSize"), 4);
+	EXPECT_EQ(state.readVariable<int>("partFirst"), 16);
+	EXPECT_EQ(state.readVariable<std::string>("partString"), std::string("\xFD\xFE\xFF", 3));
+	EXPECT_EQ(state.readVariable<std::string>("copy"), std::string("\x10\x11", 2));
+	EXPECT_EQ(state.readVariable<int>("signed"), 19);
+	EXPECT_FALSE(state.readVariable<bool>("ok"));
+	EXPECT_EQ(state.getStackSize(), 0);
+}
+
+TEST_F(BufferTest, borrowedLifetime) {
+	const std::vector<char> payload = createPayload();
+	State state(State::LibBase);
+	{
+		Buffer::Lifetime lifetime;
+		state.writeVariable("payload", Buffer::borrow(payload.data(), payload.size(), lifetime));
+		ASSERT_EQ(state.loadAndExecuteScript("part = payload:sub(1, 4)"), 0);
+		ASSERT_EQ(state.loadAndExecuteScript("ok = pcall(function() return #part end)"), 0);
+		EXPECT_TRUE(state.readVariable<bool>("ok"));
+	}
+	ASSERT_EQ(state.loadAndExecuteScript("ok, err = pcall(function() return #part end)"), 0);
+	EXPECT_FALSE(state.readVariable<bool>("ok"));
+	EXPECT_NE(state.readVariable<std::string>("err").find("expired"), std::string::npos);
+}
+
+TEST_F(BufferTest, ownedLifetime) {
+	auto payload = std::make_shared<std::vector<char>>(createPayload());
+	std::weak_ptr<std::vector<char>> weak = payload;
+	{
+		State state(State::LibNone);
+		state.writeVariable("payload", Buffer(payload->data(), payload->size(), payload));
+		payload.reset();
+		EXPECT_FALSE(weak.expired()); //kept alive by the lua state
+		state.pushGlobalToStack("payload");
+		const Buffer* buffer = Buffer::fromStack(state.getState(), -1);
+		ASSERT_NE(buffer, nullptr);
+		EXPECT_EQ(buffer->size(), 64u * 1024u);
+		state.popStack(1);
+	}
+	EXPECT_TRUE(weak.expired());
+}
+
+TEST_F(BufferTest, functionArgumentAndResult) {
+	const char* src = R"(
+		function handle(message)
+			return message:sub(5, 8)
+		end
+	)";
+
+	const std::vector<char> payload = createPayload();
+	Buffer::Lifetime lifetime;
+	State state(State::LibNone);
+	ASSERT_EQ(state.loadAndExecuteScript(src), 0);
+	ASSERT_EQ(state.executeFunction<1>("handle", Buffer::borrow(payload.data(), payload.size(), lifetime)), 0);
+	const std::string_view result = Buffer::viewFromStack(state.getState(), -1);
+	EXPECT_EQ(result.data(), payload.data() + 4); //no copy in either direction
+	EXPECT_EQ(result.size(), 4u);
+	state.popStack(1);
+
+	state.pushToStack("text");
+	EXPECT_EQ(Buffer::viewFromStack(state.getState(), -1), "text");
+	state.popStack(1);
+}
+
+} // namespace Lua
\ No newline at end of file
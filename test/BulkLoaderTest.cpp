@@ -0,0 +1,77 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#ifdef USE_CPP20_MODULES
+import luacpp.State;
+import luacpp.BulkLoader;
+#else
+#include <luacpp/State.hpp>
+#include <luacpp/BulkLoader.hpp>
+#endif
+
+namespace Lua {
+
+TEST(BulkLoaderTest, compileInParallel) {
+	BulkLoader::Options options;
+	options.threads = 4;
+	BulkLoader loader(options);
+	for (int i = 0; i < 300; ++i) {
+		loader.add("script" + std::to_string(i), "result = " + std::to_string(i) + " * 2");
+	}
+	loader.add("broken", "result = = 1");
+	loader.add("unfinished", "if true then", "@unfinished.lua");
+	EXPECT_EQ(loader.compile(), 2u);
+
+	State state(State::LibBase);
+	BulkLoader::Result result = loader.load(state.getState());
+	EXPECT_EQ(result.loaded, 300u);
+	EXPECT_EQ(result.threads, 4u);
+	EXPECT_FALSE(result.isOk());
+	ASSERT_EQ(result.errors.size(), 2u);
+	EXPECT_NE(result.errors["broken"].find("broken:1:"), std::string::npos);
+	EXPECT_NE(result.errors["unfinished"].find("unfinished.lua:1:"), std::string::npos);
+	EXPECT_EQ(state.getStackSize(), 0);
+
+	for (int i : {0, 17, 299}) {
+		ASSERT_EQ(state.executeScript(("script" + std::to_string(i)).c_str()), 0);
+		EXPECT_EQ(state.readVariable<int>("result"), i * 2);
+	}
+
+	//the bytecode is kept for further states
+	State other(State::LibBase);
+	EXPECT_EQ(loader.load(other.getState()).loaded, 300u);
+	ASSERT_EQ(other.executeScript("script5"), 0);
+	EXPECT_EQ(other.readVariable<int>("result"), 10);
+}
+
+TEST(BulkLoaderTest, loadDirectory) {
+	const auto directory = std::filesystem::temp_directory_path() / "luacpp_bulkloader";
+	std::filesystem::remove_all(directory);
+	std::filesystem::create_directories(directory / "tariff");
+	std::ofstream(directory / "main.lua") << "result = 'main'";
+	std::ofstream(directory / "tariff" / "north.lua") << "result = 'north'";
+	std::ofstream(directory / "tariff" / "notes.txt") << "not a script";
+
+	BulkLoader::Options options;
+	options.stripDebugInfo = true;
+	BulkLoader loader(options);
+	EXPECT_EQ(loader.addDirectory(directory), 2u);
+	loader.addFile("missing", directory / "missing.lua");
+
+	State state(State::LibBase);
+	BulkLoader::Result result = loader.load(state.getState());
+	EXPECT_EQ(result.loaded, 2u);
+	ASSERT_EQ(result.errors.size(), 1u);
+	EXPECT_NE(result.errors["missing"].find("cannot open"), std::string::npos);
+
+	ASSERT_EQ(state.executeScript("tariff.north"), 0);
+	EXPECT_EQ(state.readVariable<std::string>("result"), "north");
+	ASSERT_EQ(state.executeScript("main"), 0);
+	EXPECT_EQ(state.readVariable<std::string>("result"), "main");
+
+	std::filesystem::remove_all(directory);
+}
+
+} // namespace Lua
\ No newline at end of file
@@ -0,0 +1,64 @@
+#include <gtest/gtest.h>
+#include <string>
+
+#ifdef USE_CPP20_MODULES
+import luacpp.State;
+import luacpp.Bundle;
+#else
+#include <luacpp/State.hpp>
+#include <luacpp/Bundle.hpp>
+#endif
+
+#include <luacpp_bundles/testScripts.hpp>
+
+namespace Lua {
+
+TEST(BundleTest, index) {
+	const Bundle& bundle = Bundles::testScripts();
+	ASSERT_EQ(bundle.size(), 3u);
+	EXPECT_STREQ(bundle[0].name, "greeting");
+	EXPECT_STREQ(bundle[1].name, "util");
+	EXPECT_STREQ(bundle[2].name, "util.strings");
+	EXPECT_NE(bundle.find("util.strings"), nullptr);
+	EXPECT_EQ(bundle.find("util.other"), nullptr);
+	EXPECT_EQ(bundle.find(""), nullptr);
+}
+
+TEST(BundleTest, require) {
+	const char* src = R"(
+		local greeting = require("greeting")
+		hello = greeting.hello("bundle")
+		loadedAs = greeting.loadedAs
+		same = require("util.strings") == require("util").strings
+		ok, err = pcall(require, "missing")
+		failOk, failErr = pcall(require("util.strings").fail)
+	)";
+
+	State state(State::LibBase | State::LibString | State::LibPackage);
+	ASSERT_TRUE(Bundles::testScripts().install(state.getState()));
+	ASSERT_EQ(state.loadAndExecuteScript(src), 0);
+	EXPECT_EQ(state.readVariable<std::string>("hello"), "hello BUNDLE");
+	EXPECT_EQ(state.readVariable<std::string>("loadedAs"), "bundle:greeting");
+	EXPECT_TRUE(state.readVariable<bool>("same"));
+	EXPECT_FALSE(state.readVariable<bool>("ok"));
+	EXPECT_NE(state.readVariable<std::string>("err").find("no module 'missing' in bundle"), std::string::npos);
+	EXPECT_FALSE(state.readVariable<bool>("failOk"));
+	EXPECT_NE(state.readVariable<std::string>("failErr").find("failed in bundle"), std::string::npos);
+	EXPECT_EQ(state.getStackSize(), 0);
+}
+
+TEST(BundleTest, loadWithoutPackageLibrary) {
+	State state(State::LibBase);
+	EXPECT_FALSE(Bundles::testScripts().install(state.getState()));
+	EXPECT_EQ(state.getStackSize(), 0);
+
+	ASSERT_TRUE(Bundles::testScripts().load(state.getState(), "util.strings"));
+	state.setGlobalFromStack("loadStrings");
+	ASSERT_EQ(state.loadAndExecuteScript("strings = loadStrings() fn = type(strings.upper)"), 0);
+	EXPECT_EQ(state.readVariable<std::string>("fn"), "function");
+
+	EXPECT_FALSE(Bundles::testScripts().load(state.getState(), "missing"));
+	state.popStack(1);
+}
+
+} // namespace Lua
\ No newline at end of file
@@ -0,0 +1,100 @@
+#include <gtest/gtest.h>
+#include <string>
+
+#ifdef USE_CPP20_MODULES
+import luacpp.State;
+import luacpp.CoroutinePool;
+#else
+#include <luacpp/State.hpp>
+#include <luacpp/CoroutinePool.hpp>
+#endif
+
+namespace Lua {
+
+class CoroutinePoolTest : public ::testing::Test {
+protected:
+	CoroutinePoolTest() : m_state(State::LibBase | State::LibCoroutine) {
+		m_state.loadAndExecuteScript(R"(
+			function add(a, b) return a + b end
+			function values() return 1, 2, 3 end
+			function fail() error("request failed") end
+			function yielding() coroutine.yield(1) end
+			function nested()
+				local co = coroutine.wrap(function() coroutine.yield(5) end)
+				return co()
+			end
+		)");
+	}
+
+	State m_state;
+};
+
+TEST_F(CoroutinePoolTest, reuseThreads) {
+	CoroutinePool pool(m_state.getState(), 2);
+	for (int i = 0; i < 10; ++i) {
+		m_state.pushGlobalToStack("add");
+		m_state.pushToStack(i);
+		m_state.pushToStack(1);
+		ASSERT_EQ(pool.call(2, 1), 0);
+		EXPECT_EQ(m_state.getStackValue<int>(-1), i + 1);
+		m_state.popStack(1);
+	}
+	EXPECT_EQ(pool.getStatistics().created, 1u);
+	EXPECT_EQ(pool.getStatistics().reused, 9u);
+	EXPECT_EQ(pool.getStatistics().idle, 1u);
+	EXPECT_EQ(pool.getStatistics().active, 0u);
+
+	//more threads in use than the pool keeps
+	CoroutinePool::Thread threads[3] = {pool.acquire(), pool.acquire(), pool.acquire()};
+	EXPECT_EQ(pool.getStatistics().active, 3u);
+	EXPECT_NE(threads[0].state, threads[1].state);
+	for (auto& thread : threads) {
+		pool.release(thread);
+		EXPECT_EQ(thread.state, nullptr);
+	}
+	EXPECT_EQ(pool.getStatistics().idle, 2u);
+	EXPECT_EQ(pool.getStatistics().discarded, 1u);
+
+	pool.setMaxIdle(0);
+	EXPECT_EQ(pool.getStatistics().idle, 0u);
+	EXPECT_EQ(pool.getStatistics().maxIdle, 0u);
+	EXPECT_EQ(m_state.getStackSize(), 0);
+}
+
+TEST_F(CoroutinePoolTest, resultsAndErrors) {
+	CoroutinePool pool(m_state.getState());
+	m_state.pushGlobalToStack("values");
+	ASSERT_EQ(pool.call(0, CoroutinePool::AllResults), 0);
+	EXPECT_EQ(m_state.getStackSize(), 3);
+	m_state.popStack(3);
+
+	m_state.pushGlobalToStack("values");
+	ASSERT_EQ(pool.call(0, 5), 0);
+	EXPECT_EQ(m_state.getStackSize(), 5);
+	EXPECT_EQ(m_state.getType(-1), Type::Nil);
+	m_state.popStack(5);
+
+	m_state.pushGlobalToStack("fail");
+	EXPECT_NE(pool.call(0, 1), 0);
+	EXPECT_NE(pool.getLastError().find("request failed"), std::string::npos);
+	EXPECT_EQ(m_state.getStackSize(), 0);
+
+	m_state.pushGlobalToStack("yielding");
+	EXPECT_NE(pool.call(0, 0), 0);
+	EXPECT_NE(pool.getLastError().find("yield"), std::string::npos);
+
+	//the threads are reset after errors and yields
+	m_state.pushGlobalToStack("nested");
+	ASSERT_EQ(pool.call(0, 1), 0);
+	EXPECT_EQ(m_state.getStackValue<int>(-1), 5);
+	m_state.popStack(1);
+	EXPECT_EQ(pool.getStatistics().created, 1u);
+
+	ASSERT_EQ(m_state.loadScript("script", "scriptRan = true"), 0);
+	ASSERT_EQ(pool.executeScript("script"), 0);
+	EXPECT_TRUE(m_state.readVariable<bool>("scriptRan"));
+	EXPECT_NE(pool.executeScript("missing"), 0);
+	EXPECT_EQ(m_state.getStackSize(), 0);
+}
+
+} // namespace Lua
\ No newline at end of file
@@ -0,0 +1,192 @@
+#include <gtest/gtest.h>
+#include <lua/lua.hpp>
+#include <string>
+#include <thread>
+
+#ifdef __linux__
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#ifdef USE_CPP20_MODULES
+import luacpp.State;
+import luacpp.EventLoop;
+#else
+#include <luacpp/State.hpp>
+#include <luacpp/EventLoop.hpp>
+#endif
+
+#ifdef __linux__
+
+namespace Lua {
+
+static int now(lua_State* state) {
+	const auto time = std::chrono::steady_clock::now().time_since_epoch();
+	lua_pushnumber(state, std::chrono::duration<double, std::milli>(time).count());
+	return 1;
+}
+
+static int readDescriptor(lua_State* state) {
+	char buffer[256];
+	const ssize_t size = read(static_cast<int>(luaL_checkinteger(state, 1)), buffer, sizeof(buffer));
+	lua_pushlstring(state, buffer, size > 0 ? static_cast<size_t>(size) : 0);
+	return 1;
+}
+
+class EventLoopTest : public ::testing::Test {
+protected:
+	EventLoopTest() : m_state(State::LibBase | State::LibTable | State::LibString), m_loop(m_state.getState()) {
+		m_state.registerNativeFunction("read_fd", &readDescriptor);
+		m_state.registerNativeFunction("now", &now);
+	}
+
+	State m_state;
+	EventLoop m_loop;
+};
+
+TEST_F(EventLoopTest, sleepingCoroutines) {
+	m_state.loadAndExecuteScript(R"(
+		order = {}
+		count = 0
+		function sleeper(delay, record)
+			local start = now()
+			sleep(delay)
+			assert(now() - start >= delay)
+			count = count + 1
+			if record then order[#order + 1] = delay end
+		end
+	)");
+	for (int i = 0; i < 1000; ++i) {
+		m_state.pushGlobalToStack("sleeper");
+		m_state.pushToStack((i * 7) % 20);
+		ASSERT_EQ(m_loop.spawn(1), LUA_YIELD);
+	}
+	for (int delay : {30, 10, 20}) {
+		m_state.pushGlobalToStack("sleeper");
+		m_state.pushToStack(delay);
+		m_state.pushToStack(true);
+		ASSERT_EQ(m_loop.spawn(2), LUA_YIELD);
+	}
+	EXPECT_EQ(m_loop.getTimerCount(), 1003u);
+
+	EXPECT_TRUE(m_loop.run(std::chrono::seconds(10)));
+	EXPECT_TRUE(m_loop.getScheduler().getErrorList().empty());
+	EXPECT_EQ(m_loop.getTimerCount(), 0u);
+	EXPECT_EQ(m_state.readVariable<int>("count"), 1003);
+	EXPECT_EQ(m_state.loadAndExecuteScript("assert(table.concat(order, ',') == '10,20,30')"), 0);
+}
+
+TEST_F(EventLoopTest, afterStartsCoroutine) {
+	m_state.loadAndExecuteScript(R"(
+		log = {}
+		after(5, function()
+			log[#log + 1] = "first"
+			sleep(5)
+			log[#log + 1] = "third"
+		end)
+		after(7, function() log[#log + 1] = "second" end)
+		after(1, function() error("timer failed") end)
+	)");
+	EXPECT_EQ(m_loop.getTimerCount(), 3u);
+	EXPECT_TRUE(m_loop.run(std::chrono::seconds(10)));
+	EXPECT_EQ(m_state.loadAndExecuteScript("assert(table.concat(log, ',') == 'first,second,third')"), 0);
+	ASSERT_EQ(m_loop.getScheduler().getErrorList().size(), 1u);
+	EXPECT_NE(m_loop.getScheduler().getErrorList().front().find("timer failed"), std::string::npos);
+}
+
+TEST_F(EventLoopTest, waitReadable) {
+	int pipeFds[2];
+	int socketFds[2];
+	ASSERT_EQ(pipe(pipeFds), 0);
+	ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, socketFds), 0);
+
+	m_state.loadAndExecuteScript(R"(
+		received = {}
+		function reader(fd, count)
+			for i = 1, count do
+				wait_readable(fd)
+				received[#received + 1] = read_fd(fd)
+			end
+		end
+	)");
+	m_state.pushGlobalToStack("reader");
+	m_state.pushToStack(pipeFds[0]);
+	m_state.pushToStack(1);
+	ASSERT_EQ(m_loop.spawn(2), LUA_YIELD);
+	m_state.pushGlobalToStack("reader");
+	m_state.pushToStack(socketFds[0]);
+	m_state.pushToStack(2);
+	ASSERT_EQ(m_loop.spawn(2), LUA_YIELD);
+	EXPECT_EQ(m_loop.getWaitCount(), 2u);
+
+	EXPECT_FALSE(m_loop.run(std::chrono::milliseconds(5)));
+	ASSERT_EQ(write(socketFds[1], "socket", 6), 6);
+	EXPECT_FALSE(m_loop.run(std::chrono::milliseconds(5)));
+	EXPECT_EQ(m_loop.getWaitCount(), 2u);
+
+	//written while the loop sleeps in epoll_wait
+	std::thread writer([&]() {
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		ASSERT_EQ(write(pipeFds[1], "pipe", 4), 4);
+		ASSERT_EQ(write(socketFds[1], "unix", 4), 4);
+	});
+	EXPECT_TRUE(m_loop.run(std::chrono::seconds(10)));
+	writer.join();
+	EXPECT_EQ(m_loop.getWaitCount(), 0u);
+	EXPECT_EQ(m_state.loadAndExecuteScript(R"(
+		table.sort(received)
+		assert(table.concat(received, ",") == "pipe,socket,unix")
+	)"), 0);
+
+	for (int fd : {pipeFds[0], pipeFds[1], socketFds[0], socketFds[1]}) {
+		close(fd);
+	}
+}
+
+TEST_F(EventLoopTest, errors) {
+	m_state.loadAndExecuteScript(R"(
+		function invalid()
+			local ok, message = pcall(wait_readable, -1)
+			result = message
+		end
+	)");
+	EXPECT_NE(m_state.loadAndExecuteScript("sleep(1)"), 0);
+
+	m_state.pushGlobalToStack("invalid");
+	ASSERT_EQ(m_loop.spawn(0), 0);
+	EXPECT_NE(m_state.readVariable<std::string>("result").find("cannot wait for descriptor -1"), std::string::npos);
+	EXPECT_EQ(m_loop.getWaitCount(), 0u);
+}
+
+TEST_F(EventLoopTest, completionFromOtherThread) {
+	std::thread worker;
+	m_loop.getScheduler().registerFunction("compute", [&worker](Scheduler::Values, Scheduler::Completion completion) {
+		worker = std::thread([completion]() {
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+			completion.resolve({Generic(42)});
+		});
+	});
+	m_state.loadAndExecuteScript("function task() result = compute() end");
+	m_state.pushGlobalToStack("task");
+	ASSERT_EQ(m_loop.spawn(0), LUA_YIELD);
+
+	const auto start = std::chrono::steady_clock::now();
+	EXPECT_TRUE(m_loop.run(std::chrono::seconds(10)));
+	EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(5));
+	worker.join();
+	EXPECT_EQ(m_state.readVariable<int>("result"), 42);
+
+	//stop interrupts a loop waiting for a timer
+	m_state.loadAndExecuteScript("after(60000, function() end)");
+	std::thread stopper([this]() {
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		m_loop.stop();
+	});
+	EXPECT_FALSE(m_loop.run(std::chrono::seconds(10)));
+	stopper.join();
+	EXPECT_EQ(m_loop.getTimerCount(), 1u);
+}
+
+} // namespace Lua
+
+#endif // __linux__
\ No newline at end of file
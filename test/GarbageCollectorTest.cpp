@@ -0,0 +1,92 @@
+#include <gtest/gtest.h>
+
+#ifdef USE_CPP20_MODULES
+import luacpp.State;
+import luacpp.GarbageCollector;
+#else
+#include <luacpp/State.hpp>
+#include <luacpp/GarbageCollector.hpp>
+#endif
+
+namespace Lua {
+
+class GarbageCollectorTest : public ::testing::Test {
+protected:
+	void createGarbage() {
+		const char* src = R"(
+			for i = 1, 10000 do
+				local t = { i, tostring(i), { i } }
+			end
+		)";
+		ASSERT_EQ(m_state.loadAndExecuteScript(src), 0);
+	}
+
+	State m_state{State::LibBase};
+};
+
+TEST_F(GarbageCollectorTest, switchMode) {
+	GarbageCollector& gc = m_state.getGarbageCollector();
+	EXPECT_EQ(gc.getMode(), GarbageCollector::Mode::Incremental);
+
+	EXPECT_EQ(gc.setGenerational(), GarbageCollector::Mode::Incremental);
+	EXPECT_EQ(gc.getMode(), GarbageCollector::Mode::Generational);
+
+	GarbageCollector::IncrementalParameters parameters;
+	parameters.pause = 150;
+	parameters.stepMultiplier = 200;
+	EXPECT_EQ(gc.setIncremental(parameters), GarbageCollector::Mode::Generational);
+	EXPECT_EQ(gc.getMode(), GarbageCollector::Mode::Incremental);
+}
+
+TEST_F(GarbageCollectorTest, stopAndRestart) {
+	GarbageCollector& gc = m_state.getGarbageCollector();
+	EXPECT_TRUE(gc.isRunning());
+	gc.stop();
+	EXPECT_FALSE(gc.isRunning());
+
+	//without a running collector the garbage is kept until we collect explicitly
+	const size_t before = gc.getMemoryUsage();
+	createGarbage();
+	EXPECT_GT(gc.getMemoryUsage(), before);
+
+	gc.collect();
+	EXPECT_FALSE(gc.isRunning());
+	EXPECT_EQ(gc.getStatistics().collections, 1u);
+	EXPECT_GT(gc.getStatistics().bytesFreed, 0u);
+
+	gc.restart();
+	EXPECT_TRUE(gc.isRunning());
+}
+
+TEST_F(GarbageCollectorTest, stepFor) {
+	GarbageCollector& gc = m_state.getGarbageCollector();
+	gc.stop();
+	createGarbage();
+
+	//stepping with a generous budget finishes the cycle
+	bool finished = false;
+	for (int i = 0; i < 1000 && !finished; ++i) {
+		finished = gc.stepFor(std::chrono::microseconds(1000));
+	}
+	EXPECT_TRUE(finished);
+
+	const GarbageCollector::Statistics& stats = gc.getStatistics();
+	EXPECT_GE(stats.collections, 1u);
+	EXPECT_GT(stats.steps, 0u);
+	EXPECT_GT(stats.bytesFreed, 0u);
+	EXPECT_GT(stats.stepTime.count(), 0);
+
+	gc.resetStatistics();
+	EXPECT_EQ(gc.getStatistics().steps, 0u);
+}
+
+TEST_F(GarbageCollectorTest, stepForZeroBudget) {
+	GarbageCollector& gc = m_state.getGarbageCollector();
+	createGarbage();
+
+	//at least one step is performed even without a budget
+	gc.stepFor(std::chrono::microseconds(0));
+	EXPECT_EQ(gc.getStatistics().steps, 1u);
+}
+
+} // namespace Lua
\ No newline at end of file
@@ -0,0 +1,91 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <string>
+
+#ifdef USE_CPP20_MODULES
+import luacpp.State;
+import luacpp.HeapSnapshot;
+#else
+#include <luacpp/State.hpp>
+#include <luacpp/HeapSnapshot.hpp>
+#endif
+
+namespace Lua {
+
+TEST(HeapSnapshotTest, retainedSizes) {
+	State state(State::LibBase | State::LibString | State::LibCoroutine);
+	ASSERT_EQ(state.loadAndExecuteScript(R"(
+cache = {entries = {}}
+for i = 1, 1000 do
+	cache.entries[i] = {name = string.rep("x", 100) .. i}
+end
+local shared = {}
+first = {shared = shared}
+second = {shared = shared}
+local hidden = string.rep("y", 5000)
+function getHidden() return hidden end
+worker = coroutine.create(function(value) coroutine.yield() end)
+coroutine.resume(worker, {string.rep("z", 3000)})
+)"), 0);
+
+	HeapSnapshot::Options options;
+	options.minRetainedSize = 0;
+	HeapSnapshot snapshot = HeapSnapshot::capture(state.getState(), options);
+	EXPECT_EQ(state.getStackSize(), 0);
+	EXPECT_GT(snapshot.getObjectCount(), 2000u);
+	EXPECT_GT(snapshot.getTotalSize(), 0u);
+	EXPECT_LT(snapshot.getTotalSize(), snapshot.getHeapSize()); //prototypes and internal strings are missing
+
+	const HeapSnapshot::Entry* entries = snapshot.find("_G.cache.entries");
+	ASSERT_NE(entries, nullptr);
+	EXPECT_EQ(entries->type, "table");
+	EXPECT_EQ(entries->retainedObjects, 2u + 1000u * 2u); //the table, its key "name" and the table and string of each entry
+	EXPECT_GT(entries->retainedSize, 1000u * 100u);
+	EXPECT_GT(snapshot.find("_G.cache")->retainedSize, entries->retainedSize);
+	EXPECT_EQ(snapshot.getEntries().front().path, "_G");
+
+	//objects referenced twice are retained by the common dominator only
+	const HeapSnapshot::Entry* shared = snapshot.find("_G.first.shared");
+	EXPECT_NE(shared == nullptr, snapshot.find("_G.second.shared") == nullptr); //named by the first path found
+	EXPECT_EQ(snapshot.find("_G.first")->retainedSize, snapshot.find("_G.first")->shallowSize);
+	EXPECT_EQ(snapshot.find("_G.second")->retainedSize, snapshot.find("_G.second")->shallowSize);
+
+	const HeapSnapshot::Entry* hidden = snapshot.find("_G.getHidden(upvalue hidden)");
+	ASSERT_NE(hidden, nullptr);
+	EXPECT_EQ(hidden->retainedSize, 5000u + 25u);
+	EXPECT_GE(snapshot.find("_G.getHidden")->retainedSize, 5000u);
+	EXPECT_GE(snapshot.find("_G.worker")->retainedSize, 3000u);
+}
+
+TEST(HeapSnapshotTest, diffSnapshots) {
+	State state(State::LibBase | State::LibString);
+	ASSERT_EQ(state.loadAndExecuteScript("sessions = {} config = {name = 'test'}"), 0);
+	HeapSnapshot::Options options;
+	options.minRetainedSize = 0;
+	const HeapSnapshot before = HeapSnapshot::capture(state.getState(), options);
+	ASSERT_EQ(state.loadAndExecuteScript("for i = 1, 500 do sessions[i] = {id = i, data = string.rep('s', 64) .. i} end"), 0);
+	const HeapSnapshot after = HeapSnapshot::capture(state.getState(), options);
+
+	const auto path = std::filesystem::temp_directory_path() / "luacpp_heap.snapshot";
+	ASSERT_TRUE(before.write(path));
+	HeapSnapshot loaded;
+	ASSERT_TRUE(loaded.read(path));
+	std::filesystem::remove(path);
+	EXPECT_EQ(loaded.getObjectCount(), before.getObjectCount());
+	EXPECT_EQ(loaded.getTotalSize(), before.getTotalSize());
+	ASSERT_EQ(loaded.getEntries().size(), before.getEntries().size());
+	EXPECT_EQ(loaded.getEntries().back().path, before.getEntries().back().path);
+
+	std::vector<HeapSnapshot::Change> changes = HeapSnapshot::diff(loaded, after);
+	ASSERT_GE(changes.size(), 2u);
+	EXPECT_EQ(changes[0].path, "_G");
+	EXPECT_EQ(changes[1].path, "_G.sessions");
+	EXPECT_EQ(changes[0].getGrowth(), changes[1].getGrowth());
+	EXPECT_GT(changes[1].getGrowth(), 500 * 64);
+	for (const HeapSnapshot::Change& change : changes) {
+		EXPECT_NE(change.path, "_G.config");
+	}
+	EXPECT_FALSE(loaded.read("missing.snapshot"));
+}
+
+} // namespace Lua
\ No newline at end of file
@@ -0,0 +1,139 @@
+#include <gtest/gtest.h>
+#include <string>
+
+#ifdef USE_CPP20_MODULES
+import luacpp.State;
+import luacpp.Json;
+#else
+#include <luacpp/State.hpp>
+#include <luacpp/Json.hpp>
+#endif
+
+namespace Lua {
+
+class JsonTest : public ::testing::Test {
+protected:
+	JsonTest() : m_state(State::LibBase | State::LibString | State::LibTable | State::LibMath) {
+		Json::openLibrary(m_state.getState());
+	}
+
+	std::string roundTrip(const char* text) {
+		std::string error;
+		std::string out;
+		if (!Json::decode(m_state.getState(), text, error)) {
+			return "decode error: " + error;
+		}
+		if (!Json::encode(m_state.getState(), -1, out, error)) {
+			out = "encode error: " + error;
+		}
+		m_state.popStack(1);
+		return out;
+	}
+
+	State m_state;
+};
+
+TEST_F(JsonTest, decode) {
+	const char* src = R"(
+		local value = json.decode('{"name": "luacpp", "list": [1, 2.5, -3e2, true, false, null], "nested": {"a": {"b": []}}}')
+		name = value.name
+		count = #value.list
+		integer = math.type(value.list[1])
+		float = value.list[2]
+		exponent = value.list[3]
+		flag = value.list[4]
+		isNull = value.list[6] == json.null
+		emptyArray = #value.nested.a.b
+		escaped = json.decode('"a\\"b\\\\c\\n\\u00e4\\ud83d\\ude00"')
+		ok, err = pcall(json.decode, '{"a": [1, 2,]}')
+	)";
+
+	ASSERT_EQ(m_state.loadAndExecuteScript(src), 0);
+	EXPECT_EQ(m_state.readVariable<std::string>("name"), "luacpp");
+	EXPECT_EQ(m_state.readVariable<int>("count"), 6);
+	EXPECT_EQ(m_state.readVariable<std::string>("integer"), "integer");
+	EXPECT_DOUBLE_EQ(m_state.readVariable<double>("float"), 2.5);
+	EXPECT_DOUBLE_EQ(m_state.readVariable<double>("exponent"), -300.0);
+	EXPECT_TRUE(m_state.readVariable<bool>("flag"));
+	EXPECT_TRUE(m_state.readVariable<bool>("isNull"));
+	EXPECT_EQ(m_state.readVariable<int>("emptyArray"), 0);
+	EXPECT_EQ(m_state.readVariable<std::string>("escaped"), "a\"b\\c\n\xC3\xA4\xF0\x9F\x98\x80");
+	EXPECT_FALSE(m_state.readVariable<bool>("ok"));
+	EXPECT_NE(m_state.readVariable<std::string>("err").find("offset 12"), std::string::npos);
+	EXPECT_EQ(m_state.getStackSize(), 0);
+}
+
+TEST_F(JsonTest, largeContainers) {
+	//more elements than fit on the stack at once
+	std::string array = "[";
+	std::string object = "{";
+	for (int i = 1; i <= 5000; ++i) {
+		array += (i > 1 ? "," : "") + std::to_string(i);
+		object += (i > 1 ? ",\"k" : "\"k") + std::to_string(i) + "\":" + std::to_string(i);
+	}
+	array += "]";
+	object += ",\"k1\":0}"; //duplicate keys: the last one wins
+
+	std::string error;
+	ASSERT_TRUE(Json::decode(m_state.getState(), array, error));
+	m_state.setGlobalFromStack("array");
+	ASSERT_TRUE(Json::decode(m_state.getState(), object, error));
+	m_state.setGlobalFromStack("object");
+	ASSERT_EQ(m_state.loadAndExecuteScript("length = #array last = array[5000] k1 = object.k1 k5000 = object.k5000"), 0);
+	EXPECT_EQ(m_state.readVariable<int>("length"), 5000);
+	EXPECT_EQ(m_state.readVariable<int>("last"), 5000);
+	EXPECT_EQ(m_state.readVariable<int>("k1"), 0);
+	EXPECT_EQ(m_state.readVariable<int>("k5000"), 5000);
+}
+
+TEST_F(JsonTest, invalidInput) {
+	const char* inputs[] = {"", "[1 2]", "{\"a\" 1}", "[01]", "\"abc", "\"\\x\"", "nul", "[1]x", "{1: 2}", "\"\\ud800\"", "1."};
+	for (const char* input : inputs) {
+		std::string error;
+		EXPECT_FALSE(Json::decode(m_state.getState(), input, error)) << input;
+		EXPECT_FALSE(error.empty());
+		EXPECT_EQ(m_state.getStackSize(), 0);
+	}
+
+	std::string error;
+	Json::DecodeOptions options;
+	options.maxDepth = 3;
+	EXPECT_TRUE(Json::decode(m_state.getState(), "[[[1]]]", error, options));
+	m_state.popStack(1);
+	EXPECT_FALSE(Json::decode(m_state.getState(), "[[[[1]]]]", error, options));
+}
+
+TEST_F(JsonTest, encode) {
+	EXPECT_EQ(roundTrip(R"({"a":[1,2.5,"x\"y\n\u0001"],"b":null,"c":{}})").size(), 44u);
+	EXPECT_EQ(roundTrip("[1,2,3]"), "[1,2,3]");
+	EXPECT_EQ(roundTrip("[0.1,1e+300,-5]"), "[0.1,1e+300,-5]");
+	EXPECT_EQ(roundTrip("\"\\u00e4\\t\""), "\"\xC3\xA4\\t\"");
+	EXPECT_EQ(roundTrip("[]"), "{}");
+
+	const char* src = R"(
+		sparse = json.encode({[1] = "a", [3] = "c"})
+		length = json.encode({[1] = "a", [2] = "b", x = 1}, {arrays = "length"})
+		never = json.encode({10}, {arrays = "never"})
+		empty = json.encode({}, {emptyArray = true})
+		precision = json.encode(math.pi, {precision = 3})
+		local t = {}
+		t.self = t
+		ok, err = pcall(json.encode, t)
+		cycle = json.encode(t, {cycles = "null"})
+		fn = pcall(json.encode, {print})
+	)";
+	ASSERT_EQ(m_state.loadAndExecuteScript(src), 0);
+	EXPECT_TRUE(m_state.readVariable<std::string>("sparse") == R"({"1":"a","3":"c"})"
+		|| m_state.readVariable<std::string>("sparse") == R"({"3":"c","1":"a"})");
+	EXPECT_EQ(m_state.readVariable<std::string>("length"), R"(["a","b"])");
+	EXPECT_EQ(m_state.readVariable<std::string>("never"), R"({"1":10})");
+	EXPECT_EQ(m_state.readVariable<std::string>("empty"), "[]");
+	EXPECT_EQ(m_state.readVariable<std::string>("precision"), "3.14");
+	EXPECT_FALSE(m_state.readVariable<bool>("ok"));
+	EXPECT_NE(m_state.readVariable<std::string>("err").find("cyclic"), std::string::npos);
+	EXPECT_EQ(m_state.readVariable<std::string>("cycle"), R"({"self":null})");
+	EXPECT_FALSE(m_state.readVariable<bool>("fn"));
+	EXPECT_EQ(m_state.getStackSize(), 0);
+}
+
+} // namespace Lua
\ No newline at end of file
@@ -0,0 +1,125 @@
+#include <gtest/gtest.h>
+#include <string>
+
+#ifdef USE_CPP20_MODULES
+import luacpp.State;
+import luacpp.Memoizer;
+#else
+#include <luacpp/State.hpp>
+#include <luacpp/Memoizer.hpp>
+#endif
+
+namespace Lua {
+
+class MemoizerTest : public ::testing::Test {
+protected:
+	MemoizerTest() : m_state(State::LibBase | State::LibString) {
+		m_state.loadAndExecuteScript(R"(
+			calls = 0
+			factor = 2
+			function tariff(zone, weight, express)
+				calls = calls + 1
+				local price = weight * factor
+				if express then price = price + 10 end
+				return zone .. ":" .. price
+			end
+			function add(a, b)
+				calls = calls + 1
+				return a + b
+			end
+			function fail() error("no tariff") end
+		)");
+	}
+
+	int calls() { return m_state.readVariable<int>("calls"); }
+
+	State m_state;
+};
+
+TEST_F(MemoizerTest, cachedResults) {
+	Memoizer memoizer(m_state);
+	std::string price;
+	for (int i = 0; i < 10; ++i) {
+		ASSERT_EQ(memoizer.call(price, "tariff", "north", 5, false), 0);
+		EXPECT_EQ(price, "north:10");
+	}
+	ASSERT_EQ(memoizer.call(price, "tariff", "north", 5, true), 0);
+	EXPECT_EQ(price, "north:20");
+	ASSERT_EQ(memoizer.call(price, "tariff", std::string("south"), 5.5, true), 0);
+	EXPECT_EQ(price, "south:21.0");
+	EXPECT_EQ(calls(), 3);
+
+	//the result type is part of the key
+	int sum = 0;
+	double exact = 0.0;
+	ASSERT_EQ(memoizer.call(sum, "add", 1, 2), 0);
+	ASSERT_EQ(memoizer.call(exact, "add", 1, 2), 0);
+	ASSERT_EQ(memoizer.call(sum, "add", 1, 2), 0);
+	EXPECT_EQ(sum, 3);
+	EXPECT_DOUBLE_EQ(exact, 3.0);
+	EXPECT_EQ(calls(), 5);
+	EXPECT_EQ(m_state.getStackSize(), 0);
+
+	Memoizer::Statistics statistics = memoizer.getStatistics();
+	EXPECT_EQ(statistics.hits, 10u);
+	EXPECT_EQ(statistics.misses, 5u);
+	EXPECT_EQ(statistics.size, 5u);
+	EXPECT_NEAR(statistics.getHitRate(), 10.0 / 15.0, 1e-9);
+}
+
+TEST_F(MemoizerTest, evictLeastRecentlyUsed) {
+	Memoizer memoizer(m_state, 2);
+	int sum = 0;
+	memoizer.call(sum, "add", 1, 1);
+	memoizer.call(sum, "add", 2, 2);
+	memoizer.call(sum, "add", 1, 1); //1 + 1 is now the most recently used
+	memoizer.call(sum, "add", 3, 3);
+	EXPECT_EQ(calls(), 3);
+	memoizer.call(sum, "add", 1, 1);
+	EXPECT_EQ(calls(), 3);
+	memoizer.call(sum, "add", 2, 2);
+	EXPECT_EQ(calls(), 4);
+	EXPECT_EQ(sum, 4);
+	EXPECT_EQ(memoizer.getStatistics().evictions, 2u);
+	EXPECT_EQ(memoizer.getStatistics().size, 2u);
+
+	memoizer.setCapacity(1);
+	EXPECT_EQ(memoizer.getStatistics().size, 1u);
+	memoizer.call(sum, "add", 2, 2);
+	EXPECT_EQ(calls(), 4);
+}
+
+TEST_F(MemoizerTest, invalidation) {
+	Memoizer memoizer(m_state);
+	std::string price;
+	memoizer.call(price, "tariff", "north", 5, false);
+	m_state.writeVariable("factor", 3);
+	memoizer.call(price, "tariff", "north", 5, false);
+	EXPECT_EQ(price, "north:10");
+
+	memoizer.invalidate();
+	EXPECT_EQ(memoizer.getEpoch(), 1u);
+	memoizer.call(price, "tariff", "north", 5, false);
+	EXPECT_EQ(price, "north:15");
+	EXPECT_EQ(calls(), 2);
+
+	//reloading the script replaces the function
+	m_state.loadAndExecuteScript("function tariff(zone, weight) calls = calls + 1 return zone .. '=' .. weight end");
+	memoizer.call(price, "tariff", "north", 5, false);
+	EXPECT_EQ(price, "north=5");
+	EXPECT_EQ(calls(), 3);
+	EXPECT_EQ(memoizer.getStatistics().reloads, 1u);
+}
+
+TEST_F(MemoizerTest, errorsAreNotCached) {
+	Memoizer memoizer(m_state);
+	int result = 0;
+	EXPECT_NE(memoizer.call(result, "fail"), 0);
+	EXPECT_NE(memoizer.getLastError().find("no tariff"), std::string::npos);
+	EXPECT_NE(memoizer.call(result, "missing", 1), 0);
+	EXPECT_NE(memoizer.getLastError().find("global 'missing'"), std::string::npos);
+	EXPECT_EQ(memoizer.getStatistics().size, 0u);
+	EXPECT_EQ(m_state.getStackSize(), 0);
+}
+
+} // namespace Lua
\ No newline at end of file
@@ -0,0 +1,85 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#ifdef USE_CPP20_MODULES
+import luacpp.State;
+import luacpp.Metrics;
+#else
+#include <luacpp/State.hpp>
+#include <luacpp/Metrics.hpp>
+#endif
+
+namespace Lua {
+
+TEST(MetricsTest, countCallsAndErrors) {
+	State state(State::LibBase);
+	std::shared_ptr<Metrics> metrics = state.enableMetrics();
+	EXPECT_EQ(state.enableMetrics(), metrics);
+
+	ASSERT_EQ(state.loadAndExecuteScript("function add(a, b) return a + b end"), 0);
+	ASSERT_EQ(state.loadScript("broken", "x = = 1"), 3);
+	ASSERT_EQ(state.loadScript("script", "y = 1"), 0);
+	ASSERT_EQ(state.executeScript("script"), 0);
+	int sum = 0;
+	ASSERT_EQ(state.executeFunctionAndReadReturnVal(sum, "add", 1, 2), 0);
+	EXPECT_NE(state.executeFunction("add", 1), 0);
+	EXPECT_NE(state.executeFunction("missing"), 0);
+	EXPECT_EQ(state.getStackSize(), 0);
+
+	state.registerMethod("method", [](State&) { return 0; });
+	ASSERT_EQ(state.loadAndExecuteScript("for i = 1, 10 do method() end"), 0);
+	state.getGarbageCollector().step();
+
+	Metrics::Snapshot snapshot = metrics->getSnapshot();
+	EXPECT_EQ(snapshot.scriptLoads, 4u);
+	EXPECT_GT(snapshot.compileTime.count(), 0);
+	EXPECT_EQ(snapshot.calls, 6u);
+	EXPECT_EQ(snapshot.errors[2], 2u); //runtime
+	EXPECT_EQ(snapshot.errors[3], 1u); //syntax
+	EXPECT_EQ(snapshot.getErrorCount(), 3u);
+	EXPECT_EQ(snapshot.errorListSize, 3u);
+	EXPECT_EQ(snapshot.nativeCalls, 10u);
+	EXPECT_EQ(snapshot.gcSteps, 1u);
+	EXPECT_GT(snapshot.heapBytes, 0u);
+
+	state.clearErrorList();
+	EXPECT_EQ(metrics->getSnapshot().errorListSize, 0u);
+	metrics->reset();
+	EXPECT_EQ(metrics->getSnapshot().calls, 0u);
+}
+
+TEST(MetricsTest, exportPrometheus) {
+	MetricsExporter exporter;
+	auto first = std::make_unique<State>(State::LibBase);
+	State second(State::LibBase);
+	exporter.add("first", first->enableMetrics());
+	exporter.add("second \"b\"", second.enableMetrics());
+	first->loadAndExecuteScript("error('failed')");
+	second.loadAndExecuteScript("x = 1");
+
+	std::string text = exporter.toPrometheus();
+	EXPECT_NE(text.find("# TYPE luacpp_calls_total counter\n"), std::string::npos);
+	EXPECT_NE(text.find("luacpp_calls_total{state=\"first\"} 1\n"), std::string::npos);
+	EXPECT_NE(text.find("luacpp_errors_total{state=\"first\",code=\"runtime\"} 1\n"), std::string::npos);
+	EXPECT_NE(text.find("luacpp_errors_total{state=\"second \\\"b\\\"\",code=\"runtime\"} 0\n"), std::string::npos);
+	EXPECT_NE(text.find("# TYPE luacpp_heap_bytes gauge\n"), std::string::npos);
+
+	//metrics of destroyed states are dropped
+	first.reset();
+	text = exporter.toPrometheus();
+	EXPECT_EQ(text.find("state=\"first\""), std::string::npos);
+	EXPECT_NE(text.find("state=\"second"), std::string::npos);
+
+	const auto path = std::filesystem::temp_directory_path() / "luacpp_metrics.prom";
+	ASSERT_TRUE(exporter.writePrometheus(path));
+	std::ifstream file(path);
+	std::stringstream content;
+	content << file.rdbuf();
+	EXPECT_EQ(content.str(), text);
+	std::filesystem::remove(path);
+}
+
+} // namespace Lua
\ No newline at end of file
@@ -0,0 +1,212 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#ifdef USE_CPP20_MODULES
+import luacpp.State;
+import luacpp.NumArray;
+#else
+#include <luacpp/State.hpp>
+#include <luacpp/NumArray.hpp>
+#endif
+
+namespace Lua {
+
+class NumArrayTest : public ::testing::TestWithParam<bool> {
+protected:
+	void SetUp() override {
+		NumArray::setSimdEnabled(GetParam());
+	}
+
+	void TearDown() override {
+		NumArray::setSimdEnabled(true);
+	}
+
+	template <typename T>
+	static std::shared_ptr<NumArray> createRange(size_t size, T offset = 0) {
+		std::vector<T> values(size);
+		for (size_t i = 0; i < size; ++i) {
+			values[i] = static_cast<T>(i) + offset;
+		}
+		return NumArray::create(values.data(), values.size());
+	}
+};
+
+TEST_P(NumArrayTest, reductions) {
+	//odd sizes cover the remainder loops of the SIMD kernels
+	for (size_t size : {1, 3, 17, 1001}) {
+		auto f64 = createRange<double>(size, 1.0);
+		auto f32 = createRange<float>(size, 1.0f);
+		auto i64 = createRange<int64_t>(size, 1);
+		const double expected = static_cast<double>(size * (size + 1) / 2);
+		EXPECT_DOUBLE_EQ(f64->sum(), expected);
+		EXPECT_DOUBLE_EQ(f32->sum(), expected);
+		EXPECT_DOUBLE_EQ(i64->sum(), expected);
+		EXPECT_DOUBLE_EQ(f64->min(), 1.0);
+		EXPECT_DOUBLE_EQ(f32->max(), static_cast<double>(size));
+		EXPECT_DOUBLE_EQ(i64->max(), static_cast<double>(size));
+		EXPECT_DOUBLE_EQ(f64->dot(*f64), static_cast<double>(size * (size + 1) * (2 * size + 1) / 6));
+		EXPECT_DOUBLE_EQ(f32->dot(*f32), static_cast<double>(size * (size + 1) * (2 * size + 1) / 6));
+	}
+	EXPECT_TRUE(std::isnan(NumArray(NumArray::ElementType::Float64, 0).min()));
+}
+
+TEST_P(NumArrayTest, elementwise) {
+	auto a = createRange<double>(37);
+	auto b = createRange<double>(37, 1.0);
+	a->axpy(2.0, *b); //a[i] = i + 2 * (i + 1)
+	EXPECT_DOUBLE_EQ(a->get(10), 32.0);
+	a->apply(NumArray::Operation::Subtract, *b);
+	a->scale(0.5);
+	a->apply(NumArray::Operation::Add, 1.0);
+	EXPECT_DOUBLE_EQ(a->get(36), 37.5);
+
+	auto f = createRange<float>(37);
+	f->apply(NumArray::Operation::Divide, 4.0);
+	EXPECT_FLOAT_EQ(f->get(36), 9.0f);
+
+	auto i = createRange<int64_t>(37, -18);
+	i->apply(NumArray::Operation::Divide, 4.0);
+	EXPECT_EQ(i->data<int64_t>()[0], -5); //floor division like lua
+	EXPECT_EQ(i->data<int64_t>()[36], 4);
+	EXPECT_THROW(i->apply(NumArray::Operation::Divide, 0.0), std::domain_error);
+	const int64_t divisors[] = {2, 2, 0};
+	auto j = createRange<int64_t>(3, 10);
+	EXPECT_THROW(j->apply(NumArray::Operation::Divide, *NumArray::create(divisors, 3)), std::domain_error);
+	EXPECT_EQ(j->data<int64_t>()[0], 10); //unchanged
+	EXPECT_THROW(a->apply(NumArray::Operation::Add, *f), std::invalid_argument);
+	EXPECT_THROW(f->data<double>(), std::invalid_argument);
+}
+
+TEST_P(NumArrayTest, compare) {
+	auto a = createRange<float>(21);
+	auto mask = a->compare(NumArray::Comparison::GreaterEqual, 10.0);
+	ASSERT_EQ(mask->getType(), NumArray::ElementType::Int64);
+	EXPECT_DOUBLE_EQ(mask->sum(), 11.0);
+	EXPECT_EQ(mask->data<int64_t>()[9], 0);
+	EXPECT_EQ(mask->data<int64_t>()[10], 1);
+
+	auto b = createRange<double>(21);
+	auto c = b->copy();
+	c->set(5, std::nan(""));
+	EXPECT_DOUBLE_EQ(b->compare(NumArray::Comparison::Equal, *c)->sum(), 20.0);
+	EXPECT_DOUBLE_EQ(b->compare(NumArray::Comparison::NotEqual, *c)->sum(), 1.0);
+	EXPECT_DOUBLE_EQ(b->compare(NumArray::Comparison::Less, 3.0)->sum(), 3.0);
+}
+
+TEST_P(NumArrayTest, accessFromLua) {
+	const char* src = R"(
+		local a = numarray.new(1000)
+		for i = 1, #a do
+			a[i] = i
+		end
+		sum = a:sum()
+		mean = a:mean()
+		min, max = a:min(), a:max()
+		local b = numarray.from({1, 2, 3}, "i64")
+		intSum = b:sum()
+		intType = math.type(b[1])
+		bType = b:type()
+		outside = b[4] == nil
+		chained = b:copy():mul(10):add(b):totable()[3]
+		local mask = a:gt(500)
+		count = mask:sum()
+		dot = numarray.from({1, 2}):dot(numarray.from({3, 4}))
+		local y = numarray.new(4, "f32"):fill(1)
+		y:axpy(2, numarray.from({1, 2, 3, 4}, "f32"))
+		axpy = y[4]
+		divOk = pcall(function() b:div(0) end)
+		mixedOk = pcall(function() a:add(b) end)
+		rangeOk = pcall(function() b[4] = 1 end)
+	)";
+
+	State state(State::LibBase | State::LibMath);
+	NumArray::openLibrary(state.getState());
+	ASSERT_EQ(state.loadAndExecuteScript(src), 0);
+	EXPECT_DOUBLE_EQ(state.readVariable<double>("sum"), 500500.0);
+	EXPECT_DOUBLE_EQ(state.readVariable<double>("mean"), 500.5);
+	EXPECT_DOUBLE_EQ(state.readVariable<double>("min"), 1.0);
+	EXPECT_DOUBLE_EQ(state.readVariable<double>("max"), 1000.0);
+	EXPECT_EQ(state.readVariable<int>("intSum"), 6);
+	EXPECT_EQ(state.readVariable<std::string>("intType"), "integer");
+	EXPECT_EQ(state.readVariable<std::string>("bType"), "i64");
+	EXPECT_TRUE(state.readVariable<bool>("outside"));
+	EXPECT_EQ(state.readVariable<int>("chained"), 33);
+	EXPECT_EQ(state.readVariable<int>("count"), 500);
+	EXPECT_DOUBLE_EQ(state.readVariable<double>("dot"), 11.0);
+	EXPECT_DOUBLE_EQ(state.readVariable<double>("axpy"), 9.0);
+	EXPECT_FALSE(state.readVariable<bool>("divOk"));
+	EXPECT_FALSE(state.readVariable<bool>("mixedOk"));
+	EXPECT_FALSE(state.readVariable<bool>("rangeOk"));
+	EXPECT_EQ(state.getStackSize(), 0);
+}
+
+TEST_P(NumArrayTest, limitsFromLua) {
+	const char* src = R"(
+		hugeOk, hugeError = pcall(numarray.new, 1 << 60, "f64")
+		local big = numarray.from({1, 2}, "i64")
+		big:add(9007199254740993)
+		added = big[1]
+		big:scale(3)
+		scaled = big[2] == 27021597764222985
+		local y = numarray.new(1, "i64")
+		y:axpy(9007199254740993, numarray.from({1}, "i64"))
+		axpy = y[1]
+		local near = numarray.from({9007199254740992, 9007199254740993}, "i64")
+		equal = near:eq(9007199254740993)
+		less = near:lt(9007199254740993):sum()
+		equalFloat = near:eq(2.0^53)
+		local dividends = numarray.from({10, 20, 30}, "i64")
+		divideOk = pcall(dividends.div, dividends, numarray.from({1, 2, 0}, "i64"))
+		divided = dividends[2]
+	)";
+
+	State state(State::LibBase);
+	NumArray::openLibrary(state.getState());
+	ASSERT_EQ(state.loadAndExecuteScript(src), 0);
+	EXPECT_FALSE(state.readVariable<bool>("hugeOk"));
+	EXPECT_NE(state.readVariable<std::string>("hugeError").find("not enough memory"), std::string::npos);
+	EXPECT_EQ(state.readVariable<int64_t>("added"), 9007199254740994);
+	EXPECT_TRUE(state.readVariable<bool>("scaled"));
+	EXPECT_EQ(state.readVariable<int64_t>("axpy"), 9007199254740993);
+	EXPECT_EQ(state.readVariable<int>("less"), 1);
+	EXPECT_FALSE(state.readVariable<bool>("divideOk"));
+	EXPECT_EQ(state.readVariable<int>("divided"), 20);
+	const auto mask = [&state](const char* name) {
+		state.pushGlobalToStack(name);
+		std::shared_ptr<NumArray> array = NumArray::fromStack(state.getState(), -1);
+		state.popStack(1);
+		return array;
+	};
+	EXPECT_EQ(mask("equal")->data<int64_t>()[0], 0);
+	EXPECT_EQ(mask("equal")->data<int64_t>()[1], 1);
+	EXPECT_EQ(mask("equalFloat")->data<int64_t>()[0], 1);
+	EXPECT_EQ(mask("equalFloat")->data<int64_t>()[1], 0);
+	const int64_t near[] = {9007199254740992, 9007199254740993};
+	EXPECT_EQ(NumArray::create(near, 2)->compare(NumArray::Comparison::Equal, 9007199254740992.0)->data<int64_t>()[1], 0);
+	const int64_t extremes[] = {INT64_MAX, INT64_MIN};
+	EXPECT_EQ(NumArray::create(extremes, 2)->compare(NumArray::Comparison::Less, 9223372036854775808.0)->sum(), 2.0);
+	EXPECT_EQ(NumArray::create(extremes, 2)->compare(NumArray::Comparison::LessEqual, -HUGE_VAL)->sum(), 0.0);
+	EXPECT_THROW(NumArray(NumArray::ElementType::Float64, SIZE_MAX / 4), std::bad_alloc);
+}
+
+TEST_P(NumArrayTest, sharedWithCpp) {
+	auto array = createRange<double>(8);
+	State state(State::LibNone);
+	NumArray::openLibrary(state.getState());
+	NumArray::push(state.getState(), array);
+	state.setGlobalFromStack("data");
+	ASSERT_EQ(state.loadAndExecuteScript("data:scale(2) result = numarray.new(3)"), 0);
+	EXPECT_DOUBLE_EQ(array->data<double>()[7], 14.0); //modified in place
+
+	state.pushGlobalToStack("result");
+	auto result = NumArray::fromStack(state.getState(), -1);
+	state.popStack(1);
+	ASSERT_NE(result, nullptr);
+	EXPECT_EQ(result->size(), 3u);
+}
+
+INSTANTIATE_TEST_SUITE_P(Kernels, NumArrayTest, ::testing::Values(false, true));
+
+} // namespace Lua
\ No newline at end of file
@@ -0,0 +1,104 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <functional>
+#include <string>
+#include <vector>
+
+#ifdef USE_CPP20_MODULES
+import luacpp.State;
+import luacpp.Parallel;
+#else
+#include <luacpp/State.hpp>
+#include <luacpp/Parallel.hpp>
+#endif
+
+namespace Lua {
+
+class ParallelTest : public ::testing::Test {
+protected:
+	ParallelTest() : m_workers([this](State& state) {
+		++m_setups;
+		state.loadAndExecuteScript(R"(
+			function score(x) return x * x + 1 end
+			function label(s) return s:upper() .. "!" end
+			function add(acc, x) return acc + x end
+			function concat(acc, x) return acc .. x end
+			function check(x)
+				if x == 777 then error("invalid record 777") end
+				return x
+			end
+		)");
+	}, options()) {}
+
+	static Workers::Options options() {
+		Workers::Options options;
+		options.libraries = State::LibBase | State::LibString;
+		options.threads = 4;
+		options.chunkSize = 100;
+		return options;
+	}
+
+	std::atomic<int> m_setups{0};
+	Workers m_workers;
+};
+
+TEST_F(ParallelTest, mapInOrder) {
+	std::vector<int> input(10000);
+	for (size_t i = 0; i < input.size(); ++i) {
+		input[i] = static_cast<int>(i);
+	}
+	std::vector<int64_t> scores;
+	ASSERT_EQ(parallelMap(m_workers, "score", input, scores), 0);
+	ASSERT_EQ(scores.size(), input.size());
+	for (size_t i = 0; i < input.size(); ++i) {
+		ASSERT_EQ(scores[i], static_cast<int64_t>(i) * i + 1);
+	}
+	EXPECT_EQ(m_workers.getChunkCount(input.size()), 100u);
+
+	//the states are reused
+	std::vector<std::string> labels;
+	ASSERT_EQ(parallelMap(m_workers, "label", std::vector<std::string>(1000, "north"), labels), 0);
+	EXPECT_EQ(labels.front(), "NORTH!");
+	EXPECT_EQ(labels.back(), "NORTH!");
+	EXPECT_LE(m_setups, 4);
+}
+
+TEST_F(ParallelTest, reduce) {
+	std::vector<double> input(5000);
+	for (size_t i = 0; i < input.size(); ++i) {
+		input[i] = static_cast<double>(i);
+	}
+	double sum = -1.0;
+	ASSERT_EQ(parallelReduce(m_workers, "add", input, 0.0, std::plus<double>(), sum), 0);
+	EXPECT_DOUBLE_EQ(sum, 4999.0 * 5000.0 / 2.0);
+
+	//the partial results are combined in order, each chunk of 100 elements is made of one digit
+	std::vector<int> digits(1000);
+	for (size_t i = 0; i < digits.size(); ++i) {
+		digits[i] = static_cast<int>(i / 100);
+	}
+	std::string text;
+	ASSERT_EQ(parallelReduce(m_workers, "concat", digits, std::string(), std::plus<std::string>(), text), 0);
+	ASSERT_EQ(text.size(), 1000u);
+	for (size_t i = 0; i < text.size(); i += 100) {
+		EXPECT_EQ(text.substr(i, 100), std::string(100, static_cast<char>('0' + i / 100)));
+	}
+}
+
+TEST_F(ParallelTest, errors) {
+	std::vector<int> input(1000);
+	for (size_t i = 0; i < input.size(); ++i) {
+		input[i] = static_cast<int>(i);
+	}
+	std::vector<int> output;
+	EXPECT_NE(parallelMap(m_workers, "check", input, output), 0);
+	EXPECT_NE(m_workers.getLastError().find("invalid record 777"), std::string::npos);
+
+	EXPECT_NE(parallelMap(m_workers, "missing", input, output), 0);
+	EXPECT_EQ(m_workers.getLastError(), "attempt to call a nil value (global 'missing')");
+
+	ASSERT_EQ(parallelMap(m_workers, "score", std::vector<int>(), output), 0);
+	EXPECT_TRUE(output.empty());
+}
+
+} // namespace Lua
\ No newline at end of file
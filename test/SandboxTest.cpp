@@ -0,0 +1,219 @@
+#include <gtest/gtest.h>
+#include <string>
+
+#ifdef USE_CPP20_MODULES
+import luacpp.State;
+import luacpp.Sandbox;
+import luacpp.Registry;
+#else
+#include <luacpp/State.hpp>
+#include <luacpp/Sandbox.hpp>
+#include <luacpp/Registry.hpp>
+#endif
+
+#include <lua/lua.hpp>
+
+namespace Lua {
+
+class SandboxTest : public ::testing::Test {
+protected:
+	SandboxTest() : m_state(State::LibBase | State::LibString | State::LibMath) {
+		Sandbox::share(m_state.getState(), {"string", "math", "tostring", "pairs", "pcall"});
+	}
+
+	State m_state;
+};
+
+TEST_F(SandboxTest, isolatedGlobals) {
+	Sandbox first(m_state.getState());
+	Sandbox second(m_state.getState());
+	ASSERT_EQ(first.loadAndExecuteScript("counter = 1 name = string.upper('first')"), 0);
+	ASSERT_EQ(second.loadAndExecuteScript("counter = (counter or 100) + 1"), 0);
+	EXPECT_EQ(first.readVariable<int>("counter"), 1);
+	EXPECT_EQ(first.readVariable<std::string>("name"), "FIRST");
+	EXPECT_EQ(second.readVariable<int>("counter"), 101);
+
+	//globals of the state outside of the whitelist are invisible, tenant globals don't leak into the state
+	EXPECT_EQ(first.loadAndExecuteScript("hasPrint = print ~= nil"), 0);
+	EXPECT_FALSE(first.readVariable<bool>("hasPrint"));
+	EXPECT_EQ(m_state.loadAndExecuteScript("stateCounter = counter"), 0);
+	m_state.pushGlobalToStack("stateCounter");
+	EXPECT_EQ(m_state.getType(), Type::Nil);
+	m_state.popStack(1);
+	EXPECT_EQ(m_state.getStackSize(), 0);
+}
+
+TEST_F(SandboxTest, readOnlyLibraries) {
+	Sandbox sandbox(m_state.getState());
+	const char* src = R"(
+		modifyOk = pcall(function() string.upper = nil end)
+		local count = 0
+		for _ in pairs(math) do
+			count = count + 1
+		end
+		mathEntries = count
+		string = "replaced" -- shadows the shared library for this tenant only
+	)";
+	ASSERT_EQ(sandbox.loadAndExecuteScript(src), 0);
+	EXPECT_FALSE(sandbox.readVariable<bool>("modifyOk"));
+	EXPECT_GT(sandbox.readVariable<int>("mathEntries"), 10);
+	EXPECT_EQ(sandbox.readVariable<std::string>("string"), "replaced");
+
+	Sandbox other(m_state.getState());
+	ASSERT_EQ(other.loadAndExecuteScript("upper = string.upper('x')"), 0);
+	EXPECT_EQ(other.readVariable<std::string>("upper"), "X");
+
+	EXPECT_NE(sandbox.loadAndExecuteScript("error('tenant failure')"), 0);
+	EXPECT_NE(sandbox.getLastError().find("tenant failure"), std::string::npos);
+	EXPECT_EQ(m_state.getStackSize(), 0);
+}
+
+TEST_F(SandboxTest, nestedReadOnlyTables) {
+	lua_State* L = m_state.getState();
+	ASSERT_EQ(m_state.loadAndExecuteScript("config = {limits = {max = 3}, names = {'a', 'b'}}"), 0);
+	Sandbox::share(L, {"config", "string", "rawset", "pcall", "pairs", "ipairs"});
+	Sandbox tenant(L);
+	const char* src = R"(
+		nestedOk = pcall(function() config.limits.max = 100 end)
+		rawsetOk = pcall(rawset, config, "extra", 1)
+		rawsetNestedOk = pcall(rawset, config.limits, "max", 100)
+		rawsetStringOk = pcall(rawset, string, "upper", "replaced")
+		for key, value in pairs(config) do
+			if key == "limits" then
+				pairsOk = pcall(function() value.max = 100 end)
+			end
+		end
+		max = config.limits.max
+		joined = ""
+		for _, name in ipairs(config.names) do
+			joined = joined .. name
+		end
+		count = #config.names
+	)";
+	ASSERT_EQ(tenant.loadAndExecuteScript(src), 0);
+	EXPECT_FALSE(tenant.readVariable<bool>("nestedOk"));
+	EXPECT_FALSE(tenant.readVariable<bool>("rawsetOk"));
+	EXPECT_FALSE(tenant.readVariable<bool>("rawsetNestedOk"));
+	EXPECT_FALSE(tenant.readVariable<bool>("rawsetStringOk"));
+	EXPECT_FALSE(tenant.readVariable<bool>("pairsOk"));
+	EXPECT_EQ(tenant.readVariable<int>("max"), 3);
+	EXPECT_EQ(tenant.readVariable<std::string>("joined"), "ab");
+	EXPECT_EQ(tenant.readVariable<int>("count"), 2);
+
+	Sandbox other(L);
+	ASSERT_EQ(other.loadAndExecuteScript("max = config.limits.max noExtra = config.extra == nil upper = string.upper('z')"), 0);
+	EXPECT_EQ(other.readVariable<int>("max"), 3);
+	EXPECT_TRUE(other.readVariable<bool>("noExtra"));
+	EXPECT_EQ(other.readVariable<std::string>("upper"), "Z");
+	EXPECT_EQ(m_state.getStackSize(), 0);
+}
+
+TEST_F(SandboxTest, registryScripts) {
+	ASSERT_EQ(m_state.loadScript("increment", "calls = (calls or 0) + 1"), 0);
+	Sandbox first(m_state.getState());
+	Sandbox second(m_state.getState());
+	for (int i = 0; i < 3; ++i) {
+		ASSERT_EQ(first.executeScript("increment"), 0);
+	}
+	ASSERT_EQ(second.executeScript("increment"), 0);
+	EXPECT_EQ(first.readVariable<int>("calls"), 3);
+	EXPECT_EQ(second.readVariable<int>("calls"), 1);
+
+	//the script still runs against the globals of the state outside of sandboxes
+	ASSERT_EQ(m_state.executeScript("increment"), 0);
+	EXPECT_EQ(m_state.readVariable<int>("calls"), 1);
+	EXPECT_NE(first.executeScript("missing"), 0);
+	EXPECT_EQ(m_state.getStackSize(), 0);
+}
+
+TEST_F(SandboxTest, functionsKeepTheirSandbox) {
+	ASSERT_EQ(m_state.loadScript("define", "function grab() return os end function count() calls = (calls or 0) + 1 return calls end"), 0);
+	m_state.writeVariable("os", "GLOBAL");
+	Sandbox first(m_state.getState());
+	Sandbox second(m_state.getState());
+	ASSERT_EQ(first.executeScript("define"), 0);
+	ASSERT_EQ(second.executeScript("define"), 0);
+	ASSERT_EQ(first.loadAndExecuteScript("function first() return count() end"), 0);
+
+	//functions defined by an earlier script keep resolving globals in their own sandbox
+	ASSERT_EQ(first.loadAndExecuteScript("grabbed = tostring(grab()) counted = first() + first()"), 0);
+	EXPECT_EQ(first.readVariable<std::string>("grabbed"), "nil");
+	EXPECT_EQ(first.readVariable<int>("counted"), 3);
+	ASSERT_EQ(second.loadAndExecuteScript("grabbed = tostring(grab()) counted = count()"), 0);
+	EXPECT_EQ(second.readVariable<std::string>("grabbed"), "nil");
+	EXPECT_EQ(second.readVariable<int>("counted"), 1);
+	EXPECT_EQ(m_state.readVariable<std::string>("os"), "GLOBAL");
+
+	//also when called from outside of the sandbox
+	first.pushEnvironment();
+	lua_getfield(m_state.getState(), -1, "count");
+	ASSERT_EQ(lua_pcall(m_state.getState(), 0, 1, 0), LUA_OK);
+	EXPECT_EQ(lua_tointeger(m_state.getState(), -1), 3);
+	lua_pop(m_state.getState(), 2);
+	EXPECT_EQ(first.readVariable<int>("calls"), 3);
+	EXPECT_EQ(m_state.getStackSize(), 0);
+}
+
+TEST_F(SandboxTest, strippedBytecode) {
+	lua_State* L = m_state.getState();
+	lua_State* scratch = luaL_newstate();
+	std::string bytecode;
+	std::string error;
+	ASSERT_EQ(Registry::compile(scratch, "leaked = 42 local x = 1 function g() y = x end", "=stripped", bytecode, error, true), Registry::ErrorCode::Ok);
+	lua_close(scratch);
+	Registry registry(L);
+	ASSERT_EQ(registry.loadBytecode("stripped", bytecode, "=stripped"), Registry::ErrorCode::Ok);
+
+	//the only upvalue of a stripped main chunk is its _ENV
+	Sandbox sandbox(L);
+	ASSERT_EQ(sandbox.executeScript("stripped"), 0);
+	EXPECT_EQ(sandbox.readVariable<int>("leaked"), 42);
+	EXPECT_EQ(lua_getglobal(L, "leaked"), LUA_TNIL);
+	lua_pop(L, 1);
+
+	//the upvalues of other stripped functions are unknown, so they aren't called
+	sandbox.pushEnvironment();
+	lua_getfield(L, -1, "g");
+	lua_remove(L, -2);
+	EXPECT_NE(sandbox.call(0, 0), 0);
+	EXPECT_FALSE(sandbox.getLastError().empty());
+	EXPECT_EQ(sandbox.size(), 2u);
+	EXPECT_EQ(lua_getglobal(L, "y"), LUA_TNIL);
+	lua_pop(L, 1);
+	EXPECT_EQ(m_state.getStackSize(), 0);
+}
+
+TEST_F(SandboxTest, environmentAtLaterUpvalue) {
+	lua_State* L = m_state.getState();
+	ASSERT_EQ(m_state.loadAndExecuteScript("local x = 1 function g() local _ = x z = 5 end"), 0);
+	Sandbox sandbox(L);
+	lua_getglobal(L, "g");
+	ASSERT_EQ(sandbox.call(0, 0), 0);
+	EXPECT_EQ(sandbox.readVariable<int>("z"), 5);
+	EXPECT_EQ(lua_getglobal(L, "z"), LUA_TNIL);
+	lua_pop(L, 1);
+
+	//the function is bound to the globals of the state again
+	ASSERT_EQ(lua_getglobal(L, "g"), LUA_TFUNCTION);
+	ASSERT_EQ(lua_pcall(L, 0, 0, 0), LUA_OK);
+	EXPECT_EQ(m_state.readVariable<int>("z"), 5);
+	EXPECT_EQ(m_state.getStackSize(), 0);
+}
+
+TEST_F(SandboxTest, reset) {
+	Sandbox sandbox(m_state.getState());
+	ASSERT_EQ(sandbox.loadAndExecuteScript("a = 1 b = 'x' c = {} function get() return a end"), 0);
+	EXPECT_EQ(sandbox.size(), 4u);
+	sandbox.reset();
+	EXPECT_EQ(sandbox.size(), 0u);
+	ASSERT_EQ(sandbox.loadAndExecuteScript("isNil = a == nil and get == nil upper = string.upper('y')"), 0);
+	EXPECT_TRUE(sandbox.readVariable<bool>("isNil"));
+	EXPECT_EQ(sandbox.readVariable<std::string>("upper"), "Y");
+
+	sandbox.writeVariable("limit", 5);
+	ASSERT_EQ(sandbox.loadAndExecuteScript("doubled = limit * 2"), 0);
+	EXPECT_EQ(sandbox.readVariable<int>("doubled"), 10);
+	EXPECT_EQ(m_state.getStackSize(), 0);
+}
+
+} // namespace Lua
\ No newline at end of file
@@ -0,0 +1,165 @@
+#include <gtest/gtest.h>
+#include <lua/lua.hpp>
+#include <future>
+#include <string>
+#include <vector>
+
+#ifdef USE_CPP20_MODULES
+import luacpp.State;
+import luacpp.Scheduler;
+#else
+#include <luacpp/State.hpp>
+#include <luacpp/Scheduler.hpp>
+#endif
+
+namespace Lua {
+
+static int delayedSquare(lua_State* state) {
+	const lua_Integer value = luaL_checkinteger(state, 1);
+	return Scheduler::await(state, std::async(std::launch::async, [value]() {
+		return Scheduler::Values{Generic(value * value)};
+	}));
+}
+
+static int failingFuture(lua_State* state) {
+	return Scheduler::await(state, std::async(std::launch::async, []() -> Scheduler::Values {
+		throw 42;
+	}));
+}
+
+class SchedulerTest : public ::testing::Test {
+protected:
+	SchedulerTest() : m_state(State::LibBase | State::LibCoroutine), m_scheduler(m_state.getState()) {
+		m_scheduler.registerFunction("fetch", [this](Scheduler::Values arguments, Scheduler::Completion completion) {
+			m_requests.push_back(arguments.at(0).get<int>());
+			m_completions.push_back(completion);
+		});
+		m_state.registerNativeFunction("square", &delayedSquare);
+	}
+
+	void spawn(const char* function, int argument) {
+		m_state.pushGlobalToStack(function);
+		m_state.pushToStack(argument);
+		ASSERT_EQ(m_scheduler.spawn(1), LUA_YIELD);
+	}
+
+	State m_state;
+	Scheduler m_scheduler;
+	std::vector<int> m_requests;
+	std::vector<Scheduler::Completion> m_completions;
+};
+
+TEST_F(SchedulerTest, manyOutstandingOperations) {
+	m_state.loadAndExecuteScript(R"(
+		total = 0
+		function worker(id)
+			local value, text = fetch(id)
+			total = total + value
+			assert(text == "done")
+		end
+	)");
+	for (int i = 0; i < 1000; ++i) {
+		spawn("worker", i);
+	}
+	EXPECT_EQ(m_scheduler.getCoroutineCount(), 1000u);
+	EXPECT_EQ(m_scheduler.poll(), 0u);
+
+	std::thread completer([this]() {
+		for (size_t i = 0; i < m_completions.size(); ++i) {
+			m_completions[i].resolve({Generic(m_requests[i] * 2), Generic("done")});
+		}
+	});
+	EXPECT_TRUE(m_scheduler.run(std::chrono::seconds(10)));
+	completer.join();
+	EXPECT_EQ(m_scheduler.getCoroutineCount(), 0u);
+	EXPECT_TRUE(m_scheduler.getErrorList().empty());
+	EXPECT_EQ(m_state.readVariable<int>("total"), 999 * 1000);
+}
+
+TEST_F(SchedulerTest, rejectRaisesError) {
+	m_state.loadAndExecuteScript(R"(
+		function worker(id)
+			local ok, message = pcall(fetch, id)
+			result = message
+			fetch(id)
+		end
+	)");
+	spawn("worker", 1);
+	m_completions.back().reject("connection refused");
+	m_scheduler.poll();
+	EXPECT_EQ(m_state.readVariable<std::string>("result"), "connection refused");
+
+	//a completion which is dropped without result rejects the operation
+	m_completions.clear();
+	m_scheduler.poll();
+	EXPECT_EQ(m_scheduler.getCoroutineCount(), 0u);
+	ASSERT_EQ(m_scheduler.getErrorList().size(), 1u);
+	EXPECT_NE(m_scheduler.getErrorList().front().find("abandoned"), std::string::npos);
+}
+
+TEST_F(SchedulerTest, nonStandardExceptions) {
+	m_scheduler.registerFunction("failing", [](Scheduler::Values, Scheduler::Completion) {
+		throw 42;
+	});
+	m_state.registerNativeFunction("failingFuture", &failingFuture);
+	m_state.loadAndExecuteScript(R"(
+		function worker()
+			local ok, message = pcall(failing)
+			first = message
+			ok, message = pcall(failingFuture)
+			second = message
+		end
+	)");
+	spawn("worker", 0);
+	EXPECT_TRUE(m_scheduler.run(std::chrono::seconds(10)));
+	EXPECT_TRUE(m_scheduler.getErrorList().empty());
+	EXPECT_EQ(m_state.readVariable<std::string>("first"), "unknown exception");
+	EXPECT_EQ(m_state.readVariable<std::string>("second"), "unknown exception");
+}
+
+TEST_F(SchedulerTest, awaitFuture) {
+	m_state.loadAndExecuteScript(R"(
+		function worker(value)
+			result = square(value) + square(2)
+		end
+	)");
+	spawn("worker", 12);
+	EXPECT_TRUE(m_scheduler.run(std::chrono::seconds(10)));
+	EXPECT_EQ(m_state.readVariable<int>("result"), 148);
+}
+
+TEST_F(SchedulerTest, outsideOfScheduler) {
+	m_state.loadAndExecuteScript(R"(
+		function direct() return pcall(fetch, 1) end
+		function nested()
+			local co = coroutine.create(function() return fetch(1) end)
+			local ok, message = coroutine.resume(co)
+			result = message
+		end
+		function yielding()
+			coroutine.yield()
+			count = 1
+			coroutine.yield()
+			count = 2
+		end
+	)");
+	ASSERT_EQ(m_state.executeFunction<2>("direct"), 0);
+	EXPECT_FALSE(m_state.getStackValue<bool>(-2));
+	EXPECT_NE(m_state.getStackValue<std::string>(-1).find("coroutines started by the scheduler"), std::string::npos);
+	m_state.popStack(2);
+
+	m_state.pushGlobalToStack("nested");
+	ASSERT_EQ(m_scheduler.spawn(0), 0);
+	EXPECT_NE(m_state.readVariable<std::string>("result").find("coroutines started by the scheduler"), std::string::npos);
+	EXPECT_TRUE(m_requests.empty());
+
+	//coroutines yielding without an operation are resumed by the next poll
+	m_state.pushGlobalToStack("yielding");
+	ASSERT_EQ(m_scheduler.spawn(0), LUA_YIELD);
+	EXPECT_EQ(m_scheduler.poll(), 1u);
+	EXPECT_EQ(m_state.readVariable<int>("count"), 1);
+	EXPECT_TRUE(m_scheduler.run(std::chrono::seconds(1)));
+	EXPECT_EQ(m_state.readVariable<int>("count"), 2);
+}
+
+} // namespace Lua
\ No newline at end of file
@@ -0,0 +1,146 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+
+#ifdef USE_CPP20_MODULES
+import luacpp.State;
+import luacpp.ScriptWatcher;
+#else
+#include <luacpp/State.hpp>
+#include <luacpp/ScriptWatcher.hpp>
+#endif
+
+#include <lua/lua.hpp>
+
+namespace Lua {
+
+class ScriptWatcherTest : public ::testing::Test {
+protected:
+	ScriptWatcherTest() : m_state(State::LibBase) {
+		m_directory = std::filesystem::temp_directory_path() / ("luacpp_watcher_" + std::to_string(reinterpret_cast<uintptr_t>(this)));
+		std::filesystem::create_directories(m_directory);
+	}
+
+	~ScriptWatcherTest() override {
+		std::error_code error;
+		std::filesystem::remove_all(m_directory, error);
+	}
+
+	std::filesystem::path writeFile(const char* name, const std::string& content) {
+		const auto path = m_directory / name;
+		//written to a temporary file and renamed like most editors do
+		const auto temp = m_directory / (std::string(name) + ".tmp");
+		std::ofstream(temp, std::ios::binary | std::ios::trunc) << content;
+		std::filesystem::rename(temp, path);
+		return path;
+	}
+
+	int run(const char* key) {
+		EXPECT_EQ(m_state.executeScript(key), 0);
+		return m_state.readVariable<int>("result");
+	}
+
+	std::filesystem::path m_directory;
+	State m_state;
+};
+
+TEST_F(ScriptWatcherTest, reloadChangedFiles) {
+	ScriptWatcher watcher;
+	ASSERT_EQ(watcher.watch("first", writeFile("first.lua", "result = 1")), Registry::ErrorCode::Ok);
+	ASSERT_EQ(watcher.watch("second", writeFile("second.lua", "result = 2")), Registry::ErrorCode::Ok);
+	EXPECT_EQ(watcher.apply(m_state.getState()), 2u);
+	EXPECT_EQ(watcher.apply(m_state.getState()), 0u);
+	EXPECT_EQ(run("first"), 1);
+	EXPECT_EQ(run("second"), 2);
+
+	//only the changed file is compiled and installed
+	writeFile("second.lua", "result = 20");
+	EXPECT_EQ(watcher.check(), 1u);
+	EXPECT_EQ(watcher.check(), 0u);
+	EXPECT_EQ(watcher.apply(m_state.getState()), 1u);
+	EXPECT_EQ(run("first"), 1);
+	EXPECT_EQ(run("second"), 20);
+	EXPECT_EQ(m_state.getStackSize(), 0);
+}
+
+TEST_F(ScriptWatcherTest, keepOldVersionOnError) {
+	ScriptWatcher watcher;
+	ASSERT_EQ(watcher.watch("script", writeFile("script.lua", "result = 1")), Registry::ErrorCode::Ok);
+	watcher.apply(m_state.getState());
+
+	writeFile("script.lua", "result = = 2");
+	EXPECT_EQ(watcher.check(), 0u);
+	EXPECT_NE(watcher.getError("script").find("script.lua"), std::string::npos);
+	EXPECT_EQ(watcher.apply(m_state.getState()), 0u);
+	EXPECT_EQ(run("script"), 1);
+
+	writeFile("script.lua", "result = 3");
+	EXPECT_EQ(watcher.check(), 1u);
+	EXPECT_TRUE(watcher.getError("script").empty());
+	EXPECT_EQ(watcher.apply(m_state.getState()), 1u);
+	EXPECT_EQ(run("script"), 3);
+
+	EXPECT_EQ(watcher.watch("missing", m_directory / "missing.lua"), Registry::ErrorCode::RuntimeError);
+	EXPECT_FALSE(watcher.getError("missing").empty());
+}
+
+TEST_F(ScriptWatcherTest, loadError) {
+	ScriptWatcher watcher;
+	ASSERT_EQ(watcher.watch("first", writeFile("first.lua", "result = 1")), Registry::ErrorCode::Ok);
+	EXPECT_EQ(watcher.apply(m_state.getState()), 1u);
+	ASSERT_EQ(watcher.watch("second", writeFile("second.lua", "result = 2")), Registry::ErrorCode::Ok);
+
+	//loading the bytecode fails while lua can't allocate new blocks (the key is interned before, it is looked up first)
+	m_state.writeVariable("second", true);
+	struct Allocator {
+		lua_Alloc function;
+		void* data;
+	} original;
+	original.function = lua_getallocf(m_state.getState(), &original.data);
+	lua_setallocf(m_state.getState(), [](void* userData, void* ptr, size_t oldSize, size_t newSize) -> void* {
+		if (newSize > 0 && (ptr == nullptr || newSize > oldSize)) {
+			return nullptr;
+		}
+		const Allocator* allocator = static_cast<const Allocator*>(userData);
+		return allocator->function(allocator->data, ptr, oldSize, newSize);
+	}, &original);
+	EXPECT_EQ(watcher.apply(m_state.getState()), 0u);
+	lua_setallocf(m_state.getState(), original.function, original.data);
+	EXPECT_EQ(m_state.getStackSize(), 0);
+	EXPECT_NE(watcher.getError("second").find("not enough memory"), std::string::npos);
+
+	//the next call retries
+	EXPECT_EQ(watcher.apply(m_state.getState()), 1u);
+	EXPECT_EQ(run("second"), 2);
+	EXPECT_EQ(run("first"), 1);
+}
+
+TEST_F(ScriptWatcherTest, backgroundThread) {
+	for (bool inotify : {true, false}) {
+		ScriptWatcher::Options options;
+		options.useInotify = inotify;
+		options.pollInterval = std::chrono::milliseconds(10);
+		ScriptWatcher watcher(options);
+		ASSERT_EQ(watcher.watch("script", writeFile("script.lua", "result = 1")), Registry::ErrorCode::Ok);
+		watcher.start();
+		EXPECT_TRUE(watcher.isRunning());
+
+		//polling can't tell apart files of the same size written within one tick of the kernel clock
+		const uint64_t version = watcher.getVersion();
+		writeFile("script.lua", inotify ? "result = 2" : "result = 20");
+		const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+		while (watcher.getVersion() == version && std::chrono::steady_clock::now() < deadline) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		watcher.stop();
+		EXPECT_FALSE(watcher.isRunning());
+
+		watcher.apply(m_state.getState());
+		EXPECT_EQ(run("script"), inotify ? 2 : 20);
+	}
+}
+
+} // namespace Lua
\ No newline at end of file
@@ -0,0 +1,161 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef USE_CPP20_MODULES
+import luacpp.State;
+import luacpp.SharedTable;
+#else
+#include <luacpp/State.hpp>
+#include <luacpp/SharedTable.hpp>
+#endif
+
+namespace Lua {
+
+class SharedTableTest : public ::testing::Test {
+protected:
+	static std::shared_ptr<const SharedTable> createTable() {
+		SharedTable::Builder nested;
+		nested.set("name", "nested");
+		nested.set(1, 10);
+
+		SharedTable::Builder builder;
+		for (int i = 1; i <= 100; ++i) {
+			builder.set(i, i * 2);
+		}
+		builder.set("pi", 3.1415);
+		builder.set("name", "reference");
+		builder.set("enabled", true);
+		builder.set(2.5, "float key");
+		builder.set("child", nested.build());
+		return builder.build();
+	}
+};
+
+TEST_F(SharedTableTest, build) {
+	auto table = createTable();
+	EXPECT_EQ(table->size(), 105u);
+	EXPECT_EQ(table->length(), 100u);
+	EXPECT_EQ(table->get(1), Generic(2));
+	EXPECT_EQ(table->get(100), Generic(200));
+	EXPECT_EQ(table->get(1.0), Generic(2)); //float keys with an integer value are normalized
+	EXPECT_EQ(table->get("pi"), Generic(3.1415));
+	EXPECT_EQ(table->get("name"), Generic("reference"));
+	EXPECT_EQ(table->get("enabled"), Generic(true));
+	EXPECT_EQ(table->get(2.5), Generic("float key"));
+	EXPECT_EQ(table->get("missing").getType(), Type::Nil);
+	EXPECT_FALSE(table->contains(101));
+
+	auto child = table->getTable("child");
+	ASSERT_NE(child, nullptr);
+	EXPECT_EQ(child->get("name"), Generic("nested"));
+	EXPECT_EQ(table->getTable("name"), nullptr);
+}
+
+TEST_F(SharedTableTest, overwriteAndRemove) {
+	SharedTable::Builder builder;
+	builder.set("a", 1);
+	builder.set("b", 2);
+	builder.set("a", 3);
+	builder.set("b", Generic());
+	builder.set(1, "x");
+	builder.set(3, "z"); //not part of the sequence since 2 is missing
+	auto table = builder.build();
+
+	EXPECT_EQ(table->size(), 3u);
+	EXPECT_EQ(table->length(), 1u);
+	EXPECT_EQ(table->get("a"), Generic(3));
+	EXPECT_FALSE(table->contains("b"));
+	EXPECT_EQ(table->get(3), Generic("z"));
+}
+
+TEST_F(SharedTableTest, invalidKey) {
+	SharedTable::Builder builder;
+	EXPECT_THROW(builder.set(Generic(), 1), std::invalid_argument);
+}
+
+TEST_F(SharedTableTest, accessFromLua) {
+	const char* src = R"(
+		sum = 0
+		for i = 1, #data do
+			sum = sum + data[i]
+		end
+		count = 0
+		for k, v in pairs(data) do
+			count = count + 1
+		end
+		ipairsCount = 0
+		for i, v in ipairs(data) do
+			ipairsCount = ipairsCount + 1
+		end
+		name = data.name
+		childName = data.child.name
+		pi = data["pi"]
+		missing = data.missing == nil
+		floatKey = data[2.5]
+		ok, err = pcall(function() data.x = 1 end)
+	)";
+
+	State state(State::LibBase);
+	state.writeSharedTable("data", createTable());
+	ASSERT_EQ(state.loadAndExecuteScript(src), 0);
+	EXPECT_EQ(state.readVariable<int>("sum"), 10100);
+	EXPECT_EQ(state.readVariable<int>("count"), 105);
+	EXPECT_EQ(state.readVariable<int>("ipairsCount"), 100);
+	EXPECT_EQ(state.readVariable<std::string>("name"), "reference");
+	EXPECT_EQ(state.readVariable<std::string>("childName"), "nested");
+	EXPECT_DOUBLE_EQ(state.readVariable<double>("pi"), 3.1415);
+	EXPECT_TRUE(state.readVariable<bool>("missing"));
+	EXPECT_EQ(state.readVariable<std::string>("floatKey"), "float key");
+	EXPECT_FALSE(state.readVariable<bool>("ok"));
+	EXPECT_EQ(state.getStackSize(), 0);
+}
+
+TEST_F(SharedTableTest, lifetime) {
+	std::weak_ptr<const SharedTable> weak;
+	{
+		auto table = createTable();
+		weak = table;
+		State state(State::LibNone);
+		state.writeSharedTable("data", table);
+		table.reset();
+		EXPECT_FALSE(weak.expired()); //kept alive by the lua state
+		state.pushGlobalToStack("data");
+		EXPECT_EQ(SharedTable::fromStack(state.getState(), -1), weak.lock());
+		state.popStack(1);
+	}
+	EXPECT_TRUE(weak.expired());
+}
+
+TEST_F(SharedTableTest, multipleStatesAndThreads) {
+	const char* src = R"(
+		sum = 0
+		for round = 1, 50 do
+			for i = 1, #data do
+				sum = sum + data[i]
+			end
+		end
+	)";
+
+	auto table = createTable();
+	std::vector<int> results(4, 0);
+	std::vector<std::thread> threads;
+	for (size_t i = 0; i < results.size(); ++i) {
+		threads.emplace_back([&table, &results, src, i]() {
+			State state(State::LibNone);
+			state.writeSharedTable("data", table);
+			if (state.loadAndExecuteScript(src) == 0) {
+				results[i] = state.readVariable<int>("sum");
+			}
+		});
+	}
+	for (std::thread& thread : threads) {
+		thread.join();
+	}
+	for (int result : results) {
+		EXPECT_EQ(result, 50 * 10100);
+	}
+}
+
+} // namespace Lua
\ No newline at end of file
@@ -0,0 +1,90 @@
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <string>
+
+#ifdef USE_CPP20_MODULES
+import luacpp.State;
+import luacpp.StackGuard;
+#else
+#include <luacpp/State.hpp>
+#include <luacpp/StackGuard.hpp>
+#endif
+
+namespace Lua {
+
+TEST(StackGuardTest, restoreStackSize) {
+	State state(State::LibNone);
+	state.pushToStack(1);
+	{
+		StackGuard guard(state.getState());
+		EXPECT_EQ(guard.getTop(), 1);
+		state.pushToStack(2);
+		state.pushToStack(3);
+	}
+	EXPECT_EQ(state.getStackSize(), 1);
+
+	{
+		StackGuard guard(state.getState());
+		state.pushToStack(2);
+		guard.release();
+	}
+	EXPECT_EQ(state.getStackSize(), 2);
+	state.popStack(2);
+}
+
+TEST(StackGuardTest, balancedErrorPaths) {
+	State state(State::LibBase);
+	ASSERT_EQ(state.loadAndExecuteScript(R"(
+		value = 42
+		function fail() error("broken") end
+		function sum(a, b, c) return a + b + c end
+	)"), 0);
+
+	EXPECT_NE(state.executeFunction<1>("missing"), 0);
+	EXPECT_NE(state.executeFunction<1>("value"), 0);
+	EXPECT_NE(state.executeFunction<2>("fail", 1), 0);
+	int result = 0;
+	EXPECT_NE(state.executeFunctionAndReadReturnVal(result, "fail"), 0);
+	EXPECT_NE(state.executeScript("missing"), 0);
+	EXPECT_FALSE(state.assignMetaTable("missing"));
+	EXPECT_THROW(state.withTableDo("table", [](Table&) { throw std::runtime_error("abort"); }, true), std::runtime_error);
+	EXPECT_EQ(state.getStackSize(), 0);
+
+	const std::vector<std::string>& errors = state.getErrorList();
+	ASSERT_EQ(errors.size(), 4u);
+	EXPECT_EQ(errors[0], "attempt to call a nil value (global 'missing')");
+	EXPECT_EQ(errors[1], "attempt to call a number value (global 'value')");
+	EXPECT_NE(errors[2].find("broken"), std::string::npos);
+	EXPECT_NE(errors[3].find("broken"), std::string::npos);
+
+	//on success exactly the requested results are left on the stack
+	int args[] = { 1, 2, 3 };
+	ASSERT_EQ(state.executeFunctionWithArgsArray<1>("sum", args, 3), 0);
+	EXPECT_EQ(state.getStackSize(), 1);
+	EXPECT_EQ(state.getStackValue<int>(-1), 6);
+	state.popStack(1);
+	ASSERT_EQ(state.executeFunctionWithArgsArrayAndReadReturnVal(result, "sum", args, 3), 0);
+	EXPECT_EQ(result, 6);
+	EXPECT_EQ(state.getStackSize(), 0);
+
+	//all results of the function are left with AllResults
+	ASSERT_EQ(state.loadAndExecuteScript("function three() return 1, 2, 3 end"), 0);
+	ASSERT_EQ(state.executeFunction<State::AllResults>("three"), 0);
+	EXPECT_EQ(state.getStackSize(), 3);
+	state.popStack(3);
+	ASSERT_EQ(state.executeFunctionWithArgsArray<State::AllResults>("sum", args, 3), 0);
+	EXPECT_EQ(state.getStackSize(), 1);
+	state.popStack(1);
+}
+
+#ifdef LUACPP_CHECK_STACK
+TEST(StackGuardTest, detectUnbalancedStack) {
+	State state(State::LibNone);
+	EXPECT_DEATH({
+		StackCheck check(state.getState(), 0, "leak");
+		state.pushToStack(1);
+	}, "leak changed the stack size by 1 instead of 0");
+}
+#endif
+
+} // namespace Lua
\ No newline at end of file
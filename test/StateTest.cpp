@@ -423,6 +423,36 @@ TEST_F(StateTest, metatable) {
 	EXPECT_DOUBLE_EQ(v3y, 22.0);
 }
 
+TEST_F(StateTest, lazyLibraries) {
+	const char* src = R"(
+		upper = ("abc"):upper()
+		sum = "10" + 1
+		root = math.sqrt(16)
+		packed = require("table").pack(1, 2).n
+		sameTable = require("table") == table
+		missing = undefinedGlobal == nil
+	)";
+
+	State eager(State::LibAll);
+	State lazy(State::LibAll, State::LibraryLoading::Lazy);
+	EXPECT_LT(lazy.getGarbageCollector().getMemoryUsage(), eager.getGarbageCollector().getMemoryUsage());
+	EXPECT_EQ(lazy.loadAndExecuteScript("base = rawget(_G, 'print') ~= nil and rawget(_G, 'string') == nil"), 0);
+	EXPECT_TRUE(lazy.readVariable<bool>("base")); //the base library is opened right away
+	EXPECT_EQ(lazy.loadAndExecuteScript(src), 0);
+	EXPECT_EQ(lazy.readVariable<std::string>("upper"), "ABC");
+	EXPECT_EQ(lazy.readVariable<int>("sum"), 11);
+	EXPECT_EQ(lazy.readVariable<double>("root"), 4.0);
+	EXPECT_EQ(lazy.readVariable<int>("packed"), 2);
+	EXPECT_TRUE(lazy.readVariable<bool>("sameTable"));
+	EXPECT_TRUE(lazy.readVariable<bool>("missing"));
+
+	//only the requested libraries are opened
+	State partial(State::LibBase | State::LibMath, State::LibraryLoading::Lazy);
+	EXPECT_EQ(partial.loadAndExecuteScript("x = math.floor(2.5); y = string == nil and io == nil"), 0);
+	EXPECT_EQ(partial.readVariable<int>("x"), 2);
+	EXPECT_TRUE(partial.readVariable<bool>("y"));
+}
+
 TEST_F(StateTest, ctordtor) {
 	constexpr static const char* const MetaTable = "TestObjectMetaTable";
 	const char* src = R"(
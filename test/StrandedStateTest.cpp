@@ -0,0 +1,84 @@
+#include <gtest/gtest.h>
+#include <future>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#ifdef USE_CPP20_MODULES
+import luacpp.StrandedState;
+#else
+#include <luacpp/StrandedState.hpp>
+#endif
+
+namespace Lua {
+
+TEST(StrandedStateTest, executeOnOwnerThread) {
+	StrandedState::Options options;
+	options.libraries = State::LibBase;
+	StrandedState strand(options);
+	EXPECT_FALSE(strand.isOwnerThread());
+
+	auto loaded = strand.submit([](State& state) { return state.loadAndExecuteScript("function square(x) return x * x end"); });
+	auto result = strand.submit([](State& state) {
+		int value = 0;
+		state.executeFunctionAndReadReturnVal(value, "square", 7);
+		return value;
+	});
+	auto owner = strand.submit([&strand](State&) { return strand.isOwnerThread(); });
+	EXPECT_EQ(loaded.get(), 0);
+	EXPECT_EQ(result.get(), 49);
+	EXPECT_TRUE(owner.get());
+
+	auto failed = strand.submit([](State&) -> int { throw std::runtime_error("call failed"); });
+	EXPECT_THROW(failed.get(), std::runtime_error);
+}
+
+TEST(StrandedStateTest, multipleProducers) {
+	constexpr int Threads = 4;
+	constexpr int CallsPerThread = 2000;
+
+	StrandedState::Options options;
+	options.batchSize = 16;
+	StrandedState strand(options);
+	strand.submit([](State& state) { state.writeVariable("counter", 0); }).get();
+
+	std::vector<std::thread> producers;
+	for (int t = 0; t < Threads; ++t) {
+		producers.emplace_back([&strand]() {
+			std::future<void> last;
+			for (int i = 0; i < CallsPerThread; ++i) {
+				last = strand.submit([](State& state) {
+					state.writeVariable("counter", state.readVariable<int>("counter") + 1);
+				});
+			}
+			last.get();
+		});
+	}
+	for (auto& producer : producers) {
+		producer.join();
+	}
+
+	EXPECT_EQ(strand.submit([](State& state) { return state.readVariable<int>("counter"); }).get(), Threads * CallsPerThread);
+	const StrandedState::Statistics statistics = strand.getStatistics();
+	EXPECT_EQ(statistics.submitted, Threads * CallsPerThread + 2u);
+	EXPECT_EQ(statistics.executed, statistics.submitted);
+	EXPECT_EQ(statistics.queueDepth, 0u);
+	EXPECT_GE(statistics.maxQueueDepth, 1u);
+	EXPECT_LE(statistics.batches, statistics.executed);
+	EXPECT_GE(statistics.totalLatency.count(), statistics.maxLatency.count());
+}
+
+TEST(StrandedStateTest, drainOnDestruction) {
+	std::vector<std::future<int>> results;
+	{
+		StrandedState strand;
+		for (int i = 0; i < 100; ++i) {
+			results.push_back(strand.submit([i](State&) { return i; }));
+		}
+	}
+	for (int i = 0; i < 100; ++i) {
+		EXPECT_EQ(results[i].get(), i);
+	}
+}
+
+} // namespace Lua
\ No newline at end of file
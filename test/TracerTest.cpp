@@ -0,0 +1,225 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <thread>
+
+#ifdef USE_CPP20_MODULES
+import luacpp.State;
+import luacpp.Tracer;
+#else
+#include <luacpp/State.hpp>
+#include <luacpp/Tracer.hpp>
+#endif
+
+#include <lua/lua.hpp>
+
+namespace Lua {
+
+namespace {
+
+size_t count(const std::string& text, const std::string& pattern) {
+	size_t result = 0;
+	for (size_t position = text.find(pattern); position != std::string::npos; position = text.find(pattern, position + 1)) {
+		++result;
+	}
+	return result;
+}
+
+/**
+ * @brief the stack of event names at each begin event, e.g. "call/outer/inner" (the events are ordered per thread)
+*/
+std::vector<std::string> nestedNames(const std::string& json) {
+	std::vector<std::string> paths;
+	std::vector<std::string> stack;
+	size_t position = 0;
+	while ((position = json.find("{\"ph\":\"", position)) != std::string::npos) {
+		position += 7;
+		if (json.compare(position, 3, "B\",") == 0) {
+			const size_t begin = json.find("\"name\":\"", position) + 8;
+			const std::string name = json.substr(begin, json.find("\",\"cat\"", begin) - begin);
+			stack.push_back(stack.empty() ? name : stack.back() + "/" + name);
+			paths.push_back(stack.back());
+		} else if (json.compare(position, 3, "E\",") == 0 && !stack.empty()) {
+			stack.pop_back();
+		}
+	}
+	return paths;
+}
+
+} // namespace
+
+TEST(TracerTest, recordStateEvents) {
+	State state(State::LibBase);
+	Tracer::clear();
+	ASSERT_EQ(state.loadAndExecuteScript("x = 1"), 0);
+	EXPECT_EQ(count(Tracer::toChromeJson(), "\"ph\":\"B\""), 0u); //disabled
+
+	Tracer::enable();
+	Tracer::attach(state.getState());
+	state.registerMethod("method", [](State&) { return 0; });
+	ASSERT_EQ(state.loadScript("script", "local function inner() method() end\nfunction outer() inner() end"), 0);
+	ASSERT_EQ(state.executeScript("script"), 0);
+	ASSERT_EQ(state.executeFunction("outer"), 0);
+	EXPECT_NE(state.loadAndExecuteScript("error('failed')"), 0);
+	state.getGarbageCollector().step();
+	{
+		Tracer::Scope scope(Tracer::Category::User, "request \"1\"");
+	}
+	Tracer::detach(state.getState());
+	Tracer::disable();
+	ASSERT_EQ(state.executeFunction("outer"), 0);
+
+	const std::string json = Tracer::toChromeJson();
+	EXPECT_EQ(json.rfind("{\"traceEvents\":[", 0), 0u);
+	EXPECT_EQ(count(json, "\"ph\":\"B\""), count(json, "\"ph\":\"E\""));
+	EXPECT_EQ(count(json, "\"name\":\"call\",\"cat\":\"script\""), 3u);
+	EXPECT_EQ(count(json, "\"name\":\"compile\",\"cat\":\"compile\""), 2u);
+	//loadScript names the chunk after its code
+	EXPECT_EQ(count(json, "\"name\":\"main chunk ([string \\\"local function inner() method() end...\\\"]:0)\""), 1u);
+	EXPECT_EQ(count(json, "\"name\":\"function ([string \\\"local function inner() method() end...\\\"]:2)\""), 1u);
+	EXPECT_EQ(count(json, "\"name\":\"inner ([string \\\"local function inner() method() end...\\\"]:1)\""), 1u);
+	EXPECT_EQ(count(json, "\"name\":\"method\",\"cat\":\"native\""), 2u); //the hook and the registered method
+	EXPECT_EQ(count(json, "\"name\":\"error\",\"cat\":\"native\""), 1u);
+	EXPECT_EQ(count(json, "\"name\":\"step\",\"cat\":\"gc\""), 1u);
+	EXPECT_EQ(count(json, "\"name\":\"request \\\"1\\\"\",\"cat\":\"user\""), 1u);
+
+	Tracer::clear();
+	EXPECT_EQ(count(Tracer::toChromeJson(), "\"ph\":\"B\""), 0u);
+}
+
+TEST(TracerTest, coroutinesAndReusedNames) {
+	State state(State::LibBase | State::LibCoroutine);
+	Tracer::enable();
+	Tracer::attach(state.getState()); //before the coroutine is created, it inherits the hook
+	ASSERT_EQ(state.loadAndExecuteScript(R"(
+		co = coroutine.create(function()
+			local function body()
+				coroutine.yield()
+				coroutine.yield()
+			end
+			body()
+		end)
+		function run() coroutine.resume(co) end
+	)"), 0);
+	Tracer::clear();
+	for (int i = 0; i < 3; ++i) {
+		ASSERT_EQ(state.executeFunction("run"), 0);
+	}
+	Tracer::detach(state.getState());
+
+	//every call of run stays at the top, the events of the coroutine are suspended while it yielded
+	std::vector<std::string> paths = nestedNames(Tracer::toChromeJson());
+	EXPECT_EQ(std::count(paths.begin(), paths.end(), "call"), 3);
+	const std::string resume = "call/function ([string \\\"...\\\"]:9)/resume";
+	const std::string body = resume + "/function ([string \\\"...\\\"]:2)/body ([string \\\"...\\\"]:3)";
+	EXPECT_EQ(std::count(paths.begin(), paths.end(), resume), 3);
+	EXPECT_EQ(std::count(paths.begin(), paths.end(), body), 3); //begun when it is called and when it is resumed
+	EXPECT_EQ(std::count(paths.begin(), paths.end(), body + "/yield"), 4);
+	EXPECT_EQ(paths.size(), 19u);
+	Tracer::clear();
+
+	//names of functions of states which were closed meanwhile, lua's strings are freed and their addresses reused
+	for (int i = 0; i < 8; ++i) {
+		State other(State::LibBase);
+		const std::string name = "f" + std::to_string(i);
+		Tracer::attach(other.getState());
+		ASSERT_EQ(other.loadAndExecuteScript(("function " + name + "() end " + name + "()").c_str()), 0);
+		Tracer::detach(other.getState());
+	}
+	Tracer::disable();
+	const std::string json = Tracer::toChromeJson();
+	for (int i = 0; i < 8; ++i) {
+		const std::string name = "f" + std::to_string(i);
+		const std::string source = "([string \\\"function " + name + "() end " + name + "()\\\"]";
+		EXPECT_EQ(count(json, "\"name\":\"main chunk " + source + ":0)\""), 1u) << name;
+		EXPECT_EQ(count(json, "\"name\":\"" + name + " " + source + ":1)\""), 1u) << name;
+	}
+	Tracer::clear();
+}
+
+TEST(TracerTest, caughtErrors) {
+	State state(State::LibBase);
+	ASSERT_EQ(state.loadAndExecuteScript(R"(
+		local function f() error("failed") end
+		local function g() pcall(f) end
+		local function h() end
+		function top() g() h() end
+	)"), 0);
+	Tracer::enable();
+	Tracer::attach(state.getState());
+	Tracer::clear();
+	for (int i = 0; i < 2; ++i) {
+		ASSERT_EQ(state.executeFunction("top"), 0);
+	}
+	Tracer::detach(state.getState());
+	Tracer::disable();
+
+	//the error unwinds f and error without returns, their events end with the return of pcall
+	const std::string json = Tracer::toChromeJson();
+	EXPECT_EQ(count(json, "\"ph\":\"B\""), count(json, "\"ph\":\"E\""));
+	std::vector<std::string> paths = nestedNames(json);
+	const std::string top = "call/function ([string \\\"...\\\"]:5)";
+	const std::string g = top + "/g ([string \\\"...\\\"]:3)";
+	EXPECT_EQ(std::count(paths.begin(), paths.end(), g + "/pcall/function ([string \\\"...\\\"]:2)/error"), 2);
+	EXPECT_EQ(std::count(paths.begin(), paths.end(), top + "/h ([string \\\"...\\\"]:4)"), 2);
+	EXPECT_EQ(std::count(paths.begin(), paths.end(), "call"), 2);
+	EXPECT_EQ(paths.size(), 14u);
+	Tracer::clear();
+}
+
+TEST(TracerTest, methodErrorsCaughtByScripts) {
+	State state(State::LibBase);
+	state.registerMethod("fail", [](State& current) { return luaL_error(current.getState(), "failed"); });
+	state.registerMethod("succeed", [](State&) { return 0; });
+	ASSERT_EQ(state.loadAndExecuteScript("function run() pcall(fail) succeed() end"), 0);
+	Tracer::enable();
+	Tracer::clear();
+	ASSERT_EQ(state.executeFunction("run"), 0);
+	Tracer::attach(state.getState());
+	ASSERT_EQ(state.executeFunction("run"), 0);
+	Tracer::detach(state.getState());
+	Tracer::disable();
+
+	//without the hook the method is called in protected mode, with the hook its event ends with the return of pcall
+	std::vector<std::string> paths = nestedNames(Tracer::toChromeJson());
+	const std::string run = "call/function ([string \\\"function run() pcall(fail) succeed() end\\\"]:1)";
+	const std::vector<std::string> expected = {
+		"call", "call/method", "call/method",
+		"call", run, run + "/pcall", run + "/pcall/[C]", run + "/pcall/[C]/method", run + "/succeed", run + "/succeed/method"
+	};
+	EXPECT_EQ(paths, expected);
+	Tracer::clear();
+}
+
+TEST(TracerTest, ringBufferPerThread) {
+	Tracer::clear();
+	Tracer::enable(64);
+	auto record = [](size_t events) {
+		for (size_t i = 0; i < events; ++i) {
+			const uint32_t depth = Tracer::begin(Tracer::Category::User, "outer");
+			Tracer::begin(Tracer::Category::User, "inner");
+			Tracer::end(depth); //ends inner as well
+		}
+	};
+	std::thread first(record, 10);
+	std::thread second(record, 1000);
+	std::string json;
+	for (int i = 0; i < 10; ++i) {
+		json = Tracer::toChromeJson(); //concurrently with the writers
+	}
+	first.join();
+	second.join();
+	Tracer::disable();
+	Tracer::enable(); //restore the default capacity for threads created by other tests
+	Tracer::disable();
+
+	json = Tracer::toChromeJson();
+	EXPECT_EQ(count(json, "\"ph\":\"B\""), count(json, "\"ph\":\"E\""));
+	//the second thread keeps its last 64 events, the oldest one is dropped as it might have been overwritten while reading
+	EXPECT_EQ(count(json, "\"name\":\"outer\""), 10u + 15u);
+	EXPECT_EQ(count(json, "\"name\":\"thread_name\""), count(json, "\"args\":{\"name\":\"luacpp thread"));
+	Tracer::clear();
+}
+
+} // namespace Lua
\ No newline at end of file
@@ -0,0 +1,11 @@
+local util = require("util")
+
+local greeting = {}
+
+function greeting.hello(name)
+	return "hello " .. util.strings.upper(name)
+end
+
+greeting.loadedAs = select(2, ...)
+
+return greeting
\ No newline at end of file
@@ -0,0 +1,3 @@
+return {
+	strings = require("util.strings")
+}
\ No newline at end of file
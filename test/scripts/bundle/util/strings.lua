@@ -0,0 +1,11 @@
+local strings = {}
+
+function strings.upper(text)
+	return string.upper(text)
+end
+
+function strings.fail()
+	error("failed in bundle")
+end
+
+return strings
\ No newline at end of file
@@ -0,0 +1,142 @@
+// Build tool of luacpp_embed_scripts (see cmake/EmbedScripts.cmake).
+// Compiles lua modules to bytecode and writes a source file defining a Lua::Bundle with all of them and a header
+// declaring the function which returns it.
+//
+// usage: luacpp_bundler <header> <source> <bundle name> <strip 0|1> <module name>=<file>...
+
+#include <lua/lua.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Module {
+	std::string name;
+	std::string bytecode;
+};
+
+int writeBytecode(lua_State*, const void* data, size_t size, void* userData) {
+	static_cast<std::string*>(userData)->append(static_cast<const char*>(data), size);
+	return 0;
+}
+
+bool compileModule(const std::string& name, const std::string& path, bool strip, std::string& bytecode) {
+	std::ifstream file(path, std::ios::binary);
+	if (!file) {
+		std::cerr << "cannot open " << path << std::endl;
+		return false;
+	}
+	std::ostringstream content;
+	content << file.rdbuf();
+	const std::string src = content.str();
+
+	lua_State* state = luaL_newstate();
+	const std::string chunkName = "=" + name;
+	bool success = luaL_loadbufferx(state, src.data(), src.size(), chunkName.c_str(), "t") == LUA_OK;
+	if (success) {
+		lua_dump(state, writeBytecode, &bytecode, strip ? 1 : 0);
+	} else {
+		std::cerr << path << ": " << lua_tostring(state, -1) << std::endl;
+	}
+	lua_close(state);
+	return success;
+}
+
+bool writeHeader(const std::string& path, const std::string& bundleName) {
+	std::ofstream out(path, std::ios::binary | std::ios::trunc);
+	std::string guard = "LUACPP_BUNDLE_" + bundleName + "_HPP";
+	std::transform(guard.begin(), guard.end(), guard.begin(), [](unsigned char c) { return static_cast<char>(std::toupper(c)); });
+	out << "// generated by luacpp_bundler, do not edit\n"
+		<< "#ifndef " << guard << "\n#define " << guard << "\n\n"
+		<< "#ifdef USE_CPP20_MODULES\nimport luacpp.Bundle;\n#else\n#include <luacpp/Bundle.hpp>\n#endif\n\n"
+		<< "namespace Lua {\nnamespace Bundles {\n\nconst Bundle& " << bundleName << "();\n\n"
+		<< "} // namespace Bundles\n} // namespace Lua\n\n#endif // " << guard << "\n";
+	return static_cast<bool>(out);
+}
+
+bool writeSource(const std::string& path, const std::string& headerPath, const std::string& bundleName, const std::vector<Module>& modules) {
+	std::ofstream out(path, std::ios::binary | std::ios::trunc);
+	const size_t slash = headerPath.find_last_of("/\\");
+	out << "// generated by luacpp_bundler, do not edit\n"
+		<< "#include <luacpp_bundles/" << headerPath.substr(slash == std::string::npos ? 0 : slash + 1) << ">\n\n"
+		<< "namespace {\n\nconst unsigned char data[] = {";
+
+	size_t total = 0;
+	for (const Module& module : modules) {
+		for (unsigned char c : module.bytecode) {
+			out << (total % 24 == 0 ? "\n\t" : "") << static_cast<unsigned int>(c) << ",";
+			++total;
+		}
+	}
+	if (total == 0) {
+		out << "0"; //arrays must not be empty
+	}
+	out << "\n};\n\nconst Lua::Bundle::Module modules[] = {\n";
+
+	size_t offset = 0;
+	for (const Module& module : modules) {
+		out << "\t{\"" << module.name << "\", " << offset << "u, " << module.bytecode.size() << "u},\n";
+		offset += module.bytecode.size();
+	}
+	if (modules.empty()) {
+		out << "\t{\"\", 0u, 0u}\n";
+	}
+	out << "};\n\n} // namespace\n\n"
+		<< "namespace Lua {\nnamespace Bundles {\n\n"
+		<< "const Bundle& " << bundleName << "() {\n"
+		<< "\tstatic const Bundle bundle(modules, " << modules.size() << ", data);\n"
+		<< "\treturn bundle;\n}\n\n"
+		<< "} // namespace Bundles\n} // namespace Lua\n";
+	return static_cast<bool>(out);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+	if (argc < 5) {
+		std::cerr << "usage: " << argv[0] << " <header> <source> <bundle name> <strip 0|1> <module name>=<file>..." << std::endl;
+		return 1;
+	}
+	const std::string header = argv[1];
+	const std::string source = argv[2];
+	const std::string bundleName = argv[3];
+	const bool strip = std::strcmp(argv[4], "0") != 0;
+
+	std::vector<Module> modules;
+	for (int i = 5; i < argc; ++i) {
+		const char* separator = std::strchr(argv[i], '=');
+		if (separator == nullptr) {
+			std::cerr << "invalid module " << argv[i] << std::endl;
+			return 1;
+		}
+		Module module;
+		module.name.assign(argv[i], static_cast<size_t>(separator - argv[i]));
+		if (!compileModule(module.name, separator + 1, strip, module.bytecode)) {
+			return 1;
+		}
+		modules.push_back(std::move(module));
+	}
+
+	//the bundle finds modules with a binary search
+	std::sort(modules.begin(), modules.end(), [](const Module& a, const Module& b) { return a.name < b.name; });
+	for (size_t i = 1; i < modules.size(); ++i) {
+		if (modules[i].name == modules[i - 1].name) {
+			std::cerr << "module " << modules[i].name << " is embedded twice" << std::endl;
+			return 1;
+		}
+	}
+
+	if (!writeHeader(header, bundleName) || !writeSource(source, header, bundleName, modules)) {
+		std::cerr << "cannot write " << source << std::endl;
+		return 1;
+	}
+	return 0;
+}
\ No newline at end of file